@@ -0,0 +1,144 @@
+#include "AudioDucker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float dbToLinear(float db)
+{
+    return std::pow(10.0f, db / 20.0f);
+}
+
+float linearToDb(float lin)
+{
+    if (lin <= 0.0f) return -120.0f;
+    return 20.0f * std::log10(lin);
+}
+
+// One-pole smoothing coefficient for a time constant of `ms` at `sampleRate`
+float onePoleCoef(float ms, int sampleRate)
+{
+    if (ms <= 0.0f || sampleRate <= 0) return 1.0f;
+    return 1.0f - std::exp(-1000.0f / (ms * static_cast<float>(sampleRate)));
+}
+
+// Detector decay: the envelope releases over this time so short gaps between
+// words do not let the bed swell back up. The audible recovery is governed by
+// the configured release time on the gain ramp.
+constexpr float kDetectorReleaseMs = 50.0f;
+
+} // namespace
+
+AudioDucker::AudioDucker()
+    : m_ramp(kMaxChunkFrames, 1.0f)
+{
+    setSettings(Settings());
+}
+
+void AudioDucker::setSettings(const Settings& s)
+{
+    m_threshold.store(dbToLinear(s.thresholdDbfs));
+    m_depth.store(dbToLinear(std::min(s.depthDb, 0.0f)));
+    m_attackMs.store(std::max(s.attackMs, 0.0f));
+    m_releaseMs.store(std::max(s.releaseMs, 0.0f));
+    m_busMask.store(s.busMask);
+    m_enabled.store(s.enabled);
+}
+
+AudioDucker::Settings AudioDucker::settings() const
+{
+    Settings s;
+    s.enabled = m_enabled.load();
+    s.thresholdDbfs = linearToDb(m_threshold.load());
+    s.depthDb = linearToDb(m_depth.load());
+    s.attackMs = m_attackMs.load();
+    s.releaseMs = m_releaseMs.load();
+    s.busMask = m_busMask.load();
+    return s;
+}
+
+void AudioDucker::setSampleRate(int sampleRate)
+{
+    if (sampleRate > 0) m_sampleRate.store(sampleRate);
+}
+
+void AudioDucker::reset()
+{
+    m_envelope = 0.0f;
+    m_gain.store(1.0f);
+}
+
+float AudioDucker::blockPeak(const float* samples, int n)
+{
+    if (!samples || n <= 0) return 0.0f;
+    // Eight independent accumulators map onto SIMD lanes
+    float acc[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 8; ++k) {
+            float a = std::fabs(samples[i + k]);
+            acc[k] = a > acc[k] ? a : acc[k];
+        }
+    }
+    for (; i < n; ++i) {
+        float a = std::fabs(samples[i]);
+        acc[0] = a > acc[0] ? a : acc[0];
+    }
+    float peak = acc[0];
+    for (int k = 1; k < 8; ++k) peak = acc[k] > peak ? acc[k] : peak;
+    return peak;
+}
+
+void AudioDucker::process(const float* input, float** outputs, int nframes, int nOutChannels)
+{
+    if (!outputs || nframes <= 0 || nOutChannels <= 0) return;
+
+    const bool enabled = m_enabled.load(std::memory_order_relaxed);
+    float gain = m_gain.load(std::memory_order_relaxed);
+    // Fast path: disabled and fully recovered
+    if (!enabled && gain >= 1.0f) {
+        m_envelope = 0.0f;
+        return;
+    }
+
+    const int sr = m_sampleRate.load(std::memory_order_relaxed);
+    const float threshold = m_threshold.load(std::memory_order_relaxed);
+    const float depth = m_depth.load(std::memory_order_relaxed);
+    const float attackCoef = onePoleCoef(m_attackMs.load(std::memory_order_relaxed), sr);
+    const float releaseCoef = onePoleCoef(m_releaseMs.load(std::memory_order_relaxed), sr);
+    const uint32_t mask = m_busMask.load(std::memory_order_relaxed);
+
+    for (int offset = 0; offset < nframes; offset += kMaxChunkFrames) {
+        const int n = std::min(kMaxChunkFrames, nframes - offset);
+
+        // Envelope follower on the block peak: instant attack, fixed decay
+        const float peak = (enabled && input) ? blockPeak(input + offset, n) : 0.0f;
+        const float decay = std::exp(-1000.0f * static_cast<float>(n) / (kDetectorReleaseMs * static_cast<float>(sr > 0 ? sr : 48000)));
+        m_envelope = std::max(peak, m_envelope * decay);
+
+        const float target = (enabled && m_envelope >= threshold) ? depth : 1.0f;
+        if (gain == target && target >= 1.0f) continue; // nothing to apply for this chunk
+
+        // Per-sample gain ramp towards the target
+        const float coef = target < gain ? attackCoef : releaseCoef;
+        float* ramp = m_ramp.data();
+        for (int i = 0; i < n; ++i) {
+            gain += (target - gain) * coef;
+            ramp[i] = gain;
+        }
+        if (std::fabs(gain - target) < 1e-5f) gain = target;
+
+        for (int b = 0; b * 2 < nOutChannels && b < 32; ++b) {
+            if (!(mask & (1u << b))) continue;
+            for (int c = 0; c < 2 && b * 2 + c < nOutChannels; ++c) {
+                float* out = outputs[b * 2 + c];
+                if (!out) continue;
+                out += offset;
+                for (int i = 0; i < n; ++i) out[i] *= ramp[i];
+            }
+        }
+    }
+
+    m_gain.store(gain, std::memory_order_relaxed);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * AudioDucker: sidechain "talk-over" ducker driven by the JACK input port.
+ *
+ * Called from the real-time thread after the mixer has filled the bus outputs.
+ * The block peak of the sidechain input feeds an envelope follower; while the
+ * envelope is above the threshold the selected buses are attenuated by `depth`.
+ * Gain changes ramp per sample using the attack/release time constants so the
+ * reduction is click-free. All buffers are allocated up front: `process()`
+ * never allocates or locks.
+ */
+class AudioDucker
+{
+public:
+    struct Settings {
+        bool enabled = false;
+        float thresholdDbfs = -40.0f;   // sidechain level that triggers ducking
+        float depthDb = -12.0f;         // gain applied to ducked buses (<= 0)
+        float attackMs = 10.0f;         // time to reach the ducked gain
+        float releaseMs = 400.0f;       // time to recover once the input is quiet
+        uint32_t busMask = 0x1;         // bit b set -> bus b is ducked
+    };
+
+    // Longest block processed in one pass; longer blocks are split into chunks
+    static constexpr int kMaxChunkFrames = 1024;
+
+    AudioDucker();
+
+    // Non-RT: update parameters. Safe to call while the RT thread is processing.
+    void setSettings(const Settings& s);
+    Settings settings() const;
+    void setSampleRate(int sampleRate);
+
+    // RT: duck `outputs` (stereo pairs per bus, see AudioEnginePlay::process)
+    // according to the sidechain `input`. `input` may be null (treated as silence).
+    void process(const float* input, float** outputs, int nframes, int nOutChannels);
+
+    // Peak absolute value of `n` samples. Uses independent lanes so the
+    // compiler can vectorize the reduction without -ffast-math.
+    static float blockPeak(const float* samples, int n);
+
+    // Current applied gain in linear units (1.0 = no reduction); for meters/tests
+    float currentGain() const { return m_gain.load(std::memory_order_relaxed); }
+    // Reset envelope and gain to the idle state
+    void reset();
+
+private:
+    std::atomic<bool> m_enabled{false};
+    std::atomic<float> m_threshold{0.01f};     // linear
+    std::atomic<float> m_depth{0.25f};         // linear
+    std::atomic<float> m_attackMs{10.0f};
+    std::atomic<float> m_releaseMs{400.0f};
+    std::atomic<uint32_t> m_busMask{0x1};
+    std::atomic<int> m_sampleRate{48000};
+
+    // RT state
+    float m_envelope = 0.0f;
+    std::atomic<float> m_gain{1.0f};
+    std::vector<float> m_ramp;                 // preallocated kMaxChunkFrames gains
+};
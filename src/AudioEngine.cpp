@@ -13,15 +13,41 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <memory>
 
 #include "AudioEnginePlay.h"
+#include "OutputRecorder.h"
+#include "InputCapture.h"
 
 struct AudioEnginePrivate {
     jack_client_t* client = nullptr;
-    jack_port_t* out_ports[2] = {nullptr, nullptr};
+    // Stereo port pairs per bus: out_ports[2*b] left, out_ports[2*b+1] right
+    jack_port_t* out_ports[AudioEnginePlay::kMaxBuses * 2] = {};
+    float* out_bufs[AudioEnginePlay::kMaxBuses * 2] = {};
+    int busCount = 1;
     jack_port_t* in_port = nullptr;
     unsigned int jack_sample_rate = 48000;
     AudioEnginePlay player;
+    AudioDucker ducker;
+    bool offline = false;
+    // Batches accepted by playBatch() (diagnostics)
+    std::atomic<uint64_t> batchesStarted{0};
+    // Attached recorder/capture and the number of RT passes currently using them
+    std::atomic<OutputRecorder*> recorder{nullptr};
+    std::atomic<InputCapture*> capture{nullptr};
+    std::atomic<int> attachUsers{0};
+
+    // Recent input history for getInputSamples(): RT overwrites, the single
+    // reader copies the samples written since its last call and drops any
+    // the RT thread lapped meanwhile. Relaxed atomics keep the overlap
+    // between the two race-free; inputWritten orders the samples.
+    std::unique_ptr<std::atomic<float>[]> inputHistory{new std::atomic<float>[AudioEngine::kInputHistorySamples]()};
+    std::atomic<uint64_t> inputWritten{0};
+    uint64_t inputRead = 0;     // reader-owned
     KeepAliveMonitor* keepAliveMonitor = nullptr;
     std::string jackClientName = "libre-soundboard";
     int initCount = 0;
@@ -29,35 +55,113 @@ struct AudioEnginePrivate {
     // For testing: inject input samples
     std::vector<float> testInputSamples;
     std::mutex testInputLock;
+
+    // Cycle clock (see AudioEngine::cycleClock), published as a seqlock:
+    // clockSeq is odd while the RT thread updates the fields
+    std::atomic<uint32_t> clockSeq{0};
+    std::atomic<uint64_t> clockFrame{0};
+    std::atomic<int64_t> clockUsecs{0};
+    std::atomic<int64_t> clockPeriodUsecs{0};
 };
 
+static int64_t monotonicUsecs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// RT thread: stamp the cycle about to be mixed. Lock- and allocation-free.
+static void publish_cycle_clock(AudioEnginePrivate* d, int64_t usecs, int64_t periodUsecs)
+{
+    const uint32_t seq = d->clockSeq.load(std::memory_order_relaxed);
+    d->clockSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    d->clockFrame.store(d->player.framesProcessed(), std::memory_order_relaxed);
+    d->clockUsecs.store(usecs, std::memory_order_relaxed);
+    d->clockPeriodUsecs.store(periodUsecs, std::memory_order_relaxed);
+    d->clockSeq.store(seq + 2, std::memory_order_release);
+}
+
+// Shared by the JACK callback and the offline backend. Must not allocate or lock.
+static void process_block(AudioEnginePrivate* d, const float* input, float** outputs, int nframes)
+{
+    const int nOut = d->busCount * 2;
+    d->player.process(outputs, nframes, nOut);
+    d->ducker.process(input, outputs, nframes, nOut);
+
+    // Hand the final mix to the recorder and the input to the capture; neither blocks
+    d->attachUsers.fetch_add(1);
+    if (OutputRecorder* rec = d->recorder.load()) {
+        rec->pushBlock(outputs, nOut, nframes);
+    }
+    if (input) {
+        if (InputCapture* cap = d->capture.load()) {
+            cap->pushInput(input, nframes);
+        }
+    }
+    d->attachUsers.fetch_sub(1);
+
+    if (input) {
+        // Overwrite the oldest history; the reader detects lapped samples
+        const size_t cap = AudioEngine::kInputHistorySamples;
+        const uint64_t w = d->inputWritten.load(std::memory_order_relaxed);
+        const size_t n = std::min(static_cast<size_t>(nframes), cap);
+        const float* src = input + (static_cast<size_t>(nframes) - n);
+        const uint64_t base = w + static_cast<uint64_t>(nframes) - n;
+        for (size_t i = 0; i < n; ++i) {
+            d->inputHistory[static_cast<size_t>((base + i) % cap)].store(src[i], std::memory_order_relaxed);
+        }
+        d->inputWritten.store(w + static_cast<uint64_t>(nframes), std::memory_order_release);
+    }
+
+    // Feed input to KeepAliveMonitor
+    if (input && d->keepAliveMonitor) {
+        // Process 1 frame (mono input from JACK)
+        d->keepAliveMonitor->processInputSamples(input, nframes, 1);
+    }
+}
+
 static int jack_process(jack_nframes_t nframes, void* arg)
 {
     AudioEnginePrivate* d = reinterpret_cast<AudioEnginePrivate*>(arg);
     if (!d) return 0;
     
-    // Handle output
-    jack_port_t* port_l = d->out_ports[0];
-    jack_port_t* port_r = d->out_ports[1];
-    float* out_l = (float*)jack_port_get_buffer(port_l, nframes);
-    float* out_r = (float*)jack_port_get_buffer(port_r, nframes);
-
-    float* outputs[2] = { out_l, out_r };
-    d->player.process(outputs, nframes, 2);
-    
-    // Handle input - feed to KeepAliveMonitor
-    if (d->in_port && d->keepAliveMonitor) {
-        float* in_buf = (float*)jack_port_get_buffer(d->in_port, nframes);
-        if (in_buf) {
-            std::vector<float> input_samples(in_buf, in_buf + nframes);
-            // Process 1 frame (mono input from JACK)
-            d->keepAliveMonitor->processInputSamples(input_samples, nframes, 1);
-        }
+    // Handle output: one stereo port pair per bus
+    const int nOut = d->busCount * 2;
+    for (int ch = 0; ch < nOut; ++ch) {
+        d->out_bufs[ch] = (float*)jack_port_get_buffer(d->out_ports[ch], nframes);
+    }
+    const float* in_buf = d->in_port ? (const float*)jack_port_get_buffer(d->in_port, nframes) : nullptr;
+
+    // Stamp the cycle for the playhead clock before the mixer advances
+    jack_nframes_t cycleFrames = 0;
+    jack_time_t cycleUsecs = 0;
+    jack_time_t nextUsecs = 0;
+    float periodUsecs = 0.0f;
+    if (jack_get_cycle_times(d->client, &cycleFrames, &cycleUsecs, &nextUsecs, &periodUsecs) == 0) {
+        publish_cycle_clock(d, static_cast<int64_t>(cycleUsecs), static_cast<int64_t>(nextUsecs - cycleUsecs));
+    } else {
+        publish_cycle_clock(d, static_cast<int64_t>(jack_get_time()),
+                            static_cast<int64_t>(nframes) * 1000000 / std::max(1u, d->jack_sample_rate));
     }
+    process_block(d, in_buf, d->out_bufs, static_cast<int>(nframes));
     
     return 0;
 }
 
+static AudioDucker::Settings duckingSettingsFromPreferences()
+{
+    PreferencesManager& pm = PreferencesManager::instance();
+    AudioDucker::Settings s;
+    s.enabled = pm.duckingEnabled();
+    s.thresholdDbfs = static_cast<float>(pm.duckingThresholdDbfs());
+    s.depthDb = static_cast<float>(pm.duckingDepthDb());
+    s.attackMs = static_cast<float>(pm.duckingAttackMs());
+    s.releaseMs = static_cast<float>(pm.duckingReleaseMs());
+    s.busMask = pm.duckingBusMask();
+    return s;
+}
+
 AudioEngine::AudioEngine()
     : m_priv(new AudioEnginePrivate())
 {
@@ -86,8 +190,18 @@ bool AudioEngine::init()
     }
 
     m_priv->jack_sample_rate = jack_get_sample_rate(m_priv->client);
-    m_priv->out_ports[0] = jack_port_register(m_priv->client, "out_l", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    m_priv->out_ports[1] = jack_port_register(m_priv->client, "out_r", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+    m_priv->busCount = pm.audioBusCount();
+    for (int b = 0; b < m_priv->busCount; ++b) {
+        // Bus 0 keeps the historical port names so saved connections still apply
+        std::string left = b == 0 ? std::string("out_l") : "bus" + std::to_string(b + 1) + "_l";
+        std::string right = b == 0 ? std::string("out_r") : "bus" + std::to_string(b + 1) + "_r";
+        m_priv->out_ports[2 * b] = jack_port_register(m_priv->client, left.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        m_priv->out_ports[2 * b + 1] = jack_port_register(m_priv->client, right.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        m_priv->player.setBusGain(b, static_cast<float>(pm.audioBusGain(b)));
+    }
+    m_priv->ducker.setSampleRate(static_cast<int>(m_priv->jack_sample_rate));
+    m_priv->ducker.setSettings(duckingSettingsFromPreferences());
+    m_priv->ducker.reset();
     m_priv->in_port = jack_port_register(m_priv->client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
 
     jack_set_process_callback(m_priv->client, jack_process, m_priv);
@@ -105,8 +219,33 @@ bool AudioEngine::init()
     return true;
 }
 
+bool AudioEngine::initOffline(int sampleRate, int busCount)
+{
+    if (!m_priv || m_priv->client || sampleRate <= 0) return false;
+    m_priv->offline = true;
+    m_priv->jack_sample_rate = static_cast<unsigned int>(sampleRate);
+    m_priv->busCount = std::clamp(busCount, 1, AudioEnginePlay::kMaxBuses);
+    m_priv->ducker.setSampleRate(sampleRate);
+    m_priv->ducker.reset();
+    return true;
+}
+
+bool AudioEngine::isOffline() const
+{
+    return m_priv && m_priv->offline;
+}
+
+void AudioEngine::processOffline(const float* input, float** outputs, int nframes)
+{
+    if (!m_priv || !m_priv->offline || !outputs || nframes <= 0) return;
+    publish_cycle_clock(m_priv, monotonicUsecs(),
+                        static_cast<int64_t>(nframes) * 1000000 / std::max(1u, m_priv->jack_sample_rate));
+    process_block(m_priv, input, outputs, nframes);
+}
+
 void AudioEngine::shutdown()
 {
+    if (m_priv) m_priv->offline = false;
     if (m_priv && m_priv->client) {
         // Save current connections before closing
         PreferencesManager& pm = PreferencesManager::instance();
@@ -115,8 +254,7 @@ void AudioEngine::shutdown()
         }
         jack_client_close(m_priv->client);
         m_priv->client = nullptr;
-        m_priv->out_ports[0] = nullptr;
-        m_priv->out_ports[1] = nullptr;
+        for (auto& p : m_priv->out_ports) p = nullptr;
         m_priv->in_port = nullptr;
     }
 }
@@ -141,8 +279,8 @@ void AudioEngine::saveConnections() const
     std::ofstream ofs(path, std::ios::trunc);
     if (!ofs) return;
 
-    // Save output ports (left and right)
-    for (int i = 0; i < 2; ++i) {
+    // Save output ports (left and right of every bus)
+    for (int i = 0; i < m_priv->busCount * 2; ++i) {
         jack_port_t* p = m_priv->out_ports[i];
         if (!p) continue;
         const char* pname = jack_port_name(p);
@@ -218,62 +356,143 @@ void AudioEngine::autoConnectInputPort()
     jack_connect(m_priv->client, "system:capture_2", inName);
 }
 
-bool AudioEngine::playBuffer(const std::vector<float>& samples, int sampleRate, int channels, const std::string& id, float gain)
+// Resample interleaved `samples` to `targetRate` with libsamplerate
+static bool resampleBuffer(const std::vector<float>& samples, int sampleRate, int channels, int targetRate, std::vector<float>& out)
 {
-    if (!m_priv || !m_priv->client)
+    SRC_DATA src_data;
+    memset(&src_data, 0, sizeof(src_data));
+    src_data.data_in = samples.data();
+    src_data.input_frames = static_cast<long>(samples.size() / channels);
+    double ratio = double(targetRate) / double(sampleRate);
+    src_data.output_frames = static_cast<long>(src_data.input_frames * ratio) + 1;
+    out.assign(static_cast<size_t>(src_data.output_frames) * channels, 0.0f);
+    src_data.data_out = out.data();
+    src_data.src_ratio = ratio;
+    src_data.end_of_input = 1;
+    // Use a better-quality converter than the fastest low-quality option
+    int error = src_simple(&src_data, SRC_SINC_MEDIUM_QUALITY, channels);
+    if (error != 0) {
+        std::cerr << "libsamplerate error: " << src_strerror(error) << std::endl;
+        return false;
+    }
+    // Resize to the actual number of frames produced
+    long produced = src_data.output_frames_gen;
+    if (produced > 0) {
+        out.resize(static_cast<size_t>(produced) * channels);
+    } else {
+        out.clear();
+    }
+    // Diagnostic log
+    std::cerr << "AudioEngine: resampled " << src_data.input_frames << " frames @ " << sampleRate
+              << " -> " << produced << " frames @ " << targetRate << "\n";
+    return true;
+}
+
+bool AudioEngine::playBuffer(const std::vector<float>& samples, int sampleRate, int channels, const std::string& id, float gain, int bus)
+{
+    if (!m_priv || (!m_priv->client && !m_priv->offline))
         return false;
 
     // If sample rate differs, resample the entire buffer to JACK rate using libsamplerate
     if (sampleRate != static_cast<int>(m_priv->jack_sample_rate)) {
-        SRC_DATA src_data;
-        memset(&src_data, 0, sizeof(src_data));
-        src_data.data_in = samples.data();
-        src_data.input_frames = static_cast<long>(samples.size() / channels);
-        double ratio = double(m_priv->jack_sample_rate) / double(sampleRate);
-        src_data.output_frames = static_cast<long>(src_data.input_frames * ratio) + 1;
-        std::vector<float> temp_out(static_cast<size_t>(src_data.output_frames) * channels);
-        src_data.data_out = temp_out.data();
-        src_data.src_ratio = ratio;
-        src_data.end_of_input = 1;
-        // Use a better-quality converter than the fastest low-quality option
-        int error = src_simple(&src_data, SRC_SINC_MEDIUM_QUALITY, channels);
-        if (error != 0) {
-            std::cerr << "libsamplerate error: " << src_strerror(error) << std::endl;
+        std::vector<float> temp_out;
+        if (!resampleBuffer(samples, sampleRate, channels, static_cast<int>(m_priv->jack_sample_rate), temp_out)) {
             return false;
         }
-        // Resize to the actual number of frames produced
-        long produced = src_data.output_frames_gen;
-        if (produced > 0) {
-            temp_out.resize(static_cast<size_t>(produced) * channels);
-        } else {
-            temp_out.clear();
-        }
         // Queue resampled buffer for playback
-        // Diagnostic log
-        std::cerr << "AudioEngine: resampled " << src_data.input_frames << " frames @ " << sampleRate
-                  << " -> " << produced << " frames @ " << m_priv->jack_sample_rate << "\n";
         if (!id.empty()) {
             // restart existing voices with same id when requested
             // add new voice if no restart
             if (!m_priv->player.restartVoicesById(id)) {
-                m_priv->player.addVoice(std::move(temp_out), static_cast<int>(m_priv->jack_sample_rate), channels, id, gain);
+                m_priv->player.addVoice(std::move(temp_out), static_cast<int>(m_priv->jack_sample_rate), channels, id, gain, bus);
             }
         } else {
-            m_priv->player.addVoice(std::move(temp_out), static_cast<int>(m_priv->jack_sample_rate), channels, std::string(), gain);
+            m_priv->player.addVoice(std::move(temp_out), static_cast<int>(m_priv->jack_sample_rate), channels, std::string(), gain, bus);
         }
     } else {
         std::cerr << "AudioEngine: no resample needed; frames=" << (samples.size() / channels) << " @ " << sampleRate << "\n";
         if (!id.empty()) {
             if (!m_priv->player.restartVoicesById(id)) {
-                m_priv->player.addVoice(std::vector<float>(samples.begin(), samples.end()), sampleRate, channels, id, gain);
+                m_priv->player.addVoice(std::vector<float>(samples.begin(), samples.end()), sampleRate, channels, id, gain, bus);
             }
         } else {
-            m_priv->player.addVoice(std::vector<float>(samples.begin(), samples.end()), sampleRate, channels, std::string(), gain);
+            m_priv->player.addVoice(std::vector<float>(samples.begin(), samples.end()), sampleRate, channels, std::string(), gain, bus);
         }
     }
     return true;
 }
 
+bool AudioEngine::playBatch(const std::vector<BatchVoice>& voices)
+{
+    if (!m_priv || (!m_priv->client && !m_priv->offline))
+        return false;
+
+    // Prepare every buffer first so nothing slow happens between publications
+    const int engineRate = static_cast<int>(m_priv->jack_sample_rate);
+    std::vector<AudioEnginePlay::VoiceStart> starts;
+    starts.reserve(voices.size());
+    for (const BatchVoice& bv : voices) {
+        if (!bv.samples || bv.channels <= 0 || bv.sampleRate <= 0) continue;
+        AudioEnginePlay::VoiceStart st;
+        if (bv.sampleRate != engineRate) {
+            if (!resampleBuffer(*bv.samples, bv.sampleRate, bv.channels, engineRate, st.buf)) continue;
+        } else {
+            st.buf = *bv.samples;
+        }
+        st.sampleRate = engineRate;
+        st.channels = bv.channels;
+        st.id = bv.id;
+        st.gain = bv.gain;
+        st.bus = bv.bus;
+        st.delayFrames = static_cast<size_t>(std::max(0, bv.offsetFrames));
+        starts.push_back(std::move(st));
+    }
+    if (starts.empty()) return false;
+    m_priv->player.startVoices(std::move(starts));
+    m_priv->batchesStarted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t AudioEngine::batchesStarted() const
+{
+    return m_priv ? m_priv->batchesStarted.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t AudioEngine::framesProcessed() const
+{
+    if (!m_priv) return 0;
+    return m_priv->player.framesProcessed();
+}
+
+AudioEngine::CycleClock AudioEngine::cycleClock() const
+{
+    CycleClock out;
+    if (!m_priv) return out;
+    for (;;) {
+        const uint32_t seq = m_priv->clockSeq.load(std::memory_order_acquire);
+        if (seq & 1u) {
+            std::this_thread::yield();
+            continue;
+        }
+        out.frame = m_priv->clockFrame.load(std::memory_order_relaxed);
+        out.usecs = m_priv->clockUsecs.load(std::memory_order_relaxed);
+        out.periodUsecs = m_priv->clockPeriodUsecs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_priv->clockSeq.load(std::memory_order_relaxed) == seq) {
+            out.valid = seq != 0;
+            break;
+        }
+    }
+    out.sampleRate = static_cast<int>(m_priv->jack_sample_rate);
+    return out;
+}
+
+int64_t AudioEngine::clockUsecs() const
+{
+    if (m_priv && m_priv->client) return static_cast<int64_t>(jack_get_time());
+    return monotonicUsecs();
+}
+
 void AudioEngine::stopAll()
 {
     if (!m_priv) return;
@@ -292,6 +511,90 @@ void AudioEngine::stopVoicesById(const std::string& id)
     m_priv->player.stopVoicesById(id);
 }
 
+int AudioEngine::busCount() const
+{
+    if (!m_priv) return 0;
+    return m_priv->busCount;
+}
+
+void AudioEngine::setVoiceBusById(const std::string& id, int bus)
+{
+    if (!m_priv) return;
+    m_priv->player.setBusById(id, bus);
+}
+
+void AudioEngine::setBusGain(int bus, float gain)
+{
+    if (!m_priv) return;
+    m_priv->player.setBusGain(bus, gain);
+}
+
+float AudioEngine::busGain(int bus) const
+{
+    if (!m_priv) return 0.0f;
+    return m_priv->player.busGain(bus);
+}
+
+int AudioEngine::sampleRate() const
+{
+    if (!m_priv) return 0;
+    return static_cast<int>(m_priv->jack_sample_rate);
+}
+
+void AudioEngine::setOutputRecorder(OutputRecorder* recorder)
+{
+    if (!m_priv) return;
+    m_priv->recorder.store(recorder);
+    // Wait for an in-flight process cycle to finish with the old recorder
+    while (m_priv->attachUsers.load() > 0) {
+        std::this_thread::yield();
+    }
+}
+
+void AudioEngine::setInputCapture(InputCapture* capture)
+{
+    if (!m_priv) return;
+    m_priv->capture.store(capture);
+    while (m_priv->attachUsers.load() > 0) {
+        std::this_thread::yield();
+    }
+}
+
+InputCapture* AudioEngine::inputCapture() const
+{
+    if (!m_priv) return nullptr;
+    return m_priv->capture.load();
+}
+
+OutputRecorder* AudioEngine::outputRecorder() const
+{
+    if (!m_priv) return nullptr;
+    return m_priv->recorder.load();
+}
+
+void AudioEngine::setDuckingSettings(const AudioDucker::Settings& settings)
+{
+    if (!m_priv) return;
+    m_priv->ducker.setSettings(settings);
+}
+
+AudioDucker::Settings AudioEngine::duckingSettings() const
+{
+    if (!m_priv) return AudioDucker::Settings();
+    return m_priv->ducker.settings();
+}
+
+void AudioEngine::applyDuckingPreferences()
+{
+    setDuckingSettings(duckingSettingsFromPreferences());
+}
+
+float AudioEngine::duckingGain() const
+{
+    if (!m_priv) return 1.0f;
+    return m_priv->ducker.currentGain();
+}
+
 AudioEngine::PlaybackInfo AudioEngine::getPlaybackInfoForId(const std::string& id) const
 {
     AudioEngine::PlaybackInfo out;
@@ -301,9 +604,28 @@ AudioEngine::PlaybackInfo AudioEngine::getPlaybackInfoForId(const std::string& i
     out.frames = pinfo.frames;
     out.sampleRate = pinfo.sampleRate;
     out.totalFrames = pinfo.totalFrames;
+    out.startFrame = pinfo.startFrame;
     return out;
 }
 
+uint64_t AudioEngine::voiceHandle(const std::string& id)
+{
+    if (!m_priv) return 0;
+    return m_priv->player.voiceHandle(id);
+}
+
+uint64_t AudioEngine::voiceHandleGeneration() const
+{
+    if (!m_priv) return 0;
+    return m_priv->player.voiceHandleGeneration();
+}
+
+size_t AudioEngine::fillPlaybackSnapshot(VoicePosition* out, size_t capacity) const
+{
+    if (!m_priv) return 0;
+    return m_priv->player.fillPlaybackSnapshot(out, capacity);
+}
+
 void AudioEngine::setKeepAliveMonitor(KeepAliveMonitor* monitor)
 {
     if (m_priv) {
@@ -317,15 +639,30 @@ KeepAliveMonitor* AudioEngine::getKeepAliveMonitor() const
     return m_priv->keepAliveMonitor;
 }
 
-std::vector<float> AudioEngine::getInputSamples() const
+std::vector<float> AudioEngine::getInputSamples()
 {
-    if (!m_priv || !m_priv->in_port || !m_priv->client) {
-        return std::vector<float>();
+    std::vector<float> out;
+    if (!m_priv) return out;
+
+    const size_t cap = kInputHistorySamples;
+    const uint64_t w = m_priv->inputWritten.load(std::memory_order_acquire);
+    uint64_t r = m_priv->inputRead;
+    if (w - r > cap) r = w - cap;
+    if (w == r) return out;
+
+    out.resize(static_cast<size_t>(w - r));
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = m_priv->inputHistory[static_cast<size_t>((r + i) % cap)].load(std::memory_order_relaxed);
     }
-    
-    // Can only be safely called from the JACK process callback
-    // For now, return empty (real implementation would use atomic buffer exchange)
-    return std::vector<float>();
+    // Samples the RT thread overwrote while we were copying are stale; drop them
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t w2 = m_priv->inputWritten.load(std::memory_order_relaxed);
+    if (w2 - r > cap) {
+        const size_t lapped = std::min(out.size(), static_cast<size_t>(w2 - r - cap));
+        out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(lapped));
+    }
+    m_priv->inputRead = w;
+    return out;
 }
 
 void AudioEngine::processKeepAliveInput()
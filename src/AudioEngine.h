@@ -3,7 +3,12 @@
 #include <vector>
 #include <string>
 
+#include "AudioDucker.h"
+#include "VoicePosition.h"
+
 class KeepAliveMonitor;
+class OutputRecorder;
+class InputCapture;
 
 /**
  * AudioEngine: thin wrapper around JACK client for playback control.
@@ -18,13 +23,70 @@ public:
 
     bool init();
     void shutdown();
+
+    /**
+     * Offline backend: run the same mixer/ducker path as the JACK callback
+     * without a JACK server. Used by tests and for rendering. After
+     * initOffline() the caller drives processing with processOffline();
+     * `input` is the mono sidechain/input block (may be null) and `outputs`
+     * holds busCount() stereo pairs of `nframes` samples each.
+     */
+    bool initOffline(int sampleRate, int busCount = 1);
+    bool isOffline() const;
+    void processOffline(const float* input, float** outputs, int nframes);
     /**
      * Play interleaved float samples (any sample rate/channels). This will resample
      * to the JACK sample rate and queue for playback. An optional `id` may be
      * provided so subsequent play requests with the same id will restart that
-     * voice instead of adding a new concurrent voice.
+     * voice instead of adding a new concurrent voice. `bus` selects the stereo
+     * output bus (JACK port pair) the voice is mixed into.
+     */
+    bool playBuffer(const std::vector<float>& samples, int sampleRate, int channels, const std::string& id = std::string(), float gain = 1.0f, int bus = 0);
+
+    /**
+     * One sound of a batch started with playBatch(). `samples` is only read
+     * during the call. `offsetFrames` delays the sound relative to the
+     * batch's first frame (at the engine sample rate).
+     */
+    struct BatchVoice {
+        const std::vector<float>* samples = nullptr;
+        int sampleRate = 0;
+        int channels = 0;
+        std::string id;
+        float gain = 1.0f;
+        int bus = 0;
+        int offsetFrames = 0;
+    };
+
+    /**
+     * Start several sounds atomically: all buffers are prepared first and
+     * then published to the mixer at once, so every voice starts in the same
+     * audio block (plus its offset). Ids that are already playing restart.
+     */
+    bool playBatch(const std::vector<BatchVoice>& voices);
+    // Number of batches playBatch() has started (diagnostics, tests)
+    uint64_t batchesStarted() const;
+
+    // Frames mixed since the engine started (the mixer's frame clock)
+    uint64_t framesProcessed() const;
+
+    /**
+     * Cycle clock for smooth playhead animation: the mixer frame at the
+     * start of the last processed cycle and the time that cycle started
+     * (jack_get_cycle_times() under JACK), on the clock clockUsecs() reads.
+     * Published by the RT thread each cycle; readers never block it.
      */
-    bool playBuffer(const std::vector<float>& samples, int sampleRate, int channels, const std::string& id = std::string(), float gain = 1.0f);
+    struct CycleClock {
+        bool valid = false;         // false until the first cycle
+        uint64_t frame = 0;         // framesProcessed() at the cycle start
+        int64_t usecs = 0;          // cycle start time
+        int64_t periodUsecs = 0;    // cycle length
+        int sampleRate = 0;
+    };
+    CycleClock cycleClock() const;
+    // Current time on the cycle clock (jack_get_time(), or a monotonic clock
+    // for the offline backend)
+    int64_t clockUsecs() const;
 
     // Stop all currently playing voices
     void stopAll();
@@ -35,16 +97,55 @@ public:
     // Stop voices matching id
     void stopVoicesById(const std::string& id);
 
+    // Output buses: bus 0 is registered as out_l/out_r, bus N (N >= 1) as
+    // bus<N+1>_l/bus<N+1>_r. The count is read from preferences on init().
+    int busCount() const;
+    void setVoiceBusById(const std::string& id, int bus);
+    void setBusGain(int bus, float gain);
+    float busGain(int bus) const;
+
+    // Sample rate of the running backend (JACK or offline)
+    int sampleRate() const;
+
+    // Output recording: every processed block is handed to `recorder` from the
+    // RT thread. Passing nullptr detaches and waits until the RT thread has
+    // finished with the previous recorder, so it can be stopped safely.
+    void setOutputRecorder(OutputRecorder* recorder);
+    OutputRecorder* outputRecorder() const;
+
+    // Record-to-slot: the input port is appended to `capture` from the RT
+    // thread. Passing nullptr detaches with the same guarantee as above.
+    void setInputCapture(InputCapture* capture);
+    InputCapture* inputCapture() const;
+
+    // Talk-over ducking of selected buses driven by the input port
+    void setDuckingSettings(const AudioDucker::Settings& settings);
+    AudioDucker::Settings duckingSettings() const;
+    // Re-read the ducking settings from PreferencesManager
+    void applyDuckingPreferences();
+    // Current ducking gain in linear units (1.0 = not ducked)
+    float duckingGain() const;
+
     struct PlaybackInfo {
         bool found = false;
         uint64_t frames = 0; // frames (not interleaved samples)
         int sampleRate = 0;
         uint64_t totalFrames = 0;
+        int64_t startFrame = -1; // framesProcessed() value at the first played sample
     };
 
     // Thread-safe query to obtain current playback frames/sampleRate for a voice id
     PlaybackInfo getPlaybackInfoForId(const std::string& id) const;
 
+    // Batched form for callers tracking many ids (PlayheadManager): ids are
+    // resolved to handles once, then one pass over the voice snapshot fills
+    // a caller-owned array. See AudioEnginePlay::fillPlaybackSnapshot().
+    // Handles resolved before voiceHandleGeneration() changed are stale.
+    using VoicePosition = ::VoicePosition;
+    uint64_t voiceHandle(const std::string& id);
+    uint64_t voiceHandleGeneration() const;
+    size_t fillPlaybackSnapshot(VoicePosition* out, size_t capacity) const;
+
     // Persist and restore JACK connections
     void saveConnections() const;
     void restoreConnections();
@@ -62,8 +163,11 @@ public:
     // Update connections file when client name changes
     static void updateConnectionsForClientRename(const std::string& oldClientName, const std::string& newClientName);
 
-    // Get input samples from JACK input port
-    std::vector<float> getInputSamples() const;
+    // Get the input port samples received since the previous call (mono).
+    // At most the last kInputHistorySamples are kept; older ones are dropped.
+    // Advances the read position: call from one thread only.
+    static constexpr size_t kInputHistorySamples = 1 << 16;
+    std::vector<float> getInputSamples();
 
     // Process input samples through KeepAliveMonitor (called from JACK thread)
     void processKeepAliveInput();
@@ -8,11 +8,14 @@
 AudioEnginePlay::AudioEnginePlay()
 {
     std::atomic_store(&m_voiceSnapshot, std::make_shared<std::vector<std::shared_ptr<Voice>>>());
+    for (int b = 0; b < kMaxBuses; ++b) {
+        m_busGain[b].store(1.0f);
+    }
 }
 
 AudioEnginePlay::~AudioEnginePlay() = default;
 
-void AudioEnginePlay::addVoice(std::vector<float>&& buf, int sampleRate, int channels, const std::string& id, float gain)
+void AudioEnginePlay::addVoice(std::vector<float>&& buf, int sampleRate, int channels, const std::string& id, float gain, int bus)
 {
     auto v = std::make_shared<Voice>();
     v->buf = std::make_shared<std::vector<float>>(std::move(buf));
@@ -22,14 +25,67 @@ void AudioEnginePlay::addVoice(std::vector<float>&& buf, int sampleRate, int cha
     v->pos.store(0);
     v->id = id;
     v->gain.store(gain);
+    v->bus.store(bus);
 
     {
         std::lock_guard<std::mutex> lk(m_lock);
+        v->handle = internLocked(id);
         m_voices.push_back(v);
-        // publish snapshot
-        auto snap = std::make_shared<std::vector<std::shared_ptr<Voice>>>(m_voices);
-        std::atomic_store(&m_voiceSnapshot, snap);
+        publishLocked();
+    }
+}
+
+void AudioEnginePlay::startVoices(std::vector<VoiceStart>&& starts)
+{
+    if (starts.empty()) return;
+    std::vector<std::shared_ptr<Voice>> fresh;
+    fresh.reserve(starts.size());
+    for (auto& st : starts) {
+        auto v = std::make_shared<Voice>();
+        v->buf = std::make_shared<std::vector<float>>(std::move(st.buf));
+        v->channels = st.channels;
+        v->sampleRate = st.sampleRate;
+        if (st.channels > 0) v->totalFrames = v->buf->size() / static_cast<size_t>(st.channels);
+        v->id = st.id;
+        v->gain.store(st.gain);
+        v->bus.store(st.bus);
+        v->delay.store(st.delayFrames);
+        fresh.push_back(std::move(v));
+    }
+
+    std::lock_guard<std::mutex> lk(m_lock);
+    for (auto& v : fresh) {
+        v->handle = internLocked(v->id);
+        // Restarting replaces the playing voice with a new one that shares its
+        // buffer; mutating the old voice in place could let the mixer start it
+        // a block earlier than the rest of the batch
+        bool replaced = false;
+        if (!v->id.empty()) {
+            for (auto& existing : m_voices) {
+                if (existing && existing->id == v->id) {
+                    v->buf = existing->buf;
+                    v->channels = existing->channels;
+                    v->sampleRate = existing->sampleRate;
+                    v->totalFrames = existing->totalFrames;
+                    if (!replaced) {
+                        existing = v;
+                        replaced = true;
+                    } else {
+                        existing.reset();
+                    }
+                }
+            }
+            m_voices.erase(std::remove(m_voices.begin(), m_voices.end(), nullptr), m_voices.end());
+        }
+        if (!replaced) m_voices.push_back(v);
     }
+    publishLocked();
+}
+
+void AudioEnginePlay::publishLocked()
+{
+    auto snap = std::make_shared<std::vector<std::shared_ptr<Voice>>>(m_voices);
+    std::atomic_store(&m_voiceSnapshot, snap);
 }
 
 AudioEnginePlay::PlaybackInfo AudioEnginePlay::getPlaybackInfoById(const std::string& id) const
@@ -47,6 +103,7 @@ AudioEnginePlay::PlaybackInfo AudioEnginePlay::getPlaybackInfoById(const std::st
             out.frames = frames;
             out.sampleRate = v->sampleRate;
             out.totalFrames = v->totalFrames;
+            out.startFrame = v->startFrame.load();
             // previously wrote debug info to /tmp; removed per request
             return out;
         }
@@ -54,6 +111,63 @@ AudioEnginePlay::PlaybackInfo AudioEnginePlay::getPlaybackInfoById(const std::st
     return out;
 }
 
+uint64_t AudioEnginePlay::internLocked(const std::string& id)
+{
+    if (id.empty()) return 0;
+    auto it = m_handles.find(id);
+    if (it != m_handles.end()) return it->second;
+    const uint64_t handle = m_nextHandle++;
+    m_handles.emplace(id, handle);
+    return handle;
+}
+
+void AudioEnginePlay::pruneHandlesLocked()
+{
+    std::vector<uint64_t> live;
+    live.reserve(m_voices.size());
+    for (auto& v : m_voices) {
+        if (v && v->handle != 0) live.push_back(v->handle);
+    }
+    std::sort(live.begin(), live.end());
+    bool pruned = false;
+    for (auto it = m_handles.begin(); it != m_handles.end();) {
+        if (!std::binary_search(live.begin(), live.end(), it->second)) {
+            it = m_handles.erase(it);
+            pruned = true;
+        } else {
+            ++it;
+        }
+    }
+    if (pruned) m_handleGeneration.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t AudioEnginePlay::voiceHandle(const std::string& id)
+{
+    std::lock_guard<std::mutex> lk(m_lock);
+    return internLocked(id);
+}
+
+size_t AudioEnginePlay::fillPlaybackSnapshot(VoicePosition* out, size_t capacity) const
+{
+    auto snap = std::atomic_load(&m_voiceSnapshot);
+    if (!snap) return 0;
+    size_t count = 0;
+    for (auto& v : *snap) {
+        if (!v) continue;
+        if (count < capacity) {
+            VoicePosition& p = out[count];
+            const int ch = v->channels > 0 ? v->channels : 1;
+            p.handle = v->handle;
+            p.frames = v->pos.load() / static_cast<size_t>(ch);
+            p.totalFrames = v->totalFrames;
+            p.sampleRate = v->sampleRate;
+            p.startFrame = v->startFrame.load();
+        }
+        ++count;
+    }
+    return count;
+}
+
 bool AudioEnginePlay::restartVoicesById(const std::string& id)
 {
     bool restarted = false;
@@ -61,6 +175,8 @@ bool AudioEnginePlay::restartVoicesById(const std::string& id)
     for (auto& v : m_voices) {
         if (!id.empty() && v->id == id) {
             v->pos.store(0);
+            v->delay.store(0);
+            v->startFrame.store(-1);
             restarted = true;
         }
     }
@@ -88,11 +204,36 @@ void AudioEnginePlay::setGainById(const std::string& id, float gain)
     }
 }
 
+void AudioEnginePlay::setBusById(const std::string& id, int bus)
+{
+    // Bus is atomic and read once per block by the mixer, so no new snapshot is needed
+    std::lock_guard<std::mutex> lk(m_lock);
+    for (auto& v : m_voices) {
+        if (v && !id.empty() && v->id == id) {
+            v->bus.store(bus);
+        }
+    }
+}
+
+void AudioEnginePlay::setBusGain(int bus, float gain)
+{
+    if (bus < 0 || bus >= kMaxBuses) return;
+    if (gain < 0.0f) gain = 0.0f;
+    m_busGain[bus].store(gain);
+}
+
+float AudioEnginePlay::busGain(int bus) const
+{
+    if (bus < 0 || bus >= kMaxBuses) return 0.0f;
+    return m_busGain[bus].load();
+}
+
 void AudioEnginePlay::clear()
 {
     std::lock_guard<std::mutex> lk(m_lock);
     m_voices.clear();
     std::atomic_store(&m_voiceSnapshot, std::make_shared<std::vector<std::shared_ptr<Voice>>>());
+    pruneHandlesLocked();
 }
 
 void AudioEnginePlay::stopVoicesById(const std::string& id)
@@ -110,6 +251,7 @@ void AudioEnginePlay::stopVoicesById(const std::string& id)
         auto snap = std::make_shared<std::vector<std::shared_ptr<Voice>>>(m_voices);
         std::atomic_store(&m_voiceSnapshot, snap);
     }
+    pruneHandlesLocked();
 }
 
 void AudioEnginePlay::process(float** outputs, int nframes, int nOutChannels)
@@ -118,51 +260,80 @@ void AudioEnginePlay::process(float** outputs, int nframes, int nOutChannels)
     for (int ch = 0; ch < nOutChannels; ++ch) {
         std::memset(outputs[ch], 0, sizeof(float) * nframes);
     }
+    if (nOutChannels <= 0 || nframes <= 0)
+        return;
+
+    const int nBuses = std::min((nOutChannels + 1) / 2, kMaxBuses);
+    const uint64_t blockStart = m_framesProcessed.load(std::memory_order_relaxed);
+    m_framesProcessed.store(blockStart + static_cast<uint64_t>(nframes), std::memory_order_relaxed);
 
     auto snap = std::atomic_load(&m_voiceSnapshot);
     if (!snap || snap->empty())
         return;
 
-    // Mix all voices into outputs
+    // Mix each voice into the single bus it is routed to
     for (auto& v : *snap) {
         if (!v || !v->buf) continue;
         const std::vector<float>& b = *v->buf;
         size_t bsize = b.size();
         size_t pos = v->pos.load();
         int channels = v->channels;
+        if (channels <= 0 || pos >= bsize) continue;
 
-        for (int i = 0; i < nframes; ++i) {
-            if (pos >= bsize) break;
-
-            float left = 0.0f;
-            float right = 0.0f;
-            if (channels == 1) {
-                left = right = b[pos++];
-            } else {
-                left = b[pos++];
-                if (pos < bsize) right = b[pos++]; else right = 0.0f;
-                for (int c = 2; c < channels; ++c) {
-                    if (pos < bsize) pos++; else break;
-                }
-            }
+        // The first block that sees a voice fixes its start frame; a batch
+        // offset delays it within this block or into a later one
+        size_t delay = v->delay.load();
+        if (v->startFrame.load() < 0) {
+            v->startFrame.store(static_cast<int64_t>(blockStart + delay));
+        }
+        if (delay >= static_cast<size_t>(nframes)) {
+            v->delay.store(delay - static_cast<size_t>(nframes));
+            continue;
+        }
+        if (delay > 0) v->delay.store(0);
+        const int dstOffset = static_cast<int>(delay);
+        const int avail = nframes - dstOffset;
+
+        int bus = v->bus.load();
+        if (bus < 0 || bus >= nBuses) bus = 0;
+        float* dstL = outputs[2 * bus] + dstOffset;
+        float* dstR = (2 * bus + 1 < nOutChannels) ? outputs[2 * bus + 1] + dstOffset : nullptr;
 
-            // Apply per-voice gain (load atomically)
-            float g = v->gain.load();
-            left *= g;
-            right *= g;
-            if (nOutChannels > 0) outputs[0][i] += left;
-            if (nOutChannels > 1) outputs[1][i] += right;
+        // Apply per-voice gain (load atomically once per block)
+        const float g = v->gain.load();
+        const size_t framesLeft = (bsize - pos) / static_cast<size_t>(channels);
+        const int n = static_cast<int>(std::min<size_t>(static_cast<size_t>(avail), framesLeft));
+        const float* src = b.data() + pos;
+
+        if (channels == 1) {
+            for (int i = 0; i < n; ++i) dstL[i] += src[i] * g;
+            if (dstR) {
+                for (int i = 0; i < n; ++i) dstR[i] += src[i] * g;
+            }
+        } else {
+            // Extra channels beyond the first two are skipped
+            for (int i = 0; i < n; ++i) dstL[i] += src[static_cast<size_t>(i) * channels] * g;
+            if (dstR) {
+                for (int i = 0; i < n; ++i) dstR[i] += src[static_cast<size_t>(i) * channels + 1] * g;
+            }
         }
 
+        pos += static_cast<size_t>(n) * static_cast<size_t>(channels);
+        // A trailing partial frame can never be played; treat it as the end
+        if (n < avail && pos < bsize) pos = bsize;
         v->pos.store(pos);
     }
 
-    // Simple clipping to [-1,1]
+    // Per-bus gain, then simple clipping to [-1,1]
     for (int ch = 0; ch < nOutChannels; ++ch) {
+        int bus = std::min(ch / 2, kMaxBuses - 1);
+        const float bg = m_busGain[bus].load();
+        float* out = outputs[ch];
         for (int i = 0; i < nframes; ++i) {
-            float v = outputs[ch][i];
-            if (v > 1.0f) outputs[ch][i] = 1.0f;
-            else if (v < -1.0f) outputs[ch][i] = -1.0f;
+            float v = out[i] * bg;
+            if (v > 1.0f) v = 1.0f;
+            else if (v < -1.0f) v = -1.0f;
+            out[i] = v;
         }
     }
 }
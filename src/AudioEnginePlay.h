@@ -5,16 +5,42 @@
 #include <memory>
 #include <string>
 #include <mutex>
+#include <cstdint>
+#include <unordered_map>
+
+#include "VoicePosition.h"
 
 class AudioEnginePlay
 {
 public:
+    // Maximum number of stereo output buses the mixer can route to. The engine
+    // registers one JACK port pair per configured bus (see AudioEngine::init).
+    static constexpr int kMaxBuses = 8;
+
     AudioEnginePlay();
     ~AudioEnginePlay();
 
     // Add a new voice for playback (appends). If `id` is non-empty, it is used
-    // to identify/restart the voice on subsequent requests.
-    void addVoice(std::vector<float>&& buf, int sampleRate, int channels, const std::string& id = std::string(), float gain = 1.0f);
+    // to identify/restart the voice on subsequent requests. `bus` selects the
+    // stereo output bus the voice is mixed into (clamped at mix time).
+    void addVoice(std::vector<float>&& buf, int sampleRate, int channels, const std::string& id = std::string(), float gain = 1.0f, int bus = 0);
+
+    // One voice of a batch for startVoices()
+    struct VoiceStart {
+        std::vector<float> buf;       // interleaved, already at the mixer sample rate
+        int sampleRate = 0;
+        int channels = 0;
+        std::string id;
+        float gain = 1.0f;
+        int bus = 0;
+        size_t delayFrames = 0;       // frames to wait after the batch's first mixed frame
+    };
+
+    // Start several voices under one lock and publish them with a single
+    // snapshot, so the mixer picks all of them up in the same block. A voice
+    // whose id is already playing restarts from the beginning (its new buffer
+    // is ignored, as with restartVoicesById()).
+    void startVoices(std::vector<VoiceStart>&& starts);
 
     // Restart any existing voice(s) matching id (set position to 0). Returns true if any restarted.
     bool restartVoicesById(const std::string& id);
@@ -25,9 +51,22 @@ public:
     void setGainById(const std::string& id, float gain);
     void stopVoicesById(const std::string& id);
 
-    // Called by real-time thread to fill output (mixes active voices)
+    // Route voices matching id to another output bus
+    void setBusById(const std::string& id, int bus);
+
+    // Per-bus gain applied after all voices of a bus have been accumulated
+    void setBusGain(int bus, float gain);
+    float busGain(int bus) const;
+
+    // Called by real-time thread to fill output (mixes active voices).
+    // `outputs` holds stereo pairs per bus: outputs[2*b] is the left and
+    // outputs[2*b+1] the right channel of bus b. Each voice is accumulated into
+    // exactly one bus, so per-voice cost does not depend on the bus count.
     void process(float** outputs, int nframes, int nOutChannels);
 
+    // Total frames mixed by process() so far (the mixer's frame clock)
+    uint64_t framesProcessed() const { return m_framesProcessed.load(); }
+
 private:
     struct Voice {
         std::shared_ptr<std::vector<float>> buf;
@@ -36,9 +75,18 @@ private:
         int sampleRate = 0;
         size_t totalFrames = 0;
         std::string id;
+        uint64_t handle = 0;        // interned id, see voiceHandle()
         std::atomic<float> gain{1.0f};
+        std::atomic<int> bus{0};
+        // Frames of silence before the voice starts (batch offsets)
+        std::atomic<size_t> delay{0};
+        // Mixer frame at which the first sample plays; -1 until first mixed
+        std::atomic<int64_t> startFrame{-1};
     };
 
+    // Publish m_voices to the RT thread; m_lock must be held
+    void publishLocked();
+
     std::mutex m_lock; // protects m_voices when adding/removing
     std::vector<std::shared_ptr<Voice>> m_voices;
 
@@ -47,14 +95,43 @@ private:
     // thread-safe publication without making the shared_ptr itself atomic.
     std::shared_ptr<std::vector<std::shared_ptr<Voice>>> m_voiceSnapshot;
 
+    std::atomic<float> m_busGain[kMaxBuses];
+    std::atomic<uint64_t> m_framesProcessed{0};
+
 public:
     struct PlaybackInfo {
         bool found = false;
         uint64_t frames = 0; // frames (not interleaved samples)
         int sampleRate = 0;
         uint64_t totalFrames = 0; // total frames in the buffer, if known
+        int64_t startFrame = -1;  // mixer frame the voice started at; -1 if not yet mixed
     };
 
     // Thread-safe query (lock-free read of snapshot) to get playback info for a given id
     PlaybackInfo getPlaybackInfoById(const std::string& id) const;
+
+    // Position of one voice, as filled by fillPlaybackSnapshot()
+    using VoicePosition = ::VoicePosition;
+
+    // Stable handle for a voice id, interned on first use (0 for an empty
+    // id). Lets callers match voices without string compares. Ids without a
+    // voice are dropped when voices are stopped or cleared, which bumps
+    // voiceHandleGeneration(): handles resolved before then must be looked up
+    // again. Handles are never reused.
+    uint64_t voiceHandle(const std::string& id);
+    uint64_t voiceHandleGeneration() const { return m_handleGeneration.load(std::memory_order_acquire); }
+
+    // Every voice of the current snapshot in one lock-free pass. Writes at
+    // most `capacity` entries and returns the voice count, which may exceed
+    // `capacity`: grow the array and call again.
+    size_t fillPlaybackSnapshot(VoicePosition* out, size_t capacity) const;
+
+private:
+    // Interned voice ids (guarded by m_lock); handles start at 1
+    std::unordered_map<std::string, uint64_t> m_handles;
+    uint64_t m_nextHandle = 1;
+    std::atomic<uint64_t> m_handleGeneration{0};
+    uint64_t internLocked(const std::string& id);
+    // Drop interned ids that no voice in m_voices uses; m_lock must be held
+    void pruneHandlesLocked();
 };
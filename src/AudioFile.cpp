@@ -7,6 +7,18 @@
 #include <mpg123.h>
 #include <iostream>
 
+namespace {
+
+// mpg123_init() is only needed once per process; never paired with
+// mpg123_exit() because decodes run concurrently on several threads
+bool initMpg123()
+{
+    static const bool ok = mpg123_init() == MPG123_OK;
+    return ok;
+}
+
+} // namespace
+
 AudioFile::AudioFile(const QString& path)
     : m_path(path)
 {
@@ -47,7 +59,7 @@ bool AudioFile::readAllSamples(std::vector<float>& outSamples, int& sampleRate,
 
     // Fallback to mpg123 for mp3
     mpg123_handle* mh = nullptr;
-    if (mpg123_init() == MPG123_OK) {
+    if (initMpg123()) {
         int err = 0;
         mh = mpg123_new(NULL, &err);
         if (mh) {
@@ -89,7 +101,6 @@ bool AudioFile::readAllSamples(std::vector<float>& outSamples, int& sampleRate,
                 free(buffer);
                 mpg123_close(mh);
                 mpg123_delete(mh);
-                mpg123_exit();
 
                 if (raw.empty()) {
                     return false;
@@ -124,8 +135,147 @@ bool AudioFile::readAllSamples(std::vector<float>& outSamples, int& sampleRate,
             }
             mpg123_delete(mh);
         }
-        mpg123_exit();
     }
 
     return false;
 }
+
+AudioFileReader::~AudioFileReader()
+{
+    close();
+}
+
+bool AudioFileReader::open(const QString& path, bool fastSeek)
+{
+    close();
+    if (path.isEmpty()) return false;
+    QByteArray ba = path.toLocal8Bit();
+    const char* cpath = ba.constData();
+
+    // Try libsndfile first (handles WAV, FLAC, OGG if compiled)
+    SF_INFO sfinfo;
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    m_snd = sf_open(cpath, SFM_READ, &sfinfo);
+    if (m_snd) {
+        m_sampleRate = sfinfo.samplerate;
+        m_channels = sfinfo.channels;
+        m_frames = sfinfo.frames;
+        if (m_sampleRate <= 0 || m_channels <= 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Fallback to mpg123 for mp3
+    if (!initMpg123()) return false;
+    int err = 0;
+    m_mpg = mpg123_new(nullptr, &err);
+    if (!m_mpg) return false;
+    // Fuzzy seeks estimate positions from the bitrate/TOC instead of
+    // parsing every frame up to the target
+    if (fastSeek) mpg123_param(m_mpg, MPG123_ADD_FLAGS, MPG123_FUZZY, 0.0);
+
+    // Ask for float output at every rate; older builds without float
+    // support fall back to 16-bit ints
+    const long* rates = nullptr;
+    size_t rateCount = 0;
+    mpg123_rates(&rates, &rateCount);
+    mpg123_format_none(m_mpg);
+    m_mpgFloat = true;
+    for (size_t i = 0; i < rateCount; ++i) {
+        if (mpg123_format(m_mpg, rates[i], MPG123_MONO | MPG123_STEREO, MPG123_ENC_FLOAT_32) != MPG123_OK) {
+            m_mpgFloat = false;
+            break;
+        }
+    }
+    if (!m_mpgFloat) {
+        mpg123_format_none(m_mpg);
+        for (size_t i = 0; i < rateCount; ++i) {
+            mpg123_format(m_mpg, rates[i], MPG123_MONO | MPG123_STEREO, MPG123_ENC_SIGNED_16);
+        }
+    }
+
+    long rate = 0;
+    int chs = 0;
+    int enc = 0;
+    if (mpg123_open(m_mpg, cpath) != MPG123_OK || mpg123_getformat(m_mpg, &rate, &chs, &enc) != MPG123_OK
+        || rate <= 0 || chs <= 0) {
+        close();
+        return false;
+    }
+    m_sampleRate = static_cast<int>(rate);
+    m_channels = chs;
+    m_mpgFloat = (enc & MPG123_ENC_FLOAT_32) == MPG123_ENC_FLOAT_32;
+
+    // Exact for files with a Xing/Info header, estimated from the first
+    // frame otherwise; scanning is only needed when no estimate is possible
+    off_t length = mpg123_length(m_mpg);
+    if (length <= 0 && mpg123_scan(m_mpg) == MPG123_OK) length = mpg123_length(m_mpg);
+    m_frames = length > 0 ? static_cast<qint64>(length) : 0;
+    return true;
+}
+
+void AudioFileReader::close()
+{
+    if (m_snd) {
+        sf_close(m_snd);
+        m_snd = nullptr;
+    }
+    if (m_mpg) {
+        mpg123_close(m_mpg);
+        mpg123_delete(m_mpg);
+        m_mpg = nullptr;
+    }
+    m_raw.clear();
+    m_raw.shrink_to_fit();
+    m_sampleRate = 0;
+    m_channels = 0;
+    m_frames = 0;
+}
+
+qint64 AudioFileReader::read(float* out, qint64 maxFrames)
+{
+    if (!out || maxFrames <= 0) return 0;
+    if (m_snd) {
+        const sf_count_t got = sf_readf_float(m_snd, out, maxFrames);
+        return got > 0 ? static_cast<qint64>(got) : 0;
+    }
+    if (!m_mpg) return 0;
+
+    const size_t sampleBytes = m_mpgFloat ? sizeof(float) : sizeof(short);
+    const size_t wantBytes = static_cast<size_t>(maxFrames) * m_channels * sampleBytes;
+    unsigned char* dst = m_mpgFloat ? reinterpret_cast<unsigned char*>(out) : nullptr;
+    if (!dst) {
+        if (m_raw.size() < wantBytes) m_raw.resize(wantBytes);
+        dst = m_raw.data();
+    }
+
+    size_t filled = 0;
+    while (filled < wantBytes) {
+        size_t done = 0;
+        const int r = mpg123_read(m_mpg, dst + filled, wantBytes - filled, &done);
+        filled += done;
+        if (r == MPG123_OK || r == MPG123_NEW_FORMAT) {
+            if (done == 0 && r == MPG123_OK) break;
+            continue;
+        }
+        // MPG123_DONE or an error: return what we have
+        break;
+    }
+
+    const qint64 frames = static_cast<qint64>(filled / (sampleBytes * m_channels));
+    if (!m_mpgFloat) {
+        const short* sdata = reinterpret_cast<const short*>(m_raw.data());
+        for (qint64 i = 0; i < frames * m_channels; ++i) out[i] = static_cast<float>(sdata[i]) / 32768.0f;
+    }
+    return frames;
+}
+
+bool AudioFileReader::seek(qint64 frame)
+{
+    if (frame < 0) return false;
+    if (m_snd) return sf_seek(m_snd, frame, SEEK_SET) >= 0;
+    if (m_mpg) return mpg123_seek(m_mpg, static_cast<off_t>(frame), SEEK_SET) >= 0;
+    return false;
+}
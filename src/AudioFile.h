@@ -1,6 +1,10 @@
 #pragma once
 
 #include <QString>
+#include <vector>
+
+struct SNDFILE_tag;
+struct mpg123_handle_struct;
 
 /**
  * AudioFile helper — stub for loading metadata and paths.
@@ -24,3 +28,45 @@ public:
 private:
     QString m_path;
 };
+
+/**
+ * AudioFileReader — incremental decoder for long files.
+ *
+ * Opens a file with libsndfile, or with mpg123 when libsndfile cannot read it
+ * (MP3 on many builds), and hands out interleaved float frames a chunk at a
+ * time. Memory stays bounded by the chunk size, whatever the file length.
+ */
+class AudioFileReader
+{
+public:
+    AudioFileReader() = default;
+    ~AudioFileReader();
+
+    // `fastSeek` trades seek accuracy for speed on MP3 (estimated positions
+    // instead of scanning frames), for callers that only sample the file
+    bool open(const QString& path, bool fastSeek = false);
+    void close();
+    bool isOpen() const { return m_snd || m_mpg; }
+
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+    // Total frames reported by the container; an estimate for some MP3s
+    qint64 frames() const { return m_frames; }
+
+    // Decode up to `maxFrames` frames into `out` (interleaved). Returns the
+    // number of frames read; 0 at the end of the file or on error.
+    qint64 read(float* out, qint64 maxFrames);
+    // Continue reading at `frame`; returns false if the decoder cannot seek
+    bool seek(qint64 frame);
+
+private:
+    Q_DISABLE_COPY(AudioFileReader)
+
+    SNDFILE_tag* m_snd = nullptr;
+    mpg123_handle_struct* m_mpg = nullptr;
+    bool m_mpgFloat = true;                 // false: mpg123 delivers 16-bit ints
+    std::vector<unsigned char> m_raw;       // mpg123 output staging buffer
+    int m_sampleRate = 0;
+    int m_channels = 0;
+    qint64 m_frames = 0;
+};
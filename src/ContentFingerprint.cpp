@@ -0,0 +1,112 @@
+#include "ContentFingerprint.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <cstring>
+#include <sys/stat.h>
+
+std::atomic<bool> ContentFingerprint::s_enabled{false};
+
+namespace {
+
+inline quint64 mix(quint64 h, quint64 v)
+{
+    v *= 0x9E3779B97F4A7C15ULL;
+    v ^= v >> 32;
+    h ^= v;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 29;
+    return h;
+}
+
+quint64 hashBytes(quint64 h, const char* data, qint64 len)
+{
+    qint64 i = 0;
+    for (; i + 8 <= len; i += 8) {
+        quint64 w;
+        std::memcpy(&w, data + i, 8);
+        h = mix(h, w);
+    }
+    if (i < len) {
+        quint64 w = 0;
+        std::memcpy(&w, data + i, static_cast<size_t>(len - i));
+        h = mix(h, w ^ (static_cast<quint64>(len - i) << 56));
+    }
+    return h;
+}
+
+} // namespace
+
+ContentFingerprint& ContentFingerprint::instance()
+{
+    static ContentFingerprint s_instance;
+    return s_instance;
+}
+
+quint64 ContentFingerprint::compute(const QString& path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return 0;
+    const qint64 size = f.size();
+    quint64 h = mix(0x243F6A8885A308D3ULL, static_cast<quint64>(size));
+
+    const qint64 sampled = kHeaderBytes + kSampleBlocks * kSampleBlockBytes;
+    if (size <= sampled) {
+        const QByteArray all = f.readAll();
+        if (all.size() != size) return 0;
+        h = hashBytes(h, all.constData(), all.size());
+    } else {
+        QByteArray buf(kHeaderBytes, Qt::Uninitialized);
+        if (f.read(buf.data(), kHeaderBytes) != kHeaderBytes) return 0;
+        h = hashBytes(h, buf.constData(), kHeaderBytes);
+        // Evenly spaced blocks; the last one ends at the end of the file
+        const qint64 span = size - kHeaderBytes - kSampleBlockBytes;
+        for (int b = 0; b < kSampleBlocks; ++b) {
+            const qint64 offset = kHeaderBytes + span * (b + 1) / kSampleBlocks;
+            if (!f.seek(offset) || f.read(buf.data(), kSampleBlockBytes) != kSampleBlockBytes) return 0;
+            h = hashBytes(h, buf.constData(), kSampleBlockBytes);
+        }
+    }
+    // 0 is reserved for "unreadable"
+    return h ? h : 1;
+}
+
+quint64 ContentFingerprint::of(const QString& path)
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) return 0;
+    QByteArray id(4 * sizeof(qint64), '\0');
+    const qint64 fields[4] = {static_cast<qint64>(st.st_dev), static_cast<qint64>(st.st_ino),
+                              static_cast<qint64>(st.st_size),
+                              static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec};
+    std::memcpy(id.data(), fields, sizeof(fields));
+    {
+        QMutexLocker l(&m_lock);
+        auto it = m_memo.constFind(id);
+        if (it != m_memo.constEnd()) return *it;
+    }
+    // Read outside the lock; a concurrent miss hashes the same bytes
+    const quint64 fp = compute(path);
+    if (fp == 0) return 0;
+    QMutexLocker l(&m_lock);
+    if (m_memo.size() >= kMaxMemo) m_memo.clear();
+    m_memo.insert(id, fp);
+    return fp;
+}
+
+QString ContentFingerprint::toHex(quint64 fingerprint)
+{
+    return QString::number(fingerprint, 16).rightJustified(16, QLatin1Char('0'));
+}
+
+int ContentFingerprint::memoSize()
+{
+    QMutexLocker l(&m_lock);
+    return m_memo.size();
+}
+
+void ContentFingerprint::clear()
+{
+    QMutexLocker l(&m_lock);
+    m_memo.clear();
+}
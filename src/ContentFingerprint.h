@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+
+/**
+ * ContentFingerprint: cheap identity of an audio file's contents.
+ *
+ * Cache keys built from the absolute path and mtime are lost whenever a
+ * library is moved, renamed or remounted, and every copy of a file is cached
+ * separately. The fingerprint is a 64-bit non-cryptographic hash of the file
+ * size, the first 64 KB (the header) and eight 16 KB blocks spread over the
+ * rest of the file, so it costs a handful of small reads regardless of the
+ * file length. Fingerprints are memoised per device/inode/size/mtime, so a
+ * file is only read again after it changes on disk.
+ *
+ * Being sampled, it does not notice an edit that keeps the size and touches
+ * no sampled block; content keys can be turned off in the preferences.
+ */
+class ContentFingerprint {
+public:
+    static constexpr qint64 kHeaderBytes = 64 * 1024;
+    static constexpr int kSampleBlocks = 8;
+    static constexpr qint64 kSampleBlockBytes = 16 * 1024;
+
+    static ContentFingerprint& instance();
+
+    // Whether caches key entries by content (set from the preferences)
+    static void setEnabled(bool enabled) { s_enabled.store(enabled); }
+    static bool enabled() { return s_enabled.load(); }
+
+    // Memoised fingerprint of `path`; 0 if it cannot be read
+    quint64 of(const QString& path);
+    // Hash the file without consulting the memo
+    static quint64 compute(const QString& path);
+    static QString toHex(quint64 fingerprint);
+
+    int memoSize();
+    void clear();
+
+private:
+    ContentFingerprint() = default;
+    Q_DISABLE_COPY(ContentFingerprint)
+
+    static constexpr int kMaxMemo = 16384;
+
+    QMutex m_lock;
+    QHash<QByteArray, quint64> m_memo;      // dev/inode/size/mtime -> fingerprint
+    static std::atomic<bool> s_enabled;
+};
@@ -0,0 +1,123 @@
+#include "DecodedAudioCache.h"
+#include "ContentFingerprint.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+DecodedAudioCache& DecodedAudioCache::instance()
+{
+    static DecodedAudioCache cache;
+    return cache;
+}
+
+QString DecodedAudioCache::keyFor(const QString& path, bool* contentKeyed)
+{
+    if (contentKeyed) *contentKeyed = false;
+    if (!ContentFingerprint::enabled()) return path;
+    const quint64 fp = ContentFingerprint::instance().of(path);
+    if (fp == 0) return path;
+    if (contentKeyed) *contentKeyed = true;
+    return QStringLiteral("content:") + ContentFingerprint::toHex(fp);
+}
+
+bool DecodedAudioCache::lookup(const QString& path, Entry* out)
+{
+    QFileInfo fi(path);
+    const QString key = keyFor(path);
+    QMutexLocker l(&m_lock);
+    auto it = m_items.find(key);
+    if (it == m_items.end()) return false;
+    // Stale if the file changed on disk since it was decoded
+    if (!it->contentKeyed
+        && (!fi.exists() || fi.size() != it->fileSize || fi.lastModified().toMSecsSinceEpoch() != it->mtime)) {
+        removeLocked(it);
+        return false;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->lru);
+    if (out) *out = it->entry;
+    return true;
+}
+
+DecodedAudioCache::Entry DecodedAudioCache::insert(const QString& path, std::vector<float>&& samples, int sampleRate, int channels)
+{
+    QFileInfo fi(path);
+    Entry entry;
+    entry.samples = std::make_shared<const std::vector<float>>(std::move(samples));
+    entry.sampleRate = sampleRate;
+    entry.channels = channels;
+    bool contentKeyed = false;
+    const QString key = keyFor(path, &contentKeyed);
+
+    QMutexLocker l(&m_lock);
+    auto existing = m_items.find(key);
+    if (existing != m_items.end()) removeLocked(existing);
+
+    Item item;
+    item.entry = entry;
+    item.contentKeyed = contentKeyed;
+    item.fileSize = fi.size();
+    item.mtime = fi.lastModified().toMSecsSinceEpoch();
+    item.bytes = static_cast<qint64>(entry.samples->size() * sizeof(float));
+    m_lru.push_front(key);
+    item.lru = m_lru.begin();
+    m_bytes += item.bytes;
+    m_items.insert(key, item);
+    evictLocked();
+    return entry;
+}
+
+void DecodedAudioCache::remove(const QString& path)
+{
+    const QString key = keyFor(path);
+    QMutexLocker l(&m_lock);
+    auto it = m_items.find(key);
+    if (it != m_items.end()) removeLocked(it);
+}
+
+void DecodedAudioCache::clear()
+{
+    QMutexLocker l(&m_lock);
+    m_items.clear();
+    m_lru.clear();
+    m_bytes = 0;
+}
+
+void DecodedAudioCache::setCapacityBytes(qint64 bytes)
+{
+    QMutexLocker l(&m_lock);
+    m_capacity = bytes < 0 ? 0 : bytes;
+    evictLocked();
+}
+
+qint64 DecodedAudioCache::capacityBytes() const
+{
+    QMutexLocker l(&m_lock);
+    return m_capacity;
+}
+
+qint64 DecodedAudioCache::sizeBytes() const
+{
+    QMutexLocker l(&m_lock);
+    return m_bytes;
+}
+
+void DecodedAudioCache::evictLocked()
+{
+    // Keep at least the most recent entry even if it alone exceeds the capacity
+    while (m_bytes > m_capacity && m_lru.size() > 1) {
+        auto it = m_items.find(m_lru.back());
+        if (it == m_items.end()) {
+            m_lru.pop_back();
+            continue;
+        }
+        removeLocked(it);
+    }
+}
+
+void DecodedAudioCache::removeLocked(QHash<QString, Item>::iterator it)
+{
+    m_bytes -= it->bytes;
+    m_lru.erase(it->lru);
+    m_items.erase(it);
+}
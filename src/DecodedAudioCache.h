@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <list>
+#include <memory>
+#include <vector>
+
+/**
+ * DecodedAudioCache: in-memory cache of decoded (interleaved float) audio.
+ *
+ * Playback used to decode the file on every trigger. Entries are keyed by
+ * path and validated against the file's size and mtime, so an edited file is
+ * decoded again. Least recently used entries are evicted once the total
+ * exceeds the capacity. Freshly recorded takes are inserted directly, so they
+ * play without re-decoding the file that was just written.
+ *
+ * With content keys enabled (ContentFingerprint) entries are keyed by the
+ * file's fingerprint instead, so copies and moved files share one entry.
+ */
+class DecodedAudioCache {
+public:
+    struct Entry {
+        std::shared_ptr<const std::vector<float>> samples;
+        int sampleRate = 0;
+        int channels = 0;
+    };
+
+    static DecodedAudioCache& instance();
+
+    // Returns true and fills `out` if a valid entry exists for `path`
+    bool lookup(const QString& path, Entry* out);
+    // Insert or replace the entry for `path` (the file must exist)
+    Entry insert(const QString& path, std::vector<float>&& samples, int sampleRate, int channels);
+    void remove(const QString& path);
+    void clear();
+
+    void setCapacityBytes(qint64 bytes);        // default 256 MB
+    qint64 capacityBytes() const;
+    qint64 sizeBytes() const;
+
+private:
+    DecodedAudioCache() = default;
+    Q_DISABLE_COPY(DecodedAudioCache)
+
+    struct Item {
+        Entry entry;
+        bool contentKeyed = false;      // validated by the key itself
+        qint64 fileSize = 0;
+        qint64 mtime = 0;
+        qint64 bytes = 0;
+        std::list<QString>::iterator lru;
+    };
+
+    static QString keyFor(const QString& path, bool* contentKeyed = nullptr);
+    void evictLocked();
+    void removeLocked(QHash<QString, Item>::iterator it);
+
+    mutable QMutex m_lock;
+    QHash<QString, Item> m_items;               // path or "content:<fingerprint>"
+    std::list<QString> m_lru;                   // front = most recently used
+    qint64 m_bytes = 0;
+    qint64 m_capacity = 256LL * 1024 * 1024;
+};
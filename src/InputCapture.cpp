@@ -0,0 +1,163 @@
+#include "InputCapture.h"
+
+#include <sndfile.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+InputCapture::InputCapture() = default;
+
+InputCapture::~InputCapture()
+{
+    disarm();
+}
+
+bool InputCapture::arm(int sampleRate)
+{
+    if (state() != State::Idle || sampleRate <= 0) return false;
+    m_sampleRate = sampleRate;
+    m_chunks.assign(kMaxChunks, nullptr);
+    m_chunkCount.store(0);
+    m_currentFill = 0;
+    m_capturedFrames.store(0);
+    m_droppedFrames.store(0);
+    m_poolHead.store(0);
+    m_poolTail.store(0);
+
+    // Fill the pool up front so recording can start immediately
+    for (size_t i = 0; i < kPoolTarget; ++i) {
+        m_pool[i] = new Chunk;
+    }
+    m_poolTail.store(kPoolTarget);
+
+    m_refillRun.store(true);
+    m_refill = std::thread([this]() { refillLoop(); });
+    m_state.store(static_cast<int>(State::Armed));
+    return true;
+}
+
+void InputCapture::record()
+{
+    int expected = static_cast<int>(State::Armed);
+    m_state.compare_exchange_strong(expected, static_cast<int>(State::Recording));
+}
+
+std::vector<float> InputCapture::stop()
+{
+    std::vector<float> out;
+    if (state() == State::Idle) return out;
+    m_state.store(static_cast<int>(State::Idle));
+    m_refillRun.store(false);
+    if (m_refill.joinable()) m_refill.join();
+
+    const size_t count = m_chunkCount.load();
+    const size_t total = static_cast<size_t>(m_capturedFrames.load());
+    out.reserve(total);
+    for (size_t c = 0; c < count; ++c) {
+        const size_t n = (c + 1 == count) ? m_currentFill : kChunkFrames;
+        out.insert(out.end(), m_chunks[c]->frames, m_chunks[c]->frames + n);
+    }
+    releaseAll();
+    return out;
+}
+
+void InputCapture::disarm()
+{
+    if (state() == State::Idle && !m_refill.joinable()) return;
+    m_state.store(static_cast<int>(State::Idle));
+    m_refillRun.store(false);
+    if (m_refill.joinable()) m_refill.join();
+    releaseAll();
+}
+
+void InputCapture::releaseAll()
+{
+    const size_t count = m_chunkCount.load();
+    for (size_t c = 0; c < count; ++c) {
+        delete m_chunks[c];
+        m_chunks[c] = nullptr;
+    }
+    m_chunkCount.store(0);
+    m_chunks.clear();
+    m_chunks.shrink_to_fit();
+    for (size_t i = m_poolHead.load(); i != m_poolTail.load(); ++i) {
+        delete m_pool[i % kPoolSlots];
+        m_pool[i % kPoolSlots] = nullptr;
+    }
+    m_poolHead.store(0);
+    m_poolTail.store(0);
+    m_currentFill = 0;
+}
+
+InputCapture::Chunk* InputCapture::popPool()
+{
+    const size_t head = m_poolHead.load(std::memory_order_relaxed);
+    if (head == m_poolTail.load(std::memory_order_acquire)) return nullptr;
+    Chunk* c = m_pool[head % kPoolSlots];
+    m_poolHead.store(head + 1, std::memory_order_release);
+    return c;
+}
+
+void InputCapture::refillLoop()
+{
+    while (m_refillRun.load()) {
+        // Keep kPoolTarget empty chunks available to the RT thread
+        while (m_poolTail.load(std::memory_order_relaxed) - m_poolHead.load(std::memory_order_acquire) < kPoolTarget) {
+            const size_t tail = m_poolTail.load(std::memory_order_relaxed);
+            m_pool[tail % kPoolSlots] = new Chunk;
+            m_poolTail.store(tail + 1, std::memory_order_release);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+void InputCapture::pushInput(const float* input, int nframes)
+{
+    if (!input || nframes <= 0) return;
+    if (m_state.load(std::memory_order_relaxed) != static_cast<int>(State::Recording)) return;
+
+    size_t offset = 0;
+    const size_t n = static_cast<size_t>(nframes);
+    while (offset < n) {
+        size_t count = m_chunkCount.load(std::memory_order_relaxed);
+        if (count == 0 || m_currentFill == kChunkFrames) {
+            Chunk* next = count < kMaxChunks ? popPool() : nullptr;
+            if (!next) {
+                m_droppedFrames.fetch_add(n - offset, std::memory_order_relaxed);
+                return;
+            }
+            m_chunks[count] = next;
+            m_chunkCount.store(count + 1, std::memory_order_release);
+            m_currentFill = 0;
+            ++count;
+        }
+        Chunk* cur = m_chunks[count - 1];
+        const size_t take = std::min(n - offset, kChunkFrames - m_currentFill);
+        std::memcpy(cur->frames + m_currentFill, input + offset, take * sizeof(float));
+        m_currentFill += take;
+        offset += take;
+        m_capturedFrames.fetch_add(take, std::memory_order_relaxed);
+    }
+}
+
+bool InputCapture::writeWavFile(const std::string& path, const std::vector<float>& samples, int sampleRate, std::string* error)
+{
+    SF_INFO info;
+    std::memset(&info, 0, sizeof(info));
+    info.samplerate = sampleRate;
+    info.channels = 1;
+    info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    SNDFILE* snd = sf_open(path.c_str(), SFM_WRITE, &info);
+    if (!snd) {
+        if (error) *error = sf_strerror(nullptr);
+        return false;
+    }
+    const sf_count_t frames = static_cast<sf_count_t>(samples.size());
+    const sf_count_t written = sf_writef_float(snd, samples.data(), frames);
+    sf_close(snd);
+    if (written != frames) {
+        if (error) *error = "short write";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * InputCapture: records the JACK input port into memory for record-to-slot.
+ *
+ * Audio is captured into fixed-size chunks. The real-time thread never
+ * allocates: it takes empty chunks from a small lock-free pool that a non-RT
+ * refill thread keeps topped up while the capture is armed. The captured
+ * chunk table is sized once on arm(), so the buffer grows without any
+ * reallocation on the RT side. If the pool runs dry the incoming frames are
+ * dropped and counted.
+ *
+ * Lifecycle: arm() -> record() -> stop(). The engine must be detached
+ * (AudioEngine::setInputCapture(nullptr)) before stop() or disarm().
+ */
+class InputCapture
+{
+public:
+    enum class State { Idle = 0, Armed = 1, Recording = 2 };
+
+    static constexpr size_t kChunkFrames = 32768;   // ~0.7 s per chunk at 48 kHz
+    static constexpr size_t kMaxChunks = 8192;      // ~1.5 h at 48 kHz
+    static constexpr size_t kPoolTarget = 4;        // spare chunks kept ready for RT
+
+    InputCapture();
+    ~InputCapture();
+
+    // Non-RT: preallocate the chunk table and pool and start the refill thread
+    bool arm(int sampleRate);
+    // Start capturing with the next RT block
+    void record();
+    // Non-RT: stop and return the captured mono samples; frees all chunks
+    std::vector<float> stop();
+    // Non-RT: abandon an armed or running capture
+    void disarm();
+
+    State state() const { return static_cast<State>(m_state.load()); }
+    int sampleRate() const { return m_sampleRate; }
+    uint64_t capturedFrames() const { return m_capturedFrames.load(); }
+    uint64_t droppedFrames() const { return m_droppedFrames.load(); }
+
+    // RT: append one block of mono input. Never blocks or allocates.
+    void pushInput(const float* input, int nframes);
+
+    // Write mono float samples to a WAV file (used off the GUI thread)
+    static bool writeWavFile(const std::string& path, const std::vector<float>& samples, int sampleRate, std::string* error = nullptr);
+
+private:
+    struct Chunk {
+        float frames[kChunkFrames];
+    };
+
+    static constexpr size_t kPoolSlots = 16;        // power of two, > kPoolTarget
+
+    Chunk* popPool();                               // RT consumer
+    void refillLoop();                              // refill thread producer
+    void releaseAll();
+
+    std::atomic<int> m_state{static_cast<int>(State::Idle)};
+    int m_sampleRate = 0;
+
+    // Pool of empty chunks: SPSC ring, produced by the refill thread, consumed by RT
+    Chunk* m_pool[kPoolSlots] = {};
+    std::atomic<size_t> m_poolHead{0};              // next slot to pop (RT)
+    std::atomic<size_t> m_poolTail{0};              // next slot to push (refill)
+
+    // Captured chunks in order; sized to kMaxChunks on arm()
+    std::vector<Chunk*> m_chunks;
+    std::atomic<size_t> m_chunkCount{0};
+    size_t m_currentFill = 0;                       // frames used in the last chunk (RT)
+
+    std::atomic<uint64_t> m_capturedFrames{0};
+    std::atomic<uint64_t> m_droppedFrames{0};
+
+    std::thread m_refill;
+    std::atomic<bool> m_refillRun{false};
+};
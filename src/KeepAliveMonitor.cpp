@@ -20,6 +20,16 @@ KeepAliveMonitor::KeepAliveMonitor(QObject* parent)
 KeepAliveMonitor::~KeepAliveMonitor() = default;
 
 void KeepAliveMonitor::processInputSamples(const std::vector<float>& samples, int numFrames, int numChannels)
+{
+    processInputBuffer(samples.data(), static_cast<int>(samples.size()), numFrames, numChannels);
+}
+
+void KeepAliveMonitor::processInputSamples(const float* samples, int numFrames, int numChannels)
+{
+    processInputBuffer(samples, samples ? numFrames * numChannels : 0, numFrames, numChannels);
+}
+
+void KeepAliveMonitor::processInputBuffer(const float* samples, int numSamples, int numFrames, int numChannels)
 {
     if (!m_enabled) {
         m_lastFrameHadSound = false;
@@ -33,8 +43,8 @@ void KeepAliveMonitor::processInputSamples(const std::vector<float>& samples, in
     bool batchHasSound = false;
     if (m_thresholdAmplitude <= 0.0) {
         // Legacy behavior: any non-zero sample counts as sound
-        for (const auto& sample : samples) {
-            if (sample != 0.0f) {
+        for (int i = 0; i < numSamples; ++i) {
+            if (samples[i] != 0.0f) {
                 batchHasSound = true;
                 break;
             }
@@ -42,8 +52,8 @@ void KeepAliveMonitor::processInputSamples(const std::vector<float>& samples, in
     } else {
         // Thresholded behavior: use peak absolute amplitude
         float peak = 0.0f;
-        for (const auto& sample : samples) {
-            float a = std::abs(sample);
+        for (int i = 0; i < numSamples; ++i) {
+            float a = std::abs(samples[i]);
             if (a > peak) peak = a;
             if (peak >= static_cast<float>(m_thresholdAmplitude)) {
                 batchHasSound = true;
@@ -54,7 +64,7 @@ void KeepAliveMonitor::processInputSamples(const std::vector<float>& samples, in
 
     // Also track whether the last frame specifically had sound
     if (numFrames > 0) {
-        m_lastFrameHadSound = frameHasSound(samples, (numFrames - 1) * numChannels, numChannels);
+        m_lastFrameHadSound = frameHasSound(samples, numSamples, (numFrames - 1) * numChannels, numChannels);
     }
 
     if (batchHasSound) {
@@ -94,16 +104,16 @@ void KeepAliveMonitor::setSilenceTimeoutMs(qint64 ms)
     m_silenceTimeoutMs = ms;
 }
 
-bool KeepAliveMonitor::frameHasSound(const std::vector<float>& samples, int frameStart, int numChannels) const
+bool KeepAliveMonitor::frameHasSound(const float* samples, int numSamples, int frameStart, int numChannels) const
 {
-    if (frameStart < 0 || frameStart >= static_cast<int>(samples.size())) {
+    if (!samples || frameStart < 0 || frameStart >= numSamples) {
         return false;
     }
 
     // Check all channels of the given frame
     int sampleCount = frameStart + numChannels;
-    if (sampleCount > static_cast<int>(samples.size())) {
-        sampleCount = samples.size();
+    if (sampleCount > numSamples) {
+        sampleCount = numSamples;
     }
 
     for (int i = frameStart; i < sampleCount; ++i) {
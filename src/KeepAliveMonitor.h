@@ -29,6 +29,8 @@ public:
     // If ANY sample in the batch is non-zero, the silence timer resets.
     // m_lastFrameHadSound tracks whether the last frame specifically had sound.
     void processInputSamples(const std::vector<float>& samples, int numFrames, int numChannels);
+    // Pointer overload used by the JACK callback so no vector has to be built per cycle.
+    void processInputSamples(const float* samples, int numFrames, int numChannels);
 
     // Get current silence duration in seconds
     double silenceDuration() const;
@@ -62,8 +64,11 @@ signals:
 
 private:
 
+    // Shared implementation of both processInputSamples overloads
+    void processInputBuffer(const float* samples, int numSamples, int numFrames, int numChannels);
+
     // Detect if the given frame has any non-zero audio
-    bool frameHasSound(const std::vector<float>& samples, int frameStart, int numChannels) const;
+    bool frameHasSound(const float* samples, int numSamples, int frameStart, int numChannels) const;
 
     // Silence timeout in milliseconds
     qint64 m_silenceTimeoutMs = 60 * 1000;
@@ -46,6 +46,23 @@
 #include "SessionManager.h"
 #include "ShortcutsManager.h"
 #include "DebugLog.h"
+#include "OutputRecorder.h"
+#include "InputCapture.h"
+#include "DecodedAudioCache.h"
+#include "ContentFingerprint.h"
+#include "WaveformPixmapCache.h"
+#include "WaveformWorker.h"
+#include "WaveformJobService.h"
+#include "WaveformCacheProbe.h"
+#include <QPointer>
+#include <QThreadPool>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <memory>
 
 #include <QDateTime>
 #include <QFile>
@@ -57,8 +74,12 @@
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
 {
+    m_startupTimer.start();
     // Apply log level from preferences on startup
     DebugLog::setLevel(static_cast<int>(PreferencesManager::instance().logLevel()));
+    ContentFingerprint::setEnabled(PreferencesManager::instance().cacheContentKeys());
+    WaveformJobService::instance().setMaxThreads(PreferencesManager::instance().waveformDecodeThreads());
+    WaveformJobService::setApproximateFirst(PreferencesManager::instance().cacheApproximateWaveforms());
 
     // Try to initialize the audio engine (JACK)
     if (!m_audioEngine.init()) {
@@ -95,6 +116,17 @@ MainWindow::MainWindow(QWidget* parent)
     m_recentMenu->setObjectName("recentSessionsMenu");
     updateRecentSessionsMenu();
     
+    fileMenu->addSeparator();
+
+    // Record the output mix (and optionally each bus) to WAV/FLAC
+    m_startRecordingAction = fileMenu->addAction(tr("Start Recording..."));
+    connect(m_startRecordingAction, &QAction::triggered, this, &MainWindow::onStartRecording);
+    m_stopRecordingAction = fileMenu->addAction(tr("Stop Recording"));
+    m_stopRecordingAction->setEnabled(false);
+    connect(m_stopRecordingAction, &QAction::triggered, this, &MainWindow::onStopRecording);
+    m_recordPerBusAction = fileMenu->addAction(tr("Record Each Bus Separately"));
+    m_recordPerBusAction->setCheckable(true);
+
     fileMenu->addSeparator();
     // Quit action with confirmation dialog
     QAction* quitAction = fileMenu->addAction(tr("Quit"));
@@ -132,6 +164,9 @@ MainWindow::MainWindow(QWidget* parent)
         if (dlg.exec() == QDialog::Accepted) {
             // Apply preferences immediately after save
             DebugLog::setLevel(static_cast<int>(PreferencesManager::instance().logLevel()));
+            ContentFingerprint::setEnabled(PreferencesManager::instance().cacheContentKeys());
+            WaveformJobService::instance().setMaxThreads(PreferencesManager::instance().waveformDecodeThreads());
+            WaveformJobService::setApproximateFirst(PreferencesManager::instance().cacheApproximateWaveforms());
             applyKeepAlivePreferences();
         }
     });
@@ -153,6 +188,13 @@ MainWindow::MainWindow(QWidget* parent)
         WaveformCache::evict();
         statusBar()->showMessage(tr("Waveform cache eviction complete"), 2000);
     });
+    debugMenu->addAction(tr("Waveform pixmap cache stats"), this, [this]() {
+        const WaveformPixmapCache::Stats s = WaveformPixmapCache::instance().stats();
+        const QString msg = tr("Pixmap cache: %1 hits, %2 misses, %3 evictions, %4 entries, %5 KB")
+            .arg(s.hits).arg(s.misses).arg(s.evictions).arg(s.entries).arg(s.bytes / 1024);
+        qInfo().noquote() << msg;
+        statusBar()->showMessage(msg, 5000);
+    });
 
     // Keep-alive status indicator pinned to the status bar
     m_keepAliveStatusLabel = new QLabel(this);
@@ -206,16 +248,29 @@ MainWindow::MainWindow(QWidget* parent)
                 connect(sc, &SoundContainer::copyRequested, this, &MainWindow::onCopyRequested);
                 connect(sc, &SoundContainer::fileChanged, this, [this](const QString& p){ statusBar()->showMessage(p, 2000); });
                 connect(sc, &SoundContainer::clearRequested, this, &MainWindow::onClearRequested);
+                connect(sc, &SoundContainer::armRecordRequested, this, &MainWindow::onArmRecordRequested);
+                connect(sc, &SoundContainer::recordRequested, this, &MainWindow::onRecordRequested);
+                connect(sc, &SoundContainer::stopRecordRequested, this, &MainWindow::onStopRecordRequested);
+                connect(sc, &SoundContainer::sceneTriggered, this, &MainWindow::onSceneTriggered);
+                connect(sc, &SoundContainer::editSceneRequested, this, &MainWindow::onEditSceneRequested);
                 // Mark session dirty on any modification
                 connect(sc, &SoundContainer::fileChanged, this, &MainWindow::onSessionModified);
                 connect(sc, &SoundContainer::volumeChanged, this, &MainWindow::onSessionModified);
                 connect(sc, &SoundContainer::backdropColorChanged, this, &MainWindow::onSessionModified);
+                connect(sc, &SoundContainer::outputBusChanged, this, &MainWindow::onSessionModified);
+                connect(sc, &SoundContainer::sceneChanged, this, &MainWindow::onSessionModified);
                 // Update active voice gain when the slider changes
                 connect(sc, &SoundContainer::volumeChanged, this, [this, sc](float v){
                     if (sc && !sc->file().isEmpty()) {
                         m_audioEngine.setVoiceGainById(sc->file().toStdString(), v);
                     }
                 });
+                // Move any playing voices when the slot is routed to another bus
+                connect(sc, &SoundContainer::outputBusChanged, this, [this, sc](int bus){
+                    if (sc && !sc->file().isEmpty()) {
+                        m_audioEngine.setVoiceBusById(sc->file().toStdString(), bus);
+                    }
+                });
 
                 // Right-click on play button stops the audio for this container
                 connect(sc, &SoundContainer::stopRequested, this, [this](const QString& path, SoundContainer* sc){
@@ -295,6 +350,20 @@ MainWindow::MainWindow(QWidget* parent)
             restoreLayout();
         }
     }
+    m_startupLayoutMs = m_startupTimer.elapsed();
+
+    // Cache probes for the restored slots run in the background; the window is
+    // interactive once the visible tab's waveforms have been resolved
+    WaveformCacheProbe& probe = WaveformCacheProbe::instance();
+    if (probe.visibleOutstanding() == 0) {
+        QTimer::singleShot(0, this, &MainWindow::reportStartupTimeToInteractive);
+    } else {
+        auto conn = std::make_shared<QMetaObject::Connection>();
+        *conn = connect(&probe, &WaveformCacheProbe::visibleIdle, this, [this, conn]() {
+            disconnect(*conn);
+            reportStartupTimeToInteractive();
+        });
+    }
     
     // Initialize KeepAliveMonitor for input monitoring
     initializeKeepAliveMonitor();
@@ -501,6 +570,15 @@ void MainWindow::closeEvent(QCloseEvent* event)
     }
 }
 
+void MainWindow::reportStartupTimeToInteractive()
+{
+    if (m_startupTtiMs >= 0) return;
+    m_startupTtiMs = m_startupTimer.elapsed();
+    qInfo().noquote() << QString("Startup: layout restored in %1 ms, visible waveforms ready in %2 ms")
+                             .arg(m_startupLayoutMs).arg(m_startupTtiMs);
+    statusBar()->showMessage(tr("Ready in %1 ms").arg(m_startupTtiMs), 3000);
+}
+
 void MainWindow::writeDebugLog(const QString& msg)
 {
     // Do not write debug lines to disk; emit to qDebug only
@@ -511,7 +589,177 @@ MainWindow::~MainWindow()
 {
     // Save layout before shutting down audio
     saveLayout();
+    onStopRecording();
+    discardInputCapture();
     m_audioEngine.shutdown();
+    // Stop waveform decodes; waits only for the decode threads
+    WaveformJobService::instance().shutdown();
+    // Let queued waveform cache writes reach the disk
+    WaveformCache::flush();
+}
+
+void MainWindow::onStartRecording()
+{
+    if (m_outputRecorder && m_outputRecorder->isRecording()) return;
+    if (m_audioEngine.sampleRate() <= 0 || m_audioEngine.busCount() <= 0) {
+        statusBar()->showMessage(tr("Recording unavailable: audio engine not running"), 3000);
+        return;
+    }
+    QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    QString defaultPath = QDir::home().filePath(QString("libresoundboard-%1.wav").arg(stamp));
+    QString path = QFileDialog::getSaveFileName(this, tr("Record Output To"), defaultPath,
+                                                tr("WAV (*.wav);;FLAC (*.flac)"));
+    if (path.isEmpty()) return;
+
+    OutputRecorder::Options opts;
+    opts.path = path.toStdString();
+    opts.format = path.endsWith(".flac", Qt::CaseInsensitive) ? OutputRecorder::Format::Flac : OutputRecorder::Format::Wav;
+    opts.sampleRate = m_audioEngine.sampleRate();
+    opts.busCount = m_audioEngine.busCount();
+    opts.perBus = m_recordPerBusAction && m_recordPerBusAction->isChecked();
+
+    if (!m_outputRecorder) m_outputRecorder = new OutputRecorder();
+    if (!m_outputRecorder->start(opts)) {
+        QMessageBox::warning(this, tr("Recording Failed"),
+                             tr("Unable to start recording:\n%1").arg(QString::fromStdString(m_outputRecorder->lastError())));
+        return;
+    }
+    m_audioEngine.setOutputRecorder(m_outputRecorder);
+    if (m_startRecordingAction) m_startRecordingAction->setEnabled(false);
+    if (m_stopRecordingAction) m_stopRecordingAction->setEnabled(true);
+    statusBar()->showMessage(tr("Recording: %1").arg(path), 3000);
+}
+
+void MainWindow::onStopRecording()
+{
+    if (!m_outputRecorder) return;
+    // Detach first so the RT thread is done with the recorder before it stops
+    m_audioEngine.setOutputRecorder(nullptr);
+    const bool wasRecording = m_outputRecorder->isRecording();
+    m_outputRecorder->stop();
+    const QString error = QString::fromStdString(m_outputRecorder->lastError());
+    if (!error.isEmpty()) {
+        // The writer stopped on its own after a failed write
+        QMessageBox::warning(this, tr("Recording Failed"), tr("Recording stopped early:\n%1").arg(error));
+    } else if (wasRecording) {
+        quint64 dropped = m_outputRecorder->droppedBlocks();
+        if (dropped > 0) {
+            statusBar()->showMessage(tr("Recording stopped (%1 blocks dropped)").arg(dropped), 5000);
+        } else {
+            statusBar()->showMessage(tr("Recording stopped"), 3000);
+        }
+    }
+    if (m_startRecordingAction) m_startRecordingAction->setEnabled(true);
+    if (m_stopRecordingAction) m_stopRecordingAction->setEnabled(false);
+    delete m_outputRecorder;
+    m_outputRecorder = nullptr;
+}
+
+void MainWindow::onArmRecordRequested(SoundContainer* sc)
+{
+    if (!sc || !sc->file().isEmpty()) return;
+    if (m_inputCapture) {
+        statusBar()->showMessage(tr("Another slot is already armed for recording"), 3000);
+        return;
+    }
+    if (m_audioEngine.sampleRate() <= 0) {
+        statusBar()->showMessage(tr("Recording unavailable: audio engine not running"), 3000);
+        return;
+    }
+    m_inputCapture = new InputCapture();
+    if (!m_inputCapture->arm(m_audioEngine.sampleRate())) {
+        delete m_inputCapture;
+        m_inputCapture = nullptr;
+        return;
+    }
+    m_audioEngine.setInputCapture(m_inputCapture);
+    m_recordTarget = sc;
+    // A slot deleted while armed must not leave the capture running
+    m_recordTargetDestroyed = connect(sc, &QObject::destroyed, this, [this]() { discardInputCapture(); });
+    sc->setRecordState(SoundContainer::RecordState::Armed);
+    statusBar()->showMessage(tr("Slot armed for recording"), 2000);
+}
+
+void MainWindow::discardInputCapture()
+{
+    disconnect(m_recordTargetDestroyed);
+    if (!m_inputCapture) return;
+    // Detach first so the RT thread is done with the capture before it stops
+    m_audioEngine.setInputCapture(nullptr);
+    m_inputCapture->stop();
+    delete m_inputCapture;
+    m_inputCapture = nullptr;
+    if (m_recordTarget) m_recordTarget->setRecordState(SoundContainer::RecordState::None);
+    m_recordTarget = nullptr;
+}
+
+void MainWindow::onRecordRequested(SoundContainer* sc)
+{
+    if (!m_inputCapture || sc != m_recordTarget) return;
+    m_inputCapture->record();
+    sc->setRecordState(SoundContainer::RecordState::Recording);
+    statusBar()->showMessage(tr("Recording from input..."), 2000);
+}
+
+void MainWindow::onStopRecordRequested(SoundContainer* sc)
+{
+    if (!m_inputCapture || sc != m_recordTarget) return;
+    // Detach first so the RT thread is done with the capture before it stops
+    m_audioEngine.setInputCapture(nullptr);
+    const bool wasRecording = m_inputCapture->state() == InputCapture::State::Recording;
+    const int sampleRate = m_inputCapture->sampleRate();
+    const quint64 dropped = m_inputCapture->droppedFrames();
+    auto samples = std::make_shared<std::vector<float>>(m_inputCapture->stop());
+    delete m_inputCapture;
+    m_inputCapture = nullptr;
+    disconnect(m_recordTargetDestroyed);
+    m_recordTarget = nullptr;
+    sc->setRecordState(SoundContainer::RecordState::None);
+
+    if (!wasRecording || samples->empty()) {
+        statusBar()->showMessage(tr("Recording disarmed"), 2000);
+        return;
+    }
+
+    QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/recordings";
+    QDir().mkpath(dirPath);
+    QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    QString path = QDir(dirPath).filePath(QString("take-%1.wav").arg(stamp));
+    if (dropped > 0) {
+        qWarning() << "Input capture dropped" << dropped << "frames";
+    }
+    statusBar()->showMessage(tr("Saving take: %1").arg(path), 2000);
+
+    // Encode and compute the waveform off the GUI thread, then hand the take to
+    // the slot with the decoded audio and waveform already in place
+    QPointer<SoundContainer> target(sc);
+    // The window may be gone by the time the pool task finishes
+    QPointer<MainWindow> self(this);
+    qreal dpr = sc->devicePixelRatioF();
+    QThreadPool::globalInstance()->start([self, target, path, samples, sampleRate, dpr]() {
+        std::string error;
+        const bool ok = InputCapture::writeWavFile(path.toStdString(), *samples, sampleRate, &error);
+        WaveformResult waveform;
+        if (ok) {
+            waveform = WaveformWorker::decodeSamples(samples->data(), samples->size(), sampleRate, 1,
+                                                     500, dpr);
+            WaveformWorker::stampSource(path, &waveform);
+        }
+        if (!self) return;
+        // Queued on the window: dropped if it is destroyed before delivery
+        QMetaObject::invokeMethod(self.data(), [self, target, path, samples, sampleRate, ok, error, waveform]() {
+            if (!ok) {
+                QMessageBox::warning(self, tr("Recording Failed"),
+                                     tr("Unable to save recording:\n%1").arg(QString::fromStdString(error)));
+                return;
+            }
+            DecodedAudioCache::instance().insert(path, std::move(*samples), sampleRate, 1);
+            if (target && target->file().isEmpty()) {
+                target->setFileWithWaveform(path, waveform);
+            }
+            self->statusBar()->showMessage(tr("Recorded: %1").arg(path), 3000);
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::onPlayRequested(const QString& path, SoundContainer* src)
@@ -519,20 +767,145 @@ void MainWindow::onPlayRequested(const QString& path, SoundContainer* src)
     playAudioFile(path, src, 1.0f, false);
 }
 
-bool MainWindow::playAudioFile(const QString& path, SoundContainer* src, float volumeOverride, bool useOverrideVolume)
+bool MainWindow::decodedAudioFor(const QString& path, DecodedAudioCache::Entry* entry)
 {
+    // Reuse decoded audio while the file is unchanged
+    if (DecodedAudioCache::instance().lookup(path, entry)) return true;
+
     AudioFile af;
     if (!af.load(path)) {
         QMessageBox::warning(this, tr("Load Failed"), tr("Unable to load audio file."));
         return false;
     }
 
-    std::vector<float> samples;
+    std::vector<float> decoded;
     int sr = 0, ch = 0;
-    if (!af.readAllSamples(samples, sr, ch)) {
+    if (!af.readAllSamples(decoded, sr, ch)) {
         QMessageBox::warning(this, tr("Read Failed"), tr("Unable to decode audio file."));
         return false;
     }
+    *entry = DecodedAudioCache::instance().insert(path, std::move(decoded), sr, ch);
+    return true;
+}
+
+void MainWindow::onSceneTriggered(SoundContainer* sc)
+{
+    if (!sc || !sc->isScene()) return;
+    // Members take gain and bus from the slot on the same tab holding the file
+    int tab = -1;
+    for (size_t t = 0; t < m_containers.size() && tab < 0; ++t) {
+        if (std::find(m_containers[t].begin(), m_containers[t].end(), sc) != m_containers[t].end()) {
+            tab = static_cast<int>(t);
+        }
+    }
+    auto slotFor = [this, tab](const QString& path) -> SoundContainer* {
+        if (tab < 0) return nullptr;
+        for (auto* c : m_containers[tab]) {
+            if (c && c->file() == path) return c;
+        }
+        return nullptr;
+    };
+
+    // Decode everything before submitting so the batch is published at once
+    const QVector<SoundContainer::SceneMember> members = sc->scene();
+    std::vector<DecodedAudioCache::Entry> entries;
+    std::vector<AudioEngine::BatchVoice> batch;
+    std::vector<std::pair<QString, SoundContainer*>> started;
+    entries.reserve(members.size());
+    for (const auto& m : members) {
+        DecodedAudioCache::Entry entry;
+        if (!decodedAudioFor(m.path, &entry)) continue;
+        entries.push_back(entry);
+        SoundContainer* slot = slotFor(m.path);
+        AudioEngine::BatchVoice v;
+        v.samples = entries.back().samples.get();
+        v.sampleRate = entry.sampleRate;
+        v.channels = entry.channels;
+        v.id = m.path.toStdString();
+        v.gain = slot ? slot->volume() : 0.8f;
+        v.bus = slot ? slot->outputBus() : 0;
+        v.offsetFrames = static_cast<int>(static_cast<qint64>(m.offsetMs) * m_audioEngine.sampleRate() / 1000);
+        batch.push_back(v);
+        started.emplace_back(m.path, slot);
+    }
+    if (batch.empty()) return;
+
+    if (!m_audioEngine.playBatch(batch)) {
+        statusBar()->showMessage(tr("Playback failed (JACK?)"), 3000);
+        return;
+    }
+    for (const auto& s : started) {
+        PlayheadManager::instance()->playbackStarted(s.first, s.second);
+    }
+    statusBar()->showMessage(tr("Playing scene (%1 sounds)").arg(batch.size()), 2000);
+}
+
+void MainWindow::onEditSceneRequested(SoundContainer* sc)
+{
+    if (!sc || !sc->file().isEmpty()) return;
+    int tab = -1;
+    for (size_t t = 0; t < m_containers.size() && tab < 0; ++t) {
+        if (std::find(m_containers[t].begin(), m_containers[t].end(), sc) != m_containers[t].end()) {
+            tab = static_cast<int>(t);
+        }
+    }
+    if (tab < 0) return;
+
+    // Offer every sound on this tab; existing members are pre-checked
+    QHash<QString, int> current;
+    for (const auto& m : sc->scene()) current.insert(m.path, m.offsetMs);
+
+    QDialog dlg(this);
+    dlg.setWindowTitle(sc->isScene() ? tr("Edit Scene") : tr("New Scene"));
+    auto* layout = new QVBoxLayout(&dlg);
+    layout->addWidget(new QLabel(tr("Sounds started together when the scene is played:"), &dlg));
+    auto* table = new QTableWidget(0, 2, &dlg);
+    table->setHorizontalHeaderLabels({tr("Sound"), tr("Offset (ms)")});
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table->verticalHeader()->setVisible(false);
+    QStringList paths;
+    for (auto* c : m_containers[tab]) {
+        if (!c || c->file().isEmpty() || paths.contains(c->file())) continue;
+        const int row = table->rowCount();
+        table->insertRow(row);
+        auto* item = new QTableWidgetItem(QFileInfo(c->file()).fileName());
+        item->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+        item->setCheckState(current.contains(c->file()) ? Qt::Checked : Qt::Unchecked);
+        item->setToolTip(c->file());
+        table->setItem(row, 0, item);
+        auto* offset = new QSpinBox(table);
+        offset->setRange(0, 60000);
+        offset->setValue(current.value(c->file(), 0));
+        table->setCellWidget(row, 1, offset);
+        paths << c->file();
+    }
+    layout->addWidget(table);
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dlg);
+    connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    if (paths.isEmpty()) {
+        QMessageBox::information(this, tr("New Scene"), tr("Add some sounds to this tab first."));
+        return;
+    }
+    if (dlg.exec() != QDialog::Accepted) return;
+
+    QVector<SoundContainer::SceneMember> members;
+    for (int row = 0; row < table->rowCount(); ++row) {
+        if (table->item(row, 0)->checkState() != Qt::Checked) continue;
+        SoundContainer::SceneMember m;
+        m.path = paths[row];
+        m.offsetMs = qobject_cast<QSpinBox*>(table->cellWidget(row, 1))->value();
+        members.push_back(m);
+    }
+    sc->setScene(members);
+}
+
+bool MainWindow::playAudioFile(const QString& path, SoundContainer* src, float volumeOverride, bool useOverrideVolume)
+{
+    DecodedAudioCache::Entry entry;
+    if (!decodedAudioFor(path, &entry)) return false;
 
     float vol = 1.0f;
     if (useOverrideVolume) {
@@ -542,7 +915,8 @@ bool MainWindow::playAudioFile(const QString& path, SoundContainer* src, float v
     }
 
     PlayheadManager::instance()->playbackStarted(path, src);
-    if (!m_audioEngine.playBuffer(samples, sr, ch, path.toStdString(), vol)) {
+    int bus = src ? src->outputBus() : 0;
+    if (!m_audioEngine.playBuffer(*entry.samples, entry.sampleRate, entry.channels, path.toStdString(), vol, bus)) {
         statusBar()->showMessage(tr("Playback failed (JACK?)"), 3000);
         return false;
     }
@@ -659,12 +1033,16 @@ void MainWindow::onGridDimensionsChanged(int rows, int cols)
     if (newRows == m_gridRows && newCols == m_gridCols) return;
     // Pause/clear playhead overlays to avoid updates during rebuild
     PlayheadManager::instance()->stopAll();
+    // Every slot is replaced, the armed one included
+    discardInputCapture();
 
     // Snapshot current grid contents
     struct SlotData {
         QString file;
         float volume = 1.0f;
         QColor backdrop;
+        int bus = 0;
+        QVector<SoundContainer::SceneMember> scene;
     };
     std::vector<std::vector<SlotData>> oldData(m_containers.size());
     for (size_t t = 0; t < m_containers.size(); ++t) {
@@ -676,6 +1054,8 @@ void MainWindow::onGridDimensionsChanged(int rows, int cols)
                 d.file = sc->file();
                 d.volume = sc->volume();
                 d.backdrop = sc->backdropColor();
+                d.bus = sc->outputBus();
+                d.scene = sc->scene();
             }
             oldData[t].push_back(d);
         }
@@ -732,11 +1112,21 @@ void MainWindow::onGridDimensionsChanged(int rows, int cols)
             connect(sc, &SoundContainer::copyRequested, this, &MainWindow::onCopyRequested);
             connect(sc, &SoundContainer::fileChanged, this, [this](const QString& p){ statusBar()->showMessage(p, 2000); });
             connect(sc, &SoundContainer::clearRequested, this, &MainWindow::onClearRequested);
+            connect(sc, &SoundContainer::armRecordRequested, this, &MainWindow::onArmRecordRequested);
+            connect(sc, &SoundContainer::recordRequested, this, &MainWindow::onRecordRequested);
+            connect(sc, &SoundContainer::stopRecordRequested, this, &MainWindow::onStopRecordRequested);
+            connect(sc, &SoundContainer::sceneTriggered, this, &MainWindow::onSceneTriggered);
+            connect(sc, &SoundContainer::editSceneRequested, this, &MainWindow::onEditSceneRequested);
             connect(sc, &SoundContainer::volumeChanged, this, [this, sc](float v){
                 if (sc && !sc->file().isEmpty()) {
                     m_audioEngine.setVoiceGainById(sc->file().toStdString(), v);
                 }
             });
+            connect(sc, &SoundContainer::outputBusChanged, this, [this, sc](int bus){
+                if (sc && !sc->file().isEmpty()) {
+                    m_audioEngine.setVoiceBusById(sc->file().toStdString(), bus);
+                }
+            });
             // Right-click on play button stops the audio for this container
             connect(sc, &SoundContainer::stopRequested, this, [this](const QString& path, SoundContainer* sc){
                 Q_UNUSED(sc);
@@ -774,6 +1164,8 @@ void MainWindow::onGridDimensionsChanged(int rows, int cols)
                 if (d.backdrop.isValid()) {
                     sc->setBackdropColor(d.backdrop);
                 }
+                sc->setOutputBus(d.bus);
+                if (d.file.isEmpty() && !d.scene.isEmpty()) sc->setScene(d.scene);
             }
         }
 
@@ -891,10 +1283,12 @@ void MainWindow::onCopyRequested(SoundContainer* src, SoundContainer* dst)
     if (!src->file().isEmpty()) {
         dst->setFile(src->file());
         dst->setVolume(src->volume());
+        dst->setOutputBus(src->outputBus());
     } else {
-        // if source has no file, clear dest
+        // if source has no file, clear dest (or copy the scene it holds)
         dst->setFile(QString());
         dst->setVolume(0.8f);
+        dst->setScene(src->scene());
     }
 
     // Record operation for undo/redo
@@ -966,6 +1360,7 @@ void MainWindow::onClearRequested(SoundContainer* sc)
     if (m_redoAction) m_redoAction->setEnabled(false);
 
     // perform clear
+    sc->setScene({});
     sc->setFile(QString());
     sc->setVolume(0.8f);
     // also clear any user-selected backdrop color for this slot
@@ -1045,6 +1440,12 @@ void MainWindow::saveLayout()
                 // store as ARGB integer
                 obj["backdrop"] = static_cast<double>(sc->backdropColor().rgba());
             }
+            if (sc && sc->outputBus() > 0) {
+                obj["bus"] = sc->outputBus();
+            }
+            if (sc && sc->isScene()) {
+                obj["scene"] = sc->sceneToJson();
+            }
             slotArr.append(obj);
         }
         tabsArr.append(slotArr);
@@ -1118,6 +1519,10 @@ void MainWindow::restoreLayout()
             if (sc) {
                 if (!path.isEmpty()) sc->setFile(path);
                 sc->setVolume(static_cast<float>(vol));
+                sc->setOutputBus(obj.value("bus").toInt(0));
+                if (path.isEmpty() && obj.value("scene").isArray()) {
+                    sc->setSceneFromJson(obj.value("scene").toArray());
+                }
             }
             ++s;
         }
@@ -1421,6 +1826,16 @@ void MainWindow::restartAudioEngineWithPreferences(const QString& oldClientName)
     applyKeepAlivePreferences();
 }
 
+void MainWindow::applyAudioBusPreferences()
+{
+    // Bus gains and ducking are live; the bus count itself only changes on engine restart
+    PreferencesManager& pm = PreferencesManager::instance();
+    for (int b = 0; b < m_audioEngine.busCount(); ++b) {
+        m_audioEngine.setBusGain(b, static_cast<float>(pm.audioBusGain(b)));
+    }
+    m_audioEngine.applyDuckingPreferences();
+}
+
 void MainWindow::onKeepAliveTriggered()
 {
     PreferencesManager& pm = PreferencesManager::instance();
@@ -1487,6 +1902,12 @@ void MainWindow::saveSessionAs(const QString& filePath)
             if (sc && sc->backdropColor().isValid()) {
                 obj["backdrop"] = static_cast<double>(sc->backdropColor().rgba());
             }
+            if (sc && sc->outputBus() > 0) {
+                obj["bus"] = sc->outputBus();
+            }
+            if (sc && sc->isScene()) {
+                obj["scene"] = sc->sceneToJson();
+            }
             slotArr.append(obj);
         }
         tabsArr.append(slotArr);
@@ -1558,6 +1979,10 @@ void MainWindow::loadSession(const QString& filePath)
             if (sc) {
                 if (!path.isEmpty()) sc->setFile(path);
                 sc->setVolume(static_cast<float>(vol));
+                sc->setOutputBus(obj.value("bus").toInt(0));
+                if (path.isEmpty() && obj.value("scene").isArray()) {
+                    sc->setSceneFromJson(obj.value("scene").toArray());
+                }
             }
             ++s;
         }
@@ -1720,6 +2145,7 @@ void MainWindow::onNewSession()
                 sc->setFile(QString());
                 sc->setVolume(0.8f);
                 sc->setBackdropColor(QColor());
+                sc->setOutputBus(0);
             }
         }
     }
@@ -2,7 +2,10 @@
 
 #include <QMainWindow>
 #include "AudioEngine.h"
+#include "DecodedAudioCache.h"
 #include <QString>
+#include <QPointer>
+#include <QElapsedTimer>
 #include <vector>
 
 class QTabWidget;
@@ -12,6 +15,8 @@ class QKeyEvent;
 class QWidget;
 class KeepAliveMonitor;
 class QLabel;
+class OutputRecorder;
+class InputCapture;
 
 /**
  * Main application window. Contains the menu and central grid layout.
@@ -36,6 +41,7 @@ public slots:
     void restoreLayout();
     void onKeepAliveTriggered();
     void restartAudioEngineWithPreferences(const QString& oldClientName = QString());
+    void applyAudioBusPreferences();
 
     // Session I/O
     void saveSessionAs(const QString& filePath);
@@ -55,6 +61,11 @@ public slots:
     SoundContainer* containerAt(int tab, int index) const;
     int containerCountForTab(int tab) const;
 
+    // Startup metrics in ms since construction began (-1 until known):
+    // layout restored, and visible-tab waveforms resolved from the cache
+    qint64 startupLayoutMs() const { return m_startupLayoutMs; }
+    qint64 startupTimeToInteractiveMs() const { return m_startupTtiMs; }
+
 public slots:
     void onGridDimensionsChanged(int rows, int cols);
 
@@ -78,6 +89,14 @@ private slots:
     void onLoadRecentSession();
     void onClearRecentSessions();
     void onSessionModified();
+    void onStartRecording();
+    void onStopRecording();
+    void onArmRecordRequested(SoundContainer* sc);
+    void onRecordRequested(SoundContainer* sc);
+    void onStopRecordRequested(SoundContainer* sc);
+    // Scene slots: fire a stored set of sounds in one audio cycle
+    void onSceneTriggered(SoundContainer* sc);
+    void onEditSceneRequested(SoundContainer* sc);
 
     // Session management helpers
     void handleCloseEvent();     // Handle window close event
@@ -133,8 +152,27 @@ private:
     bool m_sessionDirty = false;
     KeepAliveMonitor* m_keepAliveMonitor = nullptr;
     QLabel* m_keepAliveStatusLabel = nullptr;
+    // Master/bus output recorder (post-show archives)
+    OutputRecorder* m_outputRecorder = nullptr;
+    QAction* m_startRecordingAction = nullptr;
+    QAction* m_stopRecordingAction = nullptr;
+    QAction* m_recordPerBusAction = nullptr;
+    // Record-to-slot capture from the JACK input port
+    InputCapture* m_inputCapture = nullptr;
+    QPointer<SoundContainer> m_recordTarget;
+    QMetaObject::Connection m_recordTargetDestroyed;
+    // Detach, stop and delete the capture without keeping the take (the
+    // armed slot went away or the grid is being rebuilt)
+    void discardInputCapture();
+    // Startup time-to-interactive measurement
+    QElapsedTimer m_startupTimer;
+    qint64 m_startupLayoutMs = -1;
+    qint64 m_startupTtiMs = -1;
+    void reportStartupTimeToInteractive();
     void applyKeepAlivePreferences();
     bool playAudioFile(const QString& path, SoundContainer* src, float volumeOverride, bool useOverrideVolume);
+    // Decoded samples for `path` from DecodedAudioCache, decoding on a miss
+    bool decodedAudioFor(const QString& path, DecodedAudioCache::Entry* entry);
     void updateRecentSessionsMenu();
     void updateWindowTitle();
     void markSessionDirty();
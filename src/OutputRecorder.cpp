@@ -0,0 +1,228 @@
+#include "OutputRecorder.h"
+
+#include <sndfile.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Frames encoded per sf_writef_float call by the writer thread
+constexpr size_t kWriteChunkFrames = 4096;
+
+SNDFILE* openForWrite(const std::string& path, OutputRecorder::Format format, int sampleRate)
+{
+    SF_INFO info;
+    std::memset(&info, 0, sizeof(info));
+    info.samplerate = sampleRate;
+    info.channels = 2;
+    if (format == OutputRecorder::Format::Flac) {
+        info.format = SF_FORMAT_FLAC | SF_FORMAT_PCM_24;
+    } else {
+        info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    }
+    SNDFILE* snd = sf_open(path.c_str(), SFM_WRITE, &info);
+    if (snd && format == OutputRecorder::Format::Flac) {
+        // Integer formats must clip instead of wrapping on overs
+        sf_command(snd, SFC_SET_CLIPPING, nullptr, SF_TRUE);
+    }
+    return snd;
+}
+
+} // namespace
+
+OutputRecorder::OutputRecorder() = default;
+
+OutputRecorder::~OutputRecorder()
+{
+    stop();
+}
+
+std::string OutputRecorder::busFilePath(const std::string& masterPath, int bus)
+{
+    const std::string suffix = "_bus" + std::to_string(bus + 1);
+    const size_t slash = masterPath.find_last_of('/');
+    const size_t dot = masterPath.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return masterPath + suffix;
+    }
+    return masterPath.substr(0, dot) + suffix + masterPath.substr(dot);
+}
+
+std::string OutputRecorder::lastError() const
+{
+    std::lock_guard<std::mutex> l(m_errorLock);
+    return m_lastError;
+}
+
+void OutputRecorder::setLastError(const std::string& error)
+{
+    std::lock_guard<std::mutex> l(m_errorLock);
+    m_lastError = error;
+}
+
+bool OutputRecorder::start(const Options& options)
+{
+    if (m_recording.load()) return false;
+    setLastError(std::string());
+    if (options.path.empty() || options.sampleRate <= 0) {
+        setLastError("invalid recorder options");
+        return false;
+    }
+
+    m_options = options;
+    m_options.busCount = std::max(1, options.busCount);
+    m_channels = m_options.busCount * 2;
+    m_ringFrames = static_cast<size_t>(std::max(0.01, options.ringSeconds) * options.sampleRate);
+    m_ring.assign(m_ringFrames * static_cast<size_t>(m_channels), 0.0f);
+    m_scratch.assign(kWriteChunkFrames * 2, 0.0f);
+    m_writeFrame.store(0);
+    m_readFrame.store(0);
+    m_droppedBlocks.store(0);
+    m_framesWritten.store(0);
+    m_writeFailed = false;
+
+    m_paths.clear();
+    // File 0 is the master mixdown, file 1 + b the bus b file
+    const int nFiles = m_options.perBus ? 1 + m_options.busCount : 1;
+    for (int f = 0; f < nFiles; ++f) {
+        std::string path = f == 0 ? m_options.path : busFilePath(m_options.path, f - 1);
+        SNDFILE* snd = openForWrite(path, m_options.format, m_options.sampleRate);
+        if (!snd) {
+            setLastError("unable to open " + path + ": " + sf_strerror(nullptr));
+            closeFiles();
+            return false;
+        }
+        m_files.push_back(snd);
+        m_paths.push_back(path);
+    }
+
+    m_stopRequested.store(false);
+    m_recording.store(true);
+    m_writer = std::thread([this]() { writerLoop(); });
+    return true;
+}
+
+void OutputRecorder::stop()
+{
+    if (!m_writer.joinable()) return;
+    m_recording.store(false);
+    m_stopRequested.store(true);
+    m_writer.join();
+    closeFiles();
+}
+
+void OutputRecorder::pushBlock(const float* const* outputs, int nOutChannels, int nframes)
+{
+    if (!m_recording.load(std::memory_order_relaxed) || !outputs || nframes <= 0) return;
+
+    const uint64_t w = m_writeFrame.load(std::memory_order_relaxed);
+    const uint64_t r = m_readFrame.load(std::memory_order_acquire);
+    const size_t used = static_cast<size_t>(w - r);
+    if (static_cast<size_t>(nframes) > m_ringFrames - used) {
+        m_droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Interleave into the ring in at most two contiguous segments
+    const size_t start = static_cast<size_t>(w % m_ringFrames);
+    const size_t first = std::min(static_cast<size_t>(nframes), m_ringFrames - start);
+    for (int c = 0; c < m_channels; ++c) {
+        const float* src = (c < nOutChannels) ? outputs[c] : nullptr;
+        float* dst = m_ring.data() + start * m_channels + c;
+        if (src) {
+            for (size_t i = 0; i < first; ++i) dst[i * m_channels] = src[i];
+        } else {
+            for (size_t i = 0; i < first; ++i) dst[i * m_channels] = 0.0f;
+        }
+        float* wrap = m_ring.data() + c;
+        for (size_t i = first; i < static_cast<size_t>(nframes); ++i) {
+            wrap[(i - first) * m_channels] = src ? src[i] : 0.0f;
+        }
+    }
+    m_writeFrame.store(w + static_cast<uint64_t>(nframes), std::memory_order_release);
+}
+
+size_t OutputRecorder::drainOnce()
+{
+    if (m_writeFailed) return 0;
+    const uint64_t readFrame = m_readFrame.load(std::memory_order_relaxed);
+    const uint64_t writeFrame = m_writeFrame.load(std::memory_order_acquire);
+    if (writeFrame == readFrame) return 0;
+
+    const size_t start = static_cast<size_t>(readFrame % m_ringFrames);
+    const size_t n = std::min({static_cast<size_t>(writeFrame - readFrame), m_ringFrames - start, kWriteChunkFrames});
+    const float* src = m_ring.data() + start * m_channels;
+
+    if (m_options.master == Master::Bus1) {
+        for (size_t i = 0; i < n; ++i) {
+            m_scratch[i * 2] = src[i * m_channels];
+            m_scratch[i * 2 + 1] = src[i * m_channels + 1];
+        }
+    } else {
+        // Every bus summed, clamped so the mix cannot exceed full scale
+        for (size_t i = 0; i < n; ++i) {
+            const float* frame = src + i * m_channels;
+            float left = 0.0f;
+            float right = 0.0f;
+            for (int c = 0; c < m_channels; c += 2) {
+                left += frame[c];
+                right += frame[c + 1];
+            }
+            m_scratch[i * 2] = std::clamp(left, -1.0f, 1.0f);
+            m_scratch[i * 2 + 1] = std::clamp(right, -1.0f, 1.0f);
+        }
+    }
+    if (!writeFile(0, n)) return 0;
+
+    for (size_t f = 1; f < m_files.size(); ++f) {
+        const int offset = static_cast<int>(f - 1) * 2;
+        for (size_t i = 0; i < n; ++i) {
+            m_scratch[i * 2] = src[i * m_channels + offset];
+            m_scratch[i * 2 + 1] = src[i * m_channels + offset + 1];
+        }
+        if (!writeFile(f, n)) return 0;
+    }
+
+    m_readFrame.store(readFrame + n, std::memory_order_release);
+    m_framesWritten.fetch_add(n);
+
+    const int stallMs = m_writerStallMs.load();
+    if (stallMs > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+    }
+    return n;
+}
+
+bool OutputRecorder::writeFile(size_t file, size_t frames)
+{
+    SNDFILE* snd = static_cast<SNDFILE*>(m_files[file]);
+    const sf_count_t written = sf_writef_float(snd, m_scratch.data(), static_cast<sf_count_t>(frames));
+    if (written == static_cast<sf_count_t>(frames)) return true;
+
+    // Disk full or I/O error: stop instead of silently losing audio
+    setLastError("write to " + m_paths[file] + " failed: " + sf_strerror(snd));
+    m_writeFailed = true;
+    m_recording.store(false);
+    m_stopRequested.store(true);
+    return false;
+}
+
+void OutputRecorder::writerLoop()
+{
+    while (!m_stopRequested.load()) {
+        if (drainOnce() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    // Flush whatever is still queued
+    while (drainOnce() > 0) {
+    }
+}
+
+void OutputRecorder::closeFiles()
+{
+    for (void* f : m_files) {
+        if (f) sf_close(static_cast<SNDFILE*>(f));
+    }
+    m_files.clear();
+}
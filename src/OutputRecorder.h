@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * OutputRecorder: records the engine output to WAV/FLAC for post-show archives.
+ *
+ * The real-time thread hands each output block to pushBlock(), which copies it
+ * into a large preallocated single-producer/single-consumer ring and returns.
+ * A writer thread drains the ring and encodes with libsndfile. If the disk
+ * stalls and the ring fills up, whole blocks are dropped and counted rather
+ * than blocking the audio callback.
+ *
+ * By default the master file holds the mixdown of every bus (the buses summed,
+ * left to left and right to right, clamped to [-1, 1] so the sum cannot go
+ * over full scale); `master = Master::Bus1` records bus 1 unchanged instead.
+ * With `perBus` set, each bus is also written to its own file next to it
+ * (`<name>_bus1.wav`, `<name>_bus2.wav`, ...).
+ *
+ * A failed or short write stops the recorder: isRecording() turns false,
+ * further blocks are ignored and lastError() describes the failure.
+ */
+class OutputRecorder
+{
+public:
+    enum class Format { Wav = 0, Flac = 1 };
+    // What the master file contains
+    enum class Master { MixAllBuses = 0, Bus1 = 1 };
+
+    struct Options {
+        std::string path;          // master file path; extension is not changed
+        Format format = Format::Wav;
+        Master master = Master::MixAllBuses;
+        int sampleRate = 48000;
+        int busCount = 1;          // number of stereo buses delivered to pushBlock
+        bool perBus = false;       // also write each bus to a separate file
+        double ringSeconds = 10.0; // ring capacity in seconds of audio
+    };
+
+    OutputRecorder();
+    ~OutputRecorder();
+
+    // Non-RT: open files, allocate the ring and start the writer thread
+    bool start(const Options& options);
+    // Non-RT: stop accepting blocks, drain the ring, close files
+    void stop();
+    bool isRecording() const { return m_recording.load(); }
+
+    // RT: copy one block of non-interleaved outputs (stereo pairs per bus).
+    // Never blocks or allocates; drops the whole block when the ring is full.
+    void pushBlock(const float* const* outputs, int nOutChannels, int nframes);
+
+    uint64_t droppedBlocks() const { return m_droppedBlocks.load(); }
+    uint64_t framesWritten() const { return m_framesWritten.load(); }
+    std::string lastError() const;
+
+    // Master path, then the per-bus file paths (bus 1 first) that start() opened
+    std::vector<std::string> filePaths() const { return m_paths; }
+
+    // Test hook: make the writer sleep this long after each write
+    void setWriterStallForTesting(std::chrono::milliseconds stall) { m_writerStallMs.store(static_cast<int>(stall.count())); }
+
+    // Derive the per-bus file path from the master path: foo.wav -> foo_bus2.wav
+    static std::string busFilePath(const std::string& masterPath, int bus);
+
+private:
+    void writerLoop();
+    size_t drainOnce();
+    void closeFiles();
+    bool writeFile(size_t file, size_t frames);
+    void setLastError(const std::string& error);
+
+    Options m_options;
+    int m_channels = 0;              // interleaved channels per ring frame (busCount * 2)
+    std::vector<float> m_ring;       // interleaved frames, capacity m_ringFrames
+    size_t m_ringFrames = 0;
+    std::atomic<uint64_t> m_writeFrame{0};   // total frames produced (RT)
+    std::atomic<uint64_t> m_readFrame{0};    // total frames consumed (writer)
+
+    std::vector<void*> m_files;      // SNDFILE* per output file
+    std::vector<std::string> m_paths;
+    std::vector<float> m_scratch;    // writer-side stereo deinterleave buffer
+
+    std::thread m_writer;
+    std::atomic<bool> m_recording{false};
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<uint64_t> m_droppedBlocks{0};
+    std::atomic<uint64_t> m_framesWritten{0};
+    std::atomic<int> m_writerStallMs{0};
+    bool m_writeFailed = false;      // writer thread only, reset by start()
+    mutable std::mutex m_errorLock;  // m_lastError is set by the writer thread
+    std::string m_lastError;
+};
@@ -4,6 +4,9 @@
 #include "AudioFile.h"
 
 #include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
 #include <cmath>
 #include <QDateTime>
 #include <QFile>
@@ -15,10 +18,15 @@ static PlayheadManager* g_instance = nullptr;
 PlayheadManager::PlayheadManager(QObject* parent)
     : QObject(parent)
 {
-    // default 30 Hz
-    m_timer.setInterval(33);
+    // One frame per display refresh (30-120 Hz), 60 Hz without a screen.
+    // Started by playbackStarted(), stopped by onTick() once nothing plays.
+    qreal hz = 60.0;
+    if (qGuiApp && qGuiApp->primaryScreen()) hz = qGuiApp->primaryScreen()->refreshRate();
+    m_timer.setInterval(qBound(8, qRound(1000.0 / qBound(30.0, hz, 120.0)), 33));
+    m_timer.setTimerType(Qt::PreciseTimer);
     connect(&m_timer, &QTimer::timeout, this, &PlayheadManager::onTick);
-    m_timer.start();
+    m_positions.resize(64);
+    m_voiceOrder.reserve(64);
     g_instance = this;
 }
 
@@ -36,6 +44,11 @@ PlayheadManager::~PlayheadManager()
 void PlayheadManager::init(AudioEngine* engine)
 {
     m_engine = engine;
+    // Handles belong to the engine that issued them
+    for (auto &list : m_map) {
+        for (auto &e : list) e.handle = 0;
+    }
+    m_handleGeneration = m_engine ? m_engine->voiceHandleGeneration() : 0;
 }
 
 PlayheadManager* PlayheadManager::instance()
@@ -60,6 +73,7 @@ void PlayheadManager::registerContainer(const QString& id, SoundContainer* sc, d
     en.duration = durationSeconds;
     en.sampleRate = sampleRate;
     en.lastPos = -1.0f;
+    if (!list.isEmpty()) en.handle = list.first().handle;
     // If duration or sampleRate missing, attempt to read file metadata via AudioFile
     if ((en.duration <= 0.0 || en.sampleRate <= 0) && !id.isEmpty()) {
         AudioFile af;
@@ -92,6 +106,12 @@ void PlayheadManager::playbackStarted(const QString& id, SoundContainer* sc)
             e.lastPos = -1.0f; // force update
         }
     }
+    wake();
+}
+
+void PlayheadManager::wake()
+{
+    if (!m_timer.isActive()) m_timer.start();
 }
 
 void PlayheadManager::playbackStopped(const QString& id, SoundContainer* sc)
@@ -146,75 +166,133 @@ float PlayheadManager::getLastPos(const QString& id, SoundContainer* sc) const
     return -2.0f;
 }
 
+// Elapsed playback of a voice. The voice position only advances once per
+// audio cycle; the cycle clock fills in the time since the last cycle, so
+// the playhead moves on every display frame instead of every period.
+static double elapsedSeconds(const AudioEngine::VoicePosition& pinfo, const AudioEngine::CycleClock& clock,
+                             int64_t nowUsecs)
+{
+    double frames = static_cast<double>(pinfo.frames);
+    if (clock.valid && pinfo.startFrame >= 0 && clock.sampleRate == pinfo.sampleRate) {
+        // Never run past the next cycle, so a stalled engine holds the playhead
+        const int64_t sinceCycle = qBound<int64_t>(0, nowUsecs - clock.usecs, clock.periodUsecs);
+        const double engineFrame = static_cast<double>(clock.frame) + sinceCycle * 1e-6 * clock.sampleRate;
+        frames = std::max(0.0, engineFrame - static_cast<double>(pinfo.startFrame));
+        if (pinfo.totalFrames > 0) frames = std::min(frames, static_cast<double>(pinfo.totalFrames));
+    }
+    return frames / static_cast<double>(pinfo.sampleRate);
+}
+
 void PlayheadManager::onTick()
 {
-    if (!m_engine) return;
-    // iterate files
+    // One clock reading for every voice this tick
+    AudioEngine::CycleClock clock;
+    int64_t nowUsecs = 0;
+    if (m_engine) {
+        clock = m_engine->cycleClock();
+        nowUsecs = m_engine->clockUsecs();
+    }
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    bool active = false;
+
+    // Every voice in one pass over the engine snapshot, joined to the
+    // registered ids by handle below instead of a string scan per id
+    size_t voices = 0;
+    if (m_engine) {
+        voices = m_engine->fillPlaybackSnapshot(m_positions.data(), m_positions.size());
+        if (voices > m_positions.size()) {
+            m_positions.resize(voices * 2);
+            m_voiceOrder.reserve(m_positions.size());
+            voices = std::min(m_positions.size(),
+                              m_engine->fillPlaybackSnapshot(m_positions.data(), m_positions.size()));
+        }
+        // The engine dropped ids since the handles were resolved
+        const uint64_t generation = m_engine->voiceHandleGeneration();
+        if (generation != m_handleGeneration) {
+            m_handleGeneration = generation;
+            for (auto &list : m_map) {
+                for (auto &e : list) e.handle = 0;
+            }
+        }
+    }
+    // Sorted by handle, then snapshot order: the first voice of an id wins,
+    // as in getPlaybackInfoForId()
+    m_voiceOrder.clear();
+    for (size_t i = 0; i < voices; ++i) {
+        if (m_positions[i].handle != 0) m_voiceOrder.emplace_back(m_positions[i].handle, i);
+    }
+    std::sort(m_voiceOrder.begin(), m_voiceOrder.end());
+
     for (auto it = m_map.begin(); it != m_map.end(); ++it) {
-        const QString id = it.key();
+        const QString& id = it.key();
         auto &list = it.value();
         if (list.isEmpty()) continue;
-        AudioEngine::PlaybackInfo pinfo = m_engine->getPlaybackInfoForId(id.toStdString());
-        writeDebugLogPM(QString("onTick id=%1 pinfo.found=%2 frames=%3 sampleRate=%4 listSize=%5").arg(id).arg(pinfo.found).arg((qulonglong)pinfo.frames).arg(pinfo.sampleRate).arg(list.size()));
-        if (!pinfo.found) {
-            // no active voice: ensure containers stop if they were playing
+        if (m_engine && list.first().handle == 0) {
+            const uint64_t handle = m_engine->voiceHandle(id.toStdString());
+            for (auto &e : list) e.handle = handle;
+        }
+        AudioEngine::VoicePosition pinfo;
+        bool found = false;
+        const uint64_t handle = list.first().handle;
+        const auto voice = std::lower_bound(m_voiceOrder.begin(), m_voiceOrder.end(),
+                                            std::make_pair(handle, size_t(0)));
+        if (handle != 0 && voice != m_voiceOrder.end() && voice->first == handle) {
+            pinfo = m_positions[voice->second];
+            found = true;
+        }
+        // A voice that played to its end stays in the mixer until restarted
+        const bool playing = found && pinfo.sampleRate > 0
+            && (pinfo.totalFrames == 0 || pinfo.frames < pinfo.totalFrames);
+
+        if (playing) {
+            const double elapsed = elapsedSeconds(pinfo, clock, nowUsecs);
             for (auto &e : list) {
-                if (e.lastPos != -1.0f) {
-                    e.lastPos = -1.0f;
-                    if (e.sc) e.sc->setPlayheadPosition(-1.0f);
+                if (!e.sc) continue;
+                // The engine is authoritative once it plays the voice
+                e.simStartMs = -1;
+                float pos = -1.0f;
+                // If we don't have a duration from waveform, try to compute it from playback totalFrames
+                if (e.duration <= 0.0 && pinfo.totalFrames > 0) {
+                    e.duration = double(pinfo.totalFrames) / double(pinfo.sampleRate); // cache it for future ticks
+                }
+                if (e.duration > 0.0) pos = static_cast<float>(elapsed / e.duration);
+                if (pos < 0.0f) pos = -1.0f;
+                if (pos > 1.0f) pos = 1.0f;
+                if (pos != e.lastPos) {
+                    e.lastPos = pos;
+                    e.sc->setPlayheadPosition(pos);
                 }
+                if (pos >= 0.0f) active = true;
             }
             continue;
         }
-        if (pinfo.sampleRate <= 0) continue;
-        double elapsed = double(pinfo.frames) / double(pinfo.sampleRate);
-        writeDebugLogPM(QString("onTick id=%1 elapsed=%2s").arg(id).arg(elapsed));
+
+        // No engine voice (yet): simulate from the start timestamp, which
+        // also covers the ticks before a freshly started voice is mixed
         for (auto &e : list) {
             if (!e.sc) continue;
             float pos = -1.0f;
-            // If we don't have a duration from waveform, try to compute it from playback totalFrames
-            if (e.duration > 0.0) {
-                pos = static_cast<float>(elapsed / e.duration);
-            } else if (pinfo.totalFrames > 0 && pinfo.sampleRate > 0) {
-                double dur = double(pinfo.totalFrames) / double(pinfo.sampleRate);
-                if (dur > 0.0) {
-                    e.duration = dur; // cache it for future ticks
-                    pos = static_cast<float>(elapsed / e.duration);
+            if (e.simStartMs >= 0 && e.duration > 0.0) {
+                pos = static_cast<float>(double(nowMs - e.simStartMs) / 1000.0 / e.duration);
+                if (pos > 1.0f) {
+                    // end simulation
+                    e.simStartMs = -1;
+                    pos = -1.0f;
                 }
+                if (pos < 0.0f) pos = -1.0f;
+            } else if (e.simStartMs >= 0 && nowMs - e.simStartMs < 1000) {
+                // Unknown duration: keep ticking a while for the engine to pick the voice up
+                active = true;
             }
-            if (pos < 0.0f) pos = -1.0f;
-            if (pos > 1.0f) pos = 1.0f;
-            // only update if changed by a small epsilon
-            if (std::abs(pos - e.lastPos) > 0.001f) {
-                writeDebugLogPM(QString("update container id=%1 pos=%2 last=%3").arg(id).arg(pos).arg(e.lastPos));
+            if (pos != e.lastPos) {
+                writeDebugLogPM(QString("sim update id=%1 pos=%2 last=%3").arg(id).arg(pos).arg(e.lastPos));
                 e.lastPos = pos;
                 e.sc->setPlayheadPosition(pos);
             }
+            if (pos >= 0.0f) active = true;
         }
     }
 
-        // If playback not found via AudioEngine, support simulated playback based on start timestamps
-        for (auto it2 = m_map.begin(); it2 != m_map.end(); ++it2) {
-            const QString id2 = it2.key();
-            auto &list2 = it2.value();
-            for (auto &e : list2) {
-                if (!e.sc) continue;
-                if (e.simStartMs < 0) continue;
-                if (e.duration <= 0.0) continue;
-                qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
-                double elapsedSec = double(nowMs - e.simStartMs) / 1000.0;
-                float pos = static_cast<float>(elapsedSec / e.duration);
-                if (pos < 0.0f) pos = -1.0f;
-                if (pos > 1.0f) {
-                    // end simulation
-                    e.simStartMs = -1;
-                    pos = -1.0f;
-                }
-                if (std::abs(pos - e.lastPos) > 0.001f) {
-                    writeDebugLogPM(QString("sim update id=%1 pos=%2 last=%3").arg(id2).arg(pos).arg(e.lastPos));
-                    e.lastPos = pos;
-                    e.sc->setPlayheadPosition(pos);
-                }
-            }
-        }
+    // Nothing to animate: sleep until the next playbackStarted()
+    if (!active) m_timer.stop();
 }
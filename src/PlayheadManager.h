@@ -5,6 +5,10 @@
 #include <QMap>
 #include <QList>
 #include <QString>
+#include <utility>
+#include <vector>
+
+#include "VoicePosition.h"
 
 class SoundContainer;
 class AudioEngine;
@@ -34,10 +38,18 @@ public:
     // Notify manager that all playback stopped (clear all playheads)
     void stopAll();
 
+    // The animation timer runs only while a playhead is shown, at the
+    // display refresh rate
+    bool isTicking() const { return m_timer.isActive(); }
+    int tickIntervalMs() const { return m_timer.interval(); }
+
 private slots:
     void onTick();
 
 private:
+    // Start the animation timer if it is not running
+    void wake();
+
     struct Entry {
         SoundContainer* sc = nullptr;
         double duration = 0.0;
@@ -45,10 +57,19 @@ private:
         float lastPos = -1.0f;
         // simulated playback start time in ms since epoch; -1 = not simulating
         qint64 simStartMs = -1;
+        // engine voice handle of the file id, resolved on the first tick
+        uint64_t handle = 0;
     };
 
     AudioEngine* m_engine = nullptr;
     QTimer m_timer;
     // map file id -> list of entries
     QMap<QString, QList<Entry>> m_map;
+    // Per-tick scratch, kept across ticks so a tick does not allocate once
+    // it has seen the most voices: every engine voice, and its {handle,
+    // index into m_positions} sorted for a binary search by handle
+    std::vector<VoicePosition> m_positions;
+    std::vector<std::pair<uint64_t, size_t>> m_voiceOrder;
+    // AudioEngine::voiceHandleGeneration() the entry handles were resolved at
+    uint64_t m_handleGeneration = 0;
 };
@@ -112,6 +112,7 @@ void PreferencesDialog::connectSignals() {
         auto& pm = PreferencesManager::instance();
         QString oldClientName = pm.jackClientName();
         bool oldRememberConnections = pm.jackRememberConnections();
+        int oldBusCount = pm.audioBusCount();
         // Iterate pages and call apply()
         for (int i = 0; i < m_stack->count(); ++i) {
             auto* page = qobject_cast<PreferencesPage*>(m_stack->widget(i));
@@ -119,8 +120,13 @@ void PreferencesDialog::connectSignals() {
         }
         QString newClientName = pm.jackClientName();
         bool newRememberConnections = pm.jackRememberConnections();
-        if (m_mainWindow && (newClientName != oldClientName || newRememberConnections != oldRememberConnections)) {
+        int newBusCount = pm.audioBusCount();
+        if (m_mainWindow && (newClientName != oldClientName || newRememberConnections != oldRememberConnections
+                             || newBusCount != oldBusCount)) {
+            // Port registration only happens on init, so a bus count change needs a restart
             m_mainWindow->restartAudioEngineWithPreferences(oldClientName);
+        } else if (m_mainWindow) {
+            m_mainWindow->applyAudioBusPreferences();
         }
         accept();
     });
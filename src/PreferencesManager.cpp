@@ -52,6 +52,30 @@ void PreferencesManager::setCacheTtlDays(int days) {
     m_settings.setValue("cache/ttlDays", days);
 }
 
+bool PreferencesManager::cacheContentKeys() const {
+    return m_settings.value("cache/contentKeys", true).toBool();
+}
+
+void PreferencesManager::setCacheContentKeys(bool enabled) {
+    m_settings.setValue("cache/contentKeys", enabled);
+}
+
+bool PreferencesManager::cacheApproximateWaveforms() const {
+    return m_settings.value("cache/approximateWaveforms", false).toBool();
+}
+
+void PreferencesManager::setCacheApproximateWaveforms(bool enabled) {
+    m_settings.setValue("cache/approximateWaveforms", enabled);
+}
+
+int PreferencesManager::waveformDecodeThreads() const {
+    return qBound(0, m_settings.value("waveform/decodeThreads", 0).toInt(), 16);
+}
+
+void PreferencesManager::setWaveformDecodeThreads(int threads) {
+    m_settings.setValue("waveform/decodeThreads", qBound(0, threads, 16));
+}
+
 QString PreferencesManager::jackClientName() const {
     QString name = m_settings.value("audio/jackClientName", QStringLiteral("libre-soundboard")).toString();
     if (name.trimmed().isEmpty()) {
@@ -76,6 +100,100 @@ void PreferencesManager::setJackRememberConnections(bool enabled) {
     m_settings.setValue("audio/jackRememberConnections", enabled);
 }
 
+int PreferencesManager::audioBusCount() const {
+    int v = m_settings.value("audio/busCount", 1).toInt();
+    if (v < 1) v = 1;
+    if (v > 8) v = 8;
+    return v;
+}
+
+void PreferencesManager::setAudioBusCount(int count) {
+    if (count < 1) count = 1;
+    if (count > 8) count = 8;
+    m_settings.setValue("audio/busCount", count);
+}
+
+double PreferencesManager::audioBusGain(int bus) const {
+    double v = m_settings.value(QStringLiteral("audio/busGain%1").arg(bus), 1.0).toDouble();
+    if (v < 0.0) v = 0.0;
+    if (v > 2.0) v = 2.0;
+    return v;
+}
+
+void PreferencesManager::setAudioBusGain(int bus, double gain) {
+    if (gain < 0.0) gain = 0.0;
+    if (gain > 2.0) gain = 2.0;
+    m_settings.setValue(QStringLiteral("audio/busGain%1").arg(bus), gain);
+}
+
+bool PreferencesManager::duckingEnabled() const {
+    return m_settings.value("audio/duckEnabled", false).toBool();
+}
+
+void PreferencesManager::setDuckingEnabled(bool enabled) {
+    m_settings.setValue("audio/duckEnabled", enabled);
+}
+
+double PreferencesManager::duckingThresholdDbfs() const {
+    double v = m_settings.value("audio/duckThresholdDbfs", -40.0).toDouble();
+    if (v < -80.0) v = -80.0;
+    if (v > 0.0) v = 0.0;
+    return v;
+}
+
+void PreferencesManager::setDuckingThresholdDbfs(double dbfs) {
+    if (dbfs < -80.0) dbfs = -80.0;
+    if (dbfs > 0.0) dbfs = 0.0;
+    m_settings.setValue("audio/duckThresholdDbfs", dbfs);
+}
+
+double PreferencesManager::duckingDepthDb() const {
+    double v = m_settings.value("audio/duckDepthDb", -12.0).toDouble();
+    if (v < -60.0) v = -60.0;
+    if (v > 0.0) v = 0.0;
+    return v;
+}
+
+void PreferencesManager::setDuckingDepthDb(double db) {
+    if (db < -60.0) db = -60.0;
+    if (db > 0.0) db = 0.0;
+    m_settings.setValue("audio/duckDepthDb", db);
+}
+
+int PreferencesManager::duckingAttackMs() const {
+    int v = m_settings.value("audio/duckAttackMs", 10).toInt();
+    if (v < 1) v = 1;
+    if (v > 1000) v = 1000;
+    return v;
+}
+
+void PreferencesManager::setDuckingAttackMs(int ms) {
+    if (ms < 1) ms = 1;
+    if (ms > 1000) ms = 1000;
+    m_settings.setValue("audio/duckAttackMs", ms);
+}
+
+int PreferencesManager::duckingReleaseMs() const {
+    int v = m_settings.value("audio/duckReleaseMs", 400).toInt();
+    if (v < 10) v = 10;
+    if (v > 5000) v = 5000;
+    return v;
+}
+
+void PreferencesManager::setDuckingReleaseMs(int ms) {
+    if (ms < 10) ms = 10;
+    if (ms > 5000) ms = 5000;
+    m_settings.setValue("audio/duckReleaseMs", ms);
+}
+
+quint32 PreferencesManager::duckingBusMask() const {
+    return m_settings.value("audio/duckBusMask", 1u).toUInt() & 0xFFu;
+}
+
+void PreferencesManager::setDuckingBusMask(quint32 mask) {
+    m_settings.setValue("audio/duckBusMask", mask & 0xFFu);
+}
+
 PreferencesManager::LogLevel PreferencesManager::logLevel() const {
     int v = m_settings.value("debug/logLevel", static_cast<int>(Warning)).toInt();
     if (v < static_cast<int>(Off)) v = static_cast<int>(Off);
@@ -18,6 +18,15 @@ public:
     void setCacheSoftLimitMB(int mb);
     int cacheTtlDays() const;               // default 90
     void setCacheTtlDays(int days);
+    // Key the peak and decoded-audio caches by file contents (ContentFingerprint)
+    bool cacheContentKeys() const;          // default true
+    void setCacheContentKeys(bool enabled);
+    // Show a sampled overview of long files before the exact waveform
+    bool cacheApproximateWaveforms() const; // default false
+    void setCacheApproximateWaveforms(bool enabled);
+    // Threads decoding waveforms; 0 = automatic (WaveformJobService)
+    int waveformDecodeThreads() const;      // default 0, range [0,16]
+    void setWaveformDecodeThreads(int threads);
 
     // Phase 6: JACK connection settings
     QString jackClientName() const;                // default "libre-soundboard"
@@ -25,6 +34,26 @@ public:
     bool jackRememberConnections() const;          // default true
     void setJackRememberConnections(bool enabled);
 
+    // Output buses: each bus is a stereo JACK port pair
+    int audioBusCount() const;                     // default 1, range [1,8]
+    void setAudioBusCount(int count);
+    double audioBusGain(int bus) const;            // default 1.0, range [0,2]
+    void setAudioBusGain(int bus, double gain);
+
+    // Talk-over ducking driven by the JACK input port
+    bool duckingEnabled() const;                   // default false
+    void setDuckingEnabled(bool enabled);
+    double duckingThresholdDbfs() const;           // default -40 dBFS, range [-80,0]
+    void setDuckingThresholdDbfs(double dbfs);
+    double duckingDepthDb() const;                 // default -12 dB, range [-60,0]
+    void setDuckingDepthDb(double db);
+    int duckingAttackMs() const;                   // default 10 ms, range [1,1000]
+    void setDuckingAttackMs(int ms);
+    int duckingReleaseMs() const;                  // default 400 ms, range [10,5000]
+    void setDuckingReleaseMs(int ms);
+    quint32 duckingBusMask() const;                // default 0x1 (bus 1), bit per bus
+    void setDuckingBusMask(quint32 mask);
+
     enum LogLevel { Off = 0, Error = 1, Warning = 2, Info = 3, Debug = 4 };
     LogLevel logLevel() const;              // default Warning
     void setLogLevel(LogLevel lvl);
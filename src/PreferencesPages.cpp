@@ -82,6 +82,17 @@ PrefWaveformCachePage::PrefWaveformCachePage(QWidget* parent)
 	m_ttl->setRange(0, 3650);
 	m_ttl->setSuffix(" days");
 	form->addRow(tr("Cache TTL"), m_ttl);
+	m_contentKeys = new QCheckBox(tr("Share cached waveforms between copies and moved files"), this);
+	m_contentKeys->setObjectName("chkCacheContentKeys");
+	form->addRow(tr("Content Keys"), m_contentKeys);
+	m_approximate = new QCheckBox(tr("Show a quick approximate waveform for long files first"), this);
+	m_approximate->setObjectName("chkCacheApproximate");
+	form->addRow(tr("Approximate Overview"), m_approximate);
+	m_decodeThreads = new QSpinBox(this);
+	m_decodeThreads->setObjectName("spinWaveformDecodeThreads");
+	m_decodeThreads->setRange(0, 16);
+	m_decodeThreads->setSpecialValueText(tr("Automatic"));
+	form->addRow(tr("Decode Threads"), m_decodeThreads);
 	
 	// Phase 4: Add cache directory field
 	m_cacheDir = new QLineEdit(this);
@@ -124,6 +135,9 @@ void PrefWaveformCachePage::apply()
 	auto& pm = PreferencesManager::instance();
 	pm.setCacheSoftLimitMB(m_size->value());
 	pm.setCacheTtlDays(m_ttl->value());
+	pm.setCacheContentKeys(m_contentKeys->isChecked());
+	pm.setCacheApproximateWaveforms(m_approximate->isChecked());
+	pm.setWaveformDecodeThreads(m_decodeThreads->value());
 	if (m_cacheDir) {
 		pm.setCacheDirectory(m_cacheDir->text());
 	}
@@ -134,6 +148,9 @@ void PrefWaveformCachePage::reset()
 	auto& pm = PreferencesManager::instance();
 	m_size->setValue(pm.cacheSoftLimitMB());
 	m_ttl->setValue(pm.cacheTtlDays());
+	m_contentKeys->setChecked(pm.cacheContentKeys());
+	m_approximate->setChecked(pm.cacheApproximateWaveforms());
+	m_decodeThreads->setValue(pm.waveformDecodeThreads());
 	if (m_cacheDir) {
 		m_cacheDir->setText(pm.cacheDirectory());
 	}
@@ -153,6 +170,66 @@ PrefAudioEnginePage::PrefAudioEnginePage(QWidget* parent)
 	m_rememberConnections = new QCheckBox(tr("Remember Jack Connections"), this);
 	m_rememberConnections->setObjectName("chkJackRememberConnections");
 	form->addRow(QString(), m_rememberConnections);
+
+	// Output buses: bus 1 is out_l/out_r, further buses get their own port pairs
+	m_busCount = new QSpinBox(this);
+	m_busCount->setObjectName("spinAudioBusCount");
+	m_busCount->setRange(1, 8);
+	m_busCount->setToolTip(tr("Number of stereo output port pairs (takes effect when the audio engine restarts)"));
+	form->addRow(tr("Output Buses"), m_busCount);
+	for (int b = 0; b < 8; ++b) {
+		auto* row = new QWidget(this);
+		auto* rowLayout = new QHBoxLayout(row);
+		rowLayout->setContentsMargins(0, 0, 0, 0);
+		auto* gain = new QDoubleSpinBox(row);
+		gain->setObjectName(QString("spinAudioBusGain%1").arg(b + 1));
+		gain->setRange(0.0, 2.0);
+		gain->setSingleStep(0.05);
+		gain->setDecimals(2);
+		auto* duck = new QCheckBox(tr("Duck"), row);
+		duck->setObjectName(QString("chkAudioBusDuck%1").arg(b + 1));
+		duck->setToolTip(tr("Lower this bus while the input port is active"));
+		rowLayout->addWidget(gain);
+		rowLayout->addWidget(duck);
+		form->addRow(tr("Bus %1 Gain").arg(b + 1), row);
+		m_busRows.append(row);
+		m_busGains.append(gain);
+		m_busDuck.append(duck);
+	}
+	connect(m_busCount, qOverload<int>(&QSpinBox::valueChanged), this, [this](int) { updateBusGainVisibility(); });
+
+	// Talk-over ducking driven by the input port
+	m_duckEnable = new QCheckBox(tr("Enable"), this);
+	m_duckEnable->setObjectName("chkDuckingEnable");
+	form->addRow(tr("Talk-over Ducking"), m_duckEnable);
+
+	m_duckThreshold = new QDoubleSpinBox(this);
+	m_duckThreshold->setObjectName("spinDuckingThreshold");
+	m_duckThreshold->setRange(-80.0, 0.0);
+	m_duckThreshold->setDecimals(1);
+	m_duckThreshold->setSingleStep(1.0);
+	form->addRow(tr("Threshold (dBFS)"), m_duckThreshold);
+
+	m_duckDepth = new QDoubleSpinBox(this);
+	m_duckDepth->setObjectName("spinDuckingDepth");
+	m_duckDepth->setRange(-60.0, 0.0);
+	m_duckDepth->setDecimals(1);
+	m_duckDepth->setSingleStep(1.0);
+	form->addRow(tr("Depth (dB)"), m_duckDepth);
+
+	m_duckAttack = new QSpinBox(this);
+	m_duckAttack->setObjectName("spinDuckingAttack");
+	m_duckAttack->setRange(1, 1000);
+	m_duckAttack->setSuffix(tr(" ms"));
+	form->addRow(tr("Attack"), m_duckAttack);
+
+	m_duckRelease = new QSpinBox(this);
+	m_duckRelease->setObjectName("spinDuckingRelease");
+	m_duckRelease->setRange(10, 5000);
+	m_duckRelease->setSuffix(tr(" ms"));
+	form->addRow(tr("Release"), m_duckRelease);
+	connect(m_duckEnable, &QCheckBox::toggled, this, [this](bool) { updateDuckingEnabled(); });
+
 	v->addLayout(form);
 	v->addStretch();
 	setLayout(v);
@@ -164,6 +241,18 @@ void PrefAudioEnginePage::apply()
 	auto& pm = PreferencesManager::instance();
 	pm.setJackClientName(m_jackName->text());
 	pm.setJackRememberConnections(m_rememberConnections->isChecked());
+	pm.setAudioBusCount(m_busCount->value());
+	quint32 duckMask = 0;
+	for (int b = 0; b < m_busGains.size(); ++b) {
+		pm.setAudioBusGain(b, m_busGains[b]->value());
+		if (m_busDuck[b]->isChecked()) duckMask |= (1u << b);
+	}
+	pm.setDuckingEnabled(m_duckEnable->isChecked());
+	pm.setDuckingThresholdDbfs(m_duckThreshold->value());
+	pm.setDuckingDepthDb(m_duckDepth->value());
+	pm.setDuckingAttackMs(m_duckAttack->value());
+	pm.setDuckingReleaseMs(m_duckRelease->value());
+	pm.setDuckingBusMask(duckMask);
 }
 
 void PrefAudioEnginePage::reset()
@@ -171,6 +260,41 @@ void PrefAudioEnginePage::reset()
 	auto& pm = PreferencesManager::instance();
 	m_jackName->setText(pm.jackClientName());
 	m_rememberConnections->setChecked(pm.jackRememberConnections());
+	m_busCount->setValue(pm.audioBusCount());
+	const quint32 duckMask = pm.duckingBusMask();
+	for (int b = 0; b < m_busGains.size(); ++b) {
+		m_busGains[b]->setValue(pm.audioBusGain(b));
+		m_busDuck[b]->setChecked((duckMask & (1u << b)) != 0);
+	}
+	m_duckEnable->setChecked(pm.duckingEnabled());
+	m_duckThreshold->setValue(pm.duckingThresholdDbfs());
+	m_duckDepth->setValue(pm.duckingDepthDb());
+	m_duckAttack->setValue(pm.duckingAttackMs());
+	m_duckRelease->setValue(pm.duckingReleaseMs());
+	updateBusGainVisibility();
+	updateDuckingEnabled();
+}
+
+void PrefAudioEnginePage::updateBusGainVisibility()
+{
+	auto* form = findChild<QFormLayout*>();
+	for (int b = 0; b < m_busRows.size(); ++b) {
+		const bool visible = b < m_busCount->value();
+		m_busRows[b]->setVisible(visible);
+		if (form) {
+			if (QWidget* label = form->labelForField(m_busRows[b])) label->setVisible(visible);
+		}
+	}
+}
+
+void PrefAudioEnginePage::updateDuckingEnabled()
+{
+	const bool on = m_duckEnable->isChecked();
+	m_duckThreshold->setEnabled(on);
+	m_duckDepth->setEnabled(on);
+	m_duckAttack->setEnabled(on);
+	m_duckRelease->setEnabled(on);
+	for (auto* duck : m_busDuck) duck->setEnabled(on);
 }
 
 // Debug
@@ -1,6 +1,7 @@
 #pragma once
 #include "PreferencesPage.h"
 #include <functional>
+#include <QVector>
 
 class QDoubleSpinBox;
 class QSpinBox;
@@ -16,8 +17,20 @@ public:
     void apply() override;
     void reset() override;
 private:
+    void updateBusGainVisibility();
+    void updateDuckingEnabled();
+
     QLineEdit* m_jackName = nullptr;
     QCheckBox* m_rememberConnections = nullptr;
+    QSpinBox* m_busCount = nullptr;
+    QVector<QWidget*> m_busRows;
+    QVector<QDoubleSpinBox*> m_busGains;
+    QVector<QCheckBox*> m_busDuck;
+    QCheckBox* m_duckEnable = nullptr;
+    QDoubleSpinBox* m_duckThreshold = nullptr;
+    QDoubleSpinBox* m_duckDepth = nullptr;
+    QSpinBox* m_duckAttack = nullptr;
+    QSpinBox* m_duckRelease = nullptr;
 };
 
 class PrefGridLayoutPage : public PreferencesPage {
@@ -44,6 +57,9 @@ public:
 private:
     QSpinBox* m_size = nullptr;
     QSpinBox* m_ttl = nullptr;
+    QCheckBox* m_contentKeys = nullptr;
+    QCheckBox* m_approximate = nullptr;
+    QSpinBox* m_decodeThreads = nullptr;
     QLineEdit* m_cacheDir = nullptr;
 };
 
@@ -22,16 +22,24 @@
 #include <QFont>
 #include <QDateTime>
 #include <QFile>
+#include <QJsonObject>
 #include <unistd.h>
 #include <QResizeEvent>
 #include <QPaintEvent>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QEnterEvent>
+#include <QPointer>
 #include "WaveformWorker.h"
+#include "WaveformJobService.h"
 #include "PlayheadManager.h"
 #include "WaveformCache.h"
+#include "WaveformCacheProbe.h"
 #include "WaveformRenderer.h"
+#include "WaveformPixmapCache.h"
 #include "PreferencesManager.h"
-#include <sndfile.h>
 #include <cmath>
+#include <algorithm>
 
 QSize SoundContainer::availableDisplaySize() const
 {
@@ -129,7 +137,9 @@ SoundContainer::SoundContainer(QWidget* parent)
     setContentsMargins(6,6,6,6);
 
     connect(m_playBtn, &QPushButton::clicked, this, [this]() {
-        if (!m_filePath.isEmpty()) {
+        if (isScene()) {
+            emit sceneTriggered(this);
+        } else if (!m_filePath.isEmpty()) {
             // locally mark as playing (UI playhead overlay) and notify app
             m_playing = true;
             m_playheadPos = 0.0f;
@@ -163,12 +173,19 @@ SoundContainer::SoundContainer(QWidget* parent)
     // Note: contextMenuEvent is overridden below to prevent the menu
     // from appearing while a right-button drag/press is in progress.
 
+    // Re-render at the exact size once a resize burst is over
+    m_resizeRenderTimer = new QTimer(this);
+    m_resizeRenderTimer->setSingleShot(true);
+    m_resizeRenderTimer->setInterval(kResizeRenderDelayMs);
+    connect(m_resizeRenderTimer, &QTimer::timeout, this, &SoundContainer::onResizeSettled);
+
     // Ensure the initial UI matches the default appearance used for cleared slots
     resetToDefaultAppearance();
 }
 
 SoundContainer::~SoundContainer()
 {
+    WaveformCacheProbe::instance().cancel(this);
     // Cancel any pending waveform job
     if (m_waveWorker && !m_pendingJobId.isNull()) {
         m_waveWorker->cancelJob(m_pendingJobId);
@@ -184,6 +201,23 @@ SoundContainer::~SoundContainer()
 void SoundContainer::onWaveformReady(const WaveformJob& job, const WaveformResult& result)
 {
     if (job.id != m_pendingJobId) return;
+    // The complete result replaces any partial one in a single repaint
+    m_partialWaveform = false;
+
+    if (result.peaks.isValid()) {
+        // Persist the pyramid and render it at the widget's actual size
+        m_peaks = WaveformPackedPeaks::pack(result.peaks);
+        // The decoding thread stamped the file version; nothing is stat'ed here
+        m_waveIdentity = result.identity;
+        renderFromPeaks();
+        if (!result.peakId.key.isEmpty()) {
+            WaveformCache::writePeaks(result.peakId.key, result.peaks, result.peakId.size, result.peakId.stamp);
+        }
+        if (!job.path.isEmpty()) {
+            PlayheadManager::instance()->registerContainer(job.path, this, m_peaks.duration(), m_peaks.sampleRate());
+        }
+        return;
+    }
 
     // Use the waveform widget's logical size as the authoritative width/height
     // for rendering and scaling. This keeps behavior stable and matches the
@@ -207,45 +241,34 @@ void SoundContainer::onWaveformReady(const WaveformJob& job, const WaveformResul
     m_hasWavePixmap = true;
     {
         // Force the pixmap to the container's logical height (ignore aspect ratio)
-        QSize labelSize = availableDisplaySize();
-        int containerW = labelSize.width();
-        int containerH = labelSize.height();
-        qreal widgetDpr = devicePixelRatioF();
-        // Use floor for width so the logical pixmap width never exceeds the container
-        int targetWpx = static_cast<int>(std::floor(containerW * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-        // Use ceil for height to ensure we preserve the visual height
-        int targetHpx = static_cast<int>(std::ceil(containerH * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-        applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
+        const QSize target = waveformTargetPixels();
+        applyWaveformPixmapWithBackdrop(target.width(), target.height());
     }
     update();
 
-    // Write rendered canonical image to cache for future loads
+    // Results without peaks (tests) are only displayed, not cached
     if (!job.path.isEmpty()) {
-        QFileInfo fi(job.path);
-        qint64 size = fi.size();
-        qint64 mtime = fi.lastModified().toSecsSinceEpoch();
-        int channels = result.channels;
-        int samplerate = result.sampleRate;
-        QString key = WaveformCache::makeKey(job.path, size, mtime, channels, samplerate, fdpr, pixelWidth);
-        QJsonObject meta;
-        meta["path"] = job.path;
-        meta["size"] = static_cast<double>(size);
-        meta["mtime"] = static_cast<double>(mtime);
-        meta["channels"] = channels;
-        meta["samplerate"] = samplerate;
-        meta["dpr"] = fdpr;
-        meta["pixelWidth"] = pixelWidth;
-        meta["width"] = img.width();
-        meta["height"] = img.height();
-        meta["duration"] = result.duration;
-        QString cacheDir = WaveformCache::cacheDirPath();
-        WaveformCache::write(key, img, meta);
-
         // Register this container with the playhead manager so it can receive updates
         PlayheadManager::instance()->registerContainer(job.path, this, result.duration, result.sampleRate);
     }
 }
 
+void SoundContainer::onWaveformPartial(const WaveformJob& job, const WaveformResult& partial)
+{
+    if (job.id != m_pendingJobId || !partial.peaks.isValid()) return;
+    // Draw what has been decoded so far; m_peaks stays empty until the
+    // complete result arrives, so nothing partial is cached or persisted
+    const QSize target = waveformTargetPixels();
+    WaveformLevel level = WaveformPyramid::levelForWidth(partial.peaks.levels, partial.peaks.totalFrames, target.width());
+    QImage img = Waveform::renderLevelToImage(level, target.width(), 1.0f, target.height());
+    m_wavePixmap = QPixmap::fromImage(img);
+    m_wavePixmap.setDevicePixelRatio(devicePixelRatioF());
+    m_partialWaveform = true;
+    m_hasWavePixmap = true;
+    applyWaveformPixmapWithBackdrop(target.width(), target.height());
+    update();
+}
+
 void SoundContainer::onWaveformError(const WaveformJob& job, const QString& err)
 {
     qWarning() << "onWaveformError job.id=" << job.id << "err=" << err;
@@ -253,6 +276,7 @@ void SoundContainer::onWaveformError(const WaveformJob& job, const QString& err)
     Q_UNUSED(err);
     // For now, just clear waveform display and if no file is set restore default appearance
     m_hasWavePixmap = false;
+    m_partialWaveform = false;
     m_waveform->setPixmap(QPixmap());
     if (m_filePath.isEmpty()) resetToDefaultAppearance();
     else {
@@ -423,17 +447,43 @@ void SoundContainer::contextMenuEvent(QContextMenuEvent* event)
                 m_backdropColor = c;
                 // Re-apply current pixmap with new backdrop if present
                 if (m_hasWavePixmap && !m_wavePixmap.isNull()) {
-                    QSize labelSize = availableDisplaySize();
-                    qreal widgetDpr = devicePixelRatioF();
-                    int targetWpx = static_cast<int>(std::ceil(labelSize.width() * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-                    int targetHpx = static_cast<int>(std::ceil(labelSize.height() * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-                    applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
+                    const QSize target = waveformTargetPixels();
+                    applyWaveformPixmapWithBackdrop(target.width(), target.height());
                 }
             }
         });
+        // Route this slot to one of the configured output buses
+        const int busCount = PreferencesManager::instance().audioBusCount();
+        if (busCount > 1 || m_outputBus > 0) {
+            QMenu* busMenu = menu.addMenu(tr("Output Bus"));
+            for (int b = 0; b < std::max(busCount, m_outputBus + 1); ++b) {
+                QAction* act = busMenu->addAction(tr("Bus %1").arg(b + 1), this, [this, b]() {
+                    setOutputBus(b);
+                });
+                act->setCheckable(true);
+                act->setChecked(b == m_outputBus);
+            }
+        }
+    } else if (isScene()) {
+        menu.addAction(tr("Play Scene"), this, [this]() { emit sceneTriggered(this); });
+        menu.addAction(tr("Edit Scene..."), this, [this]() { emit editSceneRequested(this); });
+        menu.addAction(tr("Clear"), this, [this]() { emit clearRequested(this); });
     } else {
         QAction* a = menu.addAction(tr("Play Sound"));
         a->setEnabled(false);
+        if (m_recordState == RecordState::None) {
+            menu.addAction(tr("New Scene..."), this, [this]() { emit editSceneRequested(this); });
+        }
+        // Record-to-slot from the JACK input port
+        menu.addSeparator();
+        if (m_recordState == RecordState::None) {
+            menu.addAction(tr("Arm Recording"), this, [this]() { emit armRecordRequested(this); });
+        } else if (m_recordState == RecordState::Armed) {
+            menu.addAction(tr("Start Recording"), this, [this]() { emit recordRequested(this); });
+            menu.addAction(tr("Disarm"), this, [this]() { emit stopRecordRequested(this); });
+        } else {
+            menu.addAction(tr("Stop Recording"), this, [this]() { emit stopRecordRequested(this); });
+        }
     }
     menu.exec(event->globalPos());
 }
@@ -455,14 +505,26 @@ void SoundContainer::setFile(const QString& path)
             PlayheadManager::instance()->unregisterContainer(m_filePath, this);
         }
         m_filePath.clear();
+        m_peaks = WaveformPackedPeaks();
+        m_probeId = 0;
+        m_waveIdentity.clear();
         resetToDefaultAppearance();
         setVolume(0.8f);
+        setOutputBus(0);
         emit fileChanged(QString());
         return;
     }
 
+    if (isScene()) setScene({});
+    m_peaks = WaveformPackedPeaks();
+    m_probeId = 0;
+
     m_filePath = path;
+    m_assignedAt.start();
     QFileInfo fi(path);
+    // No file access on the GUI thread: the probe computes the identity. One
+    // already known lets another slot's pixmap show right away.
+    m_waveIdentity = WaveformPixmapCache::instance().knownIdentity(path);
     m_filenameLabel->setText(fi.fileName());
     // show filename on hover (not the full path)
     m_filenameLabel->setToolTip(fi.fileName());
@@ -475,69 +537,152 @@ void SoundContainer::setFile(const QString& path)
     if (!m_waveWorker) {
         m_waveWorker = new WaveformWorker(this);
         connect(m_waveWorker, &WaveformWorker::waveformReady, this, &SoundContainer::onWaveformReady, Qt::QueuedConnection);
+        connect(m_waveWorker, &WaveformWorker::waveformPartial, this, &SoundContainer::onWaveformPartial, Qt::QueuedConnection);
         connect(m_waveWorker, &WaveformWorker::waveformError, this, &SoundContainer::onWaveformError, Qt::QueuedConnection);
     }
 
-    // enqueue a render for current label width and DPR
-    int px = qMax(1, m_waveform->width());
-    qreal dpr = devicePixelRatioF();
-
-    // Try to load cached rendered image first. We need file size, mtime and audio metadata (channels/samplerate)
-    qint64 size = fi.size();
-    qint64 mtime = fi.lastModified().toSecsSinceEpoch();
-    int channels = 0;
-    int samplerate = 0;
-    // Try libsndfile to probe header quickly
-    QByteArray ba = m_filePath.toLocal8Bit();
-    const char* cpath = ba.constData();
-    SF_INFO sfinfo;
-    memset(&sfinfo, 0, sizeof(sfinfo));
-    SNDFILE* snd = sf_open(cpath, SFM_READ, &sfinfo);
-    if (snd) {
-        samplerate = sfinfo.samplerate;
-        channels = sfinfo.channels;
-        sf_close(snd);
-    }
-
-    QString key;
-    const int preferredCachePx = 500;
-    if (channels > 0 && samplerate > 0) {
-        QJsonObject meta;
-        // Try to load the canonical large cache (preferredCachePx). If present,
-        // use it (scaled) and avoid enqueuing work for the current widget size.
-        QImage cached = WaveformCache::load(WaveformCache::makeKey(m_filePath, size, mtime, channels, samplerate, static_cast<float>(dpr), preferredCachePx), &meta);
-        if (!cached.isNull()) {
-            m_wavePixmap = QPixmap::fromImage(cached);
-            m_hasWavePixmap = true;
-            {
-                // Force cached pixmap to the container's logical height and width.
-                QSize labelSize = availableDisplaySize();
-                int containerW = labelSize.width();
-                int containerH = labelSize.height();
-                qreal widgetDpr = devicePixelRatioF();
-                int targetWpx = static_cast<int>(std::floor(containerW * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-                int targetHpx = static_cast<int>(std::ceil(containerH * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-                applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
-            }
-            update();
-            double duration = meta.contains("duration") ? meta.value("duration").toDouble() : 0.0;
-            int sr = meta.contains("samplerate") ? meta.value("samplerate").toInt() : samplerate;
-            if (!m_filePath.isEmpty()) {
-                PlayheadManager::instance()->registerContainer(m_filePath, this, duration, sr);
-            }
-            return;
-        }
+    // cancel previous job
+    if (!m_pendingJobId.isNull()) {
+        m_waveWorker->cancelJob(m_pendingJobId);
+        m_pendingJobId = QUuid();
     }
+    m_hasWavePixmap = false;
+    m_partialWaveform = false;
 
-    // cancel previous job
+    // Probe the peak cache off the GUI thread; a miss enqueues a render job
+    startCacheProbe();
+    // Another slot may already show this file at our size: display it now,
+    // the probe still provides the peaks
+    applyCachedWaveform();
+}
+
+void SoundContainer::enqueueWaveformJob(qint64 size, qint64 mtimeMs)
+{
+    if (!m_waveWorker || m_filePath.isEmpty()) return;
     if (!m_pendingJobId.isNull()) {
         m_waveWorker->cancelJob(m_pendingJobId);
         m_pendingJobId = QUuid();
     }
     m_hasWavePixmap = false;
+    m_partialWaveform = false;
     m_waveform->setText(tr("Rendering..."));
-    // Enqueue a job to generate the canonical large cache (preferredCachePx)
-    m_pendingJobId = m_waveWorker->enqueueJob(m_filePath, preferredCachePx, dpr);
+    // Enqueue a job to generate the peaks (the pixel width only shapes the
+    // legacy min/max preview)
+    const int preferredCachePx = 500;
+    m_pendingJobId = m_waveWorker->enqueueJob(m_filePath, preferredCachePx, devicePixelRatioF(), waveformPriority(),
+                                              size, mtimeMs);
+}
+
+WaveformPriority SoundContainer::waveformPriority() const
+{
+    // Slots assigned this recently are likely to be looked at next
+    constexpr qint64 kRecentMs = 10000;
+    if (underMouse()) return WaveformPriority::Hovered;
+    if (isVisible()) return WaveformPriority::Visible;
+    if (m_assignedAt.isValid() && m_assignedAt.elapsed() < kRecentMs) return WaveformPriority::Recent;
+    return WaveformPriority::Background;
+}
+
+void SoundContainer::updateWaveformPriority()
+{
+    if (!m_waveWorker || m_pendingJobId.isNull()) return;
+    m_waveWorker->setJobPriority(m_pendingJobId, waveformPriority());
+}
+
+void SoundContainer::setFileWithWaveform(const QString& path, const WaveformResult& waveform)
+{
+    if (path.isEmpty() || waveform.sampleRate <= 0) {
+        setFile(path);
+        return;
+    }
+    if (m_waveWorker && !m_pendingJobId.isNull()) {
+        m_waveWorker->cancelJob(m_pendingJobId);
+    }
+    m_probeId = 0;
+    if (!m_filePath.isEmpty() && m_filePath != path) {
+        PlayheadManager::instance()->unregisterContainer(m_filePath, this);
+    }
+    setRecordState(RecordState::None);
+
+    m_filePath = path;
+    QFileInfo fi(path);
+    m_filenameLabel->setText(fi.fileName());
+    m_filenameLabel->setToolTip(fi.fileName());
+    setVolume(0.8f);
+    emit fileChanged(path);
+
+    // Render through the normal completion path so the image is cached and
+    // the container is registered with the playhead manager
+    WaveformJob job;
+    job.id = QUuid::createUuid();
+    job.path = path;
+    job.pixelWidth = 500;   // same canonical cache width as setFile()
+    job.dpr = devicePixelRatioF();
+    m_pendingJobId = job.id;
+    onWaveformReady(job, waveform);
+}
+
+void SoundContainer::setScene(const QVector<SceneMember>& members)
+{
+    if (!m_filePath.isEmpty() && !members.isEmpty()) return;
+    const bool wasScene = isScene();
+    m_scene = members;
+    if (isScene()) {
+        QStringList lines;
+        for (const SceneMember& m : m_scene) {
+            QString name = QFileInfo(m.path).fileName();
+            lines << (m.offsetMs > 0 ? tr("%1 (+%2 ms)").arg(name).arg(m.offsetMs) : name);
+        }
+        m_filenameLabel->setText(tr("Scene: %n sound(s)", nullptr, m_scene.size()));
+        m_filenameLabel->setToolTip(lines.join('\n'));
+    } else if (wasScene) {
+        resetToDefaultAppearance();
+    }
+    if (isScene() || wasScene) emit sceneChanged();
+}
+
+QJsonArray SoundContainer::sceneToJson() const
+{
+    QJsonArray arr;
+    for (const SceneMember& m : m_scene) {
+        QJsonObject o;
+        o["path"] = m.path;
+        if (m.offsetMs > 0) o["offsetMs"] = m.offsetMs;
+        arr.append(o);
+    }
+    return arr;
+}
+
+void SoundContainer::setSceneFromJson(const QJsonArray& arr)
+{
+    QVector<SceneMember> members;
+    for (const QJsonValue& v : arr) {
+        if (!v.isObject()) continue;
+        QJsonObject o = v.toObject();
+        SceneMember m;
+        m.path = o.value("path").toString();
+        m.offsetMs = std::max(0, o.value("offsetMs").toInt(0));
+        if (!m.path.isEmpty()) members.push_back(m);
+    }
+    setScene(members);
+}
+
+void SoundContainer::setRecordState(RecordState state)
+{
+    if (state == m_recordState) return;
+    m_recordState = state;
+    if (!m_filePath.isEmpty() || !m_filenameLabel) return;
+    switch (state) {
+    case RecordState::Armed:
+        m_filenameLabel->setText(tr("Armed: waiting to record"));
+        break;
+    case RecordState::Recording:
+        m_filenameLabel->setText(tr("Recording..."));
+        break;
+    default:
+        m_filenameLabel->setText(tr("Drop audio file here"));
+        break;
+    }
 }
 
 void SoundContainer::setVolume(float v)
@@ -575,136 +720,113 @@ void SoundContainer::resizeEvent(QResizeEvent* event)
     // when resized, request a new waveform render if we have a file
     if (!m_filePath.isEmpty()) {
         if (!m_waveWorker) return;
-        // Prefer a canonical large cache image and scale it for any widget size
-        const int preferredCachePx = 500;
-        qreal dpr = devicePixelRatioF();
 
-        // If we already have a pixmap (from cache or prior render), just rescale
+        // If we already have a pixmap (from cache or prior render), stretch it
+        // for now and re-render from the peaks once resizing settles
         if (m_hasWavePixmap) {
-            // Force existing pixmap to the container's logical height and width.
-            QSize labelSize = availableDisplaySize();
-            int containerW = labelSize.width();
-            int containerH = labelSize.height();
-            qreal widgetDpr = devicePixelRatioF();
-            int targetWpx = static_cast<int>(std::floor(containerW * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-            int targetHpx = static_cast<int>(std::ceil(containerH * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-            applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
+            // Another slot may already show this file at the new size
+            if (m_peaks.isValid() && !m_partialWaveform && applyCachedWaveform()) {
+                m_resizeRenderTimer->stop();
+                return;
+            }
+            if (m_peaks.isValid() && !m_partialWaveform) m_resizeRenderTimer->start();
+            const QSize target = waveformTargetPixels();
+            applyWaveformPixmapWithBackdrop(target.width(), target.height());
             update();
             return;
         }
 
-        // If a generation job is already pending, don't enqueue again
-        if (!m_pendingJobId.isNull()) return;
-
-        // Try to pre-load the canonical cache; if found, use it
-        QFileInfo fi(m_filePath);
-        qint64 size = fi.size();
-        qint64 mtime = fi.lastModified().toSecsSinceEpoch();
-        int channels = 0;
-        int samplerate = 0;
-        QByteArray ba = m_filePath.toLocal8Bit();
-        const char* cpath = ba.constData();
-        SF_INFO sfinfo;
-        memset(&sfinfo, 0, sizeof(sfinfo));
-        SNDFILE* snd = sf_open(cpath, SFM_READ, &sfinfo);
-        if (snd) {
-            samplerate = sfinfo.samplerate;
-            channels = sfinfo.channels;
-            sf_close(snd);
-        }
+        // If a probe or generation job is already pending, don't enqueue again
+        if (m_probeId != 0 || !m_pendingJobId.isNull()) return;
 
-        if (channels > 0 && samplerate > 0) {
-            QJsonObject meta;
-            QImage cached = WaveformCache::load(WaveformCache::makeKey(m_filePath, size, mtime, channels, samplerate, static_cast<float>(dpr), preferredCachePx), &meta);
-            if (!cached.isNull()) {
-                m_wavePixmap = QPixmap::fromImage(cached);
-                m_hasWavePixmap = true;
-                {
-                    // Force cached pixmap to the container's logical height and width.
-                    QSize labelSize = availableDisplaySize();
-                    int containerW = labelSize.width();
-                    int containerH = labelSize.height();
-                    qreal widgetDpr = devicePixelRatioF();
-                    int targetWpx = static_cast<int>(std::ceil(containerW * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-                    int targetHpx = static_cast<int>(std::ceil(containerH * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-                    Q_UNUSED(widgetDpr); Q_UNUSED(targetWpx); Q_UNUSED(targetHpx); Q_UNUSED(containerW); Q_UNUSED(containerH);
-                    applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
-                }
-                update();
-                double duration = meta.contains("duration") ? meta.value("duration").toDouble() : 0.0;
-                int sr = meta.contains("samplerate") ? meta.value("samplerate").toInt() : samplerate;
-                PlayheadManager::instance()->registerContainer(m_filePath, this, duration, sr);
-                return;
-            }
-        }
-
-        // No cache found and no job pending: enqueue a canonical generation job
-        m_hasWavePixmap = false;
-        m_waveform->setText(tr("Rendering..."));
-        m_pendingJobId = m_waveWorker->enqueueJob(m_filePath, preferredCachePx, dpr);
+        // Probe the peak cache; a miss enqueues a generation job
+        startCacheProbe();
     }
 }
 
+void SoundContainer::showEvent(QShowEvent* event)
+{
+    QFrame::showEvent(event);
+    // Our tab became visible: serve our pending cache probe first
+    if (m_probeId != 0) WaveformCacheProbe::instance().promote(this);
+    updateWaveformPriority();
+}
+
+void SoundContainer::hideEvent(QHideEvent* event)
+{
+    QFrame::hideEvent(event);
+    // Our tab was switched away: let the visible tab's decodes go first
+    updateWaveformPriority();
+}
+
+void SoundContainer::enterEvent(QEnterEvent* event)
+{
+    QFrame::enterEvent(event);
+    updateWaveformPriority();
+}
+
+void SoundContainer::leaveEvent(QEvent* event)
+{
+    QFrame::leaveEvent(event);
+    updateWaveformPriority();
+}
+
 void SoundContainer::paintEvent(QPaintEvent* event)
 {
     QFrame::paintEvent(event);
     if (!m_hasWavePixmap) return;
     if (!m_playing) return;
+    // compute playhead x
+    if (m_playheadPos < 0.0f) return;
+    const QRect strip = playheadRect(m_playheadPos);
+    // Ticks only invalidate the old and new strip; skip the line otherwise
+    if (!event->region().intersects(strip)) return;
 
     QPainter p(this);
     QRect wfRect = m_waveform->geometry();
     p.setRenderHint(QPainter::Antialiasing);
-    // compute playhead x
-    if (m_playheadPos < 0.0f) return;
-    int x = wfRect.left() + static_cast<int>(m_playheadPos * wfRect.width());
+    const int x = playheadX(m_playheadPos);
     QPen pen(QColor(255,200,60, 220));
     pen.setWidth(2);
     p.setPen(pen);
     p.drawLine(x, wfRect.top()+2, x, wfRect.bottom()-2);
 }
 
+int SoundContainer::playheadX(float pos) const
+{
+    const QRect wfRect = m_waveform->geometry();
+    return wfRect.left() + static_cast<int>(pos * wfRect.width());
+}
+
+QRect SoundContainer::playheadRect(float pos) const
+{
+    // The 2 px antialiased pen touches the column on either side of x
+    const QRect wfRect = m_waveform->geometry();
+    return QRect(playheadX(pos) - 2, wfRect.top(), 5, wfRect.height());
+}
+
 void SoundContainer::setPlayheadPosition(float pos)
 {
+    // Runs on every PlayheadManager tick for every playing container: the
+    // label keeps its pixmap, only the strips under the old and new
+    // playhead are repainted
+    const bool wasShown = m_playing && m_playheadPos >= 0.0f;
+    const float oldPos = m_playheadPos;
     // pos in [0,1], negative -> hidden/stopped
     if (pos < 0.0f) {
         m_playing = false;
         m_playheadPos = -1.0f;
-        // restore original waveform pixmap when stopped
-                if (m_hasWavePixmap) {
-                    // Restore original waveform pixmap scaled to container height and width
-                    QSize labelSize = availableDisplaySize();
-                    int containerW = labelSize.width();
-                    int containerH = labelSize.height();
-                    qreal widgetDpr = devicePixelRatioF();
-                    int targetWpx = static_cast<int>(std::ceil(containerW * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-                    int targetHpx = static_cast<int>(std::ceil(containerH * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-                    Q_UNUSED(widgetDpr); Q_UNUSED(targetWpx); Q_UNUSED(targetHpx); Q_UNUSED(containerW); Q_UNUSED(containerH);
-                    applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
-                }
-    } else {
-        m_playing = true;
-        m_playheadPos = pos;
-        // Ensure the label shows the original waveform pixmap (without any drawn
-        // playhead). Previously we mutated the label pixmap to draw the playhead,
-        // which produced a duplicate when `paintEvent` also drew the overlay.
-        if (m_hasWavePixmap && !m_wavePixmap.isNull()) {
-            QSize labelSize = availableDisplaySize();
-            if (labelSize.width() > 0 && labelSize.height() > 0) {
-                qreal widgetDpr = devicePixelRatioF();
-                int targetWpx = static_cast<int>(std::ceil(labelSize.width() * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-                int targetHpx = static_cast<int>(std::ceil(labelSize.height() * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-                QPixmap scaled = m_wavePixmap.scaled(QSize(targetWpx, targetHpx), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-                scaled.setDevicePixelRatio(widgetDpr);
-                m_waveform->setText(QString());
-                m_waveform->setPixmap(scaled);
-            }
-        }
-        // We rely on `paintEvent` to draw the transient playhead overlay above the waveform
-        // to avoid mutating the cached pixmap and producing duplicate playheads.
+        if (wasShown) update(playheadRect(oldPos));
+        return;
     }
-    // Log to debug file and update UI (help trace stop behavior)
-    writeLocalDebug(QString("setPlayheadPosition this=%1 pos=%2 playing=%3").arg(reinterpret_cast<uintptr_t>(this)).arg(pos).arg(m_playing));
-    update();
+    m_playing = true;
+    m_playheadPos = pos;
+    if (wasShown) {
+        // Sub-pixel movement: nothing on screen changes
+        if (playheadX(oldPos) == playheadX(pos)) return;
+        update(playheadRect(oldPos));
+    }
+    update(playheadRect(pos));
 }
 
 
@@ -751,16 +873,181 @@ void SoundContainer::dropEvent(QDropEvent* event)
     event->ignore();
 }
 
+QSize SoundContainer::waveformTargetPixels() const
+{
+    QSize labelSize = availableDisplaySize();
+    qreal widgetDpr = devicePixelRatioF();
+    // Floor the width so the logical pixmap width never exceeds the
+    // container; ceil the height to preserve the visual height
+    int targetWpx = static_cast<int>(std::floor(labelSize.width() * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
+    int targetHpx = static_cast<int>(std::ceil(labelSize.height() * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
+    return QSize(targetWpx, targetHpx);
+}
+
+void SoundContainer::startCacheProbe()
+{
+    m_waveform->setText(tr("Loading..."));
+    // Containers on the current tab are probed before hidden tabs
+    const bool visible = isVisibleTo(window());
+    m_probeId = WaveformCacheProbe::instance().request(this, m_filePath, waveformTargetPixels(), visible,
+        [this](const WaveformCacheProbe::Result& r) { onCacheProbeFinished(r); });
+}
+
+void SoundContainer::onCacheProbeFinished(const WaveformCacheProbe::Result& result)
+{
+    if (result.id != m_probeId) return;
+    m_probeId = 0;
+    if (result.path != m_filePath) return;
+    m_waveIdentity = result.identity;
+    if (!result.hit) {
+        enqueueWaveformJob(result.size, result.mtimeMs);
+        return;
+    }
+
+    m_peaks = result.peaks;
+    const QSize target = waveformTargetPixels();
+    if (applyCachedWaveform()) {
+        // Already shown from the shared pixmap cache
+    } else if (!result.image.isNull() && result.image.size() == target) {
+        // Rendered by the probe worker at our current size
+        const qreal dpr = devicePixelRatioF();
+        m_wavePixmap = QPixmap::fromImage(result.image);
+        m_wavePixmap.setDevicePixelRatio(dpr);
+        WaveformPixmapCache::instance().insert(WaveformPixmapCache::keyFor(m_waveIdentity, target, dpr, QColor()), m_wavePixmap);
+        m_hasWavePixmap = true;
+        applyWaveformPixmapWithBackdrop(target.width(), target.height());
+        update();
+    } else {
+        renderFromPeaks();
+    }
+    PlayheadManager::instance()->registerContainer(m_filePath, this, m_peaks.duration(), m_peaks.sampleRate());
+}
+
+bool SoundContainer::applyCachedWaveform()
+{
+    if (m_waveIdentity.isEmpty()) return false;
+    const QSize target = waveformTargetPixels();
+    QPixmap pm;
+    if (!WaveformPixmapCache::instance().lookup(
+            WaveformPixmapCache::keyFor(m_waveIdentity, target, devicePixelRatioF(), QColor()), &pm)) {
+        return false;
+    }
+    m_wavePixmap = pm;
+    m_hasWavePixmap = true;
+    applyWaveformPixmapWithBackdrop(target.width(), target.height());
+    update();
+    return true;
+}
+
+void SoundContainer::renderFromPeaks()
+{
+    if (!m_peaks.isValid()) return;
+    // Supersedes any off-thread render still in flight
+    ++m_renderSeq;
+    if (applyCachedWaveform()) return;
+    const QSize target = waveformTargetPixels();
+    const qreal dpr = devicePixelRatioF();
+
+    // One min/max column per device pixel, straight from the pyramid
+    WaveformLevel level = m_peaks.levelForWidth(target.width());
+    QImage img = Waveform::renderLevelToImage(level, target.width(), 1.0f, target.height());
+    m_wavePixmap = QPixmap::fromImage(img);
+    m_wavePixmap.setDevicePixelRatio(dpr);
+    if (!m_waveIdentity.isEmpty()) {
+        WaveformPixmapCache::instance().insert(WaveformPixmapCache::keyFor(m_waveIdentity, target, dpr, QColor()), m_wavePixmap);
+    }
+    m_hasWavePixmap = true;
+    applyWaveformPixmapWithBackdrop(target.width(), target.height());
+    update();
+}
+
+void SoundContainer::onResizeSettled()
+{
+    if (!m_peaks.isValid() || m_partialWaveform) return;
+    const QSize target = waveformTargetPixels();
+    if (m_wavePixmap.size() == target) return;
+    if (applyCachedWaveform()) return;
+
+    // Small width changes are cheap to render in place
+    const int oldWidth = m_wavePixmap.width();
+    if (oldWidth > 0 && std::abs(target.width() - oldWidth) * 4 < oldWidth) {
+        renderFromPeaks();
+        return;
+    }
+
+    // Large ones (a maximized window, a wide 4K layout) render on a waveform
+    // thread; the stretched pixmap stays up until the result arrives
+    const quint64 seq = ++m_renderSeq;
+    const QString identity = m_waveIdentity;
+    const WaveformPackedPeaks peaks = m_peaks;
+    QPointer<SoundContainer> self(this);
+    WaveformJobService::instance().startRender([self, seq, identity, peaks, target]() {
+        const WaveformLevel level = peaks.levelForWidth(target.width());
+        const QImage image = Waveform::renderLevelToImage(level, target.width(), 1.0f, target.height());
+        // qApp outlives every container; `self` tells whether this one is still there
+        QMetaObject::invokeMethod(qApp, [self, seq, identity, target, image]() {
+            if (self) self->onAsyncRenderFinished(seq, identity, target, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SoundContainer::onAsyncRenderFinished(quint64 seq, const QString& identity, const QSize& target,
+                                           const QImage& image)
+{
+    // A newer render, another file or another size made this one stale
+    if (seq != m_renderSeq || identity != m_waveIdentity || !m_peaks.isValid() || m_partialWaveform) return;
+    if (target != waveformTargetPixels()) return;
+    const qreal dpr = devicePixelRatioF();
+    m_wavePixmap = QPixmap::fromImage(image);
+    m_wavePixmap.setDevicePixelRatio(dpr);
+    if (!m_waveIdentity.isEmpty()) {
+        WaveformPixmapCache::instance().insert(WaveformPixmapCache::keyFor(m_waveIdentity, target, dpr, QColor()), m_wavePixmap);
+    }
+    m_hasWavePixmap = true;
+    applyWaveformPixmapWithBackdrop(target.width(), target.height());
+    update();
+}
+
 void SoundContainer::applyWaveformPixmapWithBackdrop(int targetWpx, int targetHpx)
 {
     if (m_wavePixmap.isNull()) return;
     qreal widgetDpr = devicePixelRatioF();
+    const QSize target(targetWpx, targetHpx);
+    // Only exact-size renders are shared; rescaled previews stay private
+    const bool shareable = !m_partialWaveform && !m_waveIdentity.isEmpty() && m_wavePixmap.size() == target;
+    const QString key = shareable ? WaveformPixmapCache::keyFor(m_waveIdentity, target, widgetDpr, m_backdropColor) : QString();
+    QPixmap cached;
+    if (shareable && WaveformPixmapCache::instance().lookup(key, &cached)) {
+        m_waveform->setText(QString());
+        m_waveform->setPixmap(cached);
+        return;
+    }
+
     // Scale the canonical pixmap to the target logical pixel dimensions
-    QPixmap scaled = m_wavePixmap.scaled(QSize(targetWpx, targetHpx), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    scaled.setDevicePixelRatio(widgetDpr);
+    // (pixmaps rendered from peaks already have the exact size). A stretch
+    // that an exact render will soon replace does not need to be smooth.
+    const Qt::TransformationMode mode = m_resizeRenderTimer->isActive() ? Qt::FastTransformation
+                                                                        : Qt::SmoothTransformation;
+    QPixmap scaled;
+    if (m_wavePixmap.size() == target) {
+        scaled = m_wavePixmap;
+    } else if (m_scaledWaveSource == m_wavePixmap.cacheKey() && m_scaledWave.size() == target) {
+        // Backdrop changes and repeated applies reuse the last smooth stretch
+        scaled = m_scaledWave;
+    } else {
+        scaled = m_wavePixmap.scaled(target, Qt::IgnoreAspectRatio, mode);
+        scaled.setDevicePixelRatio(widgetDpr);
+        if (mode == Qt::SmoothTransformation) {
+            m_scaledWave = scaled;
+            m_scaledWaveSource = m_wavePixmap.cacheKey();
+        }
+    }
+    // Setting the ratio detaches a shared pixmap, so only do it when needed
+    if (scaled.devicePixelRatio() != widgetDpr) scaled.setDevicePixelRatio(widgetDpr);
 
     // If there's no valid backdrop color, just set the scaled pixmap
     if (!m_backdropColor.isValid()) {
+        if (shareable) WaveformPixmapCache::instance().insert(key, scaled);
         m_waveform->setText(QString());
         m_waveform->setPixmap(scaled);
         return;
@@ -777,6 +1064,7 @@ void SoundContainer::applyWaveformPixmapWithBackdrop(int targetWpx, int targetHp
 
     QPixmap outPm = QPixmap::fromImage(out);
     outPm.setDevicePixelRatio(widgetDpr);
+    if (shareable) WaveformPixmapCache::instance().insert(key, outPm);
     m_waveform->setText(QString());
     m_waveform->setPixmap(outPm);
 }
@@ -787,11 +1075,8 @@ void SoundContainer::setBackdropColor(const QColor& c)
     emit backdropColorChanged(c);
     // reapply to current pixmap if present
     if (m_hasWavePixmap && !m_wavePixmap.isNull()) {
-        QSize labelSize = availableDisplaySize();
-        qreal widgetDpr = devicePixelRatioF();
-        int targetWpx = static_cast<int>(std::ceil(labelSize.width() * widgetDpr)); if (targetWpx < 1) targetWpx = 1;
-        int targetHpx = static_cast<int>(std::ceil(labelSize.height() * widgetDpr)); if (targetHpx < 1) targetHpx = 1;
-        applyWaveformPixmapWithBackdrop(targetWpx, targetHpx);
+        const QSize target = waveformTargetPixels();
+        applyWaveformPixmapWithBackdrop(target.width(), target.height());
     }
 }
 
@@ -800,11 +1085,22 @@ QColor SoundContainer::backdropColor() const
     return m_backdropColor;
 }
 
+void SoundContainer::setOutputBus(int bus)
+{
+    if (bus < 0) bus = 0;
+    if (bus == m_outputBus) return;
+    m_outputBus = bus;
+    emit outputBusChanged(bus);
+}
+
 void SoundContainer::resetToDefaultAppearance()
 {
     // Clear waveform display
     m_waveform->setPixmap(QPixmap());
     m_hasWavePixmap = false;
+    m_partialWaveform = false;
+    m_scaledWave = QPixmap();
+    m_scaledWaveSource = 0;
     // Clear waveform text area
     m_waveform->setText(QString());
     m_waveform->setToolTip(QString());
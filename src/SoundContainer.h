@@ -2,17 +2,24 @@
 
 #include <QFrame>
 #include <QString>
+#include <QVector>
+#include <QJsonArray>
+#include <QElapsedTimer>
 
 #include <QUuid>
+#include "WaveformCacheProbe.h"
+#include "WaveformPackedPeaks.h"
 class QPushButton;
 class QLabel;
 class QSlider;
 class QResizeEvent;
 class QPaintEvent;
+class QTimer;
 
 // forward declare worker structs
 struct WaveformJob;
 struct WaveformResult;
+enum class WaveformPriority;
 
 /**
  * A single sound container shown in the grid. Displays a waveform, play button and volume knob.
@@ -24,14 +31,41 @@ public:
     explicit SoundContainer(QWidget* parent = nullptr);
     ~SoundContainer() override;
 
+    // Quiet period after the last resize before the waveform is re-rendered
+    // from its peaks at the new size (until then the old one is stretched)
+    static constexpr int kResizeRenderDelayMs = 80;
+
     // Test helper: apply a precomputed WaveformResult as if a job completed.
     // This avoids needing to run the background worker in unit tests.
     void applyWaveformResultForTest(const struct WaveformResult& result);
 
     void setFile(const QString& path);
+    // Assign a file whose waveform is already known (e.g. a freshly recorded
+    // take) without probing or decoding the file again. Only a waveform
+    // stamped with WaveformWorker::stampSource() is shared and persisted.
+    void setFileWithWaveform(const QString& path, const WaveformResult& waveform);
     QString file() const { return m_filePath; }
+
+    // Record-to-slot state shown on an empty container
+    enum class RecordState { None = 0, Armed = 1, Recording = 2 };
+    void setRecordState(RecordState state);
+    RecordState recordState() const { return m_recordState; }
     void setVolume(float v);
 
+    // Scene slot: instead of a file the slot holds a set of sounds that are
+    // started together in the same audio cycle. Members refer to files by
+    // path; gain and bus come from the slot holding that file when fired.
+    struct SceneMember {
+        QString path;
+        int offsetMs = 0;
+    };
+    void setScene(const QVector<SceneMember>& members);
+    QVector<SceneMember> scene() const { return m_scene; }
+    bool isScene() const { return !m_scene.isEmpty(); }
+    // Layout/session (de)serialization of the scene members
+    QJsonArray sceneToJson() const;
+    void setSceneFromJson(const QJsonArray& arr);
+
 signals:
     void swapRequested(SoundContainer* source, SoundContainer* target);
     void copyRequested(SoundContainer* source, SoundContainer* target);
@@ -41,7 +75,16 @@ signals:
     void fileChanged(const QString& path);
     void volumeChanged(float volume);
     void backdropColorChanged(const QColor& color);
+    void outputBusChanged(int bus);
     void clearRequested(SoundContainer* self);
+    // Record-to-slot requests from the context menu of an empty container
+    void armRecordRequested(SoundContainer* self);
+    void recordRequested(SoundContainer* self);
+    void stopRecordRequested(SoundContainer* self);
+    // Scene slot requests
+    void sceneTriggered(SoundContainer* self);
+    void editSceneRequested(SoundContainer* self);
+    void sceneChanged();
 
 public:
     // Volume in range [0.0, 1.0]
@@ -59,10 +102,15 @@ protected:
     void mouseReleaseEvent(QMouseEvent* event) override;
     void contextMenuEvent(QContextMenuEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+    void enterEvent(QEnterEvent* event) override;
+    void leaveEvent(QEvent* event) override;
     void paintEvent(QPaintEvent* event) override;
 
 private slots:
     void onWaveformReady(const WaveformJob& job, const WaveformResult& result);
+    void onWaveformPartial(const WaveformJob& job, const WaveformResult& partial);
     void onWaveformError(const WaveformJob& job, const QString& err);
 
 private:
@@ -84,7 +132,12 @@ private:
     class WaveformWorker* m_waveWorker = nullptr;
     QUuid m_pendingJobId;
     QPixmap m_wavePixmap;
+    // Last smooth stretch of m_wavePixmap to a size it was not rendered at
+    QPixmap m_scaledWave;
+    qint64 m_scaledWaveSource = 0;  // cacheKey() of the m_wavePixmap it came from
     bool m_hasWavePixmap = false;
+    // m_wavePixmap shows a partial decode: displayed, never shared or cached
+    bool m_partialWaveform = false;
     bool m_playing = false;
     // Normalized [0,1] playhead position; negative means hidden
     float m_playheadPos = -1.0f;
@@ -94,8 +147,43 @@ private:
     QColor m_backdropColor = QColor();
     // Compose `m_wavePixmap` with the backdrop and set it on `m_waveform` scaled
     void applyWaveformPixmapWithBackdrop(int targetWpx, int targetHpx);
+    // Peak cache: probe asynchronously, render hits, enqueue a job on a miss
+    void startCacheProbe();
+    void onCacheProbeFinished(const WaveformCacheProbe::Result& result);
+    // `size` and `mtimeMs` come from the cache probe
+    void enqueueWaveformJob(qint64 size, qint64 mtimeMs);
+    // Decode priority from hover, tab visibility and assignment age
+    WaveformPriority waveformPriority() const;
+    // Re-rank our pending decode after a hover or visibility change
+    void updateWaveformPriority();
+    // Playhead overlay: x in container coordinates, and the strip it covers
+    int playheadX(float pos) const;
+    QRect playheadRect(float pos) const;
+    // Render m_peaks at the current display size into m_wavePixmap
+    void renderFromPeaks();
+    // Resize settled: re-render m_peaks at the new size, off the GUI thread
+    // when the width changed a lot
+    void onResizeSettled();
+    void onAsyncRenderFinished(quint64 seq, const QString& identity, const QSize& target, const QImage& image);
+    // Show the shared pixmap for this file at the current size, if cached
+    bool applyCachedWaveform();
+    // Waveform display size in device pixels
+    QSize waveformTargetPixels() const;
+    WaveformPackedPeaks m_peaks;
+    quint64 m_probeId = 0;      // pending WaveformCacheProbe request, 0 if none
+    QString m_waveIdentity;     // WaveformPixmapCache identity of m_filePath
+    QElapsedTimer m_assignedAt; // started when a file is assigned
+    QTimer* m_resizeRenderTimer = nullptr;
+    quint64 m_renderSeq = 0;    // latest render; older off-thread renders are dropped
 public:
     // Persisted backdrop color accessors
     void setBackdropColor(const QColor& c);
     QColor backdropColor() const;
+    // Zero-based output bus this slot plays into (persisted with the slot)
+    void setOutputBus(int bus);
+    int outputBus() const { return m_outputBus; }
+private:
+    int m_outputBus = 0;
+    RecordState m_recordState = RecordState::None;
+    QVector<SceneMember> m_scene;
 };
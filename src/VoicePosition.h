@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Position of one mixer voice, as filled by
+ * AudioEnginePlay::fillPlaybackSnapshot(). Kept apart from the mixer so
+ * AudioEngine.h and its users need not include AudioEnginePlay.h.
+ */
+struct VoicePosition {
+    uint64_t handle = 0;      // voiceHandle() of the voice id; 0 for voices without id
+    uint64_t frames = 0;      // frames (not interleaved samples)
+    uint64_t totalFrames = 0;
+    int sampleRate = 0;
+    int64_t startFrame = -1;
+};
@@ -6,16 +6,53 @@
 #include <QCryptographicHash>
 #include <QDebug>
 #include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
 #include <algorithm>
+#include "ContentFingerprint.h"
 #include "PreferencesManager.h"
+#include "WaveformCacheIndex.h"
+#include "WaveformCacheWriter.h"
+
+namespace {
+
+qint64 softLimitFromPreferences()
+{
+    const int mb = std::max(0, PreferencesManager::instance().cacheSoftLimitMB());
+    return static_cast<qint64>(mb) * 1024 * 1024;
+}
+
+// Delete the files of entries already dropped from the index
+void removeEntryFiles(const QString& dir, const QVector<WaveformCacheIndex::Victim>& victims)
+{
+    if (victims.isEmpty()) return;
+    QDir d(dir);
+    for (const WaveformCacheIndex::Victim& v : victims) {
+        if (v.kind == WaveformCacheIndex::Kind::Peaks) {
+            QFile::remove(d.filePath(v.key + ".peaks"));
+        } else {
+            QFile::remove(d.filePath(v.key + ".png"));
+            QFile::remove(d.filePath(v.key + ".json"));
+        }
+    }
+}
+
+} // namespace
 
 QString WaveformCache::cacheDirPath() {
     // Phase 4: Get cache directory from PreferencesManager
     // This allows users to configure it via preferences
     QString cacheDir = PreferencesManager::instance().cacheDirectory();
-    
-    QDir pdir(cacheDir);
-    if (!pdir.exists()) pdir.mkpath(".");
+
+    // Create each configured directory once instead of checking on every call
+    static QMutex s_lock;
+    static QString s_created;
+    QMutexLocker l(&s_lock);
+    if (cacheDir != s_created) {
+        QDir().mkpath(cacheDir);
+        s_created = cacheDir;
+    }
     return cacheDir;
 }
 
@@ -35,8 +72,143 @@ QString WaveformCache::makeKey(const QString& path, qint64 size, qint64 mtime, i
     return QString::fromUtf8(hash);
 }
 
+QString WaveformCache::makePeakKey(const QString& path, qint64 size, qint64 mtimeMs) {
+    QByteArray ba;
+    ba.append(path.toUtf8());
+    ba.append(",");
+    ba.append(QByteArray::number(size));
+    ba.append(",");
+    ba.append(QByteArray::number(mtimeMs));
+    ba.append(",peaks");
+
+    QByteArray hash = QCryptographicHash::hash(ba, QCryptographicHash::Md5).toHex();
+    return QString::fromUtf8(hash);
+}
+
+QString WaveformCache::makeContentPeakKey(quint64 fingerprint, qint64 size) {
+    QByteArray ba;
+    ba.append("content:");
+    ba.append(ContentFingerprint::toHex(fingerprint).toUtf8());
+    ba.append(",");
+    ba.append(QByteArray::number(size));
+    ba.append(",peaks");
+
+    QByteArray hash = QCryptographicHash::hash(ba, QCryptographicHash::Md5).toHex();
+    return QString::fromUtf8(hash);
+}
+
+WaveformCache::PeakCacheId WaveformCache::peakCacheId(const QString& path, qint64 size, qint64 mtimeMs) {
+    PeakCacheId id;
+    id.size = size;
+    if (ContentFingerprint::enabled()) {
+        const quint64 fp = ContentFingerprint::instance().of(path);
+        if (fp != 0) {
+            id.key = makeContentPeakKey(fp, size);
+            id.stamp = static_cast<qint64>(fp);
+            return id;
+        }
+    }
+    id.key = makePeakKey(path, size, mtimeMs);
+    id.stamp = mtimeMs;
+    return id;
+}
+
+QString WaveformCache::peakFilePath(const QString& key) {
+    return QDir(cacheDirPath()).filePath(key + ".peaks");
+}
+
+bool WaveformCache::writePeaks(const QString& key, const WaveformPeaks& peaks, qint64 size, qint64 mtimeMs) {
+    if (!peaks.isValid()) return false;
+    // Preferences are read here, on the caller's thread, never by the writer
+    WaveformCacheIndex::instance().setSoftLimitBytes(softLimitFromPreferences());
+    WaveformCacheWriter::instance().enqueuePeaks(cacheDirPath(), key, peaks, size, mtimeMs);
+    return true;
+}
+
+bool WaveformCache::writePeaksFile(const QString& dir, const QString& key, const WaveformPeaks& peaks, qint64 size,
+                                   qint64 mtimeMs) {
+    const QString filePath = QDir(dir).filePath(key + ".peaks");
+    if (!WaveformPeakFile::write(filePath, peaks, size, mtimeMs)) {
+        qWarning() << "WaveformCache::writePeaks failed for" << key;
+        return false;
+    }
+    WaveformCacheIndex::instance().addPeaks(dir, key, QFileInfo(filePath).size());
+    return true;
+}
+
+bool WaveformCache::loadPeaks(const QString& key, qint64 size, qint64 mtimeMs, WaveformPeaks* out) {
+    const QString dir = cacheDirPath();
+    // A queued write is the newest data for this key
+    WaveformPeaks pending;
+    qint64 pendingSize = -1;
+    qint64 pendingMtime = -1;
+    if (WaveformCacheWriter::instance().pendingPeaks(key, &pending, &pendingSize, &pendingMtime)
+        && pendingSize == size && pendingMtime == mtimeMs) {
+        if (out) *out = std::move(pending);
+        return true;
+    }
+
+    const QString filePath = QDir(dir).filePath(key + ".peaks");
+    if (!QFile::exists(filePath)) {
+        WaveformCacheIndex::instance().remove(dir, key);
+        return false;
+    }
+    qint64 storedSize = -1;
+    qint64 storedMtime = -1;
+    if (!WaveformPeakFile::read(filePath, out, &storedSize, &storedMtime)
+        || storedSize != size || storedMtime != mtimeMs) {
+        // corrupt or stale: remove so it is regenerated
+        QFile::remove(filePath);
+        WaveformCacheIndex::instance().remove(dir, key);
+        return false;
+    }
+    WaveformCacheIndex::instance().touch(dir, key);
+    return true;
+}
+
+bool WaveformCache::mapPeaks(const QString& key, qint64 size, qint64 mtimeMs, WaveformPackedPeaks* out) {
+    return mapPeaks(cacheDirPath(), key, size, mtimeMs, out);
+}
+
+bool WaveformCache::mapPeaks(const QString& dir, const QString& key, qint64 size, qint64 mtimeMs,
+                             WaveformPackedPeaks* out) {
+    WaveformPeaks pending;
+    qint64 pendingSize = -1;
+    qint64 pendingMtime = -1;
+    if (WaveformCacheWriter::instance().pendingPeaks(key, &pending, &pendingSize, &pendingMtime)
+        && pendingSize == size && pendingMtime == mtimeMs) {
+        if (out) *out = WaveformPackedPeaks::pack(pending);
+        return true;
+    }
+
+    const QString filePath = QDir(dir).filePath(key + ".peaks");
+    if (!QFile::exists(filePath)) {
+        WaveformCacheIndex::instance().remove(dir, key);
+        return false;
+    }
+    qint64 storedSize = -1;
+    qint64 storedMtime = -1;
+    WaveformPackedPeaks packed = WaveformPackedPeaks::map(filePath, &storedSize, &storedMtime);
+    if (!packed.isValid() || storedSize != size || storedMtime != mtimeMs) {
+        // corrupt or stale: remove so it is regenerated
+        packed = WaveformPackedPeaks();
+        QFile::remove(filePath);
+        WaveformCacheIndex::instance().remove(dir, key);
+        return false;
+    }
+    WaveformCacheIndex::instance().touch(dir, key);
+    if (out) *out = std::move(packed);
+    return true;
+}
+
 bool WaveformCache::write(const QString& key, const QImage& image, const QJsonObject& metadata) {
-    QString dir = cacheDirPath();
+    if (image.isNull()) return false;
+    WaveformCacheIndex::instance().setSoftLimitBytes(softLimitFromPreferences());
+    WaveformCacheWriter::instance().enqueueImage(cacheDirPath(), key, image, metadata);
+    return true;
+}
+
+bool WaveformCache::writeImageFile(const QString& dir, const QString& key, const QImage& image, const QJsonObject& metadata) {
     QDir d(dir);
     QString imgPath = d.filePath(key + ".png");
     QString metaPath = d.filePath(key + ".json");
@@ -66,18 +238,40 @@ bool WaveformCache::write(const QString& key, const QImage& image, const QJsonOb
         return false;
     }
 
-    // write success (quiet)
-
+    // Index the entry with its size on disk once both files are in place
+    WaveformCacheIndex::instance().addImage(dir, key,
+                                            metadata.value("path").toString(),
+                                            static_cast<qint64>(metadata.value("size").toDouble()),
+                                            static_cast<qint64>(metadata.value("mtime").toDouble()),
+                                            metadata.value("channels").toInt(),
+                                            metadata.value("samplerate").toInt(),
+                                            static_cast<float>(metadata.value("dpr").toDouble()),
+                                            metadata.value("pixelWidth").toInt(),
+                                            QFileInfo(imgPath).size() + bytes.size());
     return true;
 }
 
 QImage WaveformCache::load(const QString& key, QJsonObject* outMetadata) {
+    // A queued write is the newest data for this key
+    QImage pending;
+    QJsonObject pendingMeta;
+    if (WaveformCacheWriter::instance().pendingImage(key, &pending, &pendingMeta)) {
+        if (outMetadata) *outMetadata = pendingMeta;
+        float pdpr = static_cast<float>(pendingMeta.value("dpr").toDouble());
+        if (pdpr <= 0.0f) pdpr = 1.0f;
+        pending.setDevicePixelRatio(pdpr);
+        return pending;
+    }
+
     QString dir = cacheDirPath();
     QDir d(dir);
     QString imgPath = d.filePath(key + ".png");
     QString metaPath = d.filePath(key + ".json");
 
-    if (!QFile::exists(imgPath) || !QFile::exists(metaPath)) return QImage();
+    if (!QFile::exists(imgPath) || !QFile::exists(metaPath)) {
+        WaveformCacheIndex::instance().remove(dir, key);
+        return QImage();
+    }
 
     // Read metadata
     QFile fmeta(metaPath);
@@ -95,6 +289,7 @@ QImage WaveformCache::load(const QString& key, QJsonObject* outMetadata) {
             // corrupt metadata: remove both files and fail
             QFile::remove(imgPath);
             QFile::remove(metaPath);
+            WaveformCacheIndex::instance().remove(dir, key);
             return QImage();
         }
     }
@@ -114,6 +309,7 @@ QImage WaveformCache::load(const QString& key, QJsonObject* outMetadata) {
         qWarning() << "meta:" << obj;
         QFile::remove(imgPath);
         QFile::remove(metaPath);
+        WaveformCacheIndex::instance().remove(dir, key);
         return QImage();
     }
 
@@ -127,6 +323,7 @@ QImage WaveformCache::load(const QString& key, QJsonObject* outMetadata) {
     // device scale without unexpected pixel rounding/cropping.
     if (dpr <= 0.0f) dpr = 1.0f;
     img.setDevicePixelRatio(dpr);
+    WaveformCacheIndex::instance().touch(dir, key);
     return img;
 }
 
@@ -136,72 +333,39 @@ QImage WaveformCache::loadBest(const QString& path, qint64 size, qint64 mtime, i
     QImage exact = load(exactKey, outMetadata);
     if (!exact.isNull()) return exact;
 
-    // Scan cache dir for metadata JSON files and find candidates that match the
-    // identifying fields. Prefer candidate with pixelWidth >= requested and
-    // with minimal pixelWidth; otherwise pick the largest available smaller one.
-    QString dir = cacheDirPath();
-    QDir d(dir);
-    if (!d.exists()) return QImage();
-    QStringList jsonFiles = d.entryList(QStringList() << "*.json", QDir::Files, QDir::Name);
+    // Look up the available widths for this source in the cache index.
+    // Prefer candidate with pixelWidth >= requested and with minimal
+    // pixelWidth; otherwise pick the largest available smaller one.
+    const QString dir = cacheDirPath();
+    const QVector<WaveformCacheIndex::Candidate> candidates =
+        WaveformCacheIndex::instance().candidates(dir, path, size, mtime, channels, samplerate, dpr);
+    if (candidates.isEmpty()) return QImage();
 
     int bestGreater = INT_MAX;
     int bestSmaller = -1;
     QString bestKeyGreater;
     QString bestKeySmaller;
-    QJsonObject bestMeta;
-
-    for (const QString& jf : jsonFiles) {
-        QString metaPath = d.filePath(jf);
-        QFile fmeta(metaPath);
-        if (!fmeta.open(QIODevice::ReadOnly)) continue;
-        QByteArray mbytes = fmeta.readAll();
-        fmeta.close();
-        QJsonDocument doc = QJsonDocument::fromJson(mbytes);
-        if (!doc.isObject()) continue;
-        QJsonObject obj = doc.object();
-        // match identity fields
-        if (obj.value("path").toString() != path) continue;
-        if (static_cast<qint64>(obj.value("size").toDouble()) != size) continue;
-        if (static_cast<qint64>(obj.value("mtime").toDouble()) != mtime) continue;
-        if (obj.value("channels").toInt() != channels) continue;
-        if (obj.value("samplerate").toInt() != samplerate) continue;
-        if (static_cast<int>(obj.value("dpr").toDouble()) != static_cast<int>(dpr)) continue;
-        int pw = obj.value("pixelWidth").toInt();
-        // compute key for this metadata file (filename without .json)
-        QString base = jf;
-        if (base.endsWith(".json")) base.chop(5);
-        QString candidateKey = base;
-        if (pw >= pixelWidth) {
-            if (pw < bestGreater) {
-                bestGreater = pw;
-                bestKeyGreater = candidateKey;
-                bestMeta = obj;
-            }
-        } else {
-            if (pw > bestSmaller) {
-                bestSmaller = pw;
-                bestKeySmaller = candidateKey;
-                bestMeta = obj;
+    for (const WaveformCacheIndex::Candidate& c : candidates) {
+        if (c.pixelWidth >= pixelWidth) {
+            if (c.pixelWidth < bestGreater) {
+                bestGreater = c.pixelWidth;
+                bestKeyGreater = c.key;
             }
+        } else if (c.pixelWidth > bestSmaller) {
+            bestSmaller = c.pixelWidth;
+            bestKeySmaller = c.key;
         }
     }
+    const QString chosenKey = !bestKeyGreater.isEmpty() ? bestKeyGreater : bestKeySmaller;
 
-    QString chosenKey;
+    // load() validates the sidecar and drops stale index entries
     QJsonObject chosenMeta;
-    if (!bestKeyGreater.isEmpty()) {
-        chosenKey = bestKeyGreater;
-        chosenMeta = bestMeta;
-    } else if (!bestKeySmaller.isEmpty()) {
-        chosenKey = bestKeySmaller;
-        chosenMeta = bestMeta;
-    } else {
+    QImage img = load(chosenKey, &chosenMeta);
+    if (img.isNull()) {
+        WaveformCacheIndex::instance().remove(dir, chosenKey);
         return QImage();
     }
 
-    QImage img;
-    QString imgPath = d.filePath(chosenKey + ".png");
-    if (!img.load(imgPath)) return QImage();
-
     // If the image pixelWidth differs, scale it to requested size (downscale preferred)
     int availablePW = chosenMeta.value("pixelWidth").toInt();
     if (availablePW != pixelWidth) {
@@ -221,103 +385,44 @@ QImage WaveformCache::loadBest(const QString& path, qint64 size, qint64 mtime, i
 
 void WaveformCache::evict(qint64 softLimitBytes, int ttlDays)
 {
-    // Use preferences values regardless of provided defaults
-    int mb = PreferencesManager::instance().cacheSoftLimitMB();
-    int days = PreferencesManager::instance().cacheTtlDays();
-    if (mb < 0) mb = 0; if (days < 0) days = 0;
-    softLimitBytes = static_cast<qint64>(mb) * 1024 * 1024;
-    ttlDays = days;
-    QString dir = cacheDirPath();
-    QDir d(dir);
-    if (!d.exists()) return;
+    // Account for every queued write
+    flush();
 
-    // Collect candidate base names (without extension) for json/png pairs
-    QStringList jsonFiles = d.entryList(QStringList() << "*.json", QDir::Files, QDir::Name);
-    struct Entry { QString base; qint64 size; QDateTime mtime; };
-    QVector<Entry> entries;
-    qint64 total = 0;
-    for (const QString& jf : jsonFiles) {
-        QString base = jf;
-        if (base.endsWith(".json")) base.chop(5);
-        QString metaPath = d.filePath(base + ".json");
-        QString imgPath = d.filePath(base + ".png");
-        QFileInfo imi(metaPath);
-        if (!imi.exists()) continue;
-        QFileInfo ifi(imgPath);
-        qint64 s = imi.size() + (ifi.exists() ? ifi.size() : 0);
-        QDateTime m = imi.lastModified();
-        entries.push_back({base, s, m});
-        total += s;
-    }
-
-    // Also consider stray png files without json
-    QStringList pngFiles = d.entryList(QStringList() << "*.png", QDir::Files, QDir::Name);
-    for (const QString& pf : pngFiles) {
-        QString base = pf;
-        if (base.endsWith(".png")) base.chop(4);
-        // if we already accounted via json, skip
-        bool found = false;
-        for (const Entry& e : entries) if (e.base == base) { found = true; break; }
-        if (found) continue;
-        QString imgPath = d.filePath(base + ".png");
-        QFileInfo ifi(imgPath);
-        qint64 s = ifi.exists() ? ifi.size() : 0;
-        QDateTime m = ifi.lastModified();
-        entries.push_back({base, s, m});
-        total += s;
-    }
-
-    // Remove entries older than TTL first
-    QDateTime cutoff = QDateTime::currentDateTimeUtc().addDays(-ttlDays);
-    bool removedAny = false;
-    for (const Entry& e : entries) {
-        if (e.mtime < cutoff) {
-            QString imgPath = d.filePath(e.base + ".png");
-            QString metaPath = d.filePath(e.base + ".json");
-            bool r1 = QFile::remove(imgPath);
-            bool r2 = QFile::remove(metaPath);
-            if (r1 || r2) removedAny = true;
-            total -= e.size;
-            qDebug() << "WaveformCache::evict removed (TTL)" << e.base << e.size;
-        }
+    // Use preferences values regardless of provided defaults
+    softLimitBytes = softLimitFromPreferences();
+    ttlDays = std::max(0, PreferencesManager::instance().cacheTtlDays());
+    WaveformCacheIndex& index = WaveformCacheIndex::instance();
+    index.setSoftLimitBytes(softLimitBytes);
+
+    // The index tracks sizes and access times, so this only visits the
+    // entries it removes
+    const qint64 cutoffMs = QDateTime::currentMSecsSinceEpoch() - static_cast<qint64>(ttlDays) * 24 * 3600 * 1000;
+    const QString dir = cacheDirPath();
+    const QVector<WaveformCacheIndex::Victim> victims = index.takeVictims(dir, softLimitBytes, cutoffMs);
+    removeEntryFiles(dir, victims);
+    if (!victims.isEmpty()) {
+        qDebug() << "WaveformCache::evict removed" << victims.size() << "entries, remaining:" << index.totalBytes(dir);
     }
+}
 
-    if (total <= softLimitBytes) return;
-
-    // Build remaining entries list
-    QVector<Entry> remain;
-    for (const Entry& e : entries) {
-        QString metaPath = d.filePath(e.base + ".json");
-        QString imgPath = d.filePath(e.base + ".png");
-        QFileInfo imi(metaPath);
-        QDateTime m = imi.exists() ? imi.lastModified() : QFileInfo(imgPath).lastModified();
-        // re-evaluate size
-        qint64 s = 0;
-        if (imi.exists()) s += imi.size();
-        QFileInfo ifi(imgPath);
-        if (ifi.exists()) s += ifi.size();
-        remain.push_back({e.base, s, m});
-    }
+void WaveformCache::evictOverLimit(const QString& dir)
+{
+    WaveformCacheIndex& index = WaveformCacheIndex::instance();
+    const qint64 limit = index.softLimitBytes();
+    if (limit < 0 || index.totalBytes(dir) <= limit) return;
+    removeEntryFiles(dir, index.takeVictims(dir, limit));
+}
 
-    // Sort by mtime ascending (oldest first)
-    std::sort(remain.begin(), remain.end(), [](const Entry& a, const Entry& b){ return a.mtime < b.mtime; });
-
-    for (const Entry& e : remain) {
-        if (total <= softLimitBytes) break;
-        QString imgPath = d.filePath(e.base + ".png");
-        QString metaPath = d.filePath(e.base + ".json");
-        qint64 removedSize = 0;
-        QFileInfo ifi(imgPath);
-        if (ifi.exists()) { removedSize += ifi.size(); QFile::remove(imgPath); }
-        QFileInfo imi(metaPath);
-        if (imi.exists()) { removedSize += imi.size(); QFile::remove(metaPath); }
-        total -= removedSize;
-        qDebug() << "WaveformCache::evict removed" << e.base << removedSize << "remaining:" << total;
-    }
+void WaveformCache::flush()
+{
+    WaveformCacheWriter::instance().flush();
+    // Hits since the last queued write are still only in memory
+    WaveformCacheIndex::instance().flushTouches(cacheDirPath());
 }
 
 void WaveformCache::clearAll()
 {
+    WaveformCacheWriter::instance().discardPending();
     QString dir = cacheDirPath();
     QDir d(dir);
     if (!d.exists()) return;
@@ -325,4 +430,7 @@ void WaveformCache::clearAll()
     for (const QString& f : pngFiles) QFile::remove(d.filePath(f));
     QStringList jsonFiles = d.entryList(QStringList() << "*.json", QDir::Files);
     for (const QString& f : jsonFiles) QFile::remove(d.filePath(f));
+    QStringList peakFiles = d.entryList(QStringList() << "*.peaks", QDir::Files);
+    for (const QString& f : peakFiles) QFile::remove(d.filePath(f));
+    WaveformCacheIndex::instance().clear(dir);
 }
@@ -3,20 +3,26 @@
 #include <QImage>
 #include <QJsonObject>
 #include <QString>
+#include "WaveformPackedPeaks.h"
+#include "WaveformPeakFile.h"
 
 class WaveformCache {
 public:
     // Generate a simple cache key string (MD5-like) from inputs. For tests this is a simple concatenation.
     static QString makeKey(const QString& path, qint64 size, qint64 mtime, int channels, int samplerate, float dpr, int pixelWidth);
 
-    // Write image and metadata atomically. Returns true on success.
+    // Queue image and metadata for an atomic background write and return
+    // immediately (see WaveformCacheWriter). Returns false for a null image.
     static bool write(const QString& key, const QImage& image, const QJsonObject& metadata);
+    // Blocking write into `dir` used by the background writer. Returns true
+    // on success.
+    static bool writeImageFile(const QString& dir, const QString& key, const QImage& image, const QJsonObject& metadata);
 
     // Load image if present and metadata matches (basic check). Returns null image if not found/invalid.
     static QImage load(const QString& key, QJsonObject* outMetadata = nullptr);
 
-    // Load an exact cached image if available. If not found, search the
-    // cache directory for candidate metadata entries that match path/size/mtime/
+    // Load an exact cached image if available. If not found, look up the
+    // cache index (WaveformCacheIndex) for entries that match path/size/mtime/
     // channels/samplerate/dpr and return the best match where pixelWidth >=
     // requested (prefer smallest >= requested). If none >= requested exist,
     // return the largest available smaller entry. Returns null image if no
@@ -24,13 +30,52 @@ public:
     // available.
     static QImage loadBest(const QString& path, qint64 size, qint64 mtime, int channels, int samplerate, float dpr, int pixelWidth, QJsonObject* outMetadata = nullptr);
 
-    // For tests/tools: get cache directory path
+    // Peak-file cache: one resolution-independent `.peaks` file per source
+    // file version, independent of DPR and widget width.
+    static QString makePeakKey(const QString& path, qint64 size, qint64 mtimeMs);
+    // Key for a content fingerprint (see ContentFingerprint): shared by every
+    // path holding the same bytes
+    static QString makeContentPeakKey(quint64 fingerprint, qint64 size);
+    // The key and validation stamp to use for a source file's peaks. With
+    // content keys enabled the stamp is the fingerprint, so moved or copied
+    // files hit the same entry; otherwise it is the file's mtime.
+    struct PeakCacheId {
+        QString key;
+        qint64 size = 0;
+        qint64 stamp = 0;
+    };
+    static PeakCacheId peakCacheId(const QString& path, qint64 size, qint64 mtimeMs);
+    static QString peakFilePath(const QString& key);
+    // Queued like write(); writePeaksFile() is the blocking variant
+    static bool writePeaks(const QString& key, const WaveformPeaks& peaks, qint64 size, qint64 mtimeMs);
+    static bool writePeaksFile(const QString& dir, const QString& key, const WaveformPeaks& peaks, qint64 size,
+                               qint64 mtimeMs);
+    // Returns false if missing, corrupt or recorded for another size/mtime
+    // (stale files are removed).
+    static bool loadPeaks(const QString& key, qint64 size, qint64 mtimeMs, WaveformPeaks* out);
+    // loadPeaks() without unpacking: the peak file is memory-mapped as is.
+    // The variant taking `dir` reads no preferences (worker threads).
+    static bool mapPeaks(const QString& key, qint64 size, qint64 mtimeMs, WaveformPackedPeaks* out);
+    static bool mapPeaks(const QString& dir, const QString& key, qint64 size, qint64 mtimeMs, WaveformPackedPeaks* out);
+
+    // The cache directory from the preferences, created on first use. Reads
+    // QSettings, so only the GUI thread calls it; work handed to other
+    // threads carries the directory resolved here.
     static QString cacheDirPath();
     // Evict cache entries so total size is <= softLimitBytes (in bytes).
-    // Removes oldest entries first based on filesystem modification time.
-    // Also removes entries older than ttlDays regardless of size.
+    // Removes least recently used entries first, using the access times in
+    // WaveformCacheIndex. Also removes entries not used for ttlDays
+    // regardless of size. The preferences values take precedence.
     static void evict(qint64 softLimitBytes = 200 * 1024 * 1024, int ttlDays = 90);
+    // Incremental eviction run by the background writer after each write:
+    // drops LRU entries of `dir` while the index total exceeds the soft limit
+    static void evictOverLimit(const QString& dir);
+
+    // Block until every queued write and recorded cache hit is on disk
+    // (shutdown, tests)
+    static void flush();
 
-    // Remove all cache files. Useful for tests and debug actions.
+    // Remove all cache files (queued writes are dropped). Useful for tests
+    // and debug actions.
     static void clearAll();
 };
@@ -0,0 +1,420 @@
+#include "WaveformCacheIndex.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = {'L', 'S', 'B', 'I'};
+constexpr int kDigestBytes = 16;
+
+QByteArray headerBytes()
+{
+    QByteArray h(WaveformCacheIndex::kHeaderBytes, '\0');
+    std::memcpy(h.data(), kMagic, 4);
+    qToLittleEndian<quint32>(WaveformCacheIndex::kVersion, h.data() + 4);
+    return h;
+}
+
+} // namespace
+
+WaveformCacheIndex& WaveformCacheIndex::instance()
+{
+    static WaveformCacheIndex s_instance;
+    return s_instance;
+}
+
+QByteArray WaveformCacheIndex::identityOf(const QString& path, qint64 size, qint64 mtime, int channels, int samplerate, float dpr)
+{
+    // DPR is compared as an integer, matching the previous sidecar scan
+    QByteArray ba;
+    ba.append(path.toUtf8());
+    ba.append(",");
+    ba.append(QByteArray::number(size));
+    ba.append(",");
+    ba.append(QByteArray::number(mtime));
+    ba.append(",ch:"); ba.append(QByteArray::number(channels));
+    ba.append(",sr:"); ba.append(QByteArray::number(samplerate));
+    ba.append(",dpr:"); ba.append(QByteArray::number(static_cast<int>(dpr)));
+    return QCryptographicHash::hash(ba, QCryptographicHash::Md5);
+}
+
+QByteArray WaveformCacheIndex::encodeRecord(const Record& r)
+{
+    const QByteArray key = r.key.toUtf8();
+    QByteArray out(kRecordHeaderBytes + key.size(), '\0');
+    char* p = out.data();
+    p[0] = static_cast<char>(r.op);
+    p[1] = static_cast<char>(r.kind);
+    qToLittleEndian<quint16>(static_cast<quint16>(key.size()), p + 2);
+    qToLittleEndian<quint32>(static_cast<quint32>(r.pixelWidth), p + 4);
+    if (r.identity.size() == kDigestBytes) std::memcpy(p + 8, r.identity.constData(), kDigestBytes);
+    qToLittleEndian<qint64>(r.bytes, p + 24);
+    qToLittleEndian<qint64>(r.atimeMs, p + 32);
+    std::memcpy(p + kRecordHeaderBytes, key.constData(), key.size());
+    return out;
+}
+
+QVector<WaveformCacheIndex::Candidate> WaveformCacheIndex::candidates(const QString& dir, const QString& path, qint64 size,
+                                                                     qint64 mtime, int channels, int samplerate, float dpr)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    QVector<Candidate> out;
+    auto it = m_byIdentity.constFind(identityOf(path, size, mtime, channels, samplerate, dpr));
+    if (it == m_byIdentity.constEnd()) return out;
+    out.reserve(it->size());
+    for (const QString& key : *it) out.push_back({key, m_items.value(key).pixelWidth});
+    return out;
+}
+
+void WaveformCacheIndex::addImage(const QString& dir, const QString& key, const QString& path, qint64 size, qint64 mtime,
+                                  int channels, int samplerate, float dpr, int pixelWidth, qint64 bytes)
+{
+    if (key.isEmpty()) return;
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    Record r;
+    r.kind = Kind::Image;
+    r.key = key;
+    r.identity = identityOf(path, size, mtime, channels, samplerate, dpr);
+    r.pixelWidth = pixelWidth;
+    r.bytes = bytes;
+    r.atimeMs = QDateTime::currentMSecsSinceEpoch();
+    applyLocked(r);
+    appendLocked({r});
+}
+
+void WaveformCacheIndex::addPeaks(const QString& dir, const QString& key, qint64 bytes)
+{
+    if (key.isEmpty()) return;
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    Record r;
+    r.kind = Kind::Peaks;
+    r.key = key;
+    r.bytes = bytes;
+    r.atimeMs = QDateTime::currentMSecsSinceEpoch();
+    applyLocked(r);
+    appendLocked({r});
+}
+
+void WaveformCacheIndex::touch(const QString& dir, const QString& key)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    auto it = m_items.constFind(key);
+    if (it == m_items.constEnd()) return;
+    Record r;
+    r.op = OpTouch;
+    r.kind = it->kind;
+    r.key = key;
+    r.atimeMs = QDateTime::currentMSecsSinceEpoch();
+    applyLocked(r);
+    m_dirtyTouches.insert(key);
+}
+
+void WaveformCacheIndex::flushTouches(const QString& dir)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    flushTouchesLocked();
+}
+
+void WaveformCacheIndex::remove(const QString& dir, const QString& key)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    auto it = m_items.find(key);
+    if (it == m_items.end()) return;
+    Record r;
+    r.op = OpRemove;
+    r.kind = it->kind;
+    r.key = key;
+    eraseLocked(it);
+    appendLocked({r});
+}
+
+void WaveformCacheIndex::clear(const QString& dir)
+{
+    QMutexLocker l(&m_lock);
+    m_items.clear();
+    m_byIdentity.clear();
+    m_lru.clear();
+    m_dirtyTouches.clear();
+    m_totalBytes = 0;
+    m_dir = dir;
+    m_loaded = true;
+    compactLocked();
+}
+
+QVector<WaveformCacheIndex::Victim> WaveformCacheIndex::takeVictims(const QString& dir, qint64 limitBytes, qint64 olderThanMs)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    QVector<Victim> victims;
+    QVector<Record> removals;
+    // The LRU tail is the least recently used entry; stop as soon as it is
+    // both recent enough and within the limit
+    while (!m_lru.empty()) {
+        auto it = m_items.find(m_lru.back());
+        const bool expired = olderThanMs >= 0 && it->atimeMs < olderThanMs;
+        if (!expired && m_totalBytes <= limitBytes) break;
+        victims.push_back({it.key(), it->kind, it->bytes});
+        Record r;
+        r.op = OpRemove;
+        r.kind = it->kind;
+        r.key = it.key();
+        removals.push_back(r);
+        eraseLocked(it);
+    }
+    if (!removals.isEmpty()) appendLocked(removals);
+    return victims;
+}
+
+void WaveformCacheIndex::reset()
+{
+    QMutexLocker l(&m_lock);
+    m_items.clear();
+    m_byIdentity.clear();
+    m_lru.clear();
+    m_dirtyTouches.clear();
+    m_totalBytes = 0;
+    m_fileRecords = 0;
+    m_loaded = false;
+}
+
+int WaveformCacheIndex::entryCount(const QString& dir)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    return m_items.size();
+}
+
+qint64 WaveformCacheIndex::totalBytes(const QString& dir)
+{
+    QMutexLocker l(&m_lock);
+    ensureLoadedLocked(dir);
+    return m_totalBytes;
+}
+
+void WaveformCacheIndex::ensureLoadedLocked(const QString& dir)
+{
+    if (m_loaded && dir == m_dir) return;
+    // Keep the hits recorded against the previous directory
+    if (m_loaded) flushTouchesLocked();
+    m_items.clear();
+    m_byIdentity.clear();
+    m_lru.clear();
+    m_totalBytes = 0;
+    m_fileRecords = 0;
+    m_dir = dir;
+    m_loaded = true;
+    if (!loadFileLocked(QDir(m_dir).filePath(indexFileName()))) {
+        m_items.clear();
+        m_byIdentity.clear();
+        m_lru.clear();
+        m_totalBytes = 0;
+        rebuildFromDirectoryLocked();
+    }
+}
+
+bool WaveformCacheIndex::loadFileLocked(const QString& filePath)
+{
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const qint64 fileSize = f.size();
+    if (fileSize < kHeaderBytes) return false;
+    const uchar* base = f.map(0, fileSize);
+    if (!base) return false;
+
+    const char* p = reinterpret_cast<const char*>(base);
+    const char* end = p + fileSize;
+    const bool headerOk = std::memcmp(p, kMagic, 4) == 0 && qFromLittleEndian<quint32>(p + 4) == kVersion;
+    int count = 0;
+    if (headerOk) {
+        p += kHeaderBytes;
+        // A torn trailing record from an interrupted append is ignored
+        while (end - p >= kRecordHeaderBytes) {
+            const int keyLen = qFromLittleEndian<quint16>(p + 2);
+            if (end - p < kRecordHeaderBytes + keyLen) break;
+            Record r;
+            r.op = static_cast<Op>(static_cast<quint8>(p[0]));
+            r.kind = static_cast<Kind>(static_cast<quint8>(p[1]));
+            r.pixelWidth = static_cast<int>(qFromLittleEndian<quint32>(p + 4));
+            r.identity = QByteArray(p + 8, kDigestBytes);
+            r.bytes = qFromLittleEndian<qint64>(p + 24);
+            r.atimeMs = qFromLittleEndian<qint64>(p + 32);
+            r.key = QString::fromUtf8(p + kRecordHeaderBytes, keyLen);
+            applyLocked(r);
+            p += kRecordHeaderBytes + keyLen;
+            ++count;
+        }
+        m_fileRecords = count;
+    }
+    f.unmap(const_cast<uchar*>(base));
+    f.close();
+    return headerOk;
+}
+
+void WaveformCacheIndex::rebuildFromDirectoryLocked()
+{
+    // One-time migration: a single listing of the cache directory, grouped
+    // by base name (PNG + JSON sidecar form one entry)
+    QDir d(m_dir);
+    const QFileInfoList files = d.entryInfoList(QStringList() << "*.png" << "*.json" << "*.peaks", QDir::Files);
+    QHash<QString, Record> byKey;
+    for (const QFileInfo& fi : files) {
+        const QString suffix = fi.suffix();
+        const QString key = fi.completeBaseName();
+        Record& r = byKey[key];
+        r.key = key;
+        r.kind = suffix == QLatin1String("peaks") ? Kind::Peaks : Kind::Image;
+        r.bytes += fi.size();
+        r.atimeMs = std::max(r.atimeMs, fi.lastModified().toMSecsSinceEpoch());
+        if (suffix == QLatin1String("json")) {
+            QFile fmeta(fi.filePath());
+            if (!fmeta.open(QIODevice::ReadOnly)) continue;
+            const QJsonDocument doc = QJsonDocument::fromJson(fmeta.readAll());
+            fmeta.close();
+            if (!doc.isObject()) continue;
+            const QJsonObject obj = doc.object();
+            r.identity = identityOf(obj.value("path").toString(),
+                                    static_cast<qint64>(obj.value("size").toDouble()),
+                                    static_cast<qint64>(obj.value("mtime").toDouble()),
+                                    obj.value("channels").toInt(),
+                                    obj.value("samplerate").toInt(),
+                                    static_cast<float>(obj.value("dpr").toDouble()));
+            r.pixelWidth = obj.value("pixelWidth").toInt();
+        }
+    }
+    // Oldest first, so the most recently modified entry ends up at the LRU front
+    QVector<Record> records = byKey.values();
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.atimeMs < b.atimeMs; });
+    for (const Record& r : records) applyLocked(r);
+    compactLocked();
+}
+
+void WaveformCacheIndex::eraseLocked(QHash<QString, Item>::iterator it)
+{
+    if (it->kind == Kind::Image) {
+        auto idIt = m_byIdentity.find(it->identity);
+        if (idIt != m_byIdentity.end()) {
+            idIt->removeAll(it.key());
+            if (idIt->isEmpty()) m_byIdentity.erase(idIt);
+        }
+    }
+    m_totalBytes -= it->bytes;
+    m_dirtyTouches.remove(it.key());
+    m_lru.erase(it->lru);
+    m_items.erase(it);
+}
+
+void WaveformCacheIndex::applyLocked(const Record& r)
+{
+    auto it = m_items.find(r.key);
+    if (r.op == OpTouch) {
+        if (it == m_items.end()) return;
+        it->atimeMs = r.atimeMs;
+        m_lru.splice(m_lru.begin(), m_lru, it->lru);
+        return;
+    }
+    if (it != m_items.end()) eraseLocked(it);
+    if (r.op == OpRemove) return;
+
+    Item item;
+    item.kind = r.kind;
+    item.identity = r.identity;
+    item.pixelWidth = r.pixelWidth;
+    item.bytes = r.bytes;
+    item.atimeMs = r.atimeMs;
+    m_lru.push_front(r.key);
+    item.lru = m_lru.begin();
+    m_items.insert(r.key, item);
+    m_totalBytes += r.bytes;
+    if (r.kind == Kind::Image && !r.identity.isEmpty()) m_byIdentity[r.identity].push_back(r.key);
+}
+
+void WaveformCacheIndex::appendLocked(const QVector<Record>& records)
+{
+    m_fileRecords += records.size();
+    if (m_fileRecords > 2 * m_items.size() + 64) {
+        // The rewrite already reflects these changes
+        if (compactLocked()) return;
+    }
+    QFile f(QDir(m_dir).filePath(indexFileName()));
+    if (!f.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qWarning() << "WaveformCacheIndex: cannot open index in" << m_dir;
+        return;
+    }
+    QByteArray bytes;
+    if (f.size() < kHeaderBytes) {
+        f.resize(0);
+        bytes = headerBytes();
+    }
+    for (const Record& r : records) bytes.append(encodeRecord(r));
+    f.write(bytes);
+    f.close();
+}
+
+void WaveformCacheIndex::flushTouchesLocked()
+{
+    if (m_dirtyTouches.isEmpty()) return;
+    // Least recently used first, so replaying restores the LRU order
+    QVector<Record> touches;
+    touches.reserve(m_dirtyTouches.size());
+    for (auto lit = m_lru.rbegin(); lit != m_lru.rend() && touches.size() < m_dirtyTouches.size(); ++lit) {
+        if (!m_dirtyTouches.contains(*lit)) continue;
+        const Item& item = m_items[*lit];
+        Record r;
+        r.op = OpTouch;
+        r.kind = item.kind;
+        r.key = *lit;
+        r.atimeMs = item.atimeMs;
+        touches.push_back(r);
+    }
+    m_dirtyTouches.clear();
+    appendLocked(touches);
+}
+
+bool WaveformCacheIndex::compactLocked()
+{
+    const QString filePath = QDir(m_dir).filePath(indexFileName());
+    QByteArray bytes = headerBytes();
+    // Least recently used first, so replaying restores the LRU order
+    for (auto lit = m_lru.rbegin(); lit != m_lru.rend(); ++lit) {
+        const Item& item = m_items[*lit];
+        Record r;
+        r.kind = item.kind;
+        r.key = *lit;
+        r.identity = item.identity;
+        r.pixelWidth = item.pixelWidth;
+        r.bytes = item.bytes;
+        r.atimeMs = item.atimeMs;
+        bytes.append(encodeRecord(r));
+    }
+    const QString tmp = filePath + ".tmp";
+    QFile f(tmp);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(bytes);
+    f.close();
+    QFile::remove(filePath);
+    if (!QFile::rename(tmp, filePath)) {
+        QFile::remove(tmp);
+        return false;
+    }
+    m_fileRecords = m_items.size();
+    // The rewrite carries every in-memory access time
+    m_dirtyTouches.clear();
+    return true;
+}
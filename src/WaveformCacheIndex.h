@@ -0,0 +1,139 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <list>
+
+/**
+ * WaveformCacheIndex: persistent manifest of the waveform cache.
+ *
+ * WaveformCache::loadBest used to list and parse every JSON sidecar on an
+ * exact-key miss, and evict() used to stat the whole directory. The index
+ * keeps, per cache entry (a PNG+JSON pair or a peak file), its size on disk
+ * and its last access time in an LRU list, plus a map from each source
+ * identity (path, size, mtime, channels, samplerate, integer DPR) to the
+ * cached image widths. Lookups, hits and eviction never touch the directory.
+ *
+ * Every call names the cache directory it is about (the caller resolves it
+ * from the preferences), so the index itself never reads them and can be
+ * used from the cache writer thread. On disk it is a single append-only log
+ * that is memory-mapped and replayed once per cache directory:
+ *   header   magic "LSBI", u32 version
+ *   records  u8 op, u8 kind, u16 keyLength, u32 pixelWidth, u8[16] identity,
+ *            i64 bytes, i64 accessTimeMs, key (keyLength bytes, UTF-8)
+ * op is 0 remove, 1 add, 2 touch. The log is compacted once stale records
+ * outnumber live ones. A missing or corrupt index is rebuilt from one scan of
+ * the cache directory.
+ *
+ * Cache hits only update the access time and LRU position in memory; the
+ * touched keys are written as one batch by flushTouches() (after each write
+ * on the cache writer thread and from WaveformCache::flush()) or by the next
+ * compaction. A crash loses at most those access times, never an entry.
+ */
+class WaveformCacheIndex {
+public:
+    enum class Kind : quint8 { Image = 0, Peaks = 1 };
+
+    struct Candidate {
+        QString key;
+        int pixelWidth = 0;
+    };
+
+    struct Victim {
+        QString key;
+        Kind kind = Kind::Image;
+        qint64 bytes = 0;
+    };
+
+    static constexpr quint32 kVersion = 2;
+    static constexpr int kHeaderBytes = 8;
+    static constexpr int kRecordHeaderBytes = 40;
+
+    static WaveformCacheIndex& instance();
+
+    static QString indexFileName() { return QStringLiteral("index.lsbi"); }
+
+    // All cached image widths for a source identity (empty if none)
+    QVector<Candidate> candidates(const QString& dir, const QString& path, qint64 size, qint64 mtime, int channels,
+                                  int samplerate, float dpr);
+
+    void addImage(const QString& dir, const QString& key, const QString& path, qint64 size, qint64 mtime,
+                  int channels, int samplerate, float dpr, int pixelWidth, qint64 bytes);
+    void addPeaks(const QString& dir, const QString& key, qint64 bytes);
+    // Record a cache hit: the entry becomes the most recently used. Only the
+    // in-memory state changes; flushTouches() persists it.
+    void touch(const QString& dir, const QString& key);
+    // Append the access times of every entry touched since the last flush
+    // or compaction to the index file, as one batch
+    void flushTouches(const QString& dir);
+    void remove(const QString& dir, const QString& key);
+    // Forget every entry and truncate the index file
+    void clear(const QString& dir);
+
+    // Remove from the index, and return, every entry last used before
+    // `olderThanMs` (ignored if < 0) and then the least recently used
+    // entries until the total is <= `limitBytes`. The caller deletes the files.
+    QVector<Victim> takeVictims(const QString& dir, qint64 limitBytes, qint64 olderThanMs = -1);
+
+    // Soft limit used for background eviction after writes (-1 = none)
+    void setSoftLimitBytes(qint64 bytes) { m_softLimit.store(bytes); }
+    qint64 softLimitBytes() const { return m_softLimit.load(); }
+
+    // Drop the in-memory state so the next call reloads the file (tests/tools)
+    void reset();
+    int entryCount(const QString& dir);
+    qint64 totalBytes(const QString& dir);
+
+private:
+    WaveformCacheIndex() = default;
+    Q_DISABLE_COPY(WaveformCacheIndex)
+
+    enum Op : quint8 { OpRemove = 0, OpAdd = 1, OpTouch = 2 };
+
+    struct Item {
+        Kind kind = Kind::Image;
+        QByteArray identity;
+        int pixelWidth = 0;
+        qint64 bytes = 0;
+        qint64 atimeMs = 0;
+        std::list<QString>::iterator lru;
+    };
+
+    struct Record {
+        Op op = OpAdd;
+        Kind kind = Kind::Image;
+        QString key;
+        QByteArray identity;
+        int pixelWidth = 0;
+        qint64 bytes = 0;
+        qint64 atimeMs = 0;
+    };
+
+    static QByteArray identityOf(const QString& path, qint64 size, qint64 mtime, int channels, int samplerate, float dpr);
+    static QByteArray encodeRecord(const Record& r);
+
+    void ensureLoadedLocked(const QString& dir);
+    bool loadFileLocked(const QString& filePath);
+    void rebuildFromDirectoryLocked();
+    void applyLocked(const Record& r);
+    void eraseLocked(QHash<QString, Item>::iterator it);
+    void appendLocked(const QVector<Record>& records);
+    void flushTouchesLocked();
+    bool compactLocked();
+
+    QMutex m_lock;
+    QString m_dir;                                      // cache dir the state belongs to
+    bool m_loaded = false;
+    QHash<QString, Item> m_items;                       // key -> entry
+    QHash<QByteArray, QVector<QString>> m_byIdentity;   // identity -> image keys
+    std::list<QString> m_lru;                           // front = most recently used
+    QSet<QString> m_dirtyTouches;                       // touched, not yet in the file
+    qint64 m_totalBytes = 0;
+    int m_fileRecords = 0;
+    std::atomic<qint64> m_softLimit{-1};
+};
@@ -0,0 +1,157 @@
+#include "WaveformCacheProbe.h"
+#include "WaveformCache.h"
+#include "WaveformPixmapCache.h"
+#include "WaveformPyramid.h"
+#include "WaveformRenderer.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+
+WaveformCacheProbe& WaveformCacheProbe::instance()
+{
+    static WaveformCacheProbe s_instance;
+    return s_instance;
+}
+
+WaveformCacheProbe::WaveformCacheProbe()
+{
+    // Probes are mostly small reads; a few threads hide the latency without
+    // competing with the decode workers
+    m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount() / 2, 4));
+}
+
+quint64 WaveformCacheProbe::request(QObject* owner, const QString& path, const QSize& targetPx, bool visible, Callback callback)
+{
+    Task task;
+    task.owner = owner;
+    task.ownerKey = owner;
+    task.path = path;
+    // Workers must not read the preferences (QSettings is not thread-safe)
+    task.cacheDir = WaveformCache::cacheDirPath();
+    task.targetPx = targetPx;
+    task.visible = visible;
+    task.callback = std::move(callback);
+    quint64 id = 0;
+    {
+        QMutexLocker l(&m_lock);
+        id = task.id = ++m_nextId;
+        if (visible) {
+            ++m_visibleOutstanding;
+            m_visible.push_back(std::move(task));
+        } else {
+            m_background.push_back(std::move(task));
+        }
+    }
+    // Each runnable serves whichever request has the highest priority when it starts
+    m_pool.start(QRunnable::create([this]() { runOne(); }));
+    return id;
+}
+
+void WaveformCacheProbe::promote(const QObject* owner)
+{
+    QMutexLocker l(&m_lock);
+    auto it = m_background.begin();
+    while (it != m_background.end()) {
+        if (it->ownerKey == owner) {
+            it->visible = true;
+            ++m_visibleOutstanding;
+            m_visible.push_back(std::move(*it));
+            it = m_background.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void WaveformCacheProbe::cancel(const QObject* owner)
+{
+    bool idle = false;
+    {
+        QMutexLocker l(&m_lock);
+        auto dropFrom = [owner](std::deque<Task>& q) {
+            int dropped = 0;
+            q.erase(std::remove_if(q.begin(), q.end(), [&](const Task& t) {
+                if (t.ownerKey != owner) return false;
+                ++dropped;
+                return true;
+            }), q.end());
+            return dropped;
+        };
+        const int droppedVisible = dropFrom(m_visible);
+        dropFrom(m_background);
+        if (droppedVisible > 0) {
+            m_visibleOutstanding -= droppedVisible;
+            idle = m_visibleOutstanding == 0;
+        }
+    }
+    if (idle) emit visibleIdle();
+}
+
+int WaveformCacheProbe::visibleOutstanding()
+{
+    QMutexLocker l(&m_lock);
+    return m_visibleOutstanding;
+}
+
+void WaveformCacheProbe::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+void WaveformCacheProbe::runOne()
+{
+    Task task;
+    {
+        QMutexLocker l(&m_lock);
+        if (!m_visible.empty()) {
+            task = std::move(m_visible.front());
+            m_visible.pop_front();
+        } else if (!m_background.empty()) {
+            task = std::move(m_background.front());
+            m_background.pop_front();
+        } else {
+            return;     // cancelled
+        }
+    }
+    const Result result = probe(task);
+    QMetaObject::invokeMethod(this, [this, task, result]() { deliver(task, result); }, Qt::QueuedConnection);
+}
+
+WaveformCacheProbe::Result WaveformCacheProbe::probe(const Task& task)
+{
+    Result r;
+    r.id = task.id;
+    r.path = task.path;
+    QFileInfo fi(task.path);
+    if (!fi.exists()) return r;
+    r.size = fi.size();
+    r.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    // Fingerprinting (when enabled) reads a few blocks, so it belongs here too
+    r.identity = WaveformPixmapCache::identityOf(task.path, r.size, r.mtimeMs);
+    const WaveformCache::PeakCacheId id = WaveformCache::peakCacheId(task.path, r.size, r.mtimeMs);
+    if (!WaveformCache::mapPeaks(task.cacheDir, id.key, id.size, id.stamp, &r.peaks)) {
+        return r;
+    }
+    r.hit = true;
+    if (task.targetPx.width() > 0 && task.targetPx.height() > 0) {
+        const WaveformLevel level = r.peaks.levelForWidth(task.targetPx.width());
+        r.image = Waveform::renderLevelToImage(level, task.targetPx.width(), 1.0f, task.targetPx.height());
+    }
+    return r;
+}
+
+void WaveformCacheProbe::deliver(const Task& task, const Result& result)
+{
+    if (task.owner && task.callback) task.callback(result);
+    if (!task.visible) return;
+    bool idle = false;
+    {
+        QMutexLocker l(&m_lock);
+        idle = --m_visibleOutstanding == 0;
+    }
+    if (idle) emit visibleIdle();
+}
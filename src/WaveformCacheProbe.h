@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <deque>
+#include <functional>
+#include "WaveformPackedPeaks.h"
+
+/**
+ * WaveformCacheProbe: asynchronous cache lookups for SoundContainer::setFile.
+ *
+ * Restoring a large layout used to stat every file, read and decode its peak
+ * file and render the image on the GUI thread before the window became
+ * interactive. Probes now run on a small worker pool. A worker stats the
+ * file, loads the peaks from WaveformCache and renders them at the requested
+ * device-pixel size. The result is posted back to the GUI thread.
+ *
+ * Requests for containers on the visible tab are served before background
+ * ones, and promote() moves an owner's queued requests to the front when its
+ * tab is shown. visibleIdle() is emitted whenever the last visible request
+ * has been delivered; MainWindow uses it to report time-to-interactive.
+ */
+class WaveformCacheProbe : public QObject {
+    Q_OBJECT
+public:
+    struct Result {
+        quint64 id = 0;
+        QString path;
+        bool hit = false;
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        QString identity;       // WaveformPixmapCache identity of the file
+        WaveformPackedPeaks peaks;     // mapped from the peak file
+        QImage image;           // rendered at the requested size on a hit
+    };
+    using Callback = std::function<void(const Result&)>;
+
+    static WaveformCacheProbe& instance();
+
+    // Queue a probe; `callback` runs on the GUI thread unless `owner` is
+    // destroyed first. `targetPx` is the display size in device pixels.
+    quint64 request(QObject* owner, const QString& path, const QSize& targetPx, bool visible, Callback callback);
+    // Serve this owner's queued probes before background ones
+    void promote(const QObject* owner);
+    // Drop this owner's queued probes
+    void cancel(const QObject* owner);
+
+    int visibleOutstanding();
+    // Block until all queued probes have run (tests)
+    void waitForDone();
+
+signals:
+    void visibleIdle();
+
+private:
+    WaveformCacheProbe();
+
+    struct Task {
+        quint64 id = 0;
+        QPointer<QObject> owner;
+        const QObject* ownerKey = nullptr;
+        QString path;
+        QString cacheDir;       // resolved on the GUI thread, see request()
+        QSize targetPx;
+        bool visible = false;
+        Callback callback;
+    };
+
+    void runOne();
+    static Result probe(const Task& task);
+    void deliver(const Task& task, const Result& result);
+
+    QThreadPool m_pool;
+    QMutex m_lock;
+    std::deque<Task> m_visible;
+    std::deque<Task> m_background;
+    int m_visibleOutstanding = 0;   // queued + in flight + awaiting delivery
+    quint64 m_nextId = 0;
+};
@@ -0,0 +1,160 @@
+#include "WaveformCacheWriter.h"
+#include "WaveformCache.h"
+#include "WaveformCacheIndex.h"
+
+#include <QMutexLocker>
+
+namespace {
+
+QString slotId(bool isPeaks, const QString& key)
+{
+    return (isPeaks ? QStringLiteral("p:") : QStringLiteral("i:")) + key;
+}
+
+} // namespace
+
+WaveformCacheWriter& WaveformCacheWriter::instance()
+{
+    static WaveformCacheWriter s_instance;
+    return s_instance;
+}
+
+WaveformCacheWriter::~WaveformCacheWriter()
+{
+    {
+        QMutexLocker l(&m_lock);
+        m_stop = true;
+        m_wake.wakeAll();
+    }
+    // The writer drains the queue before it exits
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void WaveformCacheWriter::enqueueImage(const QString& dir, const QString& key, const QImage& image,
+                                       const QJsonObject& metadata)
+{
+    Job job;
+    job.dir = dir;
+    job.key = key;
+    job.image = image;
+    job.metadata = metadata;
+    enqueue(std::move(job));
+}
+
+void WaveformCacheWriter::enqueuePeaks(const QString& dir, const QString& key, const WaveformPeaks& peaks, qint64 size,
+                                       qint64 mtimeMs)
+{
+    Job job;
+    job.isPeaks = true;
+    job.dir = dir;
+    job.key = key;
+    job.peaks = peaks;
+    job.size = size;
+    job.mtimeMs = mtimeMs;
+    enqueue(std::move(job));
+}
+
+void WaveformCacheWriter::enqueue(Job&& job)
+{
+    QMutexLocker l(&m_lock);
+    startLocked();
+    const QString id = slotId(job.isPeaks, job.key);
+    job.generation = ++m_generation;
+    job.queued = true;
+
+    auto it = m_jobs.find(id);
+    if (it != m_jobs.end() && it->queued) {
+        // Still waiting: replace the data and keep its place in the queue
+        *it = std::move(job);
+        m_coalesced.fetch_add(1);
+        return;
+    }
+    if (static_cast<int>(m_order.size()) >= kMaxPending) {
+        m_jobs.remove(m_order.front());
+        m_order.pop_front();
+        m_dropped.fetch_add(1);
+    }
+    m_jobs.insert(id, std::move(job));
+    m_order.push_back(id);
+    m_wake.wakeOne();
+}
+
+void WaveformCacheWriter::flush()
+{
+    QMutexLocker l(&m_lock);
+    while (!m_order.empty() || m_inFlight > 0) m_idle.wait(&m_lock);
+}
+
+void WaveformCacheWriter::discardPending()
+{
+    QMutexLocker l(&m_lock);
+    for (const QString& id : m_order) m_jobs.remove(id);
+    m_order.clear();
+    while (m_inFlight > 0) m_idle.wait(&m_lock);
+    m_idle.wakeAll();
+}
+
+bool WaveformCacheWriter::pendingImage(const QString& key, QImage* image, QJsonObject* metadata)
+{
+    QMutexLocker l(&m_lock);
+    auto it = m_jobs.constFind(slotId(false, key));
+    if (it == m_jobs.constEnd()) return false;
+    if (image) *image = it->image;
+    if (metadata) *metadata = it->metadata;
+    return true;
+}
+
+bool WaveformCacheWriter::pendingPeaks(const QString& key, WaveformPeaks* peaks, qint64* size, qint64* mtimeMs)
+{
+    QMutexLocker l(&m_lock);
+    auto it = m_jobs.constFind(slotId(true, key));
+    if (it == m_jobs.constEnd()) return false;
+    if (peaks) *peaks = it->peaks;
+    if (size) *size = it->size;
+    if (mtimeMs) *mtimeMs = it->mtimeMs;
+    return true;
+}
+
+int WaveformCacheWriter::pendingCount()
+{
+    QMutexLocker l(&m_lock);
+    return static_cast<int>(m_order.size()) + m_inFlight;
+}
+
+void WaveformCacheWriter::startLocked()
+{
+    if (m_thread.joinable()) return;
+    m_stop = false;
+    m_thread = std::thread([this]() { writerLoop(); });
+}
+
+void WaveformCacheWriter::writerLoop()
+{
+    QMutexLocker l(&m_lock);
+    for (;;) {
+        while (!m_stop && m_order.empty()) m_wake.wait(&m_lock);
+        if (m_order.empty()) break;   // stopping and drained
+
+        const QString id = m_order.front();
+        m_order.pop_front();
+        auto it = m_jobs.find(id);
+        it->queued = false;
+        const Job job = *it;    // QImage/QVector data is shared, not copied
+        ++m_inFlight;
+        l.unlock();
+
+        if (job.isPeaks) WaveformCache::writePeaksFile(job.dir, job.key, job.peaks, job.size, job.mtimeMs);
+        else WaveformCache::writeImageFile(job.dir, job.key, job.image, job.metadata);
+        // Trim the cache a few entries at a time instead of in one large scan
+        WaveformCache::evictOverLimit(job.dir);
+        // Persist the cache hits recorded since the last write in one batch
+        WaveformCacheIndex::instance().flushTouches(job.dir);
+
+        l.relock();
+        --m_inFlight;
+        // Keep a newer write for the same key that arrived meanwhile
+        it = m_jobs.find(id);
+        if (it != m_jobs.end() && it->generation == job.generation) m_jobs.erase(it);
+        if (m_order.empty() && m_inFlight == 0) m_idle.wakeAll();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include "WaveformPeakFile.h"
+
+/**
+ * WaveformCacheWriter: write-behind queue for WaveformCache.
+ *
+ * WaveformCache::write() and writePeaks() used to PNG-encode or serialize,
+ * write temp files and rename them on the caller's (GUI) thread. They now
+ * enqueue here and return immediately; one background thread performs the
+ * disk I/O. A second write for a key that is still queued replaces the queued
+ * data instead of being written twice. The backlog is bounded: once full, the
+ * oldest queued write is dropped (the cache is regenerated on the next miss).
+ *
+ * Queued and in-flight writes stay readable through pendingImage() and
+ * pendingPeaks(), so a load right after a write sees the new data. flush()
+ * blocks until everything queued so far is on disk (shutdown and tests).
+ * After each write the thread also appends the cache index's pending access
+ * times (WaveformCacheIndex::flushTouches()), so hits never write on the GUI
+ * thread.
+ */
+class WaveformCacheWriter {
+public:
+    static constexpr int kMaxPending = 256;
+
+    static WaveformCacheWriter& instance();
+    ~WaveformCacheWriter();
+
+    // `dir` is the cache directory to write into, resolved by the caller:
+    // the writer thread never reads the preferences
+    void enqueueImage(const QString& dir, const QString& key, const QImage& image, const QJsonObject& metadata);
+    void enqueuePeaks(const QString& dir, const QString& key, const WaveformPeaks& peaks, qint64 size, qint64 mtimeMs);
+
+    // Block until the queue is empty and no write is in flight
+    void flush();
+    // Drop queued writes and wait for the in-flight one (clearAll)
+    void discardPending();
+
+    bool pendingImage(const QString& key, QImage* image, QJsonObject* metadata);
+    bool pendingPeaks(const QString& key, WaveformPeaks* peaks, qint64* size, qint64* mtimeMs);
+
+    int pendingCount();
+    quint64 droppedCount() const { return m_dropped.load(); }
+    quint64 coalescedCount() const { return m_coalesced.load(); }
+
+private:
+    WaveformCacheWriter() = default;
+    Q_DISABLE_COPY(WaveformCacheWriter)
+
+    struct Job {
+        bool isPeaks = false;
+        QString dir;
+        QString key;
+        QImage image;
+        QJsonObject metadata;
+        WaveformPeaks peaks;
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        quint64 generation = 0;
+        bool queued = false;    // present in m_order (not only in flight)
+    };
+
+    void enqueue(Job&& job);
+    void startLocked();
+    void writerLoop();
+
+    QMutex m_lock;
+    QWaitCondition m_wake;      // writer: new work or stop
+    QWaitCondition m_idle;      // flush(): queue drained
+    QHash<QString, Job> m_jobs; // slot id -> latest data (queued or in flight)
+    std::deque<QString> m_order;
+    int m_inFlight = 0;
+    quint64 m_generation = 0;
+    bool m_stop = false;
+    std::thread m_thread;
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_coalesced{0};
+};
@@ -0,0 +1,300 @@
+#include "WaveformJobService.h"
+
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+#include <tuple>
+
+std::atomic<bool> WaveformJobService::s_approximateFirst{false};
+
+WaveformJobService& WaveformJobService::instance()
+{
+    static WaveformJobService s_instance;
+    return s_instance;
+}
+
+WaveformJobService::WaveformJobService()
+{
+    setMaxThreads(0);
+}
+
+QString WaveformJobService::dedupeKey(const WaveformJob& job)
+{
+    // subscribe() runs on the GUI thread: use the version the caller passed
+    // in rather than stat the file here
+    return QStringLiteral("%1|%2|%3|%4|%5")
+        .arg(job.path)
+        .arg(job.size)
+        .arg(job.mtimeMs)
+        .arg(job.pixelWidth)
+        .arg(job.dpr);
+}
+
+void WaveformJobService::subscribe(WaveformWorker* worker, const WaveformJob& job, WaveformPriority priority)
+{
+    const QString key = dedupeKey(job);
+    Subscriber sub;
+    sub.worker = worker;
+    sub.workerKey = worker;
+    sub.job = job;
+    sub.priority = priority;
+
+    bool start = false;
+    {
+        QMutexLocker l(&m_lock);
+        if (m_shutdown) return;
+        auto it = m_decodes.find(key);
+        if (it != m_decodes.end()) {
+            ++m_coalesced;
+        } else {
+            SharedDecode shared;
+            shared.job = job;
+            shared.job.id = QUuid::createUuid();
+            shared.job.cancelToken = QSharedPointer<QAtomicInteger<int>>::create(0);
+            shared.seq = ++m_nextSeq;
+            it = m_decodes.insert(key, shared);
+            start = true;
+        }
+        it->subscribers.push_back(sub);
+        updatePriorityLocked(*it);
+        m_keyByJob.insert(job.id, key);
+    }
+    // Runnables are not bound to a decode: each one takes the most urgent
+    // queued decode when a thread frees up
+    if (start) m_pool.start([this]() { runNext(); });
+}
+
+void WaveformJobService::unsubscribe(const QUuid& jobId)
+{
+    QMutexLocker l(&m_lock);
+    auto it = m_keyByJob.find(jobId);
+    if (it == m_keyByJob.end()) return;
+    const QString key = *it;
+    m_keyByJob.erase(it);
+    releaseLocked(key, jobId);
+}
+
+void WaveformJobService::unsubscribeAll(const WaveformWorker* worker)
+{
+    QMutexLocker l(&m_lock);
+    QVector<QPair<QString, QUuid>> owned;
+    for (auto it = m_decodes.cbegin(); it != m_decodes.cend(); ++it) {
+        for (const Subscriber& s : it->subscribers) {
+            if (s.workerKey == worker) owned.push_back({it.key(), s.job.id});
+        }
+    }
+    for (const auto& o : owned) {
+        m_keyByJob.remove(o.second);
+        releaseLocked(o.first, o.second);
+    }
+}
+
+void WaveformJobService::setPriority(const QUuid& jobId, WaveformPriority priority)
+{
+    QMutexLocker l(&m_lock);
+    auto key = m_keyByJob.find(jobId);
+    if (key == m_keyByJob.end()) return;
+    auto it = m_decodes.find(*key);
+    if (it == m_decodes.end()) return;
+    for (Subscriber& s : it->subscribers) {
+        if (s.job.id == jobId) s.priority = priority;
+    }
+    updatePriorityLocked(*it);
+}
+
+void WaveformJobService::startRender(std::function<void()> render)
+{
+    {
+        QMutexLocker l(&m_lock);
+        if (m_shutdown) return;
+    }
+    // Renders take milliseconds and a user is watching the slot: queue them
+    // before the runNext() runnables
+    m_pool.start(std::move(render), 1);
+}
+
+void WaveformJobService::setMaxThreads(int threads)
+{
+    // Leave a core for the GUI and audio threads by default
+    if (threads <= 0) threads = qBound(1, QThread::idealThreadCount() - 1, 4);
+    m_pool.setMaxThreadCount(threads);
+}
+
+void WaveformJobService::setApproximateFirst(bool enabled)
+{
+    s_approximateFirst.store(enabled, std::memory_order_relaxed);
+}
+
+bool WaveformJobService::approximateFirst()
+{
+    return s_approximateFirst.load(std::memory_order_relaxed);
+}
+
+int WaveformJobService::maxThreads() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void WaveformJobService::shutdown()
+{
+    {
+        QMutexLocker l(&m_lock);
+        m_shutdown = true;
+        for (SharedDecode& d : m_decodes) {
+            if (d.job.cancelToken) d.job.cancelToken->storeRelaxed(1);
+        }
+        m_decodes.clear();
+        m_keyByJob.clear();
+    }
+    // Queued runnables find nothing left; running decodes stop at the next chunk
+    m_pool.waitForDone();
+}
+
+void WaveformJobService::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+int WaveformJobService::activeDecodeCount()
+{
+    QMutexLocker l(&m_lock);
+    return m_decodes.size();
+}
+
+quint64 WaveformJobService::coalescedCount()
+{
+    QMutexLocker l(&m_lock);
+    return m_coalesced;
+}
+
+void WaveformJobService::updatePriorityLocked(SharedDecode& decode)
+{
+    WaveformPriority best = WaveformPriority::Background;
+    for (const Subscriber& s : decode.subscribers) best = std::min(best, s.priority);
+    decode.priority = best;
+}
+
+void WaveformJobService::releaseLocked(const QString& key, const QUuid& jobId)
+{
+    auto it = m_decodes.find(key);
+    if (it == m_decodes.end()) return;
+    auto& subs = it->subscribers;
+    subs.erase(std::remove_if(subs.begin(), subs.end(), [&](const Subscriber& s) { return s.job.id == jobId; }),
+               subs.end());
+    if (!subs.isEmpty()) {
+        updatePriorityLocked(*it);
+        return;
+    }
+    // Last subscriber gone: stop the decode
+    if (it->job.cancelToken) it->job.cancelToken->storeRelaxed(1);
+    m_decodes.erase(it);
+}
+
+void WaveformJobService::runNext()
+{
+    WaveformJob job;
+    bool refining = false;
+    {
+        QMutexLocker l(&m_lock);
+        // Most urgent first, FIFO within a priority; refinement passes wait
+        // behind every first decode, background ones included
+        auto order = [](const SharedDecode& d) {
+            return std::make_tuple(d.refining, d.priority, d.seq);
+        };
+        auto best = m_decodes.end();
+        for (auto it = m_decodes.begin(); it != m_decodes.end(); ++it) {
+            if (it->started) continue;
+            if (best == m_decodes.end() || order(*it) < order(*best)) best = it;
+        }
+        // Nothing queued: the decode this runnable was started for was cancelled
+        if (best == m_decodes.end()) return;
+        best->started = true;
+        job = best->job;
+        refining = best->refining;
+    }
+
+    if (!refining && approximateFirst()) {
+        WaveformResult overview = WaveformWorker::decodeApproximate(job.path, job.pixelWidth, job.dpr, job.cancelToken);
+        if (job.cancelToken && job.cancelToken->loadRelaxed() != 0) return;
+        if (overview.sampleRate > 0) {
+            QMetaObject::invokeMethod(this, [this, job, overview]() {
+                deliverPartial(job, overview);
+            }, Qt::QueuedConnection);
+            {
+                QMutexLocker l(&m_lock);
+                auto it = m_decodes.begin();
+                for (; it != m_decodes.end(); ++it) {
+                    if (it->job.id == job.id) break;
+                }
+                if (it == m_decodes.end()) return;
+                it->started = false;
+                it->refining = true;
+            }
+            m_pool.start([this]() { runNext(); });
+            return;
+        }
+    }
+
+    // Perform synchronous decode using the helper (supports cancellation);
+    // partial results travel the same queued path as the final one, so they
+    // can never arrive after it. A refinement pass sends none: the overview
+    // on screen is better than a partly silent waveform.
+    WaveformWorker::PartialCallback onPartial;
+    if (!refining) {
+        onPartial = [this, job](const WaveformResult& partial) {
+            QMetaObject::invokeMethod(this, [this, job, partial]() {
+                deliverPartial(job, partial);
+            }, Qt::QueuedConnection);
+        };
+    }
+    WaveformResult res = WaveformWorker::decodeFile(job.path, job.pixelWidth, job.dpr, job.cancelToken, onPartial);
+    // A cancelled decode has no subscribers left to notify
+    if (job.cancelToken && job.cancelToken->loadRelaxed() != 0) return;
+
+    // If decode produced no sample-rate we consider it an error
+    const QString error = res.sampleRate == 0 ? QStringLiteral("decode-failed") : QString();
+    if (error.isEmpty()) WaveformWorker::stampSource(job.path, &res);
+    QMetaObject::invokeMethod(this, [this, job, res, error]() {
+        finish(job, res, error);
+    }, Qt::QueuedConnection);
+}
+
+void WaveformJobService::deliverPartial(const WaveformJob& decoded, const WaveformResult& partial)
+{
+    QVector<Subscriber> subscribers;
+    {
+        QMutexLocker l(&m_lock);
+        for (const SharedDecode& d : std::as_const(m_decodes)) {
+            if (d.job.id == decoded.id) {
+                subscribers = d.subscribers;
+                break;
+            }
+        }
+    }
+    // Finished or cancelled decodes have no subscribers left
+    for (const Subscriber& s : subscribers) {
+        if (s.worker) s.worker->notifyPartial(s.job, partial);
+    }
+}
+
+void WaveformJobService::finish(const WaveformJob& decoded, const WaveformResult& result, const QString& error)
+{
+    QVector<Subscriber> subscribers;
+    {
+        QMutexLocker l(&m_lock);
+        // Match on the decode id: the key may belong to a newer decode by now
+        auto it = m_decodes.begin();
+        for (; it != m_decodes.end(); ++it) {
+            if (it->job.id == decoded.id) break;
+        }
+        if (it == m_decodes.end()) return;
+        subscribers = it->subscribers;
+        m_decodes.erase(it);
+        for (const Subscriber& s : subscribers) m_keyByJob.remove(s.job.id);
+    }
+    for (const Subscriber& s : subscribers) {
+        if (!s.worker) continue;
+        if (error.isEmpty()) s.worker->notifyReady(s.job, result);
+        else s.worker->notifyError(s.job, error);
+    }
+}
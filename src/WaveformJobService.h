@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QThreadPool>
+#include <QUuid>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include "WaveformWorker.h"
+
+/**
+ * WaveformJobService: process-wide scheduler behind every WaveformWorker.
+ *
+ * Each SoundContainer owns a WaveformWorker, and each enqueueJob() used to
+ * start its own decode, so ten slots holding the same file decoded it ten
+ * times. Workers now subscribe their jobs here. Jobs for the same file
+ * version (path, size, mtime) and target resolution (pixel width, DPR)
+ * share one decode, and its result is fanned out to every subscriber under
+ * the subscriber's own job id. Cancellation is reference counted: a worker
+ * cancelling its job only unsubscribes, and the shared decode is cancelled
+ * once nobody is waiting for it.
+ *
+ * Decodes run on a dedicated pool rather than QThreadPool::globalInstance().
+ * Each pool thread takes the queued decode with the highest priority (see
+ * WaveformPriority) when it starts; a decode's priority is the highest among
+ * its subscribers, and setPriority() reorders queued work when a tab is
+ * switched or a slot is hovered.
+ *
+ * With approximate-first enabled, a long file is first sampled with
+ * WaveformWorker::decodeApproximate() and the overview is delivered as a
+ * partial result; the exact decode is then queued again at background
+ * priority, so every slot gets its overview before any slot is refined.
+ */
+class WaveformJobService : public QObject {
+    Q_OBJECT
+public:
+    static WaveformJobService& instance();
+
+    // Subscribe `worker` to a decode for `job` (id, path, width and DPR set;
+    // size and mtime when known)
+    void subscribe(WaveformWorker* worker, const WaveformJob& job, WaveformPriority priority);
+    // Drop one subscription; cancels the decode when it was the last one
+    void unsubscribe(const QUuid& jobId);
+    // Drop every subscription held by `worker` (worker destruction)
+    void unsubscribeAll(const WaveformWorker* worker);
+    // Change the priority of a subscription; affects decodes not yet started
+    void setPriority(const QUuid& jobId, WaveformPriority priority);
+    // Run a short render from peaks already in memory (a slot resized far)
+    // on the decode threads, ahead of decodes that have not started
+    void startRender(std::function<void()> render);
+
+    // Show a sampled overview of long files before decoding them exactly
+    static void setApproximateFirst(bool enabled);
+    static bool approximateFirst();
+
+    // Decode threads; 0 picks a default from the core count
+    void setMaxThreads(int threads);
+    int maxThreads() const;
+    // Cancel everything and wait for the decode threads only (application exit)
+    void shutdown();
+    // Block until started decodes have finished (tests)
+    void waitForDone();
+
+    // Decodes currently running or queued
+    int activeDecodeCount();
+    // Subscriptions that joined an existing decode instead of starting one
+    quint64 coalescedCount();
+
+private:
+    WaveformJobService();
+    Q_DISABLE_COPY(WaveformJobService)
+
+    struct Subscriber {
+        QPointer<WaveformWorker> worker;
+        const WaveformWorker* workerKey = nullptr;
+        WaveformJob job;
+        WaveformPriority priority = WaveformPriority::Visible;
+    };
+
+    struct SharedDecode {
+        WaveformJob job;                    // the job actually decoded
+        QVector<Subscriber> subscribers;
+        WaveformPriority priority = WaveformPriority::Background;
+        quint64 seq = 0;                    // FIFO order within a priority
+        bool started = false;
+        bool refining = false;              // overview delivered, exact pass queued
+    };
+
+    static QString dedupeKey(const WaveformJob& job);
+    static void updatePriorityLocked(SharedDecode& decode);
+    void releaseLocked(const QString& key, const QUuid& jobId);
+    // Pool thread entry: decode the most urgent queued job, if any
+    void runNext();
+    // Runs on the service's thread for each partial result of a decode
+    void deliverPartial(const WaveformJob& decoded, const WaveformResult& partial);
+    // Runs on the service's thread when a decode ends
+    void finish(const WaveformJob& decoded, const WaveformResult& result, const QString& error);
+
+    QThreadPool m_pool;
+    mutable QMutex m_lock;
+    QHash<QString, SharedDecode> m_decodes;     // dedupe key -> shared decode
+    QHash<QUuid, QString> m_keyByJob;           // subscriber job id -> dedupe key
+    static std::atomic<bool> s_approximateFirst;
+    quint64 m_nextSeq = 0;
+    quint64 m_coalesced = 0;
+    bool m_shutdown = false;
+};
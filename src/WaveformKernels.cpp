@@ -0,0 +1,354 @@
+#include "WaveformKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WAVEFORM_KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define WAVEFORM_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Fold the min/max of `n` contiguous samples into *outMin / *outMax
+using ReduceFn = void (*)(const float* p, size_t n, float* outMin, float* outMax);
+
+// One row of vertical spans, see WaveformKernels::spanRow
+using SpanRowFn = void (*)(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                           const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n);
+
+inline uint32_t spanPixel(int32_t y, int32_t top, int32_t bottom, uint32_t topPx, uint32_t bottomPx, uint32_t fillPx)
+{
+    if (y < top || y > bottom) return 0;
+    if (y == top) return topPx;
+    if (y == bottom) return bottomPx;
+    return fillPx;
+}
+
+void spanRowScalar(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                   const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n)
+{
+    for (size_t x = 0; x < n; ++x) out[x] = spanPixel(y, top[x], bottom[x], topPx[x], bottomPx[x], fillPx);
+}
+
+void reduceScalar(const float* p, size_t n, float* outMin, float* outMax)
+{
+    float mn = *outMin;
+    float mx = *outMax;
+    for (size_t i = 0; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    *outMin = mn;
+    *outMax = mx;
+}
+
+#if defined(WAVEFORM_KERNELS_X86)
+__attribute__((target("sse2")))
+void reduceSse2(const float* p, size_t n, float* outMin, float* outMax)
+{
+    float mn = *outMin;
+    float mx = *outMax;
+    size_t i = 0;
+    if (n >= 8) {
+        // Two accumulators per side hide the min/max latency
+        __m128 min0 = _mm_set1_ps(mn), min1 = min0;
+        __m128 max0 = _mm_set1_ps(mx), max1 = max0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128 a = _mm_loadu_ps(p + i);
+            const __m128 b = _mm_loadu_ps(p + i + 4);
+            min0 = _mm_min_ps(min0, a);
+            min1 = _mm_min_ps(min1, b);
+            max0 = _mm_max_ps(max0, a);
+            max1 = _mm_max_ps(max1, b);
+        }
+        alignas(16) float lanesMin[4];
+        alignas(16) float lanesMax[4];
+        _mm_store_ps(lanesMin, _mm_min_ps(min0, min1));
+        _mm_store_ps(lanesMax, _mm_max_ps(max0, max1));
+        for (int k = 0; k < 4; ++k) {
+            mn = std::min(mn, lanesMin[k]);
+            mx = std::max(mx, lanesMax[k]);
+        }
+    }
+    for (; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    *outMin = mn;
+    *outMax = mx;
+}
+
+__attribute__((target("sse2")))
+void spanRowSse2(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                 const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n)
+{
+    const __m128i vy = _mm_set1_epi32(y);
+    const __m128i fill = _mm_set1_epi32(static_cast<int>(fillPx));
+    size_t x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x));
+        const __m128i outside = _mm_or_si128(_mm_cmpgt_epi32(t, vy), _mm_cmpgt_epi32(vy, b));
+        const __m128i isTop = _mm_cmpeq_epi32(vy, t);
+        const __m128i isBottom = _mm_cmpeq_epi32(vy, b);
+        // SSE2 has no blendv: select with and/andnot, top edge winning
+        __m128i px = _mm_or_si128(
+            _mm_and_si128(isBottom, _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottomPx + x))),
+            _mm_andnot_si128(isBottom, fill));
+        px = _mm_or_si128(_mm_and_si128(isTop, _mm_loadu_si128(reinterpret_cast<const __m128i*>(topPx + x))),
+                          _mm_andnot_si128(isTop, px));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_andnot_si128(outside, px));
+    }
+    for (; x < n; ++x) out[x] = spanPixel(y, top[x], bottom[x], topPx[x], bottomPx[x], fillPx);
+}
+
+__attribute__((target("avx2")))
+void reduceAvx2(const float* p, size_t n, float* outMin, float* outMax)
+{
+    float mn = *outMin;
+    float mx = *outMax;
+    size_t i = 0;
+    if (n >= 16) {
+        __m256 min0 = _mm256_set1_ps(mn), min1 = min0;
+        __m256 max0 = _mm256_set1_ps(mx), max1 = max0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256 a = _mm256_loadu_ps(p + i);
+            const __m256 b = _mm256_loadu_ps(p + i + 8);
+            min0 = _mm256_min_ps(min0, a);
+            min1 = _mm256_min_ps(min1, b);
+            max0 = _mm256_max_ps(max0, a);
+            max1 = _mm256_max_ps(max1, b);
+        }
+        alignas(32) float lanesMin[8];
+        alignas(32) float lanesMax[8];
+        _mm256_store_ps(lanesMin, _mm256_min_ps(min0, min1));
+        _mm256_store_ps(lanesMax, _mm256_max_ps(max0, max1));
+        // Leave no dirty upper state for the SSE code below (and the caller)
+        _mm256_zeroupper();
+        for (int k = 0; k < 8; ++k) {
+            mn = std::min(mn, lanesMin[k]);
+            mx = std::max(mx, lanesMax[k]);
+        }
+    }
+    for (; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    *outMin = mn;
+    *outMax = mx;
+}
+
+__attribute__((target("avx2")))
+void spanRowAvx2(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                 const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n)
+{
+    const __m256i vy = _mm256_set1_epi32(y);
+    const __m256i fill = _mm256_set1_epi32(static_cast<int>(fillPx));
+    size_t x = 0;
+    for (; x + 8 <= n; x += 8) {
+        const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + x));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + x));
+        const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(t, vy), _mm256_cmpgt_epi32(vy, b));
+        __m256i px = _mm256_blendv_epi8(fill, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottomPx + x)),
+                                        _mm256_cmpeq_epi32(vy, b));
+        px = _mm256_blendv_epi8(px, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(topPx + x)),
+                                _mm256_cmpeq_epi32(vy, t));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_andnot_si256(outside, px));
+    }
+    _mm256_zeroupper();
+    for (; x < n; ++x) out[x] = spanPixel(y, top[x], bottom[x], topPx[x], bottomPx[x], fillPx);
+}
+#endif
+
+#if defined(WAVEFORM_KERNELS_NEON)
+void reduceNeon(const float* p, size_t n, float* outMin, float* outMax)
+{
+    float mn = *outMin;
+    float mx = *outMax;
+    size_t i = 0;
+    if (n >= 8) {
+        float32x4_t min0 = vdupq_n_f32(mn), min1 = min0;
+        float32x4_t max0 = vdupq_n_f32(mx), max1 = max0;
+        for (; i + 8 <= n; i += 8) {
+            const float32x4_t a = vld1q_f32(p + i);
+            const float32x4_t b = vld1q_f32(p + i + 4);
+            min0 = vminq_f32(min0, a);
+            min1 = vminq_f32(min1, b);
+            max0 = vmaxq_f32(max0, a);
+            max1 = vmaxq_f32(max1, b);
+        }
+        mn = std::min(mn, vminvq_f32(vminq_f32(min0, min1)));
+        mx = std::max(mx, vmaxvq_f32(vmaxq_f32(max0, max1)));
+    }
+    for (; i < n; ++i) {
+        mn = std::min(mn, p[i]);
+        mx = std::max(mx, p[i]);
+    }
+    *outMin = mn;
+    *outMax = mx;
+}
+
+void spanRowNeon(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                 const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n)
+{
+    const int32x4_t vy = vdupq_n_s32(y);
+    const uint32x4_t fill = vdupq_n_u32(fillPx);
+    size_t x = 0;
+    for (; x + 4 <= n; x += 4) {
+        const int32x4_t t = vld1q_s32(top + x);
+        const int32x4_t b = vld1q_s32(bottom + x);
+        const uint32x4_t outside = vorrq_u32(vcgtq_s32(t, vy), vcgtq_s32(vy, b));
+        uint32x4_t px = vbslq_u32(vceqq_s32(vy, b), vld1q_u32(bottomPx + x), fill);
+        px = vbslq_u32(vceqq_s32(vy, t), vld1q_u32(topPx + x), px);
+        vst1q_u32(out + x, vbicq_u32(px, outside));
+    }
+    for (; x < n; ++x) out[x] = spanPixel(y, top[x], bottom[x], topPx[x], bottomPx[x], fillPx);
+}
+#endif
+
+ReduceFn reduceFor(WaveformKernels::Isa isa)
+{
+    switch (isa) {
+#if defined(WAVEFORM_KERNELS_X86)
+    case WaveformKernels::Isa::SSE2: return reduceSse2;
+    case WaveformKernels::Isa::AVX2: return reduceAvx2;
+#endif
+#if defined(WAVEFORM_KERNELS_NEON)
+    case WaveformKernels::Isa::NEON: return reduceNeon;
+#endif
+    default: return reduceScalar;
+    }
+}
+
+SpanRowFn spanRowFor(WaveformKernels::Isa isa)
+{
+    switch (isa) {
+#if defined(WAVEFORM_KERNELS_X86)
+    case WaveformKernels::Isa::SSE2: return spanRowSse2;
+    case WaveformKernels::Isa::AVX2: return spanRowAvx2;
+#endif
+#if defined(WAVEFORM_KERNELS_NEON)
+    case WaveformKernels::Isa::NEON: return spanRowNeon;
+#endif
+    default: return spanRowScalar;
+    }
+}
+
+bool isaSupported(WaveformKernels::Isa isa)
+{
+    switch (isa) {
+    case WaveformKernels::Isa::Scalar:
+        return true;
+#if defined(WAVEFORM_KERNELS_X86)
+    case WaveformKernels::Isa::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case WaveformKernels::Isa::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#if defined(WAVEFORM_KERNELS_NEON)
+    case WaveformKernels::Isa::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+struct Dispatch {
+    std::atomic<ReduceFn> reduce;
+    std::atomic<SpanRowFn> spanRow;
+    std::atomic<WaveformKernels::Isa> isa;
+
+    Dispatch()
+        : reduce(reduceFor(WaveformKernels::bestSupportedIsa()))
+        , spanRow(spanRowFor(WaveformKernels::bestSupportedIsa()))
+        , isa(WaveformKernels::bestSupportedIsa())
+    {
+    }
+};
+
+Dispatch& dispatch()
+{
+    static Dispatch s_dispatch;
+    return s_dispatch;
+}
+
+} // namespace
+
+void WaveformKernels::minMax(const float* interleaved, size_t frames, int channels, float* outMin, float* outMax)
+{
+    if (!interleaved || frames == 0 || channels <= 0) return;
+    dispatch().reduce.load(std::memory_order_relaxed)(interleaved, frames * static_cast<size_t>(channels),
+                                                      outMin, outMax);
+}
+
+void WaveformKernels::minMaxScalar(const float* interleaved, size_t frames, int channels, float* outMin, float* outMax)
+{
+    if (!interleaved || frames == 0 || channels <= 0) return;
+    reduceScalar(interleaved, frames * static_cast<size_t>(channels), outMin, outMax);
+}
+
+void WaveformKernels::bucketMinMax(const float* interleaved, size_t frames, int channels, size_t framesPerBucket,
+                                   float* outMin, float* outMax, size_t bucketCount)
+{
+    if (channels <= 0 || framesPerBucket == 0) return;
+    const ReduceFn reduce = dispatch().reduce.load(std::memory_order_relaxed);
+    const size_t stride = framesPerBucket * static_cast<size_t>(channels);
+    for (size_t b = 0; b < bucketCount; ++b) {
+        const size_t start = b * framesPerBucket;
+        float mn = std::numeric_limits<float>::infinity();
+        float mx = -std::numeric_limits<float>::infinity();
+        if (interleaved && start < frames) {
+            const size_t n = std::min(framesPerBucket, frames - start) * static_cast<size_t>(channels);
+            reduce(interleaved + b * stride, n, &mn, &mx);
+        }
+        // Empty buckets (past the end of the input) read as silence
+        outMin[b] = mn == std::numeric_limits<float>::infinity() ? 0.0f : mn;
+        outMax[b] = mx == -std::numeric_limits<float>::infinity() ? 0.0f : mx;
+    }
+}
+
+void WaveformKernels::spanRow(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                              const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n)
+{
+    dispatch().spanRow.load(std::memory_order_relaxed)(y, top, bottom, topPx, bottomPx, fillPx, out, n);
+}
+
+WaveformKernels::Isa WaveformKernels::activeIsa()
+{
+    return dispatch().isa.load(std::memory_order_relaxed);
+}
+
+WaveformKernels::Isa WaveformKernels::bestSupportedIsa()
+{
+    for (Isa isa : {Isa::AVX2, Isa::NEON, Isa::SSE2}) {
+        if (isaSupported(isa)) return isa;
+    }
+    return Isa::Scalar;
+}
+
+const char* WaveformKernels::isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::SSE2: return "SSE2";
+    case Isa::AVX2: return "AVX2";
+    case Isa::NEON: return "NEON";
+    default: return "scalar";
+    }
+}
+
+bool WaveformKernels::setActiveIsa(Isa isa)
+{
+    if (!isaSupported(isa)) return false;
+    dispatch().reduce.store(reduceFor(isa), std::memory_order_relaxed);
+    dispatch().spanRow.store(spanRowFor(isa), std::memory_order_relaxed);
+    dispatch().isa.store(isa, std::memory_order_relaxed);
+    return true;
+}
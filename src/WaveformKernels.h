@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * WaveformKernels: vectorized min/max reductions shared by WaveformWorker
+ * (decode preview and peak pyramid) and WaveformPyramid::build.
+ *
+ * Both callers reduce across channels, so the samples of a run of
+ * interleaved frames form one contiguous block whatever the channel count:
+ * mono, stereo and N-channel input go through the same kernel, the channel
+ * count only scales the block length. The implementation is chosen once at
+ * runtime from the CPU (AVX2, SSE2 or NEON, with a scalar fallback).
+ *
+ * spanRow() is the inner loop of the waveform rasterizer (WaveformRenderer)
+ * and is dispatched the same way.
+ */
+class WaveformKernels {
+public:
+    enum class Isa {
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    // Signed min/max over `frames` interleaved frames of `channels` samples.
+    // Results are folded into *outMin / *outMax, so callers can seed them
+    // with +/-infinity or continue a running bucket.
+    static void minMax(const float* interleaved, size_t frames, int channels, float* outMin, float* outMax);
+
+    // Same reduction without SIMD (reference for tests and benchmarks)
+    static void minMaxScalar(const float* interleaved, size_t frames, int channels, float* outMin, float* outMax);
+
+    // Per-bucket min/max: `bucketCount` buckets of `framesPerBucket` frames,
+    // the last one possibly shorter than the others when `frames` runs out
+    static void bucketMinMax(const float* interleaved, size_t frames, int channels, size_t framesPerBucket,
+                             float* outMin, float* outMax, size_t bucketCount);
+
+    // One image row of vertical column spans, for row `y`:
+    //   out[x] = 0           if y < top[x] or y > bottom[x]
+    //            topPx[x]    if y == top[x]
+    //            bottomPx[x] if y == bottom[x]
+    //            fillPx      otherwise
+    // top/bottom are inclusive; the edge pixels carry antialiasing coverage.
+    static void spanRow(int32_t y, const int32_t* top, const int32_t* bottom, const uint32_t* topPx,
+                        const uint32_t* bottomPx, uint32_t fillPx, uint32_t* out, size_t n);
+
+    // Implementation in use, and the best one this CPU supports
+    static Isa activeIsa();
+    static Isa bestSupportedIsa();
+    static const char* isaName(Isa isa);
+    // Switch implementation (tests, benchmarks). Returns false, leaving the
+    // current one active, when the CPU or build does not support `isa`.
+    static bool setActiveIsa(Isa isa);
+};
@@ -0,0 +1,164 @@
+#include "WaveformPackedPeaks.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+WaveformPackedPeaks WaveformPackedPeaks::pack(const WaveformPeaks& peaks, Precision precision)
+{
+    return fromBytes(WaveformPeakFile::encode(peaks, 0, 0, precision));
+}
+
+WaveformPackedPeaks WaveformPackedPeaks::fromBytes(const QByteArray& peakFile)
+{
+    WaveformPackedPeaks out;
+    if (!WaveformPeakFile::parse(peakFile.constData(), peakFile.size(), &out.m_layout)) return WaveformPackedPeaks();
+    out.m_bytes = peakFile;
+    out.m_data = out.m_bytes.constData();
+    out.m_size = out.m_bytes.size();
+    if (!out.isValid()) return WaveformPackedPeaks();
+    return out;
+}
+
+WaveformPackedPeaks WaveformPackedPeaks::map(const QString& filePath, qint64* sourceSize, qint64* sourceMtimeMs)
+{
+    // POSIX, like the rest of the cache's file handling. The descriptor is
+    // closed as soon as the file is mapped: a grid of mapped slots holds no
+    // descriptors, and the writer can still rename new files over mapped ones.
+    const int fd = ::open(QFile::encodeName(filePath).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return WaveformPackedPeaks();
+    struct stat st;
+    const qint64 size = ::fstat(fd, &st) == 0 ? static_cast<qint64>(st.st_size) : 0;
+    void* mapped = size > 0 ? ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+
+    WaveformPackedPeaks out;
+    if (mapped != MAP_FAILED) {
+        out.m_mapping = std::shared_ptr<const void>(mapped, [size](const void* p) {
+            ::munmap(const_cast<void*>(p), static_cast<size_t>(size));
+        });
+        const char* data = static_cast<const char*>(mapped);
+        if (!WaveformPeakFile::parse(data, size, &out.m_layout)) return WaveformPackedPeaks();
+        out.m_data = data;
+        out.m_size = size;
+    } else {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) return WaveformPackedPeaks();
+        out = fromBytes(file.readAll());
+    }
+    if (!out.isValid()) return WaveformPackedPeaks();
+    if (sourceSize) *sourceSize = out.m_layout.sourceSize;
+    if (sourceMtimeMs) *sourceMtimeMs = out.m_layout.sourceMtimeMs;
+    return out;
+}
+
+int WaveformPackedPeaks::levelIndexForWidth(int pixelCount) const
+{
+    if (!isValid() || pixelCount <= 0) return 0;
+    const double framesPerPixel = static_cast<double>(totalFrames()) / static_cast<double>(pixelCount);
+    // Each level doubles the bucket width: floor(log2) finds the level
+    // without walking the table
+    const double base = std::max(1, samplesPerBucket(0));
+    int li = framesPerPixel >= 2.0 * base ? std::ilogb(framesPerPixel / base) : 0;
+    li = std::clamp(li, 0, levelCount() - 1);
+    // Tables that do not double exactly end up at the same level as the walk
+    while (li > 0 && samplesPerBucket(li) > framesPerPixel) --li;
+    while (li + 1 < levelCount() && samplesPerBucket(li + 1) <= framesPerPixel) ++li;
+    return li;
+}
+
+template <typename T>
+WaveformLevel WaveformPackedPeaks::columns(int levelIndex, int pixelCount) const
+{
+    const WaveformPeakFile::Layout::Level& src = m_layout.levels[levelIndex];
+    const char* pairs = m_data + src.offset;
+    const int buckets = src.buckets;
+    const qint64 spb = std::max(1, src.samplesPerBucket);
+    const qint64 frames = totalFrames();
+    const float inv = 1.0f / static_cast<float>(std::numeric_limits<T>::max());
+    auto value = [pairs](qint64 i) { return qFromLittleEndian<T>(pairs + i * static_cast<qint64>(sizeof(T))); };
+
+    WaveformLevel out;
+    out.samplesPerBucket = static_cast<int>(std::ceil(static_cast<double>(frames) / pixelCount));
+    out.min.resize(pixelCount);
+    out.max.resize(pixelCount);
+    for (int x = 0; x < pixelCount; ++x) {
+        const qint64 f0 = frames * x / pixelCount;
+        const qint64 f1 = frames * (x + 1) / pixelCount;
+        const qint64 b0 = std::min<qint64>(f0 / spb, buckets - 1);
+        qint64 b1 = std::min<qint64>((f1 + spb - 1) / spb, buckets);
+        if (b1 <= b0) b1 = b0 + 1;
+        // Aggregate in the integer domain; dequantizing is monotonic
+        T vmin = value(2 * b0);
+        T vmax = value(2 * b0 + 1);
+        for (qint64 b = b0 + 1; b < b1; ++b) {
+            vmin = std::min(vmin, value(2 * b));
+            vmax = std::max(vmax, value(2 * b + 1));
+        }
+        out.min[x] = static_cast<float>(vmin) * inv;
+        out.max[x] = static_cast<float>(vmax) * inv;
+    }
+    return out;
+}
+
+WaveformLevel WaveformPackedPeaks::levelForWidth(int pixelCount) const
+{
+    if (!isValid() || pixelCount <= 0) return WaveformLevel();
+    const int li = levelIndexForWidth(pixelCount);
+    if (bucketCount(li) <= 0) return WaveformLevel();
+    return sampleBits() == 8 ? columns<qint8>(li, pixelCount) : columns<qint16>(li, pixelCount);
+}
+
+template <typename T>
+WaveformLevel WaveformPackedPeaks::unpackLevel(int levelIndex) const
+{
+    const WaveformPeakFile::Layout::Level& src = m_layout.levels[levelIndex];
+    const char* p = m_data + src.offset;
+    const float inv = 1.0f / static_cast<float>(std::numeric_limits<T>::max());
+    WaveformLevel out;
+    out.samplesPerBucket = src.samplesPerBucket;
+    out.min.resize(src.buckets);
+    out.max.resize(src.buckets);
+    for (int i = 0; i < src.buckets; ++i) {
+        out.min[i] = static_cast<float>(qFromLittleEndian<T>(p)) * inv;
+        p += sizeof(T);
+        out.max[i] = static_cast<float>(qFromLittleEndian<T>(p)) * inv;
+        p += sizeof(T);
+    }
+    return out;
+}
+
+WaveformLevel WaveformPackedPeaks::level(int index) const
+{
+    if (!isValid() || index < 0 || index >= levelCount()) return WaveformLevel();
+    return sampleBits() == 8 ? unpackLevel<qint8>(index) : unpackLevel<qint16>(index);
+}
+
+WaveformPeaks WaveformPackedPeaks::unpack() const
+{
+    WaveformPeaks peaks;
+    if (!isValid()) return peaks;
+    peaks.sampleRate = sampleRate();
+    peaks.channels = channels();
+    peaks.totalFrames = totalFrames();
+    peaks.levels.reserve(levelCount());
+    for (int i = 0; i < levelCount(); ++i) peaks.levels.push_back(level(i));
+    return peaks;
+}
+
+QByteArray WaveformPackedPeaks::bytes() const
+{
+    if (!m_bytes.isEmpty()) return m_bytes;
+    return m_data ? QByteArray(m_data, static_cast<int>(m_size)) : QByteArray();
+}
+
+qint64 WaveformPackedPeaks::memoryBytes() const
+{
+    return m_size + static_cast<qint64>(m_layout.levels.size()) * sizeof(WaveformPeakFile::Layout::Level);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "WaveformPeakFile.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+/**
+ * WaveformPeaks in the peak-file layout: every level's quantized {min, max}
+ * pairs interleaved in one contiguous arena, with a table of level offsets.
+ * The arena is either an encoded peak file held in memory (pack(), fromBytes())
+ * or the `.peaks` file itself, memory-mapped (map()). At int16 it takes half
+ * the memory of the float pyramid, a quarter at int8, and one allocation
+ * instead of two per level.
+ *
+ * Copies share the arena. Columns for a width come straight from the packed
+ * pairs (levelForWidth()), without unpacking any level to floats.
+ */
+class WaveformPackedPeaks {
+public:
+    using Precision = WaveformPeakFile::Precision;
+
+    WaveformPackedPeaks() = default;
+
+    static WaveformPackedPeaks pack(const WaveformPeaks& peaks, Precision precision = Precision::Int16);
+    // Invalid result for data WaveformPeakFile::decode() would reject
+    static WaveformPackedPeaks fromBytes(const QByteArray& peakFile);
+    // Maps `filePath` read-only (no descriptor stays open); reads it into
+    // memory where mapping fails. The source stamps are those the file was
+    // written with.
+    static WaveformPackedPeaks map(const QString& filePath, qint64* sourceSize = nullptr,
+                                   qint64* sourceMtimeMs = nullptr);
+
+    bool isValid() const { return m_data != nullptr && !m_layout.levels.isEmpty() && m_layout.sampleRate > 0
+                                  && m_layout.totalFrames > 0; }
+    bool isMapped() const { return m_mapping != nullptr; }
+    int sampleRate() const { return m_layout.sampleRate; }
+    int channels() const { return m_layout.channels; }
+    qint64 totalFrames() const { return m_layout.totalFrames; }
+    double duration() const { return sampleRate() > 0 ? static_cast<double>(totalFrames()) / sampleRate() : 0.0; }
+    int sampleBits() const { return m_layout.sampleBits; }
+
+    int levelCount() const { return m_layout.levels.size(); }
+    int bucketCount(int level) const { return m_layout.levels[level].buckets; }
+    int samplesPerBucket(int level) const { return m_layout.levels[level].samplesPerBucket; }
+    // Coarsest level whose buckets are no wider than one of `pixelCount`
+    // pixels (the level WaveformPyramid::levelForWidth() aggregates)
+    int levelIndexForWidth(int pixelCount) const;
+
+    // Same columns as WaveformPyramid::levelForWidth() on unpack()
+    WaveformLevel levelForWidth(int pixelCount) const;
+    WaveformLevel level(int index) const;
+    WaveformPeaks unpack() const;
+
+    // The encoded peak file; for a mapped file this copies the mapping
+    QByteArray bytes() const;
+    // Bytes held by this object: the arena and the level table
+    qint64 memoryBytes() const;
+
+private:
+    template <typename T>
+    WaveformLevel columns(int levelIndex, int pixelCount) const;
+    template <typename T>
+    WaveformLevel unpackLevel(int levelIndex) const;
+
+    WaveformPeakFile::Layout m_layout;
+    QByteArray m_bytes;                 // owned arena, empty when mapped
+    std::shared_ptr<const void> m_mapping;  // unmapped with the last copy
+    const char* m_data = nullptr;
+    qint64 m_size = 0;
+};
@@ -0,0 +1,199 @@
+#include "WaveformPeakFile.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char kMagic[4] = {'L', 'S', 'B', 'P'};
+
+template <typename T>
+void putLE(char*& p, T v)
+{
+    qToLittleEndian<T>(v, p);
+    p += sizeof(T);
+}
+
+template <typename T>
+T getLE(const char*& p)
+{
+    T v = qFromLittleEndian<T>(p);
+    p += sizeof(T);
+    return v;
+}
+
+// Quantize [-1,1] to the signed integer range, rounding min down and max up
+// so stored peaks never look quieter than the audio. Values within float
+// error of a step stay on it, so re-encoding decoded peaks is lossless.
+template <typename T>
+void quantizeLevel(const WaveformLevel& level, char* dst)
+{
+    const float scale = static_cast<float>(std::numeric_limits<T>::max());
+    constexpr float kSlack = 5e-7f;   // a few float ulps at full scale
+    const int n = level.min.size();
+    for (int i = 0; i < n; ++i) {
+        const float lo = (std::clamp(level.min[i], -1.0f, 1.0f) + kSlack) * scale;
+        const float hi = (std::clamp(level.max[i], -1.0f, 1.0f) - kSlack) * scale;
+        qToLittleEndian<T>(static_cast<T>(std::floor(lo)), dst);
+        dst += sizeof(T);
+        qToLittleEndian<T>(static_cast<T>(std::ceil(hi)), dst);
+        dst += sizeof(T);
+    }
+}
+
+template <typename T>
+void dequantizeLevel(const char* src, int buckets, WaveformLevel* level)
+{
+    const float inv = 1.0f / static_cast<float>(std::numeric_limits<T>::max());
+    level->min.resize(buckets);
+    level->max.resize(buckets);
+    for (int i = 0; i < buckets; ++i) {
+        level->min[i] = static_cast<float>(qFromLittleEndian<T>(src)) * inv;
+        src += sizeof(T);
+        level->max[i] = static_cast<float>(qFromLittleEndian<T>(src)) * inv;
+        src += sizeof(T);
+    }
+}
+
+} // namespace
+
+QByteArray WaveformPeakFile::encode(const WaveformPeaks& peaks, qint64 sourceSize, qint64 sourceMtimeMs, Precision precision)
+{
+    if (!peaks.isValid()) return QByteArray();
+    const int bytesPerValue = precision == Precision::Int8 ? 1 : 2;
+
+    qint64 total = kHeaderBytes + static_cast<qint64>(peaks.levels.size()) * 8;
+    for (const WaveformLevel& l : peaks.levels) total += static_cast<qint64>(l.min.size()) * 2 * bytesPerValue;
+
+    QByteArray out(static_cast<int>(total), Qt::Uninitialized);
+    char* p = out.data();
+    std::memcpy(p, kMagic, 4);
+    p += 4;
+    putLE<quint16>(p, kVersion);
+    *p++ = static_cast<char>(precision == Precision::Int8 ? 8 : 16);
+    *p++ = 0;
+    putLE<quint32>(p, static_cast<quint32>(peaks.sampleRate));
+    putLE<quint32>(p, static_cast<quint32>(peaks.channels));
+    putLE<quint64>(p, static_cast<quint64>(peaks.totalFrames));
+    putLE<quint32>(p, static_cast<quint32>(peaks.levels.size()));
+    putLE<quint32>(p, 0);
+    putLE<qint64>(p, sourceSize);
+    putLE<qint64>(p, sourceMtimeMs);
+
+    for (const WaveformLevel& l : peaks.levels) {
+        putLE<quint32>(p, static_cast<quint32>(l.samplesPerBucket));
+        putLE<quint32>(p, static_cast<quint32>(l.min.size()));
+    }
+    for (const WaveformLevel& l : peaks.levels) {
+        if (bytesPerValue == 1) quantizeLevel<qint8>(l, p);
+        else quantizeLevel<qint16>(l, p);
+        p += static_cast<qint64>(l.min.size()) * 2 * bytesPerValue;
+    }
+    return out;
+}
+
+bool WaveformPeakFile::parse(const char* data, qint64 size, Layout* out)
+{
+    if (!data || size < kHeaderBytes) return false;
+    const char* p = data;
+    if (std::memcmp(p, kMagic, 4) != 0) return false;
+    p += 4;
+    if (getLE<quint16>(p) != kVersion) return false;
+    const int bits = static_cast<unsigned char>(*p++);
+    ++p;
+    if (bits != 8 && bits != 16) return false;
+    const int bytesPerValue = bits / 8;
+
+    Layout layout;
+    layout.sampleBits = bits;
+    layout.sampleRate = static_cast<int>(getLE<quint32>(p));
+    layout.channels = static_cast<int>(getLE<quint32>(p));
+    layout.totalFrames = static_cast<qint64>(getLE<quint64>(p));
+    const quint32 levelCount = getLE<quint32>(p);
+    getLE<quint32>(p);
+    layout.sourceSize = getLE<qint64>(p);
+    layout.sourceMtimeMs = getLE<qint64>(p);
+    if (levelCount == 0 || levelCount > 64) return false;
+
+    // Validate the level table against the payload size before touching data
+    const qint64 tableEnd = kHeaderBytes + static_cast<qint64>(levelCount) * 8;
+    if (size < tableEnd) return false;
+    qint64 offset = tableEnd;
+    layout.levels.resize(static_cast<int>(levelCount));
+    for (Layout::Level& l : layout.levels) {
+        const quint32 spb = getLE<quint32>(p);
+        const quint32 buckets = getLE<quint32>(p);
+        if (spb > static_cast<quint32>(std::numeric_limits<int>::max())
+            || buckets > static_cast<quint32>(std::numeric_limits<int>::max())) {
+            return false;
+        }
+        l.samplesPerBucket = static_cast<int>(spb);
+        l.buckets = static_cast<int>(buckets);
+        l.offset = offset;
+        offset += static_cast<qint64>(buckets) * 2 * bytesPerValue;
+    }
+    if (offset != size) return false;
+
+    if (out) *out = std::move(layout);
+    return true;
+}
+
+bool WaveformPeakFile::decode(const QByteArray& data, WaveformPeaks* out, qint64* sourceSize, qint64* sourceMtimeMs)
+{
+    Layout layout;
+    if (!parse(data.constData(), data.size(), &layout)) return false;
+
+    WaveformPeaks peaks;
+    peaks.sampleRate = layout.sampleRate;
+    peaks.channels = layout.channels;
+    peaks.totalFrames = layout.totalFrames;
+    peaks.levels.resize(layout.levels.size());
+    for (int i = 0; i < layout.levels.size(); ++i) {
+        const Layout::Level& src = layout.levels[i];
+        WaveformLevel& l = peaks.levels[i];
+        l.samplesPerBucket = src.samplesPerBucket;
+        const char* p = data.constData() + src.offset;
+        if (layout.sampleBits == 8) dequantizeLevel<qint8>(p, src.buckets, &l);
+        else dequantizeLevel<qint16>(p, src.buckets, &l);
+    }
+    if (!peaks.isValid()) return false;
+
+    if (out) *out = std::move(peaks);
+    if (sourceSize) *sourceSize = layout.sourceSize;
+    if (sourceMtimeMs) *sourceMtimeMs = layout.sourceMtimeMs;
+    return true;
+}
+
+bool WaveformPeakFile::write(const QString& filePath, const WaveformPeaks& peaks, qint64 sourceSize, qint64 sourceMtimeMs, Precision precision)
+{
+    const QByteArray bytes = encode(peaks, sourceSize, sourceMtimeMs, precision);
+    if (bytes.isEmpty()) return false;
+    const QString tmp = filePath + ".tmp";
+    QFile f(tmp);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    if (f.write(bytes) != bytes.size()) {
+        f.close();
+        QFile::remove(tmp);
+        return false;
+    }
+    f.close();
+    QFile::remove(filePath);
+    if (!QFile::rename(tmp, filePath)) {
+        QFile::remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool WaveformPeakFile::read(const QString& filePath, WaveformPeaks* out, qint64* sourceSize, qint64* sourceMtimeMs)
+{
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const QByteArray bytes = f.readAll();
+    f.close();
+    return decode(bytes, out, sourceSize, sourceMtimeMs);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "WaveformPyramid.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Resolution-independent waveform data: the full min/max pyramid of a file
+struct WaveformPeaks {
+    int sampleRate = 0;
+    int channels = 0;
+    qint64 totalFrames = 0;
+    QVector<WaveformLevel> levels;   // level 0 is the finest
+
+    bool isValid() const { return sampleRate > 0 && totalFrames > 0 && !levels.isEmpty(); }
+    double duration() const { return sampleRate > 0 ? static_cast<double>(totalFrames) / sampleRate : 0.0; }
+};
+
+/**
+ * Compact binary peak file ("LSBP"): a fixed little-endian header, a level
+ * table and the quantized min/max pairs of every pyramid level. Any widget
+ * width, DPR or zoom can be rendered from it with WaveformPyramid::levelForWidth()
+ * without decoding audio or going through an image codec.
+ *
+ * Layout (all little-endian):
+ *   header   magic "LSBP", u16 version, u8 sample bits (8|16), u8 reserved,
+ *            u32 sampleRate, u32 channels, u64 totalFrames, u32 levelCount,
+ *            u32 reserved, i64 sourceSize, i64 sourceMtimeMs
+ *   levels   levelCount x { u32 samplesPerBucket, u32 bucketCount }
+ *   data     per level, bucketCount x { min, max } as int8 or int16
+ * sourceMtimeMs is the validation stamp chosen by the cache; for content
+ * keys it holds the content fingerprint instead of the mtime.
+ */
+class WaveformPeakFile {
+public:
+    enum class Precision { Int8 = 8, Int16 = 16 };
+
+    static constexpr quint16 kVersion = 1;
+    static constexpr int kHeaderBytes = 48;
+
+    static QByteArray encode(const WaveformPeaks& peaks, qint64 sourceSize, qint64 sourceMtimeMs,
+                             Precision precision = Precision::Int16);
+    // Header and level table of an encoded file; `offset` is the byte
+    // offset of a level's first {min, max} pair from the start of the data
+    struct Layout {
+        struct Level {
+            int samplesPerBucket = 0;
+            int buckets = 0;
+            qint64 offset = 0;
+        };
+        int sampleBits = 16;
+        int sampleRate = 0;
+        int channels = 0;
+        qint64 totalFrames = 0;
+        qint64 sourceSize = 0;
+        qint64 sourceMtimeMs = 0;
+        QVector<Level> levels;
+    };
+    // Validates the header and that the level table matches `size` exactly
+    static bool parse(const char* data, qint64 size, Layout* out);
+
+    // Returns false for truncated, corrupt or unknown-version data
+    static bool decode(const QByteArray& data, WaveformPeaks* out,
+                       qint64* sourceSize = nullptr, qint64* sourceMtimeMs = nullptr);
+
+    // File helpers; write() goes through a temp file and rename
+    static bool write(const QString& filePath, const WaveformPeaks& peaks, qint64 sourceSize, qint64 sourceMtimeMs,
+                      Precision precision = Precision::Int16);
+    static bool read(const QString& filePath, WaveformPeaks* out,
+                     qint64* sourceSize = nullptr, qint64* sourceMtimeMs = nullptr);
+};
@@ -0,0 +1,134 @@
+#include "WaveformPixmapCache.h"
+#include "ContentFingerprint.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+
+WaveformPixmapCache& WaveformPixmapCache::instance()
+{
+    static WaveformPixmapCache cache;
+    return cache;
+}
+
+QString WaveformPixmapCache::identityOf(const QString& path, qint64 size, qint64 mtimeMs)
+{
+    if (path.isEmpty()) return QString();
+    QString identity;
+    if (ContentFingerprint::enabled()) {
+        const quint64 fp = ContentFingerprint::instance().of(path);
+        if (fp != 0) identity = QStringLiteral("content:") + ContentFingerprint::toHex(fp);
+    }
+    if (identity.isEmpty()) identity = QStringLiteral("%1|%2|%3").arg(path).arg(size).arg(mtimeMs);
+
+    WaveformPixmapCache& cache = instance();
+    QMutexLocker l(&cache.m_lock);
+    if (cache.m_identities.size() >= kMaxIdentities) cache.m_identities.clear();
+    cache.m_identities.insert(path, identity);
+    return identity;
+}
+
+QString WaveformPixmapCache::knownIdentity(const QString& path) const
+{
+    QMutexLocker l(&m_lock);
+    return m_identities.value(path);
+}
+
+QString WaveformPixmapCache::keyFor(const QString& identity, const QSize& pixelSize, qreal dpr, const QColor& backdrop)
+{
+    const QString bg = backdrop.isValid() ? QString::number(backdrop.rgba(), 16) : QStringLiteral("none");
+    return QStringLiteral("%1|%2x%3|%4|%5").arg(identity).arg(pixelSize.width()).arg(pixelSize.height()).arg(dpr).arg(bg);
+}
+
+bool WaveformPixmapCache::lookup(const QString& key, QPixmap* out)
+{
+    QMutexLocker l(&m_lock);
+    auto it = m_items.find(key);
+    if (it == m_items.end()) {
+        ++m_misses;
+        return false;
+    }
+    ++m_hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->lru);
+    if (out) *out = it->pixmap;
+    return true;
+}
+
+void WaveformPixmapCache::insert(const QString& key, const QPixmap& pixmap)
+{
+    if (pixmap.isNull()) return;
+    QMutexLocker l(&m_lock);
+    auto existing = m_items.find(key);
+    if (existing != m_items.end()) removeLocked(existing);
+
+    Item item;
+    item.pixmap = pixmap;
+    item.bytes = static_cast<qint64>(pixmap.width()) * pixmap.height() * std::max(pixmap.depth(), 8) / 8;
+    m_lru.push_front(key);
+    item.lru = m_lru.begin();
+    m_bytes += item.bytes;
+    m_items.insert(key, item);
+    evictLocked();
+}
+
+void WaveformPixmapCache::clear()
+{
+    QMutexLocker l(&m_lock);
+    m_items.clear();
+    m_lru.clear();
+    m_identities.clear();
+    m_bytes = 0;
+}
+
+void WaveformPixmapCache::setCapacityBytes(qint64 bytes)
+{
+    QMutexLocker l(&m_lock);
+    m_capacity = bytes < 0 ? 0 : bytes;
+    evictLocked();
+}
+
+qint64 WaveformPixmapCache::capacityBytes() const
+{
+    QMutexLocker l(&m_lock);
+    return m_capacity;
+}
+
+WaveformPixmapCache::Stats WaveformPixmapCache::stats() const
+{
+    QMutexLocker l(&m_lock);
+    Stats s;
+    s.hits = m_hits;
+    s.misses = m_misses;
+    s.evictions = m_evictions;
+    s.entries = m_items.size();
+    s.bytes = m_bytes;
+    return s;
+}
+
+void WaveformPixmapCache::resetStats()
+{
+    QMutexLocker l(&m_lock);
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+}
+
+void WaveformPixmapCache::evictLocked()
+{
+    // Containers keep their own reference, so evicting only stops sharing
+    while (m_bytes > m_capacity && !m_lru.empty()) {
+        auto it = m_items.find(m_lru.back());
+        if (it == m_items.end()) {
+            m_lru.pop_back();
+            continue;
+        }
+        removeLocked(it);
+        ++m_evictions;
+    }
+}
+
+void WaveformPixmapCache::removeLocked(QHash<QString, Item>::iterator it)
+{
+    m_bytes -= it->bytes;
+    m_lru.erase(it->lru);
+    m_items.erase(it);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QColor>
+#include <QHash>
+#include <QMutex>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+#include <list>
+
+/**
+ * WaveformPixmapCache: process-wide cache of rendered waveform pixmaps.
+ *
+ * Every SoundContainer used to render and keep its own pixmap, so a file
+ * placed in several slots or tabs was rendered and held once per slot. The
+ * cache hands out implicitly shared QPixmaps keyed by file identity, device
+ * pixel size, DPR and backdrop colour; containers showing the same file at
+ * the same size share one copy, and a copied slot shows its waveform without
+ * rendering. Least recently used entries are evicted once the total exceeds
+ * the capacity. Pixmaps are GUI-thread objects; call it from the GUI thread.
+ */
+class WaveformPixmapCache {
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        int entries = 0;
+        qint64 bytes = 0;
+    };
+
+    static WaveformPixmapCache& instance();
+
+    // Identity of a file version: its content fingerprint when content keys
+    // are enabled, otherwise path, size and mtime. May stat and read the
+    // file: call it off the GUI thread.
+    static QString identityOf(const QString& path, qint64 size, qint64 mtimeMs);
+    // The identity last computed for `path`, without touching the file; empty
+    // if there is none. It may be stale until identityOf() runs again.
+    QString knownIdentity(const QString& path) const;
+    // An invalid backdrop means the bare waveform
+    static QString keyFor(const QString& identity, const QSize& pixelSize, qreal dpr, const QColor& backdrop);
+
+    bool lookup(const QString& key, QPixmap* out);
+    void insert(const QString& key, const QPixmap& pixmap);
+    void clear();
+
+    void setCapacityBytes(qint64 bytes);        // default 64 MB
+    qint64 capacityBytes() const;
+    Stats stats() const;
+    void resetStats();
+
+private:
+    WaveformPixmapCache() = default;
+    Q_DISABLE_COPY(WaveformPixmapCache)
+
+    static constexpr int kMaxIdentities = 16384;
+
+    struct Item {
+        QPixmap pixmap;
+        qint64 bytes = 0;
+        std::list<QString>::iterator lru;
+    };
+
+    void evictLocked();
+    void removeLocked(QHash<QString, Item>::iterator it);
+
+    mutable QMutex m_lock;
+    QHash<QString, Item> m_items;
+    std::list<QString> m_lru;                   // front = most recently used
+    QHash<QString, QString> m_identities;       // path -> last identityOf()
+    qint64 m_bytes = 0;
+    qint64 m_capacity = 64LL * 1024 * 1024;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+    quint64 m_evictions = 0;
+};
@@ -1,79 +1,187 @@
 #include "WaveformPyramid.h"
+#include "WaveformKernels.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
 
-QVector<WaveformLevel> WaveformPyramid::build(const QVector<float>& interleavedSamples, int channels, int baseBucket) {
+namespace {
+
+int resolveThreads(int threads, qint64 frames)
+{
+    if (threads > 0) return threads;
+    if (frames < WaveformPyramid::kParallelMinFrames) return 1;
+    // Leave a core for the GUI and audio threads
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+}
+
+// Run task(0..tasks-1) on up to `threads` threads, the caller included.
+// Tasks write disjoint outputs, so the order they run in does not matter.
+template <typename Task>
+void parallelFor(int tasks, int threads, const Task& task)
+{
+    threads = std::min(threads, tasks);
+    if (threads <= 1) {
+        for (int i = 0; i < tasks; ++i) task(i);
+        return;
+    }
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int i = next++; i < tasks; i = next++) task(i);
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(static_cast<size_t>(threads - 1));
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+}
+
+// Bucket j of the next level from buckets 2j and 2j+1 of `prev`; an odd
+// last bucket is carried forward
+inline void reducePairs(const float* prevMin, const float* prevMax, qint64 prevBuckets, float* min, float* max,
+                        qint64 begin, qint64 end)
+{
+    for (qint64 j = begin; j < end; ++j) {
+        const qint64 i = 2 * j;
+        if (i + 1 < prevBuckets) {
+            min[j] = std::min(prevMin[i], prevMin[i + 1]);
+            max[j] = std::max(prevMax[i], prevMax[i + 1]);
+        } else {
+            min[j] = prevMin[i];
+            max[j] = prevMax[i];
+        }
+    }
+}
+
+} // namespace
+
+QVector<WaveformLevel> WaveformPyramid::build(const QVector<float>& interleavedSamples, int channels, int baseBucket,
+                                              int threads) {
     QVector<WaveformLevel> levels;
     if (channels <= 0 || baseBucket <= 0) return levels;
 
-    const int totalSamples = interleavedSamples.size();
-    const int totalFrames = totalSamples / channels;
+    const qint64 totalSamples = interleavedSamples.size();
+    const qint64 totalFrames = totalSamples / channels;
     if (totalFrames <= 0) return levels;
+    threads = resolveThreads(threads, totalFrames);
 
     // Level 0: compute min/max per bucket of baseBucket frames
     WaveformLevel level0;
-    int framesPerBucket = baseBucket;
-    level0.samplesPerBucket = framesPerBucket;
-    int numBuckets = (totalFrames + framesPerBucket - 1) / framesPerBucket;
-    level0.min.reserve(numBuckets);
-    level0.max.reserve(numBuckets);
-
-    for (int b = 0; b < numBuckets; ++b) {
-        int frameStart = b * framesPerBucket;
-        int frameEnd = std::min(frameStart + framesPerBucket, totalFrames);
-        float bucketMin = std::numeric_limits<float>::infinity();
-        float bucketMax = -std::numeric_limits<float>::infinity();
-
-        for (int f = frameStart; f < frameEnd; ++f) {
-            int baseIdx = f * channels;
-            for (int c = 0; c < channels; ++c) {
-                float v = interleavedSamples[baseIdx + c];
-                if (v < bucketMin) bucketMin = v;
-                if (v > bucketMax) bucketMax = v;
-            }
-        }
+    const qint64 framesPerBucket = baseBucket;
+    level0.samplesPerBucket = baseBucket;
+    const qint64 numBuckets = (totalFrames + framesPerBucket - 1) / framesPerBucket;
+    level0.min.resize(numBuckets);
+    level0.max.resize(numBuckets);
 
-        // If bucket had no samples (shouldn't happen) fallback to 0
-        if (bucketMin == std::numeric_limits<float>::infinity()) bucketMin = 0.0f;
-        if (bucketMax == -std::numeric_limits<float>::infinity()) bucketMax = 0.0f;
+    // A few chunks per thread, each a run of whole buckets
+    const int chunks = threads > 1 ? static_cast<int>(std::min<qint64>(numBuckets, threads * 4)) : 1;
+    const qint64 bucketsPerChunk = (numBuckets + chunks - 1) / chunks;
+    const float* samples = interleavedSamples.constData();
+    float* outMin = level0.min.data();
+    float* outMax = level0.max.data();
+    parallelFor(chunks, threads, [&](int c) {
+        const qint64 b0 = c * bucketsPerChunk;
+        const qint64 b1 = std::min(numBuckets, b0 + bucketsPerChunk);
+        if (b0 >= b1) return;
+        const qint64 f0 = b0 * framesPerBucket;
+        const qint64 frames = std::min(totalFrames - f0, (b1 - b0) * framesPerBucket);
+        WaveformKernels::bucketMinMax(samples + f0 * channels, static_cast<size_t>(frames), channels,
+                                      static_cast<size_t>(framesPerBucket), outMin + b0, outMax + b0,
+                                      static_cast<size_t>(b1 - b0));
+    });
 
-        level0.min.push_back(bucketMin);
-        level0.max.push_back(bucketMax);
-    }
+    return buildFromBase(std::move(level0), threads);
+}
 
-    levels.push_back(std::move(level0));
+QVector<WaveformLevel> WaveformPyramid::buildFromBase(WaveformLevel level0, int threads) {
+    QVector<WaveformLevel> levels;
+    if (level0.min.isEmpty() || level0.samplesPerBucket <= 0) return levels;
+    threads = resolveThreads(threads, static_cast<qint64>(level0.min.size()) * level0.samplesPerBucket);
 
-    // Build coarser levels by combining pairs. Each coarser level doubles the samplesPerBucket.
-    while (levels.back().min.size() > 1) {
-        const WaveformLevel& prev = levels.back();
+    // Size every level up front: each coarser level halves the bucket count
+    // of the previous one and doubles samplesPerBucket
+    const qint64 baseBuckets = level0.min.size();
+    levels.push_back(std::move(level0));
+    for (qint64 n = baseBuckets; n > 1;) {
+        n = (n + 1) / 2;
         WaveformLevel next;
-        next.samplesPerBucket = prev.samplesPerBucket * 2;
-        int prevBuckets = prev.min.size();
-        int nextBuckets = (prevBuckets + 1) / 2;
-        next.min.reserve(nextBuckets);
-        next.max.reserve(nextBuckets);
-
-        for (int i = 0; i < prevBuckets; i += 2) {
-            float a_min = prev.min[i];
-            float a_max = prev.max[i];
-            if (i + 1 < prevBuckets) {
-                float b_min = prev.min[i+1];
-                float b_max = prev.max[i+1];
-                next.min.push_back(std::min(a_min, b_min));
-                next.max.push_back(std::max(a_max, b_max));
-            } else {
-                // odd last bucket: carry forward
-                next.min.push_back(a_min);
-                next.max.push_back(a_max);
-            }
+        next.samplesPerBucket = levels.back().samplesPerBucket * 2;
+        next.min.resize(n);
+        next.max.resize(n);
+        levels.push_back(std::move(next));
+    }
+    const int levelCount = levels.size();
+
+    // Raw pointers taken here, on one thread, before any worker writes
+    std::vector<float*> mins(levelCount);
+    std::vector<float*> maxs(levelCount);
+    std::vector<qint64> sizes(levelCount);
+    for (int k = 0; k < levelCount; ++k) {
+        mins[k] = levels[k].min.data();
+        maxs[k] = levels[k].max.data();
+        sizes[k] = levels[k].min.size();
+    }
+
+    // Levels 1..tileDepth per tile: the tile's level-0 buckets feed exactly
+    // the tile's buckets at every level it spans, so tiles are independent
+    int tileDepth = 0;
+    while ((1 << (tileDepth + 1)) <= kTileBuckets) ++tileDepth;
+    tileDepth = std::min(tileDepth, levelCount - 1);
+    const int tiles = static_cast<int>((baseBuckets + kTileBuckets - 1) / kTileBuckets);
+    parallelFor(tiles, threads, [&](int t) {
+        for (int k = 1; k <= tileDepth; ++k) {
+            const qint64 span = kTileBuckets >> k;
+            const qint64 begin = t * span;
+            const qint64 end = std::min(sizes[k], begin + span);
+            reducePairs(mins[k - 1], maxs[k - 1], sizes[k - 1], mins[k], maxs[k], begin, end);
         }
+    });
 
-        levels.push_back(std::move(next));
+    // The remaining levels have a few buckets per tile at most
+    for (int k = tileDepth + 1; k < levelCount; ++k) {
+        reducePairs(mins[k - 1], maxs[k - 1], sizes[k - 1], mins[k], maxs[k], 0, sizes[k]);
     }
 
     return levels;
 }
 
+WaveformLevel WaveformPyramid::levelForWidth(const QVector<WaveformLevel>& levels, qint64 totalFrames, int pixelCount) {
+    WaveformLevel out;
+    if (levels.isEmpty() || totalFrames <= 0 || pixelCount <= 0) return out;
+
+    // Coarsest level whose buckets are no wider than one pixel, so every
+    // pixel aggregates one or more whole buckets
+    const double framesPerPixel = static_cast<double>(totalFrames) / static_cast<double>(pixelCount);
+    int li = 0;
+    while (li + 1 < levels.size() && levels[li + 1].samplesPerBucket <= framesPerPixel) ++li;
+    const WaveformLevel& src = levels[li];
+    const int buckets = src.min.size();
+    const qint64 spb = qMax(1, src.samplesPerBucket);
+    if (buckets <= 0) return out;
+
+    out.samplesPerBucket = static_cast<int>(std::ceil(framesPerPixel));
+    out.min.resize(pixelCount);
+    out.max.resize(pixelCount);
+    for (int x = 0; x < pixelCount; ++x) {
+        const qint64 f0 = totalFrames * x / pixelCount;
+        const qint64 f1 = totalFrames * (x + 1) / pixelCount;
+        int b0 = static_cast<int>(std::min<qint64>(f0 / spb, buckets - 1));
+        int b1 = static_cast<int>(std::min<qint64>((f1 + spb - 1) / spb, buckets));
+        if (b1 <= b0) b1 = b0 + 1;
+        float vmin = src.min[b0];
+        float vmax = src.max[b0];
+        for (int b = b0 + 1; b < b1; ++b) {
+            vmin = std::min(vmin, src.min[b]);
+            vmax = std::max(vmax, src.max[b]);
+        }
+        out.min[x] = vmin;
+        out.max[x] = vmax;
+    }
+    return out;
+}
+
 int WaveformPyramid::selectLevelForPixelWidth(int totalFrames, int baseBucket, int desiredPixelWidth, int maxLevels) {
     if (desiredPixelWidth <= 0) return 0;
     if (baseBucket <= 0) baseBucket = 1;
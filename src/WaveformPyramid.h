@@ -13,7 +13,31 @@ class WaveformPyramid {
 public:
     // Build pyramid from interleaved samples. `channels` is number of channels.
     // `baseBucket` is samples-per-bucket at level 0 (per channel frames).
-    static QVector<WaveformLevel> build(const QVector<float>& interleavedSamples, int channels, int baseBucket = 256);
+    // `threads` is how many threads build it, the caller's included; 0 uses
+    // every core but one for long inputs. Code already running on a worker
+    // pool passes 1 so it stays within the pool's thread cap. The result is
+    // the same for any thread count.
+    static QVector<WaveformLevel> build(const QVector<float>& interleavedSamples, int channels, int baseBucket = 256,
+                                        int threads = 1);
+
+    // Build the coarser levels on top of an already computed level 0 (each
+    // level halves the bucket count of the previous one). `threads` as for
+    // build().
+    static QVector<WaveformLevel> buildFromBase(WaveformLevel level0, int threads = 1);
+
+    // Level 0 is split into chunks of whole buckets, so chunks never share a
+    // bucket. Coarser levels are built per tile of kTileBuckets level-0
+    // buckets, each tile reduced through every level it spans while it is
+    // still in cache.
+    static constexpr int kTileBuckets = 1 << 14;
+    // With threads = 0, inputs shorter than this many frames are built on the
+    // calling thread
+    static constexpr qint64 kParallelMinFrames = qint64(1) << 22;
+
+    // Produce exactly `pixelCount` min/max columns covering `totalFrames`,
+    // aggregated from the finest level that is not finer than one pixel.
+    // Used to render any width/zoom straight from stored peaks.
+    static WaveformLevel levelForWidth(const QVector<WaveformLevel>& levels, qint64 totalFrames, int pixelCount);
 
     // Choose pyramid level index for desired pixel width given total frames and baseBucket.
     // Returns 0..levels-1 (clamped).
@@ -1,10 +1,36 @@
 #include "WaveformRenderer.h"
-#include <QPainter>
-#include <QColor>
+#include "WaveformKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 namespace Waveform {
 
-QImage renderLevelToImage(const WaveformLevel& level, int pixelWidth, float dpr, int heightCss) {
+namespace {
+
+// Waveform colour: black at alpha 200, premultiplied (only alpha is set)
+constexpr uint32_t kForegroundAlpha = 200;
+// Faint centre line: grey 128 at alpha 60, premultiplied
+constexpr uint32_t kMidAlpha = 60;
+constexpr uint32_t kMidPremultiplied = (128 * kMidAlpha + 127) / 255;
+
+inline uint32_t foregroundPixel(double coverage)
+{
+    const uint32_t alpha = static_cast<uint32_t>(std::lround(qBound(0.0, coverage, 1.0) * kForegroundAlpha));
+    return alpha << 24;
+}
+
+// Source-over of the centre line onto a (black) waveform pixel
+inline uint32_t blendMid(uint32_t dst)
+{
+    const uint32_t alpha = kMidAlpha + ((dst >> 24) * (255 - kMidAlpha) + 127) / 255;
+    return (alpha << 24) | (kMidPremultiplied << 16) | (kMidPremultiplied << 8) | kMidPremultiplied;
+}
+
+} // namespace
+
+QImage renderLevelToImage(const WaveformLevel& level, int pixelWidth, float dpr, int heightCss, bool antialias) {
     if (pixelWidth <= 0) pixelWidth = 1;
     if (dpr <= 0.0f) dpr = 1.0f;
     if (heightCss <= 0) heightCss = 40;
@@ -12,48 +38,68 @@ QImage renderLevelToImage(const WaveformLevel& level, int pixelWidth, float dpr,
     const int width = static_cast<int>(std::ceil(pixelWidth * dpr));
     const int height = static_cast<int>(std::ceil(heightCss * dpr));
 
-    QImage img(width, height, QImage::Format_ARGB32);
+    QImage img(width, height, QImage::Format_ARGB32_Premultiplied);
     img.setDevicePixelRatio(dpr);
-    img.fill(Qt::transparent);
 
-    QPainter p(&img);
-    p.setRenderHint(QPainter::Antialiasing, false);
+    // Column spans: rows top..bottom (inclusive), edge rows carrying coverage
+    std::vector<int32_t> top(width);
+    std::vector<int32_t> bottom(width);
+    std::vector<uint32_t> topPx(width);
+    std::vector<uint32_t> bottomPx(width);
+    const uint32_t fillPx = foregroundPixel(1.0);
 
-    QColor fg(0,0,0,200);
-    QColor mid(128,128,128,60);
-
-    // draw background midline
-    p.fillRect(0, 0, width, height, Qt::transparent);
-
-    const int buckets = qMax(1, level.min.size());
-
-    // Map bucket index to pixel x. We'll sample per pixel by scaling buckets->width.
+    const qint64 buckets = std::min(level.min.size(), level.max.size());
+    const double scale = height - 1;
     for (int x = 0; x < width; ++x) {
-        // find corresponding bucket range (fractional)
-        double bucketPos = (static_cast<double>(x) / static_cast<double>(width)) * static_cast<double>(buckets);
-        int idx = qBound(0, static_cast<int>(std::floor(bucketPos)), buckets - 1);
-
-        float vmin = level.min.isEmpty() ? 0.0f : level.min[idx];
-        float vmax = level.max.isEmpty() ? 0.0f : level.max[idx];
-
-        // values expected in [-1..1] but be defensive
-        double top = (1.0 - ((vmax + 1.0) / 2.0)) * (height - 1);
-        double bottom = (1.0 - ((vmin + 1.0) / 2.0)) * (height - 1);
-
-        int itop = qBound(0, static_cast<int>(std::round(top)), height - 1);
-        int ibottom = qBound(0, static_cast<int>(std::round(bottom)), height - 1);
+        // Every bucket under the column, so no peak falls between columns
+        float vmin = 0.0f;
+        float vmax = 0.0f;
+        if (buckets > 0) {
+            const qint64 b0 = std::min(buckets - 1, x * buckets / width);
+            const qint64 b1 = std::max(b0 + 1, std::min(buckets, (x + 1) * buckets / width));
+            const size_t n = static_cast<size_t>(b1 - b0);
+            vmin = std::numeric_limits<float>::infinity();
+            vmax = -std::numeric_limits<float>::infinity();
+            float ignored = 0.0f;
+            WaveformKernels::minMax(level.min.constData() + b0, n, 1, &vmin, &ignored);
+            WaveformKernels::minMax(level.max.constData() + b0, n, 1, &ignored, &vmax);
+        }
+        // Values are expected in [-1..1] but be defensive
+        vmin = qBound(-1.0f, vmin, 1.0f);
+        vmax = qBound(-1.0f, vmax, 1.0f);
+        if (vmin > vmax) std::swap(vmin, vmax);
+
+        const double yTop = (1.0 - ((vmax + 1.0) / 2.0)) * scale;
+        const double yBottom = (1.0 - ((vmin + 1.0) / 2.0)) * scale;
+        if (!antialias) {
+            top[x] = static_cast<int32_t>(std::lround(yTop));
+            bottom[x] = static_cast<int32_t>(std::lround(yBottom));
+            topPx[x] = fillPx;
+            bottomPx[x] = fillPx;
+            continue;
+        }
+        // Antialiased: the column covers [yTop, yBottom + 1) in row units,
+        // so the rows the aliased path fills are those at least half covered
+        const double end = yBottom + 1.0;
+        const int32_t t = static_cast<int32_t>(std::floor(yTop));
+        const int32_t b = std::max(t, static_cast<int32_t>(std::ceil(end)) - 1);
+        top[x] = t;
+        bottom[x] = std::min(b, height - 1);
+        topPx[x] = foregroundPixel(std::min(end, t + 1.0) - yTop);
+        bottomPx[x] = foregroundPixel(end - std::max(yTop, static_cast<double>(b)));
+    }
 
-        // draw vertical line for this x from itop to ibottom
-        p.setPen(fg);
-        p.drawLine(x, itop, x, ibottom);
+    // Row by row, so every write is sequential in the scanline
+    for (int y = 0; y < height; ++y) {
+        uint32_t* line = reinterpret_cast<uint32_t*>(img.scanLine(y));
+        WaveformKernels::spanRow(y, top.data(), bottom.data(), topPx.data(), bottomPx.data(), fillPx, line,
+                                 static_cast<size_t>(width));
     }
 
-    // draw center line faint
-    p.setPen(mid);
-    int centerY = height / 2;
-    p.drawLine(0, centerY, width - 1, centerY);
+    // Faint centre line over the waveform
+    uint32_t* centre = reinterpret_cast<uint32_t*>(img.scanLine(height / 2));
+    for (int x = 0; x < width; ++x) centre[x] = blendMid(centre[x]);
 
-    p.end();
     return img;
 }
 
@@ -9,5 +9,10 @@ namespace Waveform {
     // - pixelWidth: target width in CSS pixels
     // - dpr: device pixel ratio (e.g. 2.0 for retina)
     // - heightCss: height in CSS pixels
-    QImage renderLevelToImage(const WaveformLevel& level, int pixelWidth, float dpr = 1.0f, int heightCss = 40);
+    // - antialias: fractional coverage on the top and bottom edge of each column
+    // Each device pixel column shows the min/max of every bucket under it.
+    // The image is Format_ARGB32_Premultiplied, rasterized straight into its
+    // scanlines (no QPainter).
+    QImage renderLevelToImage(const WaveformLevel& level, int pixelWidth, float dpr = 1.0f, int heightCss = 40,
+                              bool antialias = false);
 }
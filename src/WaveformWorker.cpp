@@ -1,52 +1,174 @@
 #include "WaveformWorker.h"
-#include <QThreadPool>
-#include <QRunnable>
-#include <QMetaObject>
+#include "WaveformJobService.h"
+#include "WaveformKernels.h"
+#include "WaveformPixmapCache.h"
+#include <QDateTime>
 #include <QDebug>
+#include <QFileInfo>
 #include <QThread>
+#include <QElapsedTimer>
 #include "AudioFile.h"
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include <QMutexLocker>
-#include <sndfile.h>
 
-class WaveformRunnable : public QRunnable {
-public:
-    WaveformRunnable(const WaveformJob& j, WaveformWorker* w)
-        : job(j), worker(w) {
-        setAutoDelete(true);
+namespace {
+
+struct PreviewAccumulator;
+
+// Collects signed per-bucket min/max across all channels for level 0 of the
+// peak pyramid while the decoder streams frames
+struct PeakAccumulator {
+    WaveformLevel level;
+    int framesInBucket = 0;
+    float bmin = std::numeric_limits<float>::infinity();
+    float bmax = -std::numeric_limits<float>::infinity();
+
+    explicit PeakAccumulator(qint64 totalFrames)
+    {
+        level.samplesPerBucket = WaveformWorker::kPeakBaseBucket;
+        const int buckets = static_cast<int>((totalFrames + level.samplesPerBucket - 1) / level.samplesPerBucket);
+        level.min.reserve(buckets);
+        level.max.reserve(buckets);
     }
 
-    void run() override {
-        // Perform synchronous decode using the helper (supports cancellation)
-        WaveformResult res = WaveformWorker::decodeFile(job.path, job.pixelWidth, job.dpr, job.cancelToken);
-        if (job.cancelToken && job.cancelToken->loadRelaxed() != 0) {
-            QMetaObject::invokeMethod(worker, "notifyError",
-                                      Qt::QueuedConnection,
-                                      Q_ARG(WaveformJob, job),
-                                      Q_ARG(QString, QStringLiteral("cancelled")));
-            return;
-        }
+    qint64 framesUntilFlush() const { return level.samplesPerBucket - framesInBucket; }
 
-        // If decode produced no sample-rate we consider it an error
-        if (res.sampleRate == 0) {
-            QMetaObject::invokeMethod(worker, "notifyError",
-                                      Qt::QueuedConnection,
-                                      Q_ARG(WaveformJob, job),
-                                      Q_ARG(QString, QStringLiteral("decode-failed")));
-            return;
-        }
+    // Fold the min/max of `frames` frames that all belong to the current bucket
+    void addSpan(float spanMin, float spanMax, qint64 frames)
+    {
+        bmin = std::min(bmin, spanMin);
+        bmax = std::max(bmax, spanMax);
+        framesInBucket += static_cast<int>(frames);
+        if (framesInBucket == level.samplesPerBucket) flush();
+    }
 
-        QMetaObject::invokeMethod(worker, "notifyReady",
-                                  Qt::QueuedConnection,
-                                  Q_ARG(WaveformJob, job),
-                                  Q_ARG(WaveformResult, res));
+    void flush()
+    {
+        if (framesInBucket == 0) return;
+        level.min.push_back(bmin);
+        level.max.push_back(bmax);
+        framesInBucket = 0;
+        bmin = std::numeric_limits<float>::infinity();
+        bmax = -std::numeric_limits<float>::infinity();
     }
 
-private:
-    WaveformJob job;
-    WaveformWorker* worker;
+    // Snapshot for a partial result: the buckets so far, padded with silence
+    // to the expected length, plus the preview columns so far
+    WaveformResult partial(int sampleRate, int channels, qint64 expectedFrames,
+                           const PreviewAccumulator& preview) const;
+
+    WaveformPeaks finish(int sampleRate, int channels, qint64 totalFrames)
+    {
+        flush();
+        WaveformPeaks peaks;
+        peaks.sampleRate = sampleRate;
+        peaks.channels = channels;
+        peaks.totalFrames = totalFrames;
+        // On a WaveformJobService thread: stay within its decodeThreads cap
+        peaks.levels = WaveformPyramid::buildFromBase(std::move(level), 1);
+        return peaks;
+    }
 };
 
+// Collects the symmetric min/max preview columns of WaveformResult: each
+// column holds -/+ the largest absolute sample (any channel) in its bucket
+struct PreviewAccumulator {
+    WaveformResult& out;
+    int targetPixels;
+    qint64 samplesPerBucket;
+    qint64 framesSeen = 0;
+    float peak = 0.0f;
+
+    PreviewAccumulator(WaveformResult& result, int pixels, qint64 totalFrames)
+        : out(result)
+        , targetPixels(pixels)
+        , samplesPerBucket(qMax<qint64>(1, (totalFrames + pixels - 1) / pixels))
+    {
+        out.min.reserve(targetPixels);
+        out.max.reserve(targetPixels);
+    }
+
+    // Frames past the last column are not needed
+    bool full() const { return out.min.size() >= targetPixels; }
+    qint64 framesUntilFlush() const { return samplesPerBucket - framesSeen; }
+
+    void addSpan(float spanMin, float spanMax, qint64 frames)
+    {
+        peak = std::max({peak, spanMax, -spanMin});
+        framesSeen += frames;
+        if (framesSeen >= samplesPerBucket) push();
+    }
+
+    void push()
+    {
+        out.min.push_back(-peak);
+        out.max.push_back(peak);
+        framesSeen = 0;
+        peak = 0.0f;
+    }
+
+    void finish()
+    {
+        // Trailing partial bucket, then pad to the requested width
+        if (!full() && framesSeen > 0) push();
+        while (!full()) {
+            out.min.push_back(0.0f);
+            out.max.push_back(0.0f);
+        }
+    }
+};
+
+WaveformResult PeakAccumulator::partial(int sampleRate, int channels, qint64 expectedFrames,
+                                        const PreviewAccumulator& preview) const
+{
+    WaveformResult r;
+    r.sampleRate = sampleRate;
+    r.channels = channels;
+    r.duration = static_cast<double>(expectedFrames) / sampleRate;
+    r.min = preview.out.min;
+    r.max = preview.out.max;
+    r.min.resize(preview.targetPixels);
+    r.max.resize(preview.targetPixels);
+
+    WaveformLevel base;
+    base.samplesPerBucket = level.samplesPerBucket;
+    const int expectedBuckets = static_cast<int>((expectedFrames + base.samplesPerBucket - 1) / base.samplesPerBucket);
+    base.min = level.min;
+    base.max = level.max;
+    const int decodedBuckets = base.min.size();
+    if (expectedBuckets > decodedBuckets) {
+        base.min.resize(expectedBuckets);
+        base.max.resize(expectedBuckets);
+    }
+    r.peaks.sampleRate = sampleRate;
+    r.peaks.channels = channels;
+    r.peaks.totalFrames = expectedFrames;
+    r.peaks.levels = WaveformPyramid::buildFromBase(std::move(base), 1);
+    r.progress = expectedBuckets > 0 ? std::min(1.0, static_cast<double>(decodedBuckets) / expectedBuckets) : 0.0;
+    return r;
+}
+
+// Feed interleaved frames to both accumulators. Every run that stays inside
+// one bucket of each is reduced with a single WaveformKernels call.
+void accumulate(const float* samples, qint64 frames, int channels, PeakAccumulator& peaks, PreviewAccumulator& preview)
+{
+    qint64 f = 0;
+    while (f < frames) {
+        qint64 run = std::min(frames - f, peaks.framesUntilFlush());
+        if (!preview.full()) run = std::min(run, preview.framesUntilFlush());
+        float runMin = std::numeric_limits<float>::infinity();
+        float runMax = -std::numeric_limits<float>::infinity();
+        WaveformKernels::minMax(samples + f * channels, static_cast<size_t>(run), channels, &runMin, &runMax);
+        peaks.addSpan(runMin, runMax, run);
+        if (!preview.full()) preview.addSpan(runMin, runMax, run);
+        f += run;
+    }
+}
+
+} // namespace
+
 WaveformWorker::WaveformWorker(QObject* parent)
     : QObject(parent) {
     qRegisterMetaType<WaveformJob>("WaveformJob");
@@ -54,216 +176,195 @@ WaveformWorker::WaveformWorker(QObject* parent)
 }
 
 WaveformWorker::~WaveformWorker() {
-    // Wait for pool to finish briefly
-    QThreadPool::globalInstance()->waitForDone(500);
+    // Release our subscriptions so decodes nobody else waits for stop
+    WaveformJobService::instance().unsubscribeAll(this);
 }
 
-QUuid WaveformWorker::enqueueJob(const QString& path, int pixelWidth, qreal dpr) {
+QUuid WaveformWorker::enqueueJob(const QString& path, int pixelWidth, qreal dpr, WaveformPriority priority,
+                                 qint64 size, qint64 mtimeMs) {
     WaveformJob job;
     job.id = QUuid::createUuid();
     job.path = path;
     job.pixelWidth = pixelWidth;
     job.dpr = dpr;
-    job.cancelToken = QSharedPointer<QAtomicInteger<int>>::create(0);
-
-    {
-        QMutexLocker l(&m_tokenLock);
-        m_tokens.insert(job.id, job.cancelToken);
-    }
-
-    auto* r = new WaveformRunnable(job, this);
-    QThreadPool::globalInstance()->start(r);
-
+    job.size = size;
+    job.mtimeMs = mtimeMs;
+    // Identical jobs from other workers share one decode
+    WaveformJobService::instance().subscribe(this, job, priority);
     return job.id;
 }
 
+void WaveformWorker::setJobPriority(const QUuid& id, WaveformPriority priority) {
+    WaveformJobService::instance().setPriority(id, priority);
+}
+
 void WaveformWorker::cancelJob(const QUuid& id) {
-    QMutexLocker l(&m_tokenLock);
-    if (m_tokens.contains(id)) {
-        auto t = m_tokens.value(id);
-        if (!t.isNull()) t->storeRelaxed(1);
-        m_tokens.remove(id);
-    }
+    WaveformJobService::instance().unsubscribe(id);
 }
 
 void WaveformWorker::notifyReady(const WaveformJob& job, const WaveformResult& result) {
     emit waveformReady(job, result);
-    QMutexLocker l(&m_tokenLock);
-    m_tokens.remove(job.id);
+}
+
+void WaveformWorker::notifyPartial(const WaveformJob& job, const WaveformResult& partial) {
+    emit waveformPartial(job, partial);
 }
 
 void WaveformWorker::notifyError(const WaveformJob& job, const QString& err) {
     emit waveformError(job, err);
-    QMutexLocker l(&m_tokenLock);
-    m_tokens.remove(job.id);
 }
 
 WaveformResult WaveformWorker::decodeFile(const QString& path, int pixelWidth, qreal dpr,
-                                          QSharedPointer<QAtomicInteger<int>> cancelToken)
+                                          QSharedPointer<QAtomicInteger<int>> cancelToken,
+                                          const PartialCallback& onPartial)
 {
     WaveformResult out;
     if (path.isEmpty()) return out;
 
-    // Prefer streaming via libsndfile when available to avoid buffering entire file
-    QByteArray ba = path.toLocal8Bit();
-    const char* cpath = ba.constData();
-    SF_INFO sfinfo;
-    memset(&sfinfo, 0, sizeof(sfinfo));
-    SNDFILE* snd = sf_open(cpath, SFM_READ, &sfinfo);
-    if (snd) {
-        int sampleRate = sfinfo.samplerate;
-        int channels = sfinfo.channels;
-        sf_count_t frames = sfinfo.frames;
-        if (sampleRate <= 0 || channels <= 0 || frames <= 0) {
-            sf_close(snd);
-            return out;
-        }
+    // Stream the file (libsndfile, or mpg123 for MP3) a chunk at a time so
+    // memory stays bounded and cancellation is checked between chunks
+    AudioFileReader reader;
+    if (!reader.open(path)) return out;
+    const int sampleRate = reader.sampleRate();
+    const int channels = reader.channels();
+    const qint64 frames = reader.frames();
+    if (frames <= 0) return out;
 
-        out.sampleRate = sampleRate;
-        out.channels = channels;
-        out.duration = static_cast<double>(frames) / static_cast<double>(sampleRate);
+    out.sampleRate = sampleRate;
+    out.channels = channels;
 
-        int targetPixels = qMax(1, static_cast<int>(std::ceil(pixelWidth * dpr)));
-        sf_count_t samplesPerBucket = (frames + targetPixels - 1) / targetPixels;
-        if (samplesPerBucket <= 0) samplesPerBucket = 1;
+    // The preview spreads the expected length over the pixels; the peak
+    // pyramid follows the frames actually decoded
+    const int targetPixels = qMax(1, static_cast<int>(std::ceil(pixelWidth * dpr)));
+    PreviewAccumulator preview(out, targetPixels, frames);
+    PeakAccumulator acc(frames);
 
-        out.min.reserve(targetPixels);
-        out.max.reserve(targetPixels);
+    const int CHUNK_FRAMES = 4096;
+    std::vector<float> buf(static_cast<size_t>(CHUNK_FRAMES * channels));
+    qint64 totalFramesRead = 0;
+    QElapsedTimer sincePartial;
+    sincePartial.start();
 
-        const int CHUNK_FRAMES = 4096;
-        std::vector<float> buf(static_cast<size_t>(CHUNK_FRAMES * channels));
-
-        sf_count_t bucketFramesSeen = 0;
-        float bucketMin = std::numeric_limits<float>::infinity();
-        float bucketMax = -std::numeric_limits<float>::infinity();
-        sf_count_t totalFramesRead = 0;
-
-        while (totalFramesRead < frames) {
-            if (cancelToken && cancelToken->loadRelaxed() != 0) {
-                // Signal cancellation via empty result (sampleRate == 0)
-                out.min.clear(); out.max.clear(); out.sampleRate = 0;
-                sf_close(snd);
-                return out;
-            }
-
-            int want = static_cast<int>(std::min<sf_count_t>(CHUNK_FRAMES, frames - totalFramesRead));
-            sf_count_t got = sf_readf_float(snd, buf.data(), want);
-            if (got <= 0) break;
-
-            for (sf_count_t f = 0; f < got; ++f) {
-                // compute downmixed per-frame amplitude (max abs across channels)
-                float sampleVal = 0.0f;
-                size_t baseIdx = static_cast<size_t>(f) * static_cast<size_t>(channels);
-                for (int c = 0; c < channels; ++c) {
-                    float s = buf[baseIdx + c];
-                    sampleVal = std::max(sampleVal, std::abs(s));
-                }
-                bucketMin = std::min(bucketMin, -sampleVal);
-                bucketMax = std::max(bucketMax, sampleVal);
-                ++bucketFramesSeen;
-                ++totalFramesRead;
-
-                if (bucketFramesSeen >= samplesPerBucket) {
-                    // finished bucket
-                    if (bucketMin == std::numeric_limits<float>::infinity()) bucketMin = 0.0f;
-                    if (bucketMax == -std::numeric_limits<float>::infinity()) bucketMax = 0.0f;
-                    out.min.push_back(bucketMin);
-                    out.max.push_back(bucketMax);
-                    bucketFramesSeen = 0;
-                    bucketMin = std::numeric_limits<float>::infinity();
-                    bucketMax = -std::numeric_limits<float>::infinity();
-                    // early exit if we've gathered enough pixels
-                    if (static_cast<int>(out.min.size()) >= targetPixels) break;
-                }
-            }
-
-            if (static_cast<int>(out.min.size()) >= targetPixels) break;
+    while (true) {
+        if (cancelToken && cancelToken->loadRelaxed() != 0) {
+            // Signal cancellation via empty result (sampleRate == 0)
+            out.min.clear(); out.max.clear(); out.sampleRate = 0;
+            return out;
         }
-
-        // If there is a trailing partial bucket and we still need pixels, push it
-        if (static_cast<int>(out.min.size()) < targetPixels && bucketFramesSeen > 0) {
-            if (bucketMin == std::numeric_limits<float>::infinity()) bucketMin = 0.0f;
-            if (bucketMax == -std::numeric_limits<float>::infinity()) bucketMax = 0.0f;
-            out.min.push_back(bucketMin);
-            out.max.push_back(bucketMax);
+        // MP3 lengths can be estimates: read until the decoder runs dry
+        const qint64 got = reader.read(buf.data(), CHUNK_FRAMES);
+        if (got <= 0) break;
+        // Keep reading after the last pixel so the peak pyramid covers the whole file
+        accumulate(buf.data(), got, channels, acc, preview);
+        totalFramesRead += got;
+        if (onPartial && sincePartial.elapsed() >= kPartialIntervalMs && totalFramesRead < frames) {
+            onPartial(acc.partial(sampleRate, channels, frames, preview));
+            sincePartial.restart();
         }
-
-        // If we produced fewer pixels than target, pad with zeros
-        while (static_cast<int>(out.min.size()) < targetPixels) {
-            out.min.push_back(0.0f);
-            out.max.push_back(0.0f);
-        }
-
-        sf_close(snd);
-        return out;
     }
-
-    // Fallback: use AudioFile (reads entire file) — keeps previous behavior for formats
-    AudioFile af;
-    if (!af.load(path)) {
+    if (totalFramesRead <= 0) {
+        out.sampleRate = 0;
         return out;
     }
+    preview.finish();
 
-    std::vector<float> samples;
-    int sampleRate = 0;
-    int channels = 0;
-    if (!af.readAllSamples(samples, sampleRate, channels)) {
-        return out;
-    }
+    out.duration = static_cast<double>(totalFramesRead) / static_cast<double>(sampleRate);
+    out.peaks = acc.finish(sampleRate, channels, totalFramesRead);
+    return out;
+}
 
-    if (sampleRate <= 0 || channels <= 0) return out;
+WaveformResult WaveformWorker::decodeApproximate(const QString& path, int pixelWidth, qreal dpr,
+                                                 QSharedPointer<QAtomicInteger<int>> cancelToken)
+{
+    WaveformResult out;
+    AudioFileReader reader;
+    if (path.isEmpty() || !reader.open(path, true)) return out;
+    const int sampleRate = reader.sampleRate();
+    const int channels = reader.channels();
+    const qint64 frames = reader.frames();
+    const int targetPixels = qMax(1, static_cast<int>(std::ceil(pixelWidth * dpr)));
+    const qint64 window = kApproximateWindowFrames;
+    // Sampling pays off only when the windows skip most of the file
+    if (frames < static_cast<qint64>(targetPixels) * window * 4) return out;
 
-    const size_t totalFrames = samples.size() / static_cast<size_t>(channels);
     out.sampleRate = sampleRate;
     out.channels = channels;
-    out.duration = static_cast<double>(totalFrames) / static_cast<double>(sampleRate);
-
-    int targetPixels = qMax(1, static_cast<int>(std::ceil(pixelWidth * dpr)));
-    size_t samplesPerBucket = (totalFrames + targetPixels - 1) / targetPixels; // ceil div
-    if (samplesPerBucket == 0) samplesPerBucket = 1;
-
+    out.duration = static_cast<double>(frames) / static_cast<double>(sampleRate);
+    out.approximate = true;
+    out.progress = 0.0;
     out.min.reserve(targetPixels);
     out.max.reserve(targetPixels);
 
-    size_t framesSeen = 0;
-    float vmin = std::numeric_limits<float>::infinity();
-    float vmax = -std::numeric_limits<float>::infinity();
-
-    for (size_t f = 0; f < totalFrames; ++f) {
-        if (cancelToken && cancelToken->loadRelaxed() != 0) {
-            out.min.clear(); out.max.clear(); out.sampleRate = 0; return out;
-        }
-        float sampleVal = 0.0f;
-        for (int c = 0; c < channels; ++c) {
-            float s = samples[f * channels + c];
-            sampleVal = std::max(sampleVal, std::abs(s));
-        }
-        vmin = std::min(vmin, -sampleVal);
-        vmax = std::max(vmax, sampleVal);
-        ++framesSeen;
-        if (framesSeen >= samplesPerBucket) {
-            if (vmin == std::numeric_limits<float>::infinity()) vmin = 0.0f;
-            if (vmax == -std::numeric_limits<float>::infinity()) vmax = 0.0f;
-            out.min.push_back(vmin);
-            out.max.push_back(vmax);
-            framesSeen = 0;
-            vmin = std::numeric_limits<float>::infinity();
-            vmax = -std::numeric_limits<float>::infinity();
-            if (static_cast<int>(out.min.size()) >= targetPixels) break;
+    // One pyramid bucket per column, so the overview renders like any peaks
+    const qint64 perColumn = (frames + targetPixels - 1) / targetPixels;
+    WaveformLevel base;
+    base.samplesPerBucket = static_cast<int>(perColumn);
+    base.min.reserve(targetPixels);
+    base.max.reserve(targetPixels);
+
+    std::vector<float> buf(static_cast<size_t>(window * channels));
+    for (int x = 0; x < targetPixels; ++x) {
+        if (cancelToken && cancelToken->loadRelaxed() != 0) return WaveformResult();
+        float colMin = std::numeric_limits<float>::infinity();
+        float colMax = -std::numeric_limits<float>::infinity();
+        // Window centred in its column
+        const qint64 start = std::clamp<qint64>(x * perColumn + (perColumn - window) / 2, 0, frames - window);
+        if (reader.seek(start)) {
+            const qint64 got = reader.read(buf.data(), window);
+            if (got > 0) WaveformKernels::minMax(buf.data(), static_cast<size_t>(got), channels, &colMin, &colMax);
         }
+        if (colMin == std::numeric_limits<float>::infinity()) colMin = colMax = 0.0f;
+        base.min.push_back(colMin);
+        base.max.push_back(colMax);
+        const float peak = std::max({0.0f, colMax, -colMin});
+        out.min.push_back(-peak);
+        out.max.push_back(peak);
     }
 
-    if (static_cast<int>(out.min.size()) < targetPixels && framesSeen > 0) {
-        if (vmin == std::numeric_limits<float>::infinity()) vmin = 0.0f;
-        if (vmax == -std::numeric_limits<float>::infinity()) vmax = 0.0f;
-        out.min.push_back(vmin);
-        out.max.push_back(vmax);
-    }
+    out.peaks.sampleRate = sampleRate;
+    out.peaks.channels = channels;
+    out.peaks.totalFrames = frames;
+    out.peaks.levels = WaveformPyramid::buildFromBase(std::move(base), 1);
+    return out;
+}
+
+WaveformResult WaveformWorker::decodeSamples(const float* samples, size_t totalFrames, int sampleRate, int channels,
+                                             int pixelWidth, qreal dpr,
+                                             QSharedPointer<QAtomicInteger<int>> cancelToken)
+{
+    WaveformResult out;
+    if (!samples || sampleRate <= 0 || channels <= 0) return out;
+
+    out.sampleRate = sampleRate;
+    out.channels = channels;
+    out.duration = static_cast<double>(totalFrames) / static_cast<double>(sampleRate);
+
+    const int targetPixels = qMax(1, static_cast<int>(std::ceil(pixelWidth * dpr)));
+    PreviewAccumulator preview(out, targetPixels, static_cast<qint64>(totalFrames));
+    PeakAccumulator acc(static_cast<qint64>(totalFrames));
 
-    while (static_cast<int>(out.min.size()) < targetPixels) {
-        out.min.push_back(0.0f);
-        out.max.push_back(0.0f);
+    // Check for cancellation between chunks rather than per frame
+    const size_t CHUNK_FRAMES = 4096;
+    for (size_t f = 0; f < totalFrames; f += CHUNK_FRAMES) {
+        if (cancelToken && cancelToken->loadRelaxed() != 0) {
+            out.min.clear(); out.max.clear(); out.sampleRate = 0; return out;
+        }
+        const size_t n = std::min(CHUNK_FRAMES, totalFrames - f);
+        accumulate(samples + f * channels, static_cast<qint64>(n), channels, acc, preview);
     }
+    out.peaks = acc.finish(sampleRate, channels, static_cast<qint64>(totalFrames));
+    preview.finish();
 
     return out;
 }
+
+void WaveformWorker::stampSource(const QString& path, WaveformResult* result)
+{
+    if (!result || path.isEmpty()) return;
+    const QFileInfo fi(path);
+    if (!fi.exists()) return;
+    const qint64 size = fi.size();
+    const qint64 mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    result->identity = WaveformPixmapCache::identityOf(path, size, mtimeMs);
+    result->peakId = WaveformCache::peakCacheId(path, size, mtimeMs);
+}
@@ -8,12 +8,19 @@
 #include <QUuid>
 #include <QMutex>
 #include <QHash>
+#include <functional>
+#include "WaveformCache.h"
+#include "WaveformPeakFile.h"
 
 struct WaveformJob {
     QUuid id;
     QString path;
     int pixelWidth = 0;
     qreal dpr = 1.0;
+    // Source file version (size, mtime) as already seen by the caller, e.g.
+    // the cache probe; -1 when unknown. Decodes are shared per version.
+    qint64 size = -1;
+    qint64 mtimeMs = -1;
     // Cancellation token: 0 = running, 1 = cancel requested
     QSharedPointer<QAtomicInteger<int>> cancelToken;
 };
@@ -24,6 +31,27 @@ struct WaveformResult {
     double duration = 0.0;
     int sampleRate = 0;
     int channels = 0;
+    // Full min/max pyramid gathered in the same pass (persisted as a peak file)
+    WaveformPeaks peaks;
+    // Fraction of the file covered; below 1 for partial results, whose
+    // undecoded tail reads as silence
+    double progress = 1.0;
+    // Sampled by decodeApproximate(): for display only, never cached
+    bool approximate = false;
+    // The source file version, set by WaveformWorker::stampSource(). A result
+    // without it is displayed but neither shared nor persisted.
+    QString identity;                   // WaveformPixmapCache identity
+    WaveformCache::PeakCacheId peakId;
+};
+
+// Scheduling class of a waveform job, most urgent first. A slot under the
+// mouse outranks the slots of the visible tab, which outrank slots assigned
+// in the last few seconds; everything else decodes in the background.
+enum class WaveformPriority {
+    Hovered = 0,
+    Visible = 1,
+    Recent = 2,
+    Background = 3
 };
 
 Q_DECLARE_METATYPE(WaveformJob)
@@ -35,33 +63,74 @@ public:
     explicit WaveformWorker(QObject* parent = nullptr);
     ~WaveformWorker() override;
 
-    // Enqueue a job; returns the job id.
-    QUuid enqueueJob(const QString& path, int pixelWidth, qreal dpr = 1.0);
+    // Enqueue a job; returns the job id. Jobs are scheduled by
+    // WaveformJobService, which shares decodes between identical jobs and
+    // starts the most urgent queued job first. `size` and `mtimeMs` are the
+    // file version the caller already knows (no file access on its thread).
+    QUuid enqueueJob(const QString& path, int pixelWidth, qreal dpr = 1.0,
+                     WaveformPriority priority = WaveformPriority::Visible, qint64 size = -1, qint64 mtimeMs = -1);
+
+    // Change the priority of a queued job (tab switch, hover)
+    void setJobPriority(const QUuid& id, WaveformPriority priority);
+
+    // Frames per level-0 bucket of the peak pyramid built while decoding
+    static constexpr int kPeakBaseBucket = 256;
+
+    // Receives partial results from decodeFile on the decoding thread, at
+    // most once per kPartialIntervalMs, so long files can be drawn while
+    // they decode. The first one arrives after kPartialIntervalMs whatever
+    // the file length.
+    using PartialCallback = std::function<void(const WaveformResult& partial)>;
+    static constexpr int kPartialIntervalMs = 100;
 
-    // Request cancellation of a job by id.
+    // Request cancellation of a job by id. The decode keeps running while
+    // other workers still wait for it; no signal is emitted for this job.
     void cancelJob(const QUuid& id);
 
     // Synchronous decode helper for tests and callers that want immediate results.
     // This reads the file (possibly using AudioFile) and fills WaveformResult
     // with duration, sampleRate, channels, and simple min/max arrays sized
-    // approximately to pixelWidth * dpr. Cancellation token can be provided.
+    // approximately to pixelWidth * dpr. Cancellation token and a partial
+    // result callback can be provided.
     static WaveformResult decodeFile(const QString& path, int pixelWidth, qreal dpr = 1.0,
-                                     QSharedPointer<QAtomicInteger<int>> cancelToken = QSharedPointer<QAtomicInteger<int>>());
+                                     QSharedPointer<QAtomicInteger<int>> cancelToken = QSharedPointer<QAtomicInteger<int>>(),
+                                     const PartialCallback& onPartial = PartialCallback());
+
+    // Quick overview of a long file: seek to one short window of
+    // kApproximateWindowFrames per pixel column and reduce only that, so the
+    // cost follows the pixel width rather than the duration. Returns an
+    // empty result (sampleRate 0) when the file is short enough that the
+    // windows would cover a large part of it; decode it exactly instead.
+    static constexpr int kApproximateWindowFrames = 1024;
+    static WaveformResult decodeApproximate(const QString& path, int pixelWidth, qreal dpr = 1.0,
+                                            QSharedPointer<QAtomicInteger<int>> cancelToken = QSharedPointer<QAtomicInteger<int>>());
+
+    // Build the same min/max result from samples already in memory (e.g. a
+    // freshly recorded take) so callers do not have to decode a file again.
+    static WaveformResult decodeSamples(const float* samples, size_t totalFrames, int sampleRate, int channels,
+                                        int pixelWidth, qreal dpr = 1.0,
+                                        QSharedPointer<QAtomicInteger<int>> cancelToken = QSharedPointer<QAtomicInteger<int>>());
+
+    // Fill in the identity and peak-cache id of the file `result` was decoded
+    // from. Stats and may fingerprint the file, so it runs on the decoding
+    // thread rather than where the result is delivered.
+    static void stampSource(const QString& path, WaveformResult* result);
 
 signals:
     // Emitted on the main (GUI) thread when job completes successfully
     void waveformReady(const WaveformJob& job, const WaveformResult& result);
+    // Emitted on the main (GUI) thread while a long job decodes; never
+    // after waveformReady for the same job
+    void waveformPartial(const WaveformJob& job, const WaveformResult& partial);
     // Emitted on the main (GUI) thread when job fails or is cancelled
     void waveformError(const WaveformJob& job, const QString& error);
 
 private:
     Q_DISABLE_COPY(WaveformWorker)
+    friend class WaveformJobService;
 
-    // Map of active job tokens for cancellation support
-    QMutex m_tokenLock;
-    QHash<QUuid, QSharedPointer<QAtomicInteger<int>>> m_tokens;
-
-    // Internal invokables called from worker threads via queued connection
-    Q_INVOKABLE void notifyReady(const WaveformJob& job, const WaveformResult& result);
-    Q_INVOKABLE void notifyError(const WaveformJob& job, const QString& err);
+    // Called by WaveformJobService on the GUI thread when a decode ends
+    void notifyReady(const WaveformJob& job, const WaveformResult& result);
+    void notifyPartial(const WaveformJob& job, const WaveformResult& partial);
+    void notifyError(const WaveformJob& job, const QString& err);
 };
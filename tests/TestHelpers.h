@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../src/WaveformCache.h"
+#include <QApplication>
+#include <QDir>
+#include <QJsonObject>
+#include <QLabel>
+#include <QPixmap>
+#include <QWidget>
+#include <vector>
+
+/**
+ * Helpers shared by the test executables.
+ */
+
+// Non-interleaved output channels for AudioEnginePlay::process() and
+// AudioEngine::processOffline()
+struct OutputBuffers {
+    OutputBuffers(int nChannels, int nframes)
+        : data(nChannels, std::vector<float>(nframes, 0.0f)), ptrs(nChannels, nullptr)
+    {
+        for (int ch = 0; ch < nChannels; ++ch) ptrs[ch] = data[ch].data();
+    }
+    std::vector<std::vector<float>> data;
+    std::vector<float*> ptrs;
+};
+
+// The test process's QApplication, created on first use
+inline QApplication& app()
+{
+    static int argc = 1;
+    static char arg0[] = "test";
+    static char* argv[] = {arg0, nullptr};
+    static QApplication s_app(argc, argv);
+    return s_app;
+}
+
+// The pixmap a widget currently shows (a SoundContainer's waveform), or a
+// null pixmap
+inline QPixmap shownPixmap(const QWidget& widget)
+{
+    for (QLabel* label : widget.findChildren<QLabel*>()) {
+        const QPixmap pm = label->pixmap();
+        if (!pm.isNull()) return pm;
+    }
+    return QPixmap();
+}
+
+// Point WaveformCache at an empty per-process directory
+// (<tmp>/libresoundboard_<prefix>_<pid>_<name>)
+inline void useTempCacheDir(const QString& prefix, const QString& name)
+{
+    const QString dir = QDir::tempPath()
+        + QString("/libresoundboard_%1_%2_%3").arg(prefix).arg(QCoreApplication::applicationPid()).arg(name);
+    qputenv("LIBRE_WAVEFORM_CACHE_DIR", dir.toUtf8());
+    WaveformCache::clearAll();
+}
+
+// Sidecar metadata for a cached image of a 100-byte mono 44.1 kHz source
+// at DPR 1, matching WaveformCache::makeKey(path, 100, mtime, 1, 44100, 1.0f, width)
+inline QJsonObject makeCacheMeta(const QString& path, qint64 mtime, int width)
+{
+    QJsonObject meta;
+    meta["path"] = path;
+    meta["size"] = 100;
+    meta["mtime"] = static_cast<double>(mtime);
+    meta["channels"] = 1;
+    meta["samplerate"] = 44100;
+    meta["dpr"] = 1.0;
+    meta["pixelWidth"] = width;
+    return meta;
+}
@@ -0,0 +1,196 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioEnginePlay.h"
+#include "../src/AudioEngine.h"
+#include "../src/InputCapture.h"
+#include "../src/MainWindow.h"
+#include "../src/SoundContainer.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QDir>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Tests for batch (scene) triggering: every voice of a batch must start in
+ * the same mixer block.
+ */
+
+namespace {
+
+AudioEnginePlay::VoiceStart makeStart(const std::string& id, float value, size_t frames, int bus, size_t delay)
+{
+    AudioEnginePlay::VoiceStart st;
+    st.buf.assign(frames, value);
+    st.sampleRate = 48000;
+    st.channels = 1;
+    st.id = id;
+    st.bus = bus;
+    st.delayFrames = delay;
+    return st;
+}
+
+// Index of the first non-zero sample, or -1
+int firstSound(const std::vector<float>& v)
+{
+    for (size_t i = 0; i < v.size(); ++i) {
+        if (v[i] != 0.0f) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+} // namespace
+
+TEST_CASE("Batch voices share one start frame", "[audioengine][batch]") {
+    AudioEnginePlay player;
+    OutputBuffers out(6, 128);
+    // Advance the clock so start frames are not trivially zero
+    for (int i = 0; i < 3; ++i) player.process(out.ptrs.data(), 128, 6);
+
+    std::vector<AudioEnginePlay::VoiceStart> batch;
+    batch.push_back(makeStart("a", 0.1f, 1000, 0, 0));
+    batch.push_back(makeStart("b", 0.2f, 1000, 1, 0));
+    batch.push_back(makeStart("c", 0.3f, 1000, 2, 0));
+    player.startVoices(std::move(batch));
+    player.process(out.ptrs.data(), 128, 6);
+
+    const int64_t start = player.getPlaybackInfoById("a").startFrame;
+    REQUIRE(start == 3 * 128);
+    REQUIRE(player.getPlaybackInfoById("b").startFrame == start);
+    REQUIRE(player.getPlaybackInfoById("c").startFrame == start);
+    for (int ch = 0; ch < 6; ++ch) REQUIRE(firstSound(out.data[ch]) == 0);
+}
+
+TEST_CASE("Batch offsets delay voices within and across blocks", "[audioengine][batch]") {
+    AudioEnginePlay player;
+    OutputBuffers out(6, 128);
+
+    std::vector<AudioEnginePlay::VoiceStart> batch;
+    batch.push_back(makeStart("a", 0.1f, 1000, 0, 0));
+    batch.push_back(makeStart("b", 0.2f, 1000, 1, 37));
+    batch.push_back(makeStart("c", 0.3f, 1000, 2, 300));
+    player.startVoices(std::move(batch));
+
+    player.process(out.ptrs.data(), 128, 6);
+    REQUIRE(firstSound(out.data[0]) == 0);
+    REQUIRE(firstSound(out.data[2]) == 37);
+    REQUIRE(firstSound(out.data[4]) == -1);
+    REQUIRE(player.getPlaybackInfoById("b").startFrame == 37);
+    REQUIRE(player.getPlaybackInfoById("c").startFrame == 300);
+    // The delayed voice has not consumed any of its buffer yet
+    REQUIRE(player.getPlaybackInfoById("c").frames == 0);
+    REQUIRE(player.getPlaybackInfoById("b").frames == 128 - 37);
+
+    player.process(out.ptrs.data(), 128, 6);
+    REQUIRE(firstSound(out.data[4]) == -1);
+    player.process(out.ptrs.data(), 128, 6);
+    REQUIRE(firstSound(out.data[4]) == 300 - 256);
+    REQUIRE(out.data[4][300 - 256] == Approx(0.3f));
+}
+
+TEST_CASE("Batch restarts playing ids together with new voices", "[audioengine][batch]") {
+    AudioEnginePlay player;
+    OutputBuffers out(2, 64);
+    player.addVoice(std::vector<float>(1000, 0.5f), 48000, 1, "a");
+    for (int i = 0; i < 4; ++i) player.process(out.ptrs.data(), 64, 2);
+    REQUIRE(player.getPlaybackInfoById("a").frames == 256);
+
+    std::vector<AudioEnginePlay::VoiceStart> batch;
+    batch.push_back(makeStart("a", 0.9f, 10, 0, 0));
+    batch.push_back(makeStart("b", 0.1f, 1000, 0, 0));
+    player.startVoices(std::move(batch));
+    player.process(out.ptrs.data(), 64, 2);
+
+    auto a = player.getPlaybackInfoById("a");
+    auto b = player.getPlaybackInfoById("b");
+    // "a" restarted from the beginning of its original buffer
+    REQUIRE(a.frames == 64);
+    REQUIRE(a.totalFrames == 1000);
+    REQUIRE(a.startFrame == b.startFrame);
+    REQUIRE(out.data[0][0] == Approx(0.6f));
+}
+
+TEST_CASE("Concurrent batches are never split across blocks", "[audioengine][batch]") {
+    AudioEnginePlay player;
+    std::atomic<bool> done{false};
+    std::thread mixer([&]() {
+        OutputBuffers out(2, 64);
+        while (!done.load()) player.process(out.ptrs.data(), 64, 2);
+    });
+
+    for (int round = 0; round < 200; ++round) {
+        std::vector<AudioEnginePlay::VoiceStart> batch;
+        for (int v = 0; v < 4; ++v) {
+            batch.push_back(makeStart("v" + std::to_string(v), 0.01f, 100000, 0, 0));
+        }
+        player.startVoices(std::move(batch));
+        // Wait until the mixer has picked the batch up
+        while (player.getPlaybackInfoById("v3").startFrame < 0) std::this_thread::yield();
+        const int64_t start = player.getPlaybackInfoById("v0").startFrame;
+        for (int v = 1; v < 4; ++v) {
+            REQUIRE(player.getPlaybackInfoById("v" + std::to_string(v)).startFrame == start);
+        }
+    }
+    done.store(true);
+    mixer.join();
+}
+
+TEST_CASE("Offline engine starts a batch in one cycle", "[audioengine][batch][offline]") {
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 2));
+    OutputBuffers out(4, 256);
+    engine.processOffline(nullptr, out.ptrs.data(), 256);
+
+    std::vector<float> kick(4800, 0.5f);
+    std::vector<float> bed(9600, 0.25f);
+    std::vector<AudioEngine::BatchVoice> batch(2);
+    batch[0].samples = &kick;
+    batch[0].sampleRate = 48000;
+    batch[0].channels = 1;
+    batch[0].id = "kick";
+    batch[1].samples = &bed;
+    batch[1].sampleRate = 48000;
+    batch[1].channels = 2;
+    batch[1].id = "bed";
+    batch[1].bus = 1;
+    REQUIRE(engine.playBatch(batch));
+
+    engine.processOffline(nullptr, out.ptrs.data(), 256);
+    auto kickInfo = engine.getPlaybackInfoForId("kick");
+    auto bedInfo = engine.getPlaybackInfoForId("bed");
+    REQUIRE(kickInfo.found);
+    REQUIRE(bedInfo.found);
+    REQUIRE(kickInfo.startFrame == 256);
+    REQUIRE(bedInfo.startFrame == kickInfo.startFrame);
+    REQUIRE(engine.framesProcessed() == 512);
+    REQUIRE(out.data[0][0] == Approx(0.5f));
+    REQUIRE(out.data[2][0] == Approx(0.25f));
+}
+
+TEST_CASE("Triggering a scene starts one batch", "[audioengine][batch][mainwindow]") {
+    static int argc = 1;
+    static char arg0[] = "test";
+    static char* argv[] = {arg0, nullptr};
+    static QApplication app(argc, argv);
+
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_batch_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    const QString path = dir + "/scene_member.wav";
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), std::vector<float>(4800, 0.1f), 48000));
+
+    MainWindow window;
+    AudioEngine* engine = window.getAudioEngine();
+    // Without JACK the offline backend accepts the batch
+    engine->initOffline(48000, 1);
+    const QList<SoundContainer*> containers = window.findChildren<SoundContainer*>();
+    REQUIRE(!containers.isEmpty());
+    SoundContainer* scene = containers.first();
+    scene->setScene({{path, 0}});
+
+    const uint64_t before = engine->batchesStarted();
+    emit scene->sceneTriggered(scene);
+    REQUIRE(engine->batchesStarted() == before + 1);
+}
@@ -0,0 +1,130 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioEnginePlay.h"
+#include "TestHelpers.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Tests for multi-bus routing in the AudioEnginePlay mixer.
+ */
+
+namespace {
+
+double mixSeconds(AudioEnginePlay& player, int nVoices, int nBuses, int nframes, int blocks)
+{
+    OutputBuffers out(nBuses * 2, nframes);
+    for (int v = 0; v < nVoices; ++v) player.restartVoicesById("v" + std::to_string(v));
+    auto t0 = std::chrono::steady_clock::now();
+    for (int blk = 0; blk < blocks; ++blk) {
+        player.process(out.ptrs.data(), nframes, nBuses * 2);
+        // Rewind voices before they run dry so every block mixes all of them
+        if ((blk + 1) % (40000 / nframes) == 0) {
+            for (int v = 0; v < nVoices; ++v) player.restartVoicesById("v" + std::to_string(v));
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+} // namespace
+
+TEST_CASE("Voices mix only into their assigned bus", "[audioengine][buses]") {
+    AudioEnginePlay player;
+    player.addVoice(std::vector<float>(64, 0.5f), 48000, 1, "a", 1.0f, 0);
+    player.addVoice(std::vector<float>(64, 0.25f), 48000, 1, "b", 1.0f, 2);
+
+    OutputBuffers out(6, 32);
+    player.process(out.ptrs.data(), 32, 6);
+
+    REQUIRE(out.data[0][0] == Approx(0.5f));
+    REQUIRE(out.data[1][0] == Approx(0.5f));
+    REQUIRE(out.data[2][0] == Approx(0.0f));
+    REQUIRE(out.data[3][0] == Approx(0.0f));
+    REQUIRE(out.data[4][0] == Approx(0.25f));
+    REQUIRE(out.data[5][0] == Approx(0.25f));
+}
+
+TEST_CASE("Voices can be moved to another bus while playing", "[audioengine][buses]") {
+    AudioEnginePlay player;
+    player.addVoice(std::vector<float>(128, 0.5f), 48000, 1, "a", 1.0f, 0);
+
+    OutputBuffers out(4, 32);
+    player.process(out.ptrs.data(), 32, 4);
+    REQUIRE(out.data[0][0] == Approx(0.5f));
+    REQUIRE(out.data[2][0] == Approx(0.0f));
+
+    player.setBusById("a", 1);
+    player.process(out.ptrs.data(), 32, 4);
+    REQUIRE(out.data[0][0] == Approx(0.0f));
+    REQUIRE(out.data[2][0] == Approx(0.5f));
+    REQUIRE(out.data[3][0] == Approx(0.5f));
+}
+
+TEST_CASE("Bus gain scales only its own bus", "[audioengine][buses]") {
+    AudioEnginePlay player;
+    player.addVoice(std::vector<float>(64, 0.5f), 48000, 1, "a", 1.0f, 0);
+    player.addVoice(std::vector<float>(64, 0.5f), 48000, 1, "b", 1.0f, 1);
+    player.setBusGain(1, 0.5f);
+    REQUIRE(player.busGain(1) == Approx(0.5f));
+    REQUIRE(player.busGain(0) == Approx(1.0f));
+
+    OutputBuffers out(4, 16);
+    player.process(out.ptrs.data(), 16, 4);
+    REQUIRE(out.data[0][0] == Approx(0.5f));
+    REQUIRE(out.data[2][0] == Approx(0.25f));
+}
+
+TEST_CASE("Voices routed past the registered buses fall back to bus 0", "[audioengine][buses]") {
+    AudioEnginePlay player;
+    player.addVoice(std::vector<float>(64, 0.5f), 48000, 1, "a", 1.0f, 5);
+
+    OutputBuffers out(2, 16);
+    player.process(out.ptrs.data(), 16, 2);
+    REQUIRE(out.data[0][0] == Approx(0.5f));
+    REQUIRE(out.data[1][0] == Approx(0.5f));
+}
+
+TEST_CASE("Stereo voices keep left and right separate on their bus", "[audioengine][buses]") {
+    AudioEnginePlay player;
+    std::vector<float> stereo(64);
+    for (size_t i = 0; i < stereo.size(); i += 2) { stereo[i] = 0.1f; stereo[i + 1] = -0.2f; }
+    player.addVoice(std::move(stereo), 48000, 2, "s", 1.0f, 1);
+
+    OutputBuffers out(4, 16);
+    player.process(out.ptrs.data(), 16, 4);
+    REQUIRE(out.data[2][0] == Approx(0.1f));
+    REQUIRE(out.data[3][0] == Approx(-0.2f));
+    REQUIRE(out.data[0][0] == Approx(0.0f));
+}
+
+TEST_CASE("Mix cost with one and eight buses", "[.][audioengine][buses][benchmark]") {
+    const int nVoices = 32;
+    const int nframes = 256;
+    const int blocks = 2000;
+
+    auto setup = [&](AudioEnginePlay& player, int nBuses) {
+        for (int v = 0; v < nVoices; ++v) {
+            std::vector<float> buf(48000, 0.001f * static_cast<float>(v % 7));
+            player.addVoice(std::move(buf), 48000, 1, "v" + std::to_string(v), 0.5f, v % nBuses);
+        }
+    };
+
+    AudioEnginePlay one;
+    setup(one, 1);
+    AudioEnginePlay eight;
+    setup(eight, 8);
+
+    // Warm up caches before timing
+    mixSeconds(one, nVoices, 1, nframes, 50);
+    mixSeconds(eight, nVoices, 8, nframes, 50);
+
+    double t1 = mixSeconds(one, nVoices, 1, nframes, blocks);
+    double t8 = mixSeconds(eight, nVoices, 8, nframes, blocks);
+
+    std::cout << "mix " << nVoices << " voices x " << blocks << " blocks: 1 bus "
+              << t1 * 1000.0 << " ms, 8 buses " << t8 * 1000.0 << " ms" << std::endl;
+}
@@ -0,0 +1,161 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioDucker.h"
+#include "../src/AudioEngine.h"
+#include "TestHelpers.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/**
+ * Tests for the talk-over ducker, driven through the offline engine backend.
+ */
+
+namespace {
+
+// Count heap allocations while armed so the RT path can be checked for zero allocation
+std::atomic<bool> g_countAllocs{false};
+std::atomic<int> g_allocs{0};
+
+AudioDucker::Settings fastDucker(uint32_t mask)
+{
+    AudioDucker::Settings s;
+    s.enabled = true;
+    s.thresholdDbfs = -30.0f;
+    s.depthDb = -20.0f;
+    s.attackMs = 1.0f;
+    s.releaseMs = 20.0f;
+    s.busMask = mask;
+    return s;
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (g_countAllocs.load()) g_allocs.fetch_add(1);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST_CASE("blockPeak returns the largest absolute sample", "[ducker]") {
+    std::vector<float> v(37, 0.1f);
+    v[29] = -0.8f;
+    v[36] = 0.5f;
+    REQUIRE(AudioDucker::blockPeak(v.data(), static_cast<int>(v.size())) == Approx(0.8f));
+    REQUIRE(AudioDucker::blockPeak(v.data(), 3) == Approx(0.1f));
+    REQUIRE(AudioDucker::blockPeak(nullptr, 10) == 0.0f);
+}
+
+TEST_CASE("Ducker attenuates only masked buses while the input is loud", "[ducker]") {
+    AudioDucker ducker;
+    ducker.setSampleRate(48000);
+    ducker.setSettings(fastDucker(0x1));
+
+    const int nframes = 512;
+    std::vector<float> voice(nframes, 0.5f);
+    for (int blk = 0; blk < 20; ++blk) {
+        OutputBuffers out(4, nframes);
+        for (auto& ch : out.data) ch.assign(nframes, 0.5f);
+        ducker.process(voice.data(), out.ptrs.data(), nframes, 4);
+        if (blk == 19) {
+            // -20 dB on bus 1, bus 2 untouched
+            REQUIRE(out.data[0][nframes - 1] == Approx(0.05f).margin(1e-3));
+            REQUIRE(out.data[1][nframes - 1] == Approx(0.05f).margin(1e-3));
+            REQUIRE(out.data[2][nframes - 1] == Approx(0.5f));
+            REQUIRE(out.data[3][nframes - 1] == Approx(0.5f));
+        }
+    }
+    REQUIRE(ducker.currentGain() == Approx(0.1f).margin(1e-3));
+}
+
+TEST_CASE("Ducker releases back to unity after the input goes quiet", "[ducker]") {
+    AudioDucker ducker;
+    ducker.setSampleRate(48000);
+    ducker.setSettings(fastDucker(0x1));
+
+    const int nframes = 256;
+    std::vector<float> loud(nframes, 0.5f);
+    std::vector<float> quiet(nframes, 0.0f);
+    OutputBuffers out(2, nframes);
+    for (int blk = 0; blk < 20; ++blk) ducker.process(loud.data(), out.ptrs.data(), nframes, 2);
+    REQUIRE(ducker.currentGain() < 0.2f);
+
+    // Gain must rise monotonically while releasing
+    float prev = ducker.currentGain();
+    for (int blk = 0; blk < 100; ++blk) {
+        ducker.process(quiet.data(), out.ptrs.data(), nframes, 2);
+        REQUIRE(ducker.currentGain() >= prev);
+        prev = ducker.currentGain();
+    }
+    REQUIRE(ducker.currentGain() == Approx(1.0f).margin(1e-3));
+}
+
+TEST_CASE("Disabled ducker leaves the mix untouched", "[ducker]") {
+    AudioDucker ducker;
+    AudioDucker::Settings s = fastDucker(0xFF);
+    s.enabled = false;
+    ducker.setSettings(s);
+
+    const int nframes = 128;
+    std::vector<float> loud(nframes, 1.0f);
+    OutputBuffers out(2, nframes);
+    for (auto& ch : out.data) ch.assign(nframes, 0.5f);
+    ducker.process(loud.data(), out.ptrs.data(), nframes, 2);
+    REQUIRE(out.data[0][0] == Approx(0.5f));
+    REQUIRE(ducker.currentGain() == 1.0f);
+}
+
+TEST_CASE("Offline engine ducks a playing bed when the input talks", "[ducker][offline]") {
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 2));
+    REQUIRE(engine.isOffline());
+    engine.setDuckingSettings(fastDucker(0x1));
+
+    REQUIRE(engine.playBuffer(std::vector<float>(48000, 0.5f), 48000, 1, "bed", 1.0f, 0));
+    REQUIRE(engine.playBuffer(std::vector<float>(48000, 0.5f), 48000, 1, "cue", 1.0f, 1));
+
+    const int nframes = 256;
+    std::vector<float> talk(nframes, 0.3f);
+    std::vector<float> silence(nframes, 0.0f);
+    OutputBuffers out(4, nframes);
+
+    // Quiet input: both buses at full level
+    engine.processOffline(silence.data(), out.ptrs.data(), nframes);
+    REQUIRE(out.data[0][nframes - 1] == Approx(0.5f));
+    REQUIRE(out.data[2][nframes - 1] == Approx(0.5f));
+
+    // Talking: bus 1 ducks, bus 2 stays; the RT path must not allocate
+    g_allocs.store(0);
+    g_countAllocs.store(true);
+    for (int blk = 0; blk < 20; ++blk) {
+        engine.processOffline(talk.data(), out.ptrs.data(), nframes);
+    }
+    g_countAllocs.store(false);
+    REQUIRE(g_allocs.load() == 0);
+    REQUIRE(out.data[0][nframes - 1] == Approx(0.05f).margin(1e-3));
+    REQUIRE(out.data[2][nframes - 1] == Approx(0.5f));
+    REQUIRE(engine.duckingGain() < 0.2f);
+
+    // Quiet again: bus 1 recovers
+    for (int blk = 0; blk < 100; ++blk) {
+        engine.processOffline(silence.data(), out.ptrs.data(), nframes);
+    }
+    REQUIRE(out.data[0][nframes - 1] == Approx(0.5f).margin(1e-3));
+
+    engine.shutdown();
+    REQUIRE_FALSE(engine.isOffline());
+}
@@ -0,0 +1,164 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioFile.h"
+#include "../src/ContentFingerprint.h"
+#include "../src/DecodedAudioCache.h"
+#include "../src/InputCapture.h"
+#include "../src/WaveformCache.h"
+#include "../src/WaveformPyramid.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <cmath>
+#include <iostream>
+
+/**
+ * Tests for content-addressed cache keys.
+ */
+
+namespace {
+
+QString tempPath(const QString& name)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_fp_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    return QDir(dir).filePath(name);
+}
+
+// A mono sine, long enough to be sampled rather than hashed whole
+QString writeWav(const QString& name, int seconds, float freq)
+{
+    const int sr = 48000;
+    std::vector<float> samples(static_cast<size_t>(sr) * seconds);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = 0.5f * static_cast<float>(std::sin(2.0 * M_PI * freq * static_cast<double>(i) / sr));
+    }
+    const QString path = tempPath(name);
+    QFile::remove(path);
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, sr));
+    return path;
+}
+
+QString copyTo(const QString& from, const QString& name)
+{
+    const QString to = tempPath(name);
+    QFile::remove(to);
+    REQUIRE(QFile::copy(from, to));
+    return to;
+}
+
+WaveformPeaks makePeaks()
+{
+    QVector<float> s(48000);
+    for (int i = 0; i < s.size(); ++i) s[i] = std::sin(i * 0.01f);
+    WaveformPeaks peaks;
+    peaks.sampleRate = 48000;
+    peaks.channels = 1;
+    peaks.totalFrames = s.size();
+    peaks.levels = WaveformPyramid::build(s, 1, 256);
+    return peaks;
+}
+
+} // namespace
+
+TEST_CASE("Copies share a fingerprint and edits change it", "[cache][fingerprint]") {
+    const QString a = writeWav("a.wav", 5, 440.0f);
+    const QString b = copyTo(a, "b.wav");
+    const QString c = writeWav("c.wav", 5, 660.0f);
+
+    const quint64 fa = ContentFingerprint::compute(a);
+    REQUIRE(fa != 0);
+    REQUIRE(ContentFingerprint::compute(b) == fa);
+    REQUIRE(ContentFingerprint::compute(c) != fa);
+    REQUIRE(ContentFingerprint::compute(tempPath("missing.wav")) == 0);
+
+    // Memoised per file version; a rewrite is hashed again
+    ContentFingerprint::instance().clear();
+    REQUIRE(ContentFingerprint::instance().of(a) == fa);
+    REQUIRE(ContentFingerprint::instance().of(a) == fa);
+    REQUIRE(ContentFingerprint::instance().memoSize() == 1);
+    QThread::msleep(20);
+    QFile f(b);
+    REQUIRE(f.open(QIODevice::ReadWrite));
+    f.seek(100);
+    f.write("edit");
+    f.close();
+    REQUIRE(ContentFingerprint::instance().of(b) != fa);
+}
+
+TEST_CASE("Peak entries follow the contents across paths", "[cache][fingerprint]") {
+    qputenv("LIBRE_WAVEFORM_CACHE_DIR", tempPath("cache").toUtf8());
+    WaveformCache::clearAll();
+    const QString a = writeWav("lib_a.wav", 2, 440.0f);
+
+    ContentFingerprint::setEnabled(true);
+    const QFileInfo fa(a);
+    const WaveformCache::PeakCacheId ida = WaveformCache::peakCacheId(a, fa.size(), fa.lastModified().toMSecsSinceEpoch());
+    REQUIRE(WaveformCache::writePeaksFile(WaveformCache::cacheDirPath(), ida.key, makePeaks(), ida.size, ida.stamp));
+
+    // A copy (new path, new mtime) and a moved file hit the same entry
+    QThread::msleep(20);
+    const QString copy = copyTo(a, "copy.wav");
+    const QString moved = tempPath("moved.wav");
+    QFile::remove(moved);
+    REQUIRE(QFile::rename(a, moved));
+    for (const QString& p : {copy, moved}) {
+        const QFileInfo fi(p);
+        const WaveformCache::PeakCacheId id = WaveformCache::peakCacheId(p, fi.size(), fi.lastModified().toMSecsSinceEpoch());
+        REQUIRE(id.key == ida.key);
+        WaveformPeaks loaded;
+        REQUIRE(WaveformCache::loadPeaks(id.key, id.size, id.stamp, &loaded));
+        REQUIRE(loaded.totalFrames == 48000);
+    }
+
+    // Path keys are unchanged when content keys are off
+    ContentFingerprint::setEnabled(false);
+    const QFileInfo fc(copy);
+    const WaveformCache::PeakCacheId pathId = WaveformCache::peakCacheId(copy, fc.size(), fc.lastModified().toMSecsSinceEpoch());
+    REQUIRE(pathId.key == WaveformCache::makePeakKey(copy, fc.size(), fc.lastModified().toMSecsSinceEpoch()));
+    REQUIRE(!WaveformCache::loadPeaks(pathId.key, pathId.size, pathId.stamp, nullptr));
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Decoded audio is shared between copies", "[cache][fingerprint]") {
+    const QString a = writeWav("dec_a.wav", 1, 440.0f);
+    const QString b = copyTo(a, "dec_b.wav");
+    DecodedAudioCache::instance().clear();
+
+    ContentFingerprint::setEnabled(true);
+    DecodedAudioCache::instance().insert(a, std::vector<float>(48000, 0.25f), 48000, 1);
+    DecodedAudioCache::Entry entry;
+    REQUIRE(DecodedAudioCache::instance().lookup(b, &entry));
+    REQUIRE(entry.samples->size() == 48000);
+
+    ContentFingerprint::setEnabled(false);
+    REQUIRE(!DecodedAudioCache::instance().lookup(b, &entry));
+    DecodedAudioCache::instance().clear();
+}
+
+TEST_CASE("Fingerprint and decode cost of a 60 s file", "[.][cache][fingerprint][benchmark]") {
+    const QString path = writeWav("bench.wav", 60, 440.0f);
+    const int runs = 20;
+    QElapsedTimer t;
+
+    t.start();
+    quint64 fp = 0;
+    for (int i = 0; i < runs; ++i) fp ^= ContentFingerprint::compute(path);
+    const double fingerprintMs = t.nsecsElapsed() / 1e6 / runs;
+    REQUIRE(fp == 0);   // even number of identical hashes
+
+    t.restart();
+    AudioFile af;
+    REQUIRE(af.load(path));
+    std::vector<float> samples;
+    int sr = 0, ch = 0;
+    REQUIRE(af.readAllSamples(samples, sr, ch));
+    const double decodeMs = t.nsecsElapsed() / 1e6;
+
+    std::cout << "60 s WAV (" << QFileInfo(path).size() / 1024 << " KB): fingerprint " << fingerprintMs
+              << " ms, decode " << decodeMs << " ms" << std::endl;
+}
@@ -0,0 +1,255 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/DecodedAudioCache.h"
+#include "../src/AudioEngine.h"
+#include "../src/MainWindow.h"
+#include "../src/SoundContainer.h"
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Tests for record-to-slot input capture and the decoded audio cache.
+ */
+
+namespace {
+
+std::atomic<bool> g_countAllocs{false};
+std::atomic<int> g_allocs{0};
+
+std::string tempPath(const std::string& name)
+{
+    return "/tmp/libresoundboard_cap_" + std::to_string(getpid()) + "_" + name;
+}
+
+std::vector<float> ramp(size_t n, size_t start)
+{
+    std::vector<float> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<float>((start + i) % 1000) / 1000.0f;
+    return v;
+}
+
+void writeBytes(const QString& path, int size)
+{
+    QFile f(path);
+    REQUIRE(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write(QByteArray(size, 'x'));
+    f.close();
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (g_countAllocs.load()) g_allocs.fetch_add(1);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST_CASE("Capture keeps every frame in order across chunk boundaries", "[capture]") {
+    InputCapture cap;
+    REQUIRE(cap.arm(48000));
+    cap.record();
+    REQUIRE(cap.state() == InputCapture::State::Recording);
+
+    const int nframes = 256;
+    const size_t total = InputCapture::kChunkFrames * 3 + 100;
+    size_t pushed = 0;
+    while (pushed < total) {
+        const size_t n = std::min(static_cast<size_t>(nframes), total - pushed);
+        std::vector<float> block = ramp(n, pushed);
+        cap.pushInput(block.data(), static_cast<int>(n));
+        pushed += n;
+        // Give the refill thread time to top up the pool, as the JACK period would
+        if (pushed % InputCapture::kChunkFrames < static_cast<size_t>(nframes)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        }
+    }
+
+    REQUIRE(cap.droppedFrames() == 0);
+    REQUIRE(cap.capturedFrames() == total);
+    std::vector<float> out = cap.stop();
+    REQUIRE(out.size() == total);
+    std::vector<float> expected = ramp(total, 0);
+    REQUIRE(out == expected);
+    REQUIRE(cap.state() == InputCapture::State::Idle);
+}
+
+TEST_CASE("Armed capture ignores input until record()", "[capture]") {
+    InputCapture cap;
+    REQUIRE(cap.arm(48000));
+    std::vector<float> block(128, 0.5f);
+    cap.pushInput(block.data(), 128);
+    REQUIRE(cap.capturedFrames() == 0);
+    cap.record();
+    cap.pushInput(block.data(), 128);
+    REQUIRE(cap.capturedFrames() == 128);
+    cap.disarm();
+    REQUIRE(cap.state() == InputCapture::State::Idle);
+}
+
+TEST_CASE("Capture drops frames instead of allocating when the pool runs dry", "[capture][rt]") {
+    InputCapture cap;
+    REQUIRE(cap.arm(48000));
+    cap.record();
+
+    // Consume more chunks than the pool holds without giving the refill
+    // thread a chance to run; the RT path must never allocate
+    std::vector<float> block(InputCapture::kChunkFrames, 0.25f);
+    g_allocs.store(0);
+    g_countAllocs.store(true);
+    for (size_t i = 0; i < InputCapture::kPoolTarget + 4; ++i) {
+        cap.pushInput(block.data(), static_cast<int>(block.size()));
+    }
+    g_countAllocs.store(false);
+
+    REQUIRE(g_allocs.load() == 0);
+    REQUIRE(cap.capturedFrames() + cap.droppedFrames() == block.size() * (InputCapture::kPoolTarget + 4));
+    REQUIRE(cap.capturedFrames() >= block.size() * InputCapture::kPoolTarget);
+    cap.disarm();
+}
+
+TEST_CASE("Offline engine exposes input history and feeds an attached capture", "[capture][offline]") {
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+
+    const int nframes = 256;
+    std::vector<float> outL(nframes), outR(nframes);
+    float* outputs[2] = {outL.data(), outR.data()};
+    std::vector<float> input = ramp(nframes, 0);
+
+    engine.processOffline(input.data(), outputs, nframes);
+    std::vector<float> history = engine.getInputSamples();
+    REQUIRE(history == input);
+    // Samples are only returned once
+    REQUIRE(engine.getInputSamples().empty());
+
+    InputCapture cap;
+    REQUIRE(cap.arm(engine.sampleRate()));
+    engine.setInputCapture(&cap);
+    REQUIRE(engine.inputCapture() == &cap);
+    cap.record();
+    for (int b = 0; b < 4; ++b) {
+        std::vector<float> block = ramp(nframes, static_cast<size_t>(b) * nframes);
+        engine.processOffline(block.data(), outputs, nframes);
+    }
+    engine.setInputCapture(nullptr);
+    std::vector<float> take = cap.stop();
+    REQUIRE(take == ramp(4 * nframes, 0));
+}
+
+TEST_CASE("Decoded audio cache invalidates entries when the file changes", "[cache]") {
+    DecodedAudioCache& cache = DecodedAudioCache::instance();
+    cache.clear();
+    const QString path = QString::fromStdString(tempPath("decoded.raw"));
+    writeBytes(path, 64);
+
+    cache.insert(path, std::vector<float>(100, 0.5f), 48000, 1);
+    DecodedAudioCache::Entry entry;
+    REQUIRE(cache.lookup(path, &entry));
+    REQUIRE(entry.samples->size() == 100);
+    REQUIRE(entry.sampleRate == 48000);
+    REQUIRE(entry.channels == 1);
+
+    // Rewriting the file with a different size invalidates the entry
+    writeBytes(path, 128);
+    REQUIRE_FALSE(cache.lookup(path, &entry));
+
+    // A changed mtime alone also invalidates it
+    cache.insert(path, std::vector<float>(100, 0.5f), 48000, 1);
+    REQUIRE(cache.lookup(path, &entry));
+    QFile f(path);
+    REQUIRE(f.open(QIODevice::ReadWrite));
+    REQUIRE(f.setFileTime(QDateTime::currentDateTime().addSecs(-3600), QFileDevice::FileModificationTime));
+    f.close();
+    REQUIRE_FALSE(cache.lookup(path, &entry));
+
+    QFile::remove(path);
+    cache.clear();
+}
+
+TEST_CASE("Decoded audio cache evicts the least recently used entry", "[cache]") {
+    DecodedAudioCache& cache = DecodedAudioCache::instance();
+    cache.clear();
+    const qint64 oldCapacity = cache.capacityBytes();
+    cache.setCapacityBytes(3 * 1000 * static_cast<qint64>(sizeof(float)));
+
+    QString paths[4];
+    for (int i = 0; i < 4; ++i) {
+        paths[i] = QString::fromStdString(tempPath("lru" + std::to_string(i) + ".raw"));
+        writeBytes(paths[i], 16);
+    }
+    cache.insert(paths[0], std::vector<float>(1000), 48000, 1);
+    cache.insert(paths[1], std::vector<float>(1000), 48000, 1);
+    cache.insert(paths[2], std::vector<float>(1000), 48000, 1);
+    // Touch 0 so 1 becomes the oldest
+    REQUIRE(cache.lookup(paths[0], nullptr));
+    cache.insert(paths[3], std::vector<float>(1000), 48000, 1);
+
+    REQUIRE(cache.sizeBytes() <= cache.capacityBytes());
+    REQUIRE(cache.lookup(paths[0], nullptr));
+    REQUIRE_FALSE(cache.lookup(paths[1], nullptr));
+    REQUIRE(cache.lookup(paths[2], nullptr));
+    REQUIRE(cache.lookup(paths[3], nullptr));
+
+    for (const QString& p : paths) QFile::remove(p);
+    cache.setCapacityBytes(oldCapacity);
+    cache.clear();
+}
+
+TEST_CASE("Rebuilding the grid discards an armed capture", "[inputcapture][mainwindow]") {
+    static int argc = 1;
+    static char arg0[] = "test";
+    static char* argv[] = {arg0, nullptr};
+    static QApplication app(argc, argv);
+
+    MainWindow window;
+    AudioEngine* engine = window.getAudioEngine();
+    engine->initOffline(48000, 1);
+    if (engine->sampleRate() <= 0) return;
+
+    auto emptySlot = [&window]() -> SoundContainer* {
+        for (SoundContainer* sc : window.findChildren<SoundContainer*>()) {
+            if (sc->file().isEmpty() && !sc->isScene()) return sc;
+        }
+        return nullptr;
+    };
+    SoundContainer* armed = emptySlot();
+    REQUIRE(armed != nullptr);
+    emit armed->armRecordRequested(armed);
+    REQUIRE(armed->recordState() == SoundContainer::RecordState::Armed);
+    REQUIRE(engine->inputCapture() != nullptr);
+
+    // The armed slot is deleted with the old grid: the capture goes with it
+    window.onGridDimensionsChanged(window.gridRows() == 8 ? 7 : window.gridRows() + 1, window.gridCols());
+    REQUIRE(engine->inputCapture() == nullptr);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    // ...so another slot can be armed
+    SoundContainer* next = emptySlot();
+    REQUIRE(next != nullptr);
+    emit next->armRecordRequested(next);
+    REQUIRE(next->recordState() == SoundContainer::RecordState::Armed);
+    REQUIRE(engine->inputCapture() != nullptr);
+}
@@ -0,0 +1,203 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/OutputRecorder.h"
+#include "../src/AudioEngine.h"
+#include "TestHelpers.h"
+#include <sndfile.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Tests for the output recorder ring/writer pipeline.
+ */
+
+namespace {
+
+std::string tempPath(const std::string& name)
+{
+    return "/tmp/libresoundboard_rec_" + std::to_string(getpid()) + "_" + name;
+}
+
+sf_count_t readFrames(const std::string& path, std::vector<float>& out, int& channels)
+{
+    SF_INFO info;
+    std::memset(&info, 0, sizeof(info));
+    SNDFILE* snd = sf_open(path.c_str(), SFM_READ, &info);
+    if (!snd) return -1;
+    channels = info.channels;
+    out.resize(static_cast<size_t>(info.frames) * info.channels);
+    sf_count_t got = sf_readf_float(snd, out.data(), info.frames);
+    sf_close(snd);
+    return got;
+}
+
+} // namespace
+
+TEST_CASE("Recorder writes every pushed block when the disk keeps up", "[recorder]") {
+    const std::string path = tempPath("master.wav");
+    OutputRecorder rec;
+    OutputRecorder::Options opts;
+    opts.path = path;
+    opts.sampleRate = 48000;
+    opts.busCount = 2;
+    opts.perBus = true;
+    opts.ringSeconds = 2.0;
+    REQUIRE(rec.start(opts));
+    REQUIRE(rec.filePaths().size() == 3);
+    REQUIRE(rec.filePaths()[1] == OutputRecorder::busFilePath(path, 0));
+    REQUIRE(rec.filePaths()[2] == OutputRecorder::busFilePath(path, 1));
+
+    const int nframes = 256;
+    const int blocks = 100;
+    OutputBuffers out(4, nframes);
+    for (int blk = 0; blk < blocks; ++blk) {
+        for (int i = 0; i < nframes; ++i) {
+            out.data[0][i] = 0.25f;
+            out.data[1][i] = -0.25f;
+            out.data[2][i] = 0.5f;
+            out.data[3][i] = -0.5f;
+        }
+        rec.pushBlock(out.ptrs.data(), 4, nframes);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    rec.stop();
+
+    REQUIRE(rec.droppedBlocks() == 0);
+    REQUIRE(rec.framesWritten() == static_cast<uint64_t>(blocks * nframes));
+
+    std::vector<float> master;
+    int channels = 0;
+    REQUIRE(readFrames(path, master, channels) == blocks * nframes);
+    REQUIRE(channels == 2);
+    // The master is the mixdown of both buses
+    REQUIRE(master[0] == Approx(0.75f));
+    REQUIRE(master[1] == Approx(-0.75f));
+
+    std::vector<float> bus1;
+    REQUIRE(readFrames(OutputRecorder::busFilePath(path, 0), bus1, channels) == blocks * nframes);
+    REQUIRE(bus1[0] == Approx(0.25f));
+    REQUIRE(bus1[1] == Approx(-0.25f));
+
+    std::vector<float> bus2;
+    REQUIRE(readFrames(OutputRecorder::busFilePath(path, 1), bus2, channels) == blocks * nframes);
+    REQUIRE(bus2[0] == Approx(0.5f));
+    REQUIRE(bus2[1] == Approx(-0.5f));
+
+    std::remove(path.c_str());
+    std::remove(OutputRecorder::busFilePath(path, 0).c_str());
+    std::remove(OutputRecorder::busFilePath(path, 1).c_str());
+}
+
+TEST_CASE("The master mix is clamped, or can be bus 1 alone", "[recorder]") {
+    const int nframes = 256;
+    OutputBuffers out(4, nframes);
+    for (int i = 0; i < nframes; ++i) {
+        out.data[0][i] = 0.75f;
+        out.data[1][i] = -0.75f;
+        out.data[2][i] = 0.5f;
+        out.data[3][i] = -0.5f;
+    }
+
+    const std::string mixPath = tempPath("mix.wav");
+    OutputRecorder mix;
+    OutputRecorder::Options opts;
+    opts.path = mixPath;
+    opts.busCount = 2;
+    REQUIRE(mix.start(opts));
+    mix.pushBlock(out.ptrs.data(), 4, nframes);
+    mix.stop();
+
+    std::vector<float> samples;
+    int channels = 0;
+    REQUIRE(readFrames(mixPath, samples, channels) == nframes);
+    // 0.75 + 0.5 would be over full scale
+    REQUIRE(samples[0] == Approx(1.0f));
+    REQUIRE(samples[1] == Approx(-1.0f));
+    std::remove(mixPath.c_str());
+
+    const std::string bus1Path = tempPath("bus1.wav");
+    OutputRecorder bus1;
+    opts.path = bus1Path;
+    opts.master = OutputRecorder::Master::Bus1;
+    REQUIRE(bus1.start(opts));
+    bus1.pushBlock(out.ptrs.data(), 4, nframes);
+    bus1.stop();
+
+    REQUIRE(readFrames(bus1Path, samples, channels) == nframes);
+    REQUIRE(samples[0] == Approx(0.75f));
+    REQUIRE(samples[1] == Approx(-0.75f));
+    REQUIRE(bus1.lastError().empty());
+    std::remove(bus1Path.c_str());
+}
+
+TEST_CASE("Slow writer drops blocks instead of blocking the producer", "[recorder]") {
+    const std::string path = tempPath("stall.wav");
+    OutputRecorder rec;
+    OutputRecorder::Options opts;
+    opts.path = path;
+    opts.sampleRate = 48000;
+    opts.busCount = 1;
+    opts.ringSeconds = 0.05; // 2400 frames
+    REQUIRE(rec.start(opts));
+    rec.setWriterStallForTesting(std::chrono::milliseconds(50));
+
+    const int nframes = 256;
+    const int blocks = 400;
+    OutputBuffers out(2, nframes);
+    for (int blk = 0; blk < blocks; ++blk) {
+        rec.pushBlock(out.ptrs.data(), 2, nframes);
+        // Produce blocks far faster than the stalled writer drains them
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    rec.setWriterStallForTesting(std::chrono::milliseconds(0));
+    rec.stop();
+
+    INFO("dropped " << rec.droppedBlocks() << " of " << blocks << " blocks");
+    // The writer stalls for 50 ms per write: the full ring drops blocks
+    // instead of making the producer wait
+    REQUIRE(rec.droppedBlocks() > 0);
+    REQUIRE(rec.droppedBlocks() < static_cast<uint64_t>(blocks));
+    // Whatever was accepted is on disk and accounted for
+    REQUIRE(rec.framesWritten() + rec.droppedBlocks() * nframes == static_cast<uint64_t>(blocks * nframes));
+
+    std::vector<float> samples;
+    int channels = 0;
+    REQUIRE(readFrames(path, samples, channels) == static_cast<sf_count_t>(rec.framesWritten()));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Engine feeds an attached recorder from the process path", "[recorder][offline]") {
+    const std::string path = tempPath("engine.wav");
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+    REQUIRE(engine.playBuffer(std::vector<float>(48000, 0.5f), 48000, 1, "bed", 1.0f, 0));
+
+    OutputRecorder rec;
+    OutputRecorder::Options opts;
+    opts.path = path;
+    opts.sampleRate = engine.sampleRate();
+    opts.busCount = engine.busCount();
+    REQUIRE(rec.start(opts));
+    engine.setOutputRecorder(&rec);
+    REQUIRE(engine.outputRecorder() == &rec);
+
+    const int nframes = 512;
+    OutputBuffers out(2, nframes);
+    for (int blk = 0; blk < 10; ++blk) engine.processOffline(nullptr, out.ptrs.data(), nframes);
+
+    engine.setOutputRecorder(nullptr);
+    rec.stop();
+    engine.shutdown();
+
+    std::vector<float> samples;
+    int channels = 0;
+    REQUIRE(readFrames(path, samples, channels) == 10 * nframes);
+    REQUIRE(samples[0] == Approx(0.5f));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,145 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioEngine.h"
+#include "../src/PlayheadManager.h"
+#include "../src/SoundContainer.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QMetaObject>
+#include <QThread>
+#include <QTimer>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+/**
+ * Tests for the playhead clock: interpolation between audio cycles and an
+ * animation timer that stops while idle.
+ */
+
+namespace {
+
+float tick(PlayheadManager* pm, const QString& id, SoundContainer* sc)
+{
+    REQUIRE(QMetaObject::invokeMethod(pm, "onTick", Qt::DirectConnection));
+    return pm->getLastPos(id, sc);
+}
+
+void runEventLoop(int ms)
+{
+    QElapsedTimer t;
+    t.start();
+    while (t.elapsed() < ms) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+        QThread::msleep(1);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Cycle clock is published by every processed cycle", "[playhead][clock]") {
+    AudioEngine engine;
+    REQUIRE(!engine.cycleClock().valid);
+    REQUIRE(engine.initOffline(48000, 1));
+    OutputBuffers out(2, 512);
+    engine.processOffline(nullptr, out.ptrs.data(), 512);
+    const int64_t before = engine.clockUsecs();
+    engine.processOffline(nullptr, out.ptrs.data(), 512);
+
+    const AudioEngine::CycleClock clock = engine.cycleClock();
+    REQUIRE(clock.valid);
+    REQUIRE(clock.frame == 512);   // the second cycle starts after the first
+    REQUIRE(clock.sampleRate == 48000);
+    REQUIRE(clock.periodUsecs == 512 * 1000000 / 48000);
+    REQUIRE(clock.usecs >= before);
+    REQUIRE(clock.usecs <= engine.clockUsecs());
+}
+
+TEST_CASE("The playhead moves between audio cycles and holds when the engine stalls", "[playhead][clock]") {
+    app();
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+    PlayheadManager* pm = PlayheadManager::instance();
+    pm->init(&engine);
+
+    const QString id = "/tmp/playhead_clock.wav";
+    SoundContainer sc;
+    pm->registerContainer(id, &sc, 2.0, 48000);
+
+    std::vector<float> samples(48000 * 2, 0.1f);
+    std::vector<AudioEngine::BatchVoice> batch(1);
+    batch[0].samples = &samples;
+    batch[0].sampleRate = 48000;
+    batch[0].channels = 1;
+    batch[0].id = id.toStdString();
+    REQUIRE(engine.playBatch(batch));
+    pm->playbackStarted(id, &sc);
+
+    // One long cycle (~85 ms): the voice position itself only steps per cycle
+    const int period = 4096;
+    OutputBuffers out(2, period);
+    engine.processOffline(nullptr, out.ptrs.data(), period);
+
+    const float p1 = tick(pm, id, &sc);
+    QThread::msleep(20);
+    const float p2 = tick(pm, id, &sc);
+    REQUIRE(p1 >= 0.0f);
+    REQUIRE(p2 > p1);
+    // 20 ms of a 2 s file, give or take scheduling
+    REQUIRE(p2 - p1 == Approx(0.01f).margin(0.008f));
+
+    // Past the next cycle without new audio: the playhead waits at the cycle end
+    QThread::msleep(150);
+    const float p3 = tick(pm, id, &sc);
+    QThread::msleep(30);
+    const float p4 = tick(pm, id, &sc);
+    REQUIRE(p3 == p4);
+    REQUIRE(p3 == Approx(static_cast<float>(period) / (48000 * 2)).margin(1e-4));
+
+    pm->unregisterContainer(id, &sc);
+    pm->init(nullptr);
+}
+
+TEST_CASE("The animation timer stops while nothing plays", "[playhead][clock]") {
+    app();
+    PlayheadManager* pm = PlayheadManager::instance();
+    pm->init(nullptr);
+    runEventLoop(50);
+    REQUIRE(!pm->isTicking());
+    REQUIRE(pm->tickIntervalMs() >= 8);
+    REQUIRE(pm->tickIntervalMs() <= 33);
+
+    // A short simulated playback wakes the timer, which stops after it ends
+    const QString id = "/tmp/playhead_idle.wav";
+    SoundContainer sc;
+    pm->registerContainer(id, &sc, 0.2, 48000);
+    pm->playbackStarted(id, &sc);
+    REQUIRE(pm->isTicking());
+    runEventLoop(100);
+    REQUIRE(pm->getLastPos(id, &sc) > 0.0f);
+    runEventLoop(300);
+    REQUIRE(pm->getLastPos(id, &sc) == -1.0f);
+    REQUIRE(!pm->isTicking());
+    pm->unregisterContainer(id, &sc);
+}
+
+TEST_CASE("Idle playhead manager CPU cost", "[.][playhead][clock][benchmark]") {
+    app();
+    PlayheadManager* pm = PlayheadManager::instance();
+    pm->init(nullptr);
+    runEventLoop(50);
+    REQUIRE(!pm->isTicking());
+
+    // Idle: no timer, so the event loop sleeps
+    const std::clock_t start = std::clock();
+    QEventLoop loop;
+    QTimer::singleShot(1000, &loop, &QEventLoop::quit);
+    loop.exec();
+    const double cpuMs = 1000.0 * static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    std::cout << "idle playhead manager: " << cpuMs << " ms CPU per second, tick interval "
+              << pm->tickIntervalMs() << " ms while playing" << std::endl;
+    REQUIRE(!pm->isTicking());
+}
@@ -0,0 +1,158 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/PlayheadManager.h"
+#include "../src/SoundContainer.h"
+#include "../src/WaveformWorker.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QDir>
+#include <QGridLayout>
+#include <QLabel>
+#include <QPaintEvent>
+#include <QThread>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+
+/**
+ * Tests for the playhead overlay: ticks repaint only the playhead strips.
+ */
+
+namespace {
+
+// A short take with a waveform, assigned without going through the decoder
+void assignWaveform(SoundContainer& sc, int index)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_playhead_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    const QString path = dir + QString("/take%1.wav").arg(index);
+    std::vector<float> samples(48000 * 2);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = 0.8f * std::sin(static_cast<float>(i) * (0.01f + 0.001f * index));
+    }
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, 48000));
+    sc.setFileWithWaveform(path, WaveformWorker::decodeSamples(samples.data(), samples.size(), 48000, 1, 500, 1.0));
+}
+
+void settle()
+{
+    for (int i = 0; i < 10; ++i) {
+        QCoreApplication::processEvents();
+        QThread::msleep(2);
+    }
+}
+
+// Collects the regions painted on a widget
+class PaintSpy : public QObject {
+public:
+    QRegion painted;
+    int paints = 0;
+
+protected:
+    bool eventFilter(QObject* obj, QEvent* event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            painted += static_cast<QPaintEvent*>(event)->region();
+            ++paints;
+        }
+        return QObject::eventFilter(obj, event);
+    }
+};
+
+qint64 area(const QRegion& region)
+{
+    qint64 total = 0;
+    for (const QRect& r : region) total += static_cast<qint64>(r.width()) * r.height();
+    return total;
+}
+
+} // namespace
+
+TEST_CASE("Playhead ticks leave the waveform pixmap alone", "[playhead][overlay]") {
+    app();
+    SoundContainer sc;
+    sc.resize(320, 140);
+    sc.show();
+    settle();
+    assignWaveform(sc, 0);
+    settle();
+    const qint64 shown = shownPixmap(sc).cacheKey();
+    REQUIRE(shown != 0);
+
+    for (int i = 0; i <= 30; ++i) {
+        sc.setPlayheadPosition(i / 30.0f);
+        QCoreApplication::processEvents();
+    }
+    sc.setPlayheadPosition(-1.0f);
+    settle();
+    REQUIRE(shownPixmap(sc).cacheKey() == shown);
+}
+
+TEST_CASE("A tick repaints only the old and new playhead strips", "[playhead][overlay]") {
+    app();
+    SoundContainer sc;
+    sc.resize(320, 140);
+    sc.show();
+    settle();
+    assignWaveform(sc, 1);
+    sc.setPlayheadPosition(0.1f);
+    settle();
+
+    PaintSpy spy;
+    sc.installEventFilter(&spy);
+    sc.setPlayheadPosition(0.5f);
+    settle();
+    REQUIRE(spy.paints > 0);
+    // Two 5 px strips, far from the whole container
+    REQUIRE(area(spy.painted) * 4 < static_cast<qint64>(sc.width()) * sc.height());
+
+    // Movement below a pixel repaints nothing
+    spy.painted = QRegion();
+    spy.paints = 0;
+    sc.setPlayheadPosition(0.5f + 0.1f / sc.width());
+    settle();
+    REQUIRE(spy.paints == 0);
+
+    // Stopping clears the strip the playhead was in
+    sc.setPlayheadPosition(-1.0f);
+    settle();
+    REQUIRE(spy.paints > 0);
+    sc.removeEventFilter(&spy);
+}
+
+TEST_CASE("Playhead CPU cost with many playing containers", "[.][playhead][overlay][benchmark]") {
+    app();
+    const int containers = 20;
+    // Two seconds of PlayheadManager ticks, at its display-refresh interval
+    const int intervalMs = PlayheadManager::instance()->tickIntervalMs();
+    const int ticks = 2000 / intervalMs;
+    QWidget grid;
+    auto* layout = new QGridLayout(&grid);
+    std::vector<SoundContainer*> playing;
+    for (int i = 0; i < containers; ++i) {
+        auto* sc = new SoundContainer(&grid);
+        layout->addWidget(sc, i / 5, i % 5);
+        playing.push_back(sc);
+    }
+    grid.resize(1600, 720);
+    grid.show();
+    settle();
+    for (int i = 0; i < containers; ++i) assignWaveform(*playing[i], i);
+    settle();
+    std::vector<qint64> shown;
+    for (SoundContainer* sc : playing) shown.push_back(shownPixmap(*sc).cacheKey());
+
+    const std::clock_t start = std::clock();
+    for (int t = 0; t < ticks; ++t) {
+        for (int i = 0; i < containers; ++i) playing[i]->setPlayheadPosition((t + i) / static_cast<float>(ticks + containers));
+        QCoreApplication::processEvents();
+    }
+    const double cpuMs = 1000.0 * static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    std::cout << containers << " playing containers, " << ticks << " ticks: " << cpuMs << " ms CPU ("
+              << cpuMs / (ticks * intervalMs / 1000.0) / 10.0 << "% of a core at " << 1000 / intervalMs << " Hz, "
+              << 1000.0 * cpuMs / (ticks * containers) << " us per container tick)" << std::endl;
+    for (int i = 0; i < containers; ++i) REQUIRE(shownPixmap(*playing[i]).cacheKey() == shown[i]);
+}
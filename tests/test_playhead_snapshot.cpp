@@ -0,0 +1,210 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioEngine.h"
+#include "../src/PlayheadManager.h"
+#include "../src/SoundContainer.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QThread>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/**
+ * Tests for the batched voice position snapshot the playhead tick reads.
+ */
+
+namespace {
+
+QString slotId(int i)
+{
+    return QString("/tmp/playhead_snapshot/slot%1.wav").arg(i);
+}
+
+// `playing` one-second mono voices with ids slotId(0..playing-1), started
+// together and mixed for `period` frames
+void startVoices(AudioEngine& engine, int playing, int period)
+{
+    static const std::vector<float> samples(48000, 0.01f);
+    std::vector<AudioEngine::BatchVoice> batch(playing);
+    for (int i = 0; i < playing; ++i) {
+        batch[i].samples = &samples;
+        batch[i].sampleRate = 48000;
+        batch[i].channels = 1;
+        batch[i].id = slotId(i).toStdString();
+    }
+    REQUIRE(engine.playBatch(batch));
+    OutputBuffers out(2, period);
+    engine.processOffline(nullptr, out.ptrs.data(), period);
+}
+
+} // namespace
+
+TEST_CASE("The snapshot matches the per-id queries", "[playhead][snapshot]") {
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+    const uint64_t a = engine.voiceHandle("a");
+    REQUIRE(a != 0);
+    REQUIRE(engine.voiceHandle("a") == a);
+    REQUIRE(engine.voiceHandle("b") != a);
+    REQUIRE(engine.voiceHandle("") == 0);
+
+    std::vector<float> samples(48000, 0.01f);
+    std::vector<AudioEngine::BatchVoice> batch(3);
+    const char* ids[] = {"a", "b", ""};
+    for (int i = 0; i < 3; ++i) {
+        batch[i].samples = &samples;
+        batch[i].sampleRate = 48000;
+        batch[i].channels = 1;
+        batch[i].id = ids[i];
+        batch[i].offsetFrames = 100 * i;
+    }
+    REQUIRE(engine.playBatch(batch));
+    OutputBuffers out(2, 512);
+    engine.processOffline(nullptr, out.ptrs.data(), 512);
+
+    // Too small an array: the count says how much room is needed
+    std::vector<AudioEngine::VoicePosition> positions(1);
+    REQUIRE(engine.fillPlaybackSnapshot(positions.data(), positions.size()) == 3);
+    positions.resize(8);
+    REQUIRE(engine.fillPlaybackSnapshot(positions.data(), positions.size()) == 3);
+
+    for (int i = 0; i < 3; ++i) {
+        const AudioEngine::VoicePosition& p = positions[i];
+        REQUIRE(p.handle == engine.voiceHandle(ids[i]));
+        if (p.handle == 0) continue;
+        const AudioEngine::PlaybackInfo info = engine.getPlaybackInfoForId(ids[i]);
+        REQUIRE(info.found);
+        REQUIRE(p.frames == info.frames);
+        REQUIRE(p.totalFrames == info.totalFrames);
+        REQUIRE(p.sampleRate == info.sampleRate);
+        REQUIRE(p.startFrame == info.startFrame);
+    }
+}
+
+TEST_CASE("Ids without a voice are dropped when voices stop", "[playhead][snapshot]") {
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+    startVoices(engine, 2, 512);
+    const uint64_t playing = engine.voiceHandle(slotId(0).toStdString());
+    const uint64_t stopped = engine.voiceHandle(slotId(1).toStdString());
+    const uint64_t idle = engine.voiceHandle("idle");
+    const uint64_t generation = engine.voiceHandleGeneration();
+
+    engine.stopVoicesById(slotId(1).toStdString());
+    REQUIRE(engine.voiceHandleGeneration() != generation);
+    // A playing id keeps its handle; dropped ids come back with new ones
+    REQUIRE(engine.voiceHandle(slotId(0).toStdString()) == playing);
+    const uint64_t again = engine.voiceHandle(slotId(1).toStdString());
+    REQUIRE(again != stopped);
+    REQUIRE(again != idle);
+    REQUIRE(engine.voiceHandle("idle") != idle);
+}
+
+TEST_CASE("Playheads follow their voices through the batched tick", "[playhead][snapshot]") {
+    app();
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+    PlayheadManager pm;
+    pm.init(&engine);
+
+    const int slots = 128;
+    const int playing = 32;
+    const int period = 4096;
+    std::vector<std::unique_ptr<SoundContainer>> containers;
+    for (int i = 0; i < slots; ++i) {
+        containers.push_back(std::make_unique<SoundContainer>());
+        // Distinct durations so a mixed-up join shows
+        pm.registerContainer(slotId(i), containers.back().get(), 1.0 + i * 0.01, 48000);
+    }
+    startVoices(engine, playing, period);
+    // Past the cycle end, so interpolation holds at the period
+    QThread::msleep(120);
+    REQUIRE(QMetaObject::invokeMethod(&pm, "onTick", Qt::DirectConnection));
+
+    for (int i = 0; i < slots; ++i) {
+        const float pos = pm.getLastPos(slotId(i), containers[i].get());
+        if (i < playing) REQUIRE(pos == Approx(period / 48000.0 / (1.0 + i * 0.01)).margin(1e-4));
+        else REQUIRE(pos == -1.0f);
+    }
+
+    // Stopping a voice drops its id; the restarted voice is found under its new handle
+    engine.stopVoicesById(slotId(0).toStdString());
+    REQUIRE(QMetaObject::invokeMethod(&pm, "onTick", Qt::DirectConnection));
+    REQUIRE(pm.getLastPos(slotId(0), containers[0].get()) == -1.0f);
+    std::vector<AudioEngine::BatchVoice> restart(1);
+    static const std::vector<float> samples(48000, 0.01f);
+    restart[0].samples = &samples;
+    restart[0].sampleRate = 48000;
+    restart[0].channels = 1;
+    restart[0].id = slotId(0).toStdString();
+    REQUIRE(engine.playBatch(restart));
+    OutputBuffers out(2, period);
+    engine.processOffline(nullptr, out.ptrs.data(), period);
+    QThread::msleep(120);
+    REQUIRE(QMetaObject::invokeMethod(&pm, "onTick", Qt::DirectConnection));
+    REQUIRE(pm.getLastPos(slotId(0), containers[0].get()) == Approx(period / 48000.0).margin(1e-4));
+
+    for (int i = 0; i < slots; ++i) pm.unregisterContainer(slotId(i), containers[i].get());
+}
+
+TEST_CASE("Tick cost with 128 slots and 32 voices", "[.][playhead][snapshot][benchmark]") {
+    app();
+    AudioEngine engine;
+    REQUIRE(engine.initOffline(48000, 1));
+    PlayheadManager pm;
+    pm.init(&engine);
+
+    const int slots = 128;
+    const int playing = 32;
+    const int ticks = 2000;
+    std::vector<std::unique_ptr<SoundContainer>> containers;
+    std::vector<QString> ids;
+    for (int i = 0; i < slots; ++i) {
+        ids.push_back(slotId(i));
+        containers.push_back(std::make_unique<SoundContainer>());
+        pm.registerContainer(ids.back(), containers.back().get(), 1.0, 48000);
+    }
+    startVoices(engine, playing, 512);
+
+    // Previous tick: a string scan of the voice snapshot per registered id
+    QElapsedTimer t;
+    t.start();
+    int found = 0;
+    for (int n = 0; n < ticks; ++n) {
+        for (const QString& id : ids) found += engine.getPlaybackInfoForId(id.toStdString()).found ? 1 : 0;
+    }
+    const double perIdUs = t.nsecsElapsed() / 1e3 / ticks;
+    REQUIRE(found == playing * ticks);
+
+    // Batched: one snapshot pass, then a sorted join on the handles
+    std::vector<uint64_t> handles;
+    for (const QString& id : ids) handles.push_back(engine.voiceHandle(id.toStdString()));
+    std::vector<AudioEngine::VoicePosition> positions(64);
+    std::vector<uint64_t> order;
+    order.reserve(64);
+    found = 0;
+    t.restart();
+    for (int n = 0; n < ticks; ++n) {
+        const size_t voices = engine.fillPlaybackSnapshot(positions.data(), positions.size());
+        order.clear();
+        for (size_t i = 0; i < voices; ++i) order.push_back(positions[i].handle);
+        std::sort(order.begin(), order.end());
+        for (uint64_t h : handles) found += std::binary_search(order.begin(), order.end(), h) ? 1 : 0;
+    }
+    const double batchedUs = t.nsecsElapsed() / 1e3 / ticks;
+    REQUIRE(found == playing * ticks);
+
+    // The whole tick, playhead updates included
+    t.restart();
+    for (int n = 0; n < ticks; ++n) QMetaObject::invokeMethod(&pm, "onTick", Qt::DirectConnection);
+    const double tickUs = t.nsecsElapsed() / 1e3 / ticks;
+
+    std::cout << slots << " slots, " << playing << " voices: per-id lookups " << perIdUs
+              << " us, batched snapshot + join " << batchedUs << " us, full tick " << tickUs << " us" << std::endl;
+    for (int i = 0; i < slots; ++i) pm.unregisterContainer(ids[i], containers[i].get());
+}
@@ -54,12 +54,12 @@ TEST_CASE("SoundContainer caching flow writes cache file", "[waveform][cache][in
     QString cacheDir = WaveformCache::cacheDirPath();
     QDir d(cacheDir);
 
-    // Wait up to 10 seconds for any cache png to appear
+    // Wait up to 10 seconds for the peak file to appear
     QElapsedTimer et; et.start();
     bool found = false;
     while (et.elapsed() < 10000) {
         QCoreApplication::processEvents();
-        QStringList files = d.entryList(QStringList() << "*.png", QDir::Files | QDir::NoDotAndDotDot);
+        QStringList files = d.entryList(QStringList() << "*.peaks", QDir::Files | QDir::NoDotAndDotDot);
         if (!files.isEmpty()) { found = true; break; }
         QThread::msleep(100);
     }
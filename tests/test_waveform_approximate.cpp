@@ -0,0 +1,116 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/WaveformJobService.h"
+#include "../src/WaveformWorker.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/**
+ * Tests for the seek-sampled approximate waveform and its refinement.
+ */
+
+namespace {
+
+QCoreApplication* app()
+{
+    static int argc = 1;
+    static char name[] = "tests_waveform_approximate";
+    static char* argv[] = {name, nullptr};
+    static QCoreApplication* a = new QCoreApplication(argc, argv);
+    return a;
+}
+
+// A fast sine under an envelope rising linearly from 0 to 1
+QString makeRamp(const QString& name, int seconds)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_approx_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    const QString path = dir + "/" + name;
+    const size_t frames = static_cast<size_t>(48000) * seconds;
+    std::vector<float> samples(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        const float envelope = static_cast<float>(i) / static_cast<float>(frames);
+        samples[i] = envelope * std::sin(static_cast<float>(i) * 0.2f);
+    }
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, 48000));
+    return path;
+}
+
+} // namespace
+
+TEST_CASE("Sampled overview follows the exact waveform", "[waveform][approximate]") {
+    const QString path = makeRamp("ramp.wav", 180);
+    const WaveformResult approx = WaveformWorker::decodeApproximate(path, 500, 1.0);
+    const WaveformResult exact = WaveformWorker::decodeFile(path, 500, 1.0);
+
+    REQUIRE(approx.sampleRate == 48000);
+    REQUIRE(approx.approximate);
+    REQUIRE(!exact.approximate);
+    REQUIRE(approx.peaks.isValid());
+    REQUIRE(approx.peaks.totalFrames == exact.peaks.totalFrames);
+    REQUIRE(approx.min.size() == exact.min.size());
+    // Each window sits mid-column, where the envelope is half a column
+    // below the column's end
+    for (int x = 0; x < approx.max.size(); ++x) {
+        REQUIRE(approx.max[x] == Approx(exact.max[x]).margin(0.01));
+        REQUIRE(approx.min[x] == -approx.max[x]);
+    }
+}
+
+TEST_CASE("Short files are not sampled", "[waveform][approximate]") {
+    const QString path = makeRamp("short.wav", 5);
+    REQUIRE(WaveformWorker::decodeApproximate(path, 500, 1.0).sampleRate == 0);
+}
+
+TEST_CASE("Approximate-first delivers the overview, then the exact waveform", "[waveform][approximate]") {
+    app();
+    const QString path = makeRamp("service.wav", 180);
+    WaveformJobService::setApproximateFirst(true);
+
+    WaveformWorker worker;
+    std::vector<bool> partials;     // approximate flag of each partial
+    int ready = 0;
+    bool finalExact = false;
+    QObject::connect(&worker, &WaveformWorker::waveformPartial, &worker,
+                     [&](const WaveformJob&, const WaveformResult& r) { partials.push_back(r.approximate); });
+    QObject::connect(&worker, &WaveformWorker::waveformReady, &worker, [&](const WaveformJob&, const WaveformResult& r) {
+        ++ready;
+        finalExact = !r.approximate && r.progress == 1.0;
+    });
+    worker.enqueueJob(path, 500, 1.0);
+
+    QElapsedTimer t;
+    t.start();
+    while (ready == 0 && t.elapsed() < 30000) {
+        QCoreApplication::processEvents();
+        QThread::msleep(5);
+    }
+    WaveformJobService::setApproximateFirst(false);
+
+    REQUIRE(ready == 1);
+    REQUIRE(finalExact);
+    // The refinement pass sends no partly silent partials over the overview
+    REQUIRE(partials == std::vector<bool>{true});
+}
+
+TEST_CASE("Approximate and exact decode cost of a long file", "[.][waveform][approximate][benchmark]") {
+    const QString path = makeRamp("bench.wav", 180);
+    QElapsedTimer t;
+    t.start();
+    const WaveformResult approx = WaveformWorker::decodeApproximate(path, 500, 1.0);
+    const double approxMs = t.nsecsElapsed() / 1e6;
+    t.restart();
+    const WaveformResult exact = WaveformWorker::decodeFile(path, 500, 1.0);
+    const double exactMs = t.nsecsElapsed() / 1e6;
+    REQUIRE(approx.sampleRate > 0);
+    REQUIRE(exact.sampleRate > 0);
+
+    std::cout << "3 min file at 500 px: approximate " << approxMs << " ms, exact " << exactMs << " ms" << std::endl;
+}
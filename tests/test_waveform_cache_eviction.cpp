@@ -43,6 +43,9 @@ TEST_CASE("WaveformCache eviction reduces total size", "[waveform][cache][evict]
         QThread::msleep(10);
     }
 
+    // Writes are queued; wait for them to reach the disk
+    WaveformCache::flush();
+
     // Compute total size
     QDir d(cacheDir);
     qint64 total = 0;
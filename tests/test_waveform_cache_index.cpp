@@ -0,0 +1,106 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformCache.h"
+#include "../src/WaveformCacheIndex.h"
+#include "TestHelpers.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonObject>
+#include <iostream>
+
+/**
+ * Tests for the persistent waveform cache index used by loadBest.
+ */
+
+namespace {
+
+QString writeEntry(const QString& path, qint64 mtime, int width)
+{
+    QImage img(width, 10, QImage::Format_ARGB32);
+    img.fill(Qt::black);
+    const QString key = WaveformCache::makeKey(path, 100, mtime, 1, 44100, 1.0f, width);
+    REQUIRE(WaveformCache::write(key, img, makeCacheMeta(path, mtime, width)));
+    WaveformCache::flush();
+    return key;
+}
+
+} // namespace
+
+TEST_CASE("loadBest picks the closest width from the index", "[waveform][cache][index]") {
+    useTempCacheDir("index", "best");
+    writeEntry("/tmp/a.wav", 1, 200);
+    writeEntry("/tmp/a.wav", 1, 500);
+    writeEntry("/tmp/a.wav", 1, 800);
+    writeEntry("/tmp/b.wav", 1, 300);
+
+    QJsonObject meta;
+    REQUIRE(!WaveformCache::loadBest("/tmp/a.wav", 100, 1, 1, 44100, 1.0f, 400, &meta).isNull());
+    REQUIRE(meta.value("pixelWidth").toInt() == 500);
+    REQUIRE(!WaveformCache::loadBest("/tmp/a.wav", 100, 1, 1, 44100, 1.0f, 1000, &meta).isNull());
+    REQUIRE(meta.value("pixelWidth").toInt() == 800);
+    // Another mtime is another identity
+    REQUIRE(WaveformCache::loadBest("/tmp/a.wav", 100, 2, 1, 44100, 1.0f, 400, &meta).isNull());
+
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Index persists and is updated on eviction", "[waveform][cache][index]") {
+    useTempCacheDir("index", "persist");
+    const QString k200 = writeEntry("/tmp/a.wav", 1, 200);
+    writeEntry("/tmp/a.wav", 1, 500);
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == 2);
+
+    // Replaying the file gives the same state
+    WaveformCacheIndex::instance().reset();
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == 2);
+    REQUIRE(WaveformCacheIndex::instance().candidates(WaveformCache::cacheDirPath(), "/tmp/a.wav", 100, 1, 1, 44100, 1.0f).size() == 2);
+
+    // Files removed behind the index's back are dropped on lookup
+    QDir d(WaveformCache::cacheDirPath());
+    QFile::remove(d.filePath(k200 + ".png"));
+    QFile::remove(d.filePath(k200 + ".json"));
+    QJsonObject meta;
+    WaveformCache::loadBest("/tmp/a.wav", 100, 1, 1, 44100, 1.0f, 100, &meta);
+    WaveformCacheIndex::instance().reset();
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == 1);
+
+    // A corrupt index is rebuilt from the sidecars
+    QFile f(d.filePath(WaveformCacheIndex::indexFileName()));
+    REQUIRE(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write("junk");
+    f.close();
+    WaveformCacheIndex::instance().reset();
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == 1);
+
+    WaveformCache::clearAll();
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == 0);
+}
+
+TEST_CASE("Index lookups do not scale with cache size", "[.][waveform][cache][index][benchmark]") {
+    useTempCacheDir("index", "bench");
+    const int entries = 2000;
+    for (int i = 0; i < entries; ++i) writeEntry(QString("/tmp/bench%1.wav").arg(i), 1, 64);
+
+    WaveformCacheIndex::instance().reset();
+    QElapsedTimer t;
+    t.start();
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == entries);
+    const double loadMs = t.nsecsElapsed() / 1e6;
+
+    t.restart();
+    const int lookups = 1000;
+    for (int i = 0; i < lookups; ++i) {
+        // Misses at other widths go through the index, not the directory
+        QJsonObject meta;
+        REQUIRE(!WaveformCache::loadBest(QString("/tmp/bench%1.wav").arg(i), 100, 1, 1, 44100, 1.0f, 60, &meta).isNull());
+    }
+    const double lookupMs = t.nsecsElapsed() / 1e6 / lookups;
+
+    std::cout << "cache index with " << entries << " entries: load " << loadMs << " ms, loadBest miss "
+              << lookupMs << " ms per lookup" << std::endl;
+
+    WaveformCache::clearAll();
+}
@@ -0,0 +1,158 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/PreferencesManager.h"
+#include "../src/WaveformCache.h"
+#include "../src/WaveformCacheIndex.h"
+#include "TestHelpers.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QThread>
+#include <iostream>
+
+/**
+ * Tests for index-driven waveform cache eviction (access-time LRU).
+ */
+
+namespace {
+
+// A temporary cache directory with the preferences soft limit set
+void useLimitedCacheDir(const QString& name, int softLimitMB)
+{
+    QStandardPaths::setTestModeEnabled(true);
+    PreferencesManager::instance().setCacheSoftLimitMB(softLimitMB);
+    PreferencesManager::instance().setCacheTtlDays(3650);
+    useTempCacheDir("lru", name);
+}
+
+// Noise does not compress, so the PNG size is close to w * h * 4
+QString writeEntry(const QString& path, int w, int h)
+{
+    QImage img(w, h, QImage::Format_ARGB32);
+    QRandomGenerator rng(static_cast<quint32>(qHash(path)));
+    for (int y = 0; y < h; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
+        for (int x = 0; x < w; ++x) line[x] = rng.generate();
+    }
+    const QString key = WaveformCache::makeKey(path, 100, 1, 1, 44100, 1.0f, w);
+    REQUIRE(WaveformCache::write(key, img, makeCacheMeta(path, 1, w)));
+    WaveformCache::flush();
+    return key;
+}
+
+bool exists(const QString& key)
+{
+    return QFile::exists(QDir(WaveformCache::cacheDirPath()).filePath(key + ".png"));
+}
+
+qint64 diskBytes()
+{
+    QDir d(WaveformCache::cacheDirPath());
+    qint64 total = 0;
+    for (const QFileInfo& fi : d.entryInfoList(QStringList() << "*.png" << "*.json" << "*.peaks", QDir::Files)) {
+        total += fi.size();
+    }
+    return total;
+}
+
+} // namespace
+
+TEST_CASE("The index total matches the files on disk", "[waveform][cache][lru]") {
+    useLimitedCacheDir("total", 200);
+    for (int i = 0; i < 5; ++i) writeEntry(QString("/tmp/t%1.wav").arg(i), 64 + i * 16, 16);
+    REQUIRE(WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath()) == diskBytes());
+
+    // Replaying the file and rebuilding from the directory agree
+    WaveformCacheIndex::instance().reset();
+    REQUIRE(WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath()) == diskBytes());
+    QFile::remove(QDir(WaveformCache::cacheDirPath()).filePath(WaveformCacheIndex::indexFileName()));
+    WaveformCacheIndex::instance().reset();
+    REQUIRE(WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath()) == diskBytes());
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Eviction removes the least recently used entries first", "[waveform][cache][lru]") {
+    useLimitedCacheDir("order", 200);
+    const QString a = writeEntry("/tmp/a.wav", 64, 16);
+    const QString b = writeEntry("/tmp/b.wav", 64, 16);
+    const QString c = writeEntry("/tmp/c.wav", 64, 16);
+
+    // A hit on the oldest entry makes it the most recently used
+    REQUIRE(!WaveformCache::load(a).isNull());
+    const qint64 total = WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath());
+    const QVector<WaveformCacheIndex::Victim> victims = WaveformCacheIndex::instance().takeVictims(WaveformCache::cacheDirPath(), total - 1);
+    REQUIRE(victims.size() == 1);
+    REQUIRE(victims.front().key == b);
+
+    // The order survives a reload of the index file once the hits are flushed
+    WaveformCache::flush();
+    WaveformCacheIndex::instance().reset();
+    const QVector<WaveformCacheIndex::Victim> next = WaveformCacheIndex::instance().takeVictims(WaveformCache::cacheDirPath(), 0);
+    REQUIRE(next.size() == 2);
+    REQUIRE(next[0].key == c);
+    REQUIRE(next[1].key == a);
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Cache hits reach the index file in one batch", "[waveform][cache][lru]") {
+    useLimitedCacheDir("hits", 200);
+    const QString a = writeEntry("/tmp/ha.wav", 64, 16);
+    const QString b = writeEntry("/tmp/hb.wav", 64, 16);
+    const QString indexPath = QDir(WaveformCache::cacheDirPath()).filePath(WaveformCacheIndex::indexFileName());
+    const qint64 before = QFileInfo(indexPath).size();
+
+    // Hits only change the in-memory state
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(!WaveformCache::load(a).isNull());
+        REQUIRE(!WaveformCache::load(b).isNull());
+    }
+    REQUIRE(QFileInfo(indexPath).size() == before);
+
+    // One record per touched entry, however often it was hit
+    WaveformCache::flush();
+    const qint64 recordBytes = WaveformCacheIndex::kRecordHeaderBytes + a.toUtf8().size();
+    REQUIRE(QFileInfo(indexPath).size() == before + 2 * recordBytes);
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Writes past the soft limit evict in the background", "[waveform][cache][lru]") {
+    useLimitedCacheDir("background", 1);
+    QStringList keys;
+    // About 256 KB each
+    for (int i = 0; i < 8; ++i) keys << writeEntry(QString("/tmp/bg%1.wav").arg(i), 256, 256);
+
+    REQUIRE(diskBytes() <= 1024 * 1024);
+    REQUIRE(WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath()) == diskBytes());
+    REQUIRE(!exists(keys.front()));
+    REQUIRE(exists(keys.back()));
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("evict() honors the preferences limit without scanning the directory", "[.][waveform][cache][lru][benchmark]") {
+    useLimitedCacheDir("bench", 200);
+    const int entries = 2000;
+    for (int i = 0; i < entries; ++i) writeEntry(QString("/tmp/bench%1.wav").arg(i), 32, 8);
+
+    QElapsedTimer t;
+    t.start();
+    WaveformCache::evict();
+    const double underLimitMs = t.nsecsElapsed() / 1e6;
+    REQUIRE(WaveformCacheIndex::instance().entryCount(WaveformCache::cacheDirPath()) == entries);
+
+    // Halve the cache: only the removed entries are visited
+    const qint64 half = WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath()) / 2;
+    t.restart();
+    const QVector<WaveformCacheIndex::Victim> victims = WaveformCacheIndex::instance().takeVictims(WaveformCache::cacheDirPath(), half);
+    const double selectMs = t.nsecsElapsed() / 1e6;
+    REQUIRE(WaveformCacheIndex::instance().totalBytes(WaveformCache::cacheDirPath()) <= half);
+    REQUIRE(!victims.isEmpty());
+
+    std::cout << "cache eviction with " << entries << " entries: evict() under the limit " << underLimitMs
+              << " ms, selecting " << victims.size() << " LRU victims " << selectMs << " ms" << std::endl;
+    WaveformCache::clearAll();
+}
@@ -0,0 +1,143 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformCache.h"
+#include "../src/WaveformCacheProbe.h"
+#include "../src/WaveformPyramid.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+/**
+ * Tests for asynchronous, prioritized waveform cache probes.
+ */
+
+namespace {
+
+QCoreApplication* app()
+{
+    static int argc = 1;
+    static char name[] = "tests_waveform_cache_probe";
+    static char* argv[] = {name, nullptr};
+    static QCoreApplication* a = new QCoreApplication(argc, argv);
+    return a;
+}
+
+QString makeSource(const QString& name, bool withPeaks)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_probe_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    qputenv("LIBRE_WAVEFORM_CACHE_DIR", (dir + "/cache").toUtf8());
+    const QString path = dir + "/" + name;
+    QFile f(path);
+    REQUIRE(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    f.write(QByteArray(256, 'x'));
+    f.close();
+    if (withPeaks) {
+        QVector<float> samples(48000);
+        for (int i = 0; i < samples.size(); ++i) samples[i] = static_cast<float>(std::sin(i * 0.01));
+        WaveformPeaks peaks;
+        peaks.sampleRate = 48000;
+        peaks.channels = 1;
+        peaks.totalFrames = samples.size();
+        peaks.levels = WaveformPyramid::build(samples, 1, 256);
+        QFileInfo fi(path);
+        const qint64 mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+        REQUIRE(WaveformCache::writePeaks(WaveformCache::makePeakKey(path, fi.size(), mtimeMs), peaks, fi.size(), mtimeMs));
+    }
+    return path;
+}
+
+void drain()
+{
+    WaveformCacheProbe::instance().waitForDone();
+    QCoreApplication::processEvents();
+}
+
+} // namespace
+
+TEST_CASE("Probe renders cache hits at the requested size", "[waveform][cache][probe]") {
+    app();
+    const QString hitPath = makeSource("hit.raw", true);
+    const QString missPath = makeSource("miss.raw", false);
+    WaveformCache::flush();
+
+    QObject owner;
+    std::vector<WaveformCacheProbe::Result> results;
+    auto collect = [&](const WaveformCacheProbe::Result& r) { results.push_back(r); };
+    const quint64 hitId = WaveformCacheProbe::instance().request(&owner, hitPath, QSize(120, 40), true, collect);
+    const quint64 missId = WaveformCacheProbe::instance().request(&owner, missPath, QSize(120, 40), true, collect);
+    drain();
+
+    REQUIRE(results.size() == 2);
+    for (const auto& r : results) {
+        if (r.id == hitId) {
+            REQUIRE(r.hit);
+            REQUIRE(r.peaks.totalFrames() == 48000);
+            REQUIRE(r.image.size() == QSize(120, 40));
+        } else {
+            REQUIRE(r.id == missId);
+            REQUIRE_FALSE(r.hit);
+            REQUIRE(r.image.isNull());
+        }
+    }
+    REQUIRE(WaveformCacheProbe::instance().visibleOutstanding() == 0);
+}
+
+TEST_CASE("Visible probes are served before background probes", "[waveform][cache][probe]") {
+    app();
+    const QString path = makeSource("prio.raw", true);
+    WaveformCache::flush();
+
+    QObject background;
+    QObject visible;
+    std::vector<bool> order;    // true for the visible result
+    const int backgroundCount = 2000;
+    for (int i = 0; i < backgroundCount; ++i) {
+        WaveformCacheProbe::instance().request(&background, path, QSize(200, 40), false,
+            [&](const WaveformCacheProbe::Result&) { order.push_back(false); });
+    }
+    WaveformCacheProbe::instance().request(&visible, path, QSize(200, 40), true,
+        [&](const WaveformCacheProbe::Result&) { order.push_back(true); });
+    drain();
+
+    REQUIRE(order.size() == static_cast<size_t>(backgroundCount + 1));
+    const auto pos = std::find(order.begin(), order.end(), true) - order.begin();
+    INFO("visible result delivered at position " << pos);
+    REQUIRE(pos < backgroundCount / 2);
+}
+
+TEST_CASE("Promoted and cancelled probes update the visible count", "[waveform][cache][probe]") {
+    app();
+    const QString path = makeSource("cancel.raw", true);
+    WaveformCache::flush();
+
+    int idleSignals = 0;
+    QObject context;
+    QObject::connect(&WaveformCacheProbe::instance(), &WaveformCacheProbe::visibleIdle, &context, [&]() { ++idleSignals; });
+
+    auto owner = std::make_unique<QObject>();
+    int delivered = 0;
+    for (int i = 0; i < 500; ++i) {
+        WaveformCacheProbe::instance().request(owner.get(), path, QSize(64, 16), false,
+            [&](const WaveformCacheProbe::Result&) { ++delivered; });
+    }
+    WaveformCacheProbe::instance().promote(owner.get());
+    REQUIRE(WaveformCacheProbe::instance().visibleOutstanding() > 0);
+
+    // Destroying the owner: queued probes are dropped, in-flight ones are
+    // not delivered
+    WaveformCacheProbe::instance().cancel(owner.get());
+    owner.reset();
+    drain();
+    REQUIRE(delivered == 0);
+    REQUIRE(WaveformCacheProbe::instance().visibleOutstanding() == 0);
+    REQUIRE(idleSignals >= 1);
+}
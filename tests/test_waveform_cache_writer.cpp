@@ -0,0 +1,120 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformCache.h"
+#include "../src/WaveformCacheWriter.h"
+#include "TestHelpers.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonObject>
+#include <iostream>
+
+/**
+ * Tests for the write-behind waveform cache writer.
+ */
+
+namespace {
+
+QImage makeImage(int w, int h, QRgb color)
+{
+    QImage img(w, h, QImage::Format_ARGB32);
+    img.fill(color);
+    return img;
+}
+
+int countFiles(const QString& pattern)
+{
+    QDir d(WaveformCache::cacheDirPath());
+    return d.entryList(QStringList() << pattern, QDir::Files).size();
+}
+
+} // namespace
+
+TEST_CASE("Queued writes are readable before they reach the disk", "[waveform][cache][writer]") {
+    useTempCacheDir("writer", "read");
+    const QString key = WaveformCache::makeKey("/tmp/w.wav", 100, 1, 1, 44100, 1.0f, 64);
+    REQUIRE(WaveformCache::write(key, makeImage(64, 8, qRgb(255, 0, 0)), makeCacheMeta("/tmp/w.wav", 1, 64)));
+    QImage loaded = WaveformCache::load(key);
+    REQUIRE(!loaded.isNull());
+    REQUIRE(loaded.width() == 64);
+
+    WaveformCache::flush();
+    REQUIRE(WaveformCacheWriter::instance().pendingCount() == 0);
+    REQUIRE(countFiles("*.png") == 1);
+    REQUIRE(countFiles("*.json") == 1);
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Rewrites of a key leave only the latest data on disk", "[waveform][cache][writer]") {
+    useTempCacheDir("writer", "coalesce");
+    const QString key = WaveformCache::makeKey("/tmp/w.wav", 100, 1, 1, 44100, 1.0f, 64);
+    for (int i = 0; i < 20; ++i) {
+        WaveformCache::write(key, makeImage(64, 8, qRgb(i, 0, 0)), makeCacheMeta("/tmp/w.wav", 1, 64));
+    }
+    WaveformCache::flush();
+    REQUIRE(countFiles("*.png") == 1);
+    QImage loaded = WaveformCache::load(key);
+    REQUIRE(!loaded.isNull());
+    REQUIRE(qRed(loaded.pixel(0, 0)) == 19);
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("The backlog is bounded and drops the oldest writes", "[waveform][cache][writer]") {
+    useTempCacheDir("writer", "bounded");
+    const quint64 droppedBefore = WaveformCacheWriter::instance().droppedCount();
+    const int writes = WaveformCacheWriter::kMaxPending * 4;
+    for (int i = 0; i < writes; ++i) {
+        const QString path = QString("/tmp/w%1.wav").arg(i);
+        WaveformCache::write(WaveformCache::makeKey(path, 100, 1, 1, 44100, 1.0f, 256),
+                             makeImage(256, 32, qRgb(i & 0xff, 0, 0)), makeCacheMeta(path, 1, 256));
+        REQUIRE(WaveformCacheWriter::instance().pendingCount() <= WaveformCacheWriter::kMaxPending + 1);
+    }
+    WaveformCache::flush();
+    const quint64 dropped = WaveformCacheWriter::instance().droppedCount() - droppedBefore;
+    REQUIRE(countFiles("*.png") + static_cast<int>(dropped) == writes);
+    WaveformCache::clearAll();
+}
+
+TEST_CASE("Queued writes land in the directory current when they were queued", "[waveform][cache][writer]") {
+    useTempCacheDir("writer", "first");
+    const QString first = WaveformCache::cacheDirPath();
+    const QString key = WaveformCache::makeKey("/tmp/w.wav", 100, 1, 1, 44100, 1.0f, 64);
+    REQUIRE(WaveformCache::write(key, makeImage(64, 8, qRgb(0, 255, 0)), makeCacheMeta("/tmp/w.wav", 1, 64)));
+    // The writer uses the directory stored with the job, not the preferences
+    qputenv("LIBRE_WAVEFORM_CACHE_DIR", (first + "_moved").toUtf8());
+    WaveformCache::flush();
+    REQUIRE(countFiles("*.png") == 0);
+    REQUIRE(QFile::exists(QDir(first).filePath(key + ".png")));
+    QFile::remove(QDir(first).filePath(key + ".png"));
+    QFile::remove(QDir(first).filePath(key + ".json"));
+}
+
+TEST_CASE("Synchronous and queued cache write cost", "[.][waveform][cache][writer][benchmark]") {
+    useTempCacheDir("writer", "bench");
+    const int count = 64;
+    QElapsedTimer t;
+
+    const QString dir = WaveformCache::cacheDirPath();
+    t.start();
+    for (int i = 0; i < count; ++i) {
+        const QString path = QString("/tmp/sync%1.wav").arg(i);
+        WaveformCache::writeImageFile(dir, WaveformCache::makeKey(path, 100, 1, 1, 44100, 2.0f, 500),
+                                      makeImage(1000, 128, qRgb(i, 80, 160)), makeCacheMeta(path, 1, 500));
+    }
+    const double syncMs = t.nsecsElapsed() / 1e6;
+
+    t.restart();
+    for (int i = 0; i < count; ++i) {
+        const QString path = QString("/tmp/async%1.wav").arg(i);
+        WaveformCache::write(WaveformCache::makeKey(path, 100, 1, 1, 44100, 2.0f, 500),
+                             makeImage(1000, 128, qRgb(i, 80, 160)), makeCacheMeta(path, 1, 500));
+    }
+    const double enqueueMs = t.nsecsElapsed() / 1e6;
+    WaveformCache::flush();
+
+    std::cout << count << " cache writes on the calling thread: synchronous " << syncMs
+              << " ms, queued " << enqueueMs << " ms" << std::endl;
+    WaveformCache::clearAll();
+}
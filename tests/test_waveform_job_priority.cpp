@@ -0,0 +1,152 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/WaveformJobService.h"
+#include "../src/WaveformWorker.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/**
+ * Tests for priority scheduling on the dedicated waveform decode pool.
+ */
+
+namespace {
+
+QCoreApplication* app()
+{
+    static int argc = 1;
+    static char name[] = "tests_waveform_job_priority";
+    static char* argv[] = {name, nullptr};
+    static QCoreApplication* a = new QCoreApplication(argc, argv);
+    return a;
+}
+
+QString makeWav(const QString& name, int seconds)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_prio_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    const QString path = dir + "/" + name;
+    std::vector<float> samples(static_cast<size_t>(48000) * seconds);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = 0.5f * std::sin(static_cast<float>(i) * 0.03f);
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, 48000));
+    return path;
+}
+
+// Records the order in which jobs complete
+struct Recorder {
+    WaveformWorker worker;
+    std::vector<QUuid> order;
+
+    Recorder()
+    {
+        QObject::connect(&worker, &WaveformWorker::waveformReady, &worker,
+                         [this](const WaveformJob& job, const WaveformResult&) { order.push_back(job.id); });
+    }
+};
+
+void waitForIdle(int timeoutMs = 20000)
+{
+    QElapsedTimer t;
+    t.start();
+    while (WaveformJobService::instance().activeDecodeCount() > 0 && t.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents();
+        QThread::msleep(5);
+    }
+    QCoreApplication::processEvents();
+}
+
+} // namespace
+
+TEST_CASE("Queued decodes start in priority order", "[waveform][jobs][priority]") {
+    app();
+    WaveformJobService::instance().setMaxThreads(1);
+    const QString blocker = makeWav("blocker.wav", 20);
+    const QString a = makeWav("a.wav", 1);
+    const QString b = makeWav("b.wav", 1);
+    const QString c = makeWav("c.wav", 1);
+
+    // The blocker is queued first at the top priority, so it runs first
+    // whether or not the pool thread has picked it up yet
+    Recorder r;
+    const QUuid first = r.worker.enqueueJob(blocker, 500, 1.0, WaveformPriority::Hovered);
+    const QUuid background = r.worker.enqueueJob(a, 500, 1.0, WaveformPriority::Background);
+    const QUuid recent = r.worker.enqueueJob(b, 500, 1.0, WaveformPriority::Recent);
+    const QUuid visible = r.worker.enqueueJob(c, 500, 1.0, WaveformPriority::Visible);
+    waitForIdle();
+
+    REQUIRE(r.order == std::vector<QUuid>{first, visible, recent, background});
+    WaveformJobService::instance().setMaxThreads(0);
+}
+
+TEST_CASE("Raising a queued job's priority moves it ahead", "[waveform][jobs][priority]") {
+    app();
+    WaveformJobService::instance().setMaxThreads(1);
+    const QString blocker = makeWav("blocker.wav", 20);
+    const QString a = makeWav("a.wav", 1);
+    const QString b = makeWav("b.wav", 1);
+
+    Recorder r;
+    const QUuid first = r.worker.enqueueJob(blocker, 500, 1.0, WaveformPriority::Hovered);
+    const QUuid hiddenTab = r.worker.enqueueJob(a, 500, 1.0, WaveformPriority::Visible);
+    const QUuid shownTab = r.worker.enqueueJob(b, 500, 1.0, WaveformPriority::Background);
+    // Tab switch: the first tab is hidden, the second shown
+    r.worker.setJobPriority(hiddenTab, WaveformPriority::Background);
+    r.worker.setJobPriority(shownTab, WaveformPriority::Visible);
+    waitForIdle();
+
+    REQUIRE(r.order == std::vector<QUuid>{first, shownTab, hiddenTab});
+    WaveformJobService::instance().setMaxThreads(0);
+}
+
+TEST_CASE("A shared decode runs at its most urgent subscriber's priority", "[waveform][jobs][priority]") {
+    app();
+    WaveformJobService::instance().setMaxThreads(1);
+    const QString blocker = makeWav("blocker.wav", 20);
+    const QString a = makeWav("a.wav", 1);
+    const QString b = makeWav("b.wav", 1);
+
+    Recorder r, other;
+    const QUuid first = r.worker.enqueueJob(blocker, 500, 1.0, WaveformPriority::Hovered);
+    const QUuid visible = r.worker.enqueueJob(a, 500, 1.0, WaveformPriority::Visible);
+    const QUuid shared = r.worker.enqueueJob(b, 500, 1.0, WaveformPriority::Background);
+    other.worker.enqueueJob(b, 500, 1.0, WaveformPriority::Hovered);
+    waitForIdle();
+
+    REQUIRE(r.order == std::vector<QUuid>{first, shared, visible});
+    WaveformJobService::instance().setMaxThreads(0);
+}
+
+// Runs last: shutdown is final for the process-wide service
+TEST_CASE("Shutdown cancels decodes without waiting on unrelated work", "[waveform][jobs][priority]") {
+    app();
+    const QString path = makeWav("shutdown.wav", 20);
+
+    // Unrelated work on the global pool
+    QThreadPool::globalInstance()->start([]() { QThread::msleep(2000); });
+
+    Recorder r;
+    for (int i = 0; i < 4; ++i) r.worker.enqueueJob(path, 500 + i, 1.0);
+    QElapsedTimer t;
+    t.start();
+    WaveformJobService::instance().shutdown();
+    const qint64 shutdownMs = t.elapsed();
+    QCoreApplication::processEvents();
+
+    std::cout << "decode pool shutdown took " << shutdownMs << " ms" << std::endl;
+    REQUIRE(shutdownMs < 1500);
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 0);
+    REQUIRE(r.order.empty());
+
+    // Jobs submitted after shutdown are dropped
+    r.worker.enqueueJob(path, 500, 1.0);
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 0);
+    QThreadPool::globalInstance()->waitForDone();
+}
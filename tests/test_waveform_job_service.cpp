@@ -0,0 +1,168 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/WaveformJobService.h"
+#include "../src/WaveformWorker.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/**
+ * Tests for shared, reference-counted waveform decodes.
+ */
+
+namespace {
+
+QCoreApplication* app()
+{
+    static int argc = 1;
+    static char name[] = "tests_waveform_job_service";
+    static char* argv[] = {name, nullptr};
+    static QCoreApplication* a = new QCoreApplication(argc, argv);
+    return a;
+}
+
+QString makeWav(const QString& name, int seconds)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_jobs_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    const QString path = dir + "/" + name;
+    std::vector<float> samples(static_cast<size_t>(48000) * seconds);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = 0.5f * std::sin(static_cast<float>(i) * 0.03f);
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, 48000));
+    return path;
+}
+
+struct Listener {
+    std::unique_ptr<WaveformWorker> worker = std::make_unique<WaveformWorker>();
+    QUuid jobId;
+    int ready = 0;
+    int errors = 0;
+    bool idMatched = false;
+
+    Listener()
+    {
+        QObject::connect(worker.get(), &WaveformWorker::waveformReady, worker.get(),
+                         [this](const WaveformJob& job, const WaveformResult& r) {
+            ++ready;
+            idMatched = job.id == jobId && r.peaks.isValid();
+        });
+        QObject::connect(worker.get(), &WaveformWorker::waveformError, worker.get(),
+                         [this](const WaveformJob&, const QString&) { ++errors; });
+    }
+};
+
+void waitForIdle(int timeoutMs = 10000)
+{
+    QElapsedTimer t;
+    t.start();
+    while (WaveformJobService::instance().activeDecodeCount() > 0 && t.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents();
+        QThread::msleep(5);
+    }
+    QCoreApplication::processEvents();
+}
+
+} // namespace
+
+TEST_CASE("Identical jobs share one decode and all receive the result", "[waveform][jobs]") {
+    app();
+    const QString path = makeWav("shared.wav", 2);
+    const quint64 coalescedBefore = WaveformJobService::instance().coalescedCount();
+    std::vector<std::unique_ptr<Listener>> listeners;
+    for (int i = 0; i < 10; ++i) {
+        listeners.push_back(std::make_unique<Listener>());
+        listeners.back()->jobId = listeners.back()->worker->enqueueJob(path, 500, 1.0);
+    }
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 1);
+    REQUIRE(WaveformJobService::instance().coalescedCount() - coalescedBefore == 9);
+
+    waitForIdle();
+    for (const auto& l : listeners) {
+        REQUIRE(l->ready == 1);
+        REQUIRE(l->idMatched);
+    }
+}
+
+TEST_CASE("Different resolutions are decoded separately", "[waveform][jobs]") {
+    app();
+    const QString path = makeWav("widths.wav", 1);
+    Listener a, b;
+    a.jobId = a.worker->enqueueJob(path, 500, 1.0);
+    b.jobId = b.worker->enqueueJob(path, 500, 2.0);
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 2);
+    waitForIdle();
+    REQUIRE(a.ready == 1);
+    REQUIRE(b.ready == 1);
+}
+
+TEST_CASE("Different file versions are decoded separately", "[waveform][jobs]") {
+    app();
+    const QString path = makeWav("versions.wav", 1);
+    // The version comes from the caller (the cache probe), not from a stat
+    Listener before, after;
+    before.jobId = before.worker->enqueueJob(path, 500, 1.0, WaveformPriority::Visible, 1000, 1);
+    after.jobId = after.worker->enqueueJob(path, 500, 1.0, WaveformPriority::Visible, 1000, 2);
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 2);
+    waitForIdle();
+    REQUIRE(before.ready == 1);
+    REQUIRE(after.ready == 1);
+}
+
+TEST_CASE("Cancelling one subscription keeps the decode for the others", "[waveform][jobs]") {
+    app();
+    const QString path = makeWav("cancel.wav", 2);
+    Listener keep, drop;
+    keep.jobId = keep.worker->enqueueJob(path, 500, 1.0);
+    drop.jobId = drop.worker->enqueueJob(path, 500, 1.0);
+    drop.worker->cancelJob(drop.jobId);
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 1);
+    waitForIdle();
+    REQUIRE(keep.ready == 1);
+    REQUIRE(drop.ready == 0);
+    REQUIRE(drop.errors == 0);
+
+    // The last cancellation stops the decode
+    Listener only;
+    only.jobId = only.worker->enqueueJob(path, 500, 1.0);
+    only.worker->cancelJob(only.jobId);
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 0);
+
+    // So does destroying the worker
+    auto gone = std::make_unique<Listener>();
+    gone->jobId = gone->worker->enqueueJob(path, 500, 1.0);
+    gone.reset();
+    REQUIRE(WaveformJobService::instance().activeDecodeCount() == 0);
+    WaveformJobService::instance().waitForDone();
+    QCoreApplication::processEvents();
+}
+
+TEST_CASE("Separate and shared decode cost for ten slots", "[.][waveform][jobs][benchmark]") {
+    app();
+    const QString path = makeWav("bench.wav", 30);
+    const int slots = 10;
+    QElapsedTimer t;
+
+    t.start();
+    for (int i = 0; i < slots; ++i) REQUIRE(WaveformWorker::decodeFile(path, 500, 1.0).sampleRate > 0);
+    const double separateMs = t.nsecsElapsed() / 1e6;
+
+    std::vector<std::unique_ptr<Listener>> listeners;
+    t.restart();
+    for (int i = 0; i < slots; ++i) {
+        listeners.push_back(std::make_unique<Listener>());
+        listeners.back()->jobId = listeners.back()->worker->enqueueJob(path, 500, 1.0);
+    }
+    waitForIdle(30000);
+    const double sharedMs = t.nsecsElapsed() / 1e6;
+    for (const auto& l : listeners) REQUIRE(l->ready == 1);
+
+    std::cout << slots << " slots on a 30 s file: separate decodes " << separateMs << " ms, shared decode "
+              << sharedMs << " ms" << std::endl;
+}
@@ -0,0 +1,167 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformKernels.h"
+#include "../src/WaveformPyramid.h"
+#include "../src/WaveformWorker.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+/**
+ * Tests for the SIMD min/max reduction kernels and their runtime dispatch.
+ */
+
+namespace {
+
+using Isa = WaveformKernels::Isa;
+
+std::vector<float> noise(size_t count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> v(count);
+    for (float& s : v) s = dist(rng);
+    return v;
+}
+
+std::vector<Isa> supportedIsas()
+{
+    std::vector<Isa> out;
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::NEON}) {
+        const Isa previous = WaveformKernels::activeIsa();
+        if (WaveformKernels::setActiveIsa(isa)) out.push_back(isa);
+        WaveformKernels::setActiveIsa(previous);
+    }
+    return out;
+}
+
+// Frames per second of `fn` reducing `samples` in buckets of 256 frames
+template <typename Fn>
+double throughput(const std::vector<float>& samples, int channels, int rounds, Fn fn)
+{
+    const size_t frames = samples.size() / channels;
+    const size_t bucket = 256;
+    volatile float sink = 0.0f;
+    QElapsedTimer t;
+    t.start();
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t f = 0; f < frames; f += bucket) {
+            float mn = std::numeric_limits<float>::infinity();
+            float mx = -std::numeric_limits<float>::infinity();
+            fn(samples.data() + f * channels, std::min(bucket, frames - f), channels, &mn, &mx);
+            sink = sink + mn + mx;
+        }
+    }
+    const double seconds = std::max<qint64>(1, t.nsecsElapsed()) / 1e9;
+    return static_cast<double>(frames) * rounds / seconds;
+}
+
+} // namespace
+
+TEST_CASE("Every supported kernel matches the scalar reduction", "[waveform][kernels]") {
+    const std::vector<float> samples = noise(4096, 1);
+    const Isa best = WaveformKernels::activeIsa();
+    REQUIRE(best == WaveformKernels::bestSupportedIsa());
+
+    for (Isa isa : supportedIsas()) {
+        INFO("isa " << WaveformKernels::isaName(isa));
+        REQUIRE(WaveformKernels::setActiveIsa(isa));
+        for (int channels : {1, 2, 3, 6}) {
+            // Unaligned starts and lengths that leave vector tails
+            for (size_t offset = 0; offset < 4; ++offset) {
+                for (size_t frames = 0; frames <= 70; ++frames) {
+                    float mn = std::numeric_limits<float>::infinity(), mx = -mn;
+                    float refMin = mn, refMax = mx;
+                    WaveformKernels::minMax(samples.data() + offset, frames, channels, &mn, &mx);
+                    WaveformKernels::minMaxScalar(samples.data() + offset, frames, channels, &refMin, &refMax);
+                    REQUIRE(mn == refMin);
+                    REQUIRE(mx == refMax);
+                }
+            }
+        }
+        // Seeds are folded in, not overwritten
+        float mn = -5.0f, mx = 5.0f;
+        WaveformKernels::minMax(samples.data(), 1000, 2, &mn, &mx);
+        REQUIRE(mn == -5.0f);
+        REQUIRE(mx == 5.0f);
+    }
+    WaveformKernels::setActiveIsa(best);
+}
+
+TEST_CASE("Bucketed reduction handles a short last bucket", "[waveform][kernels]") {
+    const int channels = 2;
+    const size_t frames = 1000;
+    const size_t perBucket = 256;
+    const std::vector<float> samples = noise(frames * channels, 2);
+    std::vector<float> mins(5), maxs(5);
+    WaveformKernels::bucketMinMax(samples.data(), frames, channels, perBucket, mins.data(), maxs.data(), mins.size());
+
+    for (size_t b = 0; b < 4; ++b) {
+        const size_t start = b * perBucket;
+        const size_t n = std::min(perBucket, frames - start);
+        const auto first = samples.begin() + start * channels;
+        const auto range = std::minmax_element(first, first + n * channels);
+        REQUIRE(mins[b] == *range.first);
+        REQUIRE(maxs[b] == *range.second);
+    }
+    // Past the input: silence
+    REQUIRE(mins[4] == 0.0f);
+    REQUIRE(maxs[4] == 0.0f);
+}
+
+TEST_CASE("Decoder preview and peaks match a per-sample reference", "[waveform][kernels]") {
+    const int channels = 2;
+    const size_t frames = 48000 + 123;
+    const std::vector<float> samples = noise(frames * channels, 3);
+    const int pixels = 500;
+    const WaveformResult r = WaveformWorker::decodeSamples(samples.data(), frames, 48000, channels, pixels);
+
+    // Level 0 of the peak pyramid equals the pyramid built from the buffer
+    const QVector<float> interleaved(samples.begin(), samples.end());
+    const auto levels = WaveformPyramid::build(interleaved, channels, WaveformWorker::kPeakBaseBucket);
+    REQUIRE(r.peaks.levels.size() == levels.size());
+    REQUIRE(r.peaks.levels[0].min == levels[0].min);
+    REQUIRE(r.peaks.levels[0].max == levels[0].max);
+
+    // Preview columns hold -/+ the largest absolute sample of each bucket
+    REQUIRE(r.min.size() == pixels);
+    const size_t perColumn = (frames + pixels - 1) / pixels;
+    for (int x = 0; x < pixels; ++x) {
+        float peak = 0.0f;
+        for (size_t f = x * perColumn; f < std::min(frames, (x + 1) * perColumn); ++f) {
+            for (int c = 0; c < channels; ++c) peak = std::max(peak, std::abs(samples[f * channels + c]));
+        }
+        REQUIRE(r.max[x] == peak);
+        REQUIRE(r.min[x] == -peak);
+    }
+}
+
+TEST_CASE("Kernel throughput against the scalar reference", "[.][waveform][kernels][benchmark]") {
+    const Isa best = WaveformKernels::bestSupportedIsa();
+    REQUIRE(WaveformKernels::setActiveIsa(best));
+    const int rounds = 5;
+
+    for (int channels : {1, 2, 6}) {
+        // 60 s at 48 kHz
+        const std::vector<float> samples = noise(static_cast<size_t>(48000) * 60 * channels, 4);
+        const double scalar = throughput(samples, channels, rounds, WaveformKernels::minMaxScalar);
+        const double simd = throughput(samples, channels, rounds, WaveformKernels::minMax);
+        std::cout << channels << " ch: scalar " << scalar / 1e6 << " Mframes/s, "
+                  << WaveformKernels::isaName(best) << " " << simd / 1e6 << " Mframes/s ("
+                  << simd / scalar << "x)" << std::endl;
+    }
+
+    // End to end: preview + pyramid from a decoded stereo buffer
+    const std::vector<float> stereo = noise(static_cast<size_t>(48000) * 60 * 2, 5);
+    QElapsedTimer t;
+    t.start();
+    const WaveformResult r = WaveformWorker::decodeSamples(stereo.data(), stereo.size() / 2, 48000, 2, 500);
+    const double seconds = std::max<qint64>(1, t.nsecsElapsed()) / 1e9;
+    REQUIRE(r.sampleRate == 48000);
+    std::cout << "decodeSamples: " << (stereo.size() / 2) / seconds / 1e6 << " Mframes/s" << std::endl;
+}
@@ -0,0 +1,209 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformPackedPeaks.h"
+#include "../src/WaveformPyramid.h"
+#include "../src/WaveformRenderer.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/**
+ * Tests for the packed peak pyramid: one quantized arena, optionally mapped
+ * from the peak file.
+ */
+
+namespace {
+
+// Pyramid over `seconds` of 48 kHz audio at base bucket 256, from a
+// deterministic level 0 (a noisy envelope) rather than decoded samples
+WaveformPeaks makePeaks(int seconds)
+{
+    WaveformPeaks peaks;
+    peaks.sampleRate = 48000;
+    peaks.channels = 2;
+    peaks.totalFrames = static_cast<qint64>(seconds) * 48000;
+    WaveformLevel level0;
+    level0.samplesPerBucket = 256;
+    const int buckets = static_cast<int>((peaks.totalFrames + 255) / 256);
+    level0.min.resize(buckets);
+    level0.max.resize(buckets);
+    quint32 seed = 12345;
+    for (int i = 0; i < buckets; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(seed >> 8) / static_cast<float>(1 << 24);
+        const float envelope = 0.2f + 0.7f * std::fabs(std::sin(i * 0.0003f));
+        level0.max[i] = envelope * (0.5f + 0.5f * noise);
+        level0.min[i] = -envelope * (1.0f - 0.5f * noise);
+    }
+    peaks.levels = WaveformPyramid::buildFromBase(std::move(level0));
+    return peaks;
+}
+
+qint64 floatBytes(const WaveformPeaks& peaks)
+{
+    qint64 total = 0;
+    for (const WaveformLevel& l : peaks.levels) {
+        total += static_cast<qint64>(l.min.capacity() + l.max.capacity()) * sizeof(float) + sizeof(WaveformLevel);
+    }
+    return total;
+}
+
+QString tempPath(const QString& name)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_packed_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    return dir + "/" + name;
+}
+
+} // namespace
+
+TEST_CASE("Packed columns match the unpacked pyramid exactly", "[waveform][packed]") {
+    const WaveformPeaks peaks = makePeaks(90);
+    for (auto precision : {WaveformPackedPeaks::Precision::Int16, WaveformPackedPeaks::Precision::Int8}) {
+        const WaveformPackedPeaks packed = WaveformPackedPeaks::pack(peaks, precision);
+        REQUIRE(packed.isValid());
+        REQUIRE(packed.totalFrames() == peaks.totalFrames);
+        REQUIRE(packed.levelCount() == peaks.levels.size());
+        const WaveformPeaks unpacked = packed.unpack();
+
+        for (int width : {1, 37, 160, 500, 1001, 4000, 20000}) {
+            // Same level as the table walk
+            int walk = 0;
+            while (walk + 1 < peaks.levels.size()
+                   && peaks.levels[walk + 1].samplesPerBucket <= static_cast<double>(peaks.totalFrames) / width) {
+                ++walk;
+            }
+            REQUIRE(packed.levelIndexForWidth(width) == walk);
+
+            const WaveformLevel expected = WaveformPyramid::levelForWidth(unpacked.levels, unpacked.totalFrames, width);
+            const WaveformLevel level = packed.levelForWidth(width);
+            REQUIRE(level.samplesPerBucket == expected.samplesPerBucket);
+            REQUIRE(level.min == expected.min);
+            REQUIRE(level.max == expected.max);
+        }
+    }
+}
+
+TEST_CASE("Packing unpacked peaks is lossless", "[waveform][packed]") {
+    const WaveformPeaks peaks = makePeaks(30);
+    for (auto precision : {WaveformPackedPeaks::Precision::Int16, WaveformPackedPeaks::Precision::Int8}) {
+        const WaveformPackedPeaks packed = WaveformPackedPeaks::pack(peaks, precision);
+        const WaveformPackedPeaks again = WaveformPackedPeaks::pack(packed.unpack(), precision);
+        REQUIRE(again.bytes() == packed.bytes());
+    }
+}
+
+TEST_CASE("Peak files map without a decode", "[waveform][packed]") {
+    const WaveformPeaks peaks = makePeaks(30);
+    const QString path = tempPath("mapped.peaks");
+    REQUIRE(WaveformPeakFile::write(path, peaks, 1234, 5678));
+
+    qint64 size = -1;
+    qint64 mtime = -1;
+    const WaveformPackedPeaks mapped = WaveformPackedPeaks::map(path, &size, &mtime);
+    REQUIRE(mapped.isValid());
+    REQUIRE(size == 1234);
+    REQUIRE(mtime == 5678);
+    REQUIRE(mapped.memoryBytes() >= QFile(path).size());
+    REQUIRE(mapped.levelForWidth(800).max == WaveformPackedPeaks::pack(peaks).levelForWidth(800).max);
+
+    // Copies share the mapping
+    const WaveformPackedPeaks copy = mapped;
+    REQUIRE(copy.isMapped() == mapped.isMapped());
+    REQUIRE(copy.levelForWidth(333).min == mapped.levelForWidth(333).min);
+
+    QFile truncated(tempPath("truncated.peaks"));
+    REQUIRE(truncated.open(QIODevice::WriteOnly));
+    truncated.write(mapped.bytes().left(100));
+    truncated.close();
+    REQUIRE(!WaveformPackedPeaks::map(truncated.fileName()).isValid());
+    REQUIRE(!WaveformPackedPeaks::map(tempPath("missing.peaks")).isValid());
+}
+
+TEST_CASE("Mapped peaks hold no file descriptors", "[waveform][packed]") {
+    const QDir fds("/proc/self/fd");
+    if (!fds.exists()) {
+        WARN("no /proc/self/fd, skipping");
+        return;
+    }
+    const WaveformPeaks peaks = makePeaks(10);
+    const QString path = tempPath("fd.peaks");
+    REQUIRE(WaveformPeakFile::write(path, peaks, 1, 2));
+
+    const int before = fds.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System).size();
+    std::vector<WaveformPackedPeaks> mapped;
+    for (int i = 0; i < 64; ++i) mapped.push_back(WaveformPackedPeaks::map(path));
+    const int after = fds.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System).size();
+    REQUIRE(mapped.back().isMapped());
+    REQUIRE(after - before < 4);
+
+    // The mapping outlives the file it came from
+    REQUIRE(QFile::remove(path));
+    REQUIRE(mapped.front().levelForWidth(300).max == WaveformPackedPeaks::pack(peaks).levelForWidth(300).max);
+}
+
+TEST_CASE("Packed pyramids take a half or a quarter of the float memory", "[waveform][packed]") {
+    const WaveformPeaks peaks = makePeaks(3600);
+    const qint64 floatMem = floatBytes(peaks);
+    const WaveformPackedPeaks packed16 = WaveformPackedPeaks::pack(peaks, WaveformPackedPeaks::Precision::Int16);
+    const WaveformPackedPeaks packed8 = WaveformPackedPeaks::pack(peaks, WaveformPackedPeaks::Precision::Int8);
+    REQUIRE(packed16.memoryBytes() * 2 <= floatMem + 4096);
+    REQUIRE(packed8.memoryBytes() * 4 <= floatMem + 4096);
+}
+
+TEST_CASE("Packed and float pyramids: memory, level select and render", "[.][waveform][packed][benchmark]") {
+    const WaveformPeaks peaks = makePeaks(3600);
+    const WaveformPackedPeaks packed16 = WaveformPackedPeaks::pack(peaks, WaveformPackedPeaks::Precision::Int16);
+    const WaveformPackedPeaks packed8 = WaveformPackedPeaks::pack(peaks, WaveformPackedPeaks::Precision::Int8);
+
+    const qint64 floatMem = floatBytes(peaks);
+    std::cout << "1 h at base bucket 256: float levels " << floatMem / 1024 << " KiB, packed int16 "
+              << packed16.memoryBytes() / 1024 << " KiB, int8 " << packed8.memoryBytes() / 1024 << " KiB" << std::endl;
+
+    const int rounds = 20;
+    for (int width : {500, 1920, 7680, 40000}) {
+        QElapsedTimer t;
+        t.start();
+        for (int i = 0; i < rounds; ++i) WaveformPyramid::levelForWidth(peaks.levels, peaks.totalFrames, width);
+        const double floatUs = t.nsecsElapsed() / 1e3 / rounds;
+        t.restart();
+        for (int i = 0; i < rounds; ++i) packed16.levelForWidth(width);
+        const double packed16Us = t.nsecsElapsed() / 1e3 / rounds;
+        t.restart();
+        for (int i = 0; i < rounds; ++i) packed8.levelForWidth(width);
+        const double packed8Us = t.nsecsElapsed() / 1e3 / rounds;
+
+        t.restart();
+        for (int i = 0; i < rounds; ++i) {
+            Waveform::renderLevelToImage(WaveformPyramid::levelForWidth(peaks.levels, peaks.totalFrames, width), width,
+                                         1.0f, 80);
+        }
+        const double floatRenderUs = t.nsecsElapsed() / 1e3 / rounds;
+        t.restart();
+        for (int i = 0; i < rounds; ++i) Waveform::renderLevelToImage(packed16.levelForWidth(width), width, 1.0f, 80);
+        const double packedRenderUs = t.nsecsElapsed() / 1e3 / rounds;
+
+        std::cout << "  " << width << " px (level " << packed16.levelIndexForWidth(width) << "): columns float "
+                  << floatUs << " us, int16 " << packed16Us << " us, int8 " << packed8Us << " us; render float "
+                  << floatRenderUs << " us, int16 " << packedRenderUs << " us" << std::endl;
+    }
+
+    // Loading from the peak cache: full decode to floats vs mapping
+    const QString path = tempPath("bench.peaks");
+    REQUIRE(WaveformPeakFile::write(path, peaks, 1, 2));
+    QElapsedTimer t;
+    t.start();
+    WaveformPeaks decoded;
+    REQUIRE(WaveformPeakFile::read(path, &decoded));
+    const double decodeMs = t.nsecsElapsed() / 1e6;
+    t.restart();
+    const WaveformPackedPeaks mapped = WaveformPackedPeaks::map(path);
+    const double mapMs = t.nsecsElapsed() / 1e6;
+    REQUIRE(mapped.isValid());
+    std::cout << "peak file load: decode " << decodeMs << " ms, map " << mapMs << " ms" << std::endl;
+}
@@ -0,0 +1,228 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformPeakFile.h"
+#include "../src/WaveformPyramid.h"
+#include "../src/WaveformRenderer.h"
+#include "../src/WaveformCache.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <cmath>
+#include <iostream>
+
+/**
+ * Tests for the binary peak-file pyramid cache.
+ */
+
+namespace {
+
+// Mono test signal: a decaying 220 Hz tone with a burst in the middle
+QVector<float> makeSignal(int frames, int sampleRate)
+{
+    QVector<float> s(frames);
+    for (int i = 0; i < frames; ++i) {
+        const double t = static_cast<double>(i) / sampleRate;
+        double v = std::sin(2.0 * M_PI * 220.0 * t) * std::exp(-t * 0.5);
+        if (i > frames / 2 && i < frames / 2 + sampleRate / 10) v = (i % 2) ? 0.95 : -0.95;
+        s[i] = static_cast<float>(v);
+    }
+    return s;
+}
+
+WaveformPeaks makePeaks(const QVector<float>& samples, int sampleRate)
+{
+    WaveformPeaks peaks;
+    peaks.sampleRate = sampleRate;
+    peaks.channels = 1;
+    peaks.totalFrames = samples.size();
+    peaks.levels = WaveformPyramid::build(samples, 1, 256);
+    return peaks;
+}
+
+void requireWithinQuantization(const WaveformPeaks& a, const WaveformPeaks& b, float step)
+{
+    REQUIRE(b.levels.size() == a.levels.size());
+    for (int l = 0; l < a.levels.size(); ++l) {
+        const WaveformLevel& la = a.levels[l];
+        const WaveformLevel& lb = b.levels[l];
+        REQUIRE(lb.samplesPerBucket == la.samplesPerBucket);
+        REQUIRE(lb.min.size() == la.min.size());
+        for (int i = 0; i < la.min.size(); ++i) {
+            // Min rounds down and max rounds up, never by more than one step
+            REQUIRE(lb.min[i] <= la.min[i] + 1e-6f);
+            REQUIRE(lb.min[i] >= la.min[i] - step - 1e-6f);
+            REQUIRE(lb.max[i] >= la.max[i] - 1e-6f);
+            REQUIRE(lb.max[i] <= la.max[i] + step + 1e-6f);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Peak file round-trips within quantization error", "[waveform][peakfile]") {
+    const int sr = 48000;
+    QVector<float> samples = makeSignal(sr * 2 + 123, sr);
+    WaveformPeaks peaks = makePeaks(samples, sr);
+    REQUIRE(peaks.isValid());
+
+    SECTION("int16") {
+        QByteArray bytes = WaveformPeakFile::encode(peaks, 1111, 2222, WaveformPeakFile::Precision::Int16);
+        WaveformPeaks out;
+        qint64 size = 0, mtime = 0;
+        REQUIRE(WaveformPeakFile::decode(bytes, &out, &size, &mtime));
+        REQUIRE(size == 1111);
+        REQUIRE(mtime == 2222);
+        REQUIRE(out.sampleRate == sr);
+        REQUIRE(out.channels == 1);
+        REQUIRE(out.totalFrames == peaks.totalFrames);
+        requireWithinQuantization(peaks, out, 1.0f / 32767.0f);
+    }
+    SECTION("int8") {
+        QByteArray bytes8 = WaveformPeakFile::encode(peaks, 1, 2, WaveformPeakFile::Precision::Int8);
+        QByteArray bytes16 = WaveformPeakFile::encode(peaks, 1, 2, WaveformPeakFile::Precision::Int16);
+        REQUIRE(bytes8.size() < bytes16.size());
+        WaveformPeaks out;
+        REQUIRE(WaveformPeakFile::decode(bytes8, &out));
+        requireWithinQuantization(peaks, out, 1.0f / 127.0f);
+    }
+}
+
+TEST_CASE("Peak file rejects corrupt and truncated data", "[waveform][peakfile]") {
+    WaveformPeaks peaks = makePeaks(makeSignal(20000, 48000), 48000);
+    const QByteArray good = WaveformPeakFile::encode(peaks, 10, 20);
+    REQUIRE(WaveformPeakFile::decode(good, nullptr));
+
+    REQUIRE_FALSE(WaveformPeakFile::decode(QByteArray(), nullptr));
+    REQUIRE_FALSE(WaveformPeakFile::decode(good.left(WaveformPeakFile::kHeaderBytes - 1), nullptr));
+    REQUIRE_FALSE(WaveformPeakFile::decode(good.left(good.size() - 1), nullptr));
+    REQUIRE_FALSE(WaveformPeakFile::decode(good + QByteArray(4, '\0'), nullptr));
+
+    QByteArray badMagic = good;
+    badMagic[0] = 'X';
+    REQUIRE_FALSE(WaveformPeakFile::decode(badMagic, nullptr));
+
+    QByteArray badVersion = good;
+    badVersion[4] = static_cast<char>(WaveformPeakFile::kVersion + 1);
+    REQUIRE_FALSE(WaveformPeakFile::decode(badVersion, nullptr));
+
+    QByteArray badBits = good;
+    badBits[6] = 12;
+    REQUIRE_FALSE(WaveformPeakFile::decode(badBits, nullptr));
+}
+
+TEST_CASE("levelForWidth yields one column per pixel covering the audio", "[waveform][pyramid][peakfile]") {
+    const int sr = 48000;
+    QVector<float> samples = makeSignal(sr * 3, sr);
+    WaveformPeaks peaks = makePeaks(samples, sr);
+
+    for (int width : {1, 37, 160, 500, 1001, 4000}) {
+        WaveformLevel level = WaveformPyramid::levelForWidth(peaks.levels, peaks.totalFrames, width);
+        REQUIRE(level.min.size() == width);
+        REQUIRE(level.max.size() == width);
+        for (int x = 0; x < width; ++x) {
+            const qint64 f0 = peaks.totalFrames * x / width;
+            const qint64 f1 = peaks.totalFrames * (x + 1) / width;
+            float lo = samples[static_cast<int>(f0)];
+            float hi = lo;
+            for (qint64 f = f0; f < f1; ++f) {
+                lo = std::min(lo, samples[static_cast<int>(f)]);
+                hi = std::max(hi, samples[static_cast<int>(f)]);
+            }
+            // Columns may include a partial neighbouring bucket but never miss a peak
+            REQUIRE(level.min[x] <= lo);
+            REQUIRE(level.max[x] >= hi);
+        }
+    }
+}
+
+TEST_CASE("Peak cache entries are rejected when the source changes", "[waveform][peakfile][cache]") {
+    WaveformPeaks peaks = makePeaks(makeSignal(48000, 48000), 48000);
+    const QString key = WaveformCache::makePeakKey("/tmp/peak_source.wav", 4096, 1700000000123);
+    REQUIRE(WaveformCache::writePeaks(key, peaks, 4096, 1700000000123));
+    WaveformCache::flush();
+    REQUIRE(QFile::exists(WaveformCache::peakFilePath(key)));
+
+    WaveformPeaks out;
+    REQUIRE(WaveformCache::loadPeaks(key, 4096, 1700000000123, &out));
+    REQUIRE(out.totalFrames == peaks.totalFrames);
+
+    // Stale mtime: rejected and removed
+    REQUIRE_FALSE(WaveformCache::loadPeaks(key, 4096, 1700000000124, &out));
+    REQUIRE_FALSE(QFile::exists(WaveformCache::peakFilePath(key)));
+
+    // Corrupt file: rejected and removed
+    QFile f(WaveformCache::peakFilePath(key));
+    REQUIRE(f.open(QIODevice::WriteOnly));
+    f.write("LSBP garbage");
+    f.close();
+    REQUIRE_FALSE(WaveformCache::loadPeaks(key, 4096, 1700000000123, &out));
+    REQUIRE_FALSE(QFile::exists(WaveformCache::peakFilePath(key)));
+}
+
+TEST_CASE("Peak cache hit versus PNG cache hit", "[.][waveform][peakfile][benchmark]") {
+    const int sr = 48000;
+    const int seconds = 60;
+    QVector<float> samples = makeSignal(sr * seconds, sr);
+    WaveformPeaks peaks = makePeaks(samples, sr);
+    const int targetW = 320;
+    const int targetH = 64;
+    const int iterations = 50;
+
+    // Peak path: one file for every width/DPR
+    const QString peakKey = WaveformCache::makePeakKey("/tmp/bench_source.wav", 1, 2);
+    REQUIRE(WaveformCache::writePeaks(peakKey, peaks, 1, 2));
+    WaveformCache::flush();
+    const qint64 peakBytes = QFileInfo(WaveformCache::peakFilePath(peakKey)).size();
+    const qint64 peak8Bytes = WaveformPeakFile::encode(peaks, 1, 2, WaveformPeakFile::Precision::Int8).size();
+
+    // PNG path: the canonical 500px image plus JSON sidecar, per DPR
+    WaveformLevel canonical = WaveformPyramid::levelForWidth(peaks.levels, peaks.totalFrames, 500);
+    QImage png = Waveform::renderLevelToImage(canonical, 500, 1.0f, targetH);
+    const QString pngKey = WaveformCache::makeKey("/tmp/bench_source.wav", 1, 2, 1, sr, 1.0f, 500);
+    QJsonObject meta;
+    meta["path"] = "/tmp/bench_source.wav";
+    meta["size"] = 1;
+    meta["mtime"] = 2;
+    meta["channels"] = 1;
+    meta["samplerate"] = sr;
+    meta["dpr"] = 1.0;
+    meta["pixelWidth"] = 500;
+    meta["width"] = png.width();
+    meta["height"] = png.height();
+    REQUIRE(WaveformCache::write(pngKey, png, meta));
+    WaveformCache::flush();
+    QDir d(WaveformCache::cacheDirPath());
+    const qint64 pngBytes = QFileInfo(d.filePath(pngKey + ".png")).size() + QFileInfo(d.filePath(pngKey + ".json")).size();
+
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < iterations; ++i) {
+        WaveformPeaks loaded;
+        REQUIRE(WaveformCache::loadPeaks(peakKey, 1, 2, &loaded));
+        WaveformLevel level = WaveformPyramid::levelForWidth(loaded.levels, loaded.totalFrames, targetW);
+        QImage img = Waveform::renderLevelToImage(level, targetW, 1.0f, targetH);
+        REQUIRE(img.width() == targetW);
+    }
+    const double peakMs = t.nsecsElapsed() / 1e6 / iterations;
+
+    t.restart();
+    for (int i = 0; i < iterations; ++i) {
+        QImage cached = WaveformCache::load(pngKey);
+        REQUIRE(!cached.isNull());
+        QImage img = cached.scaled(QSize(targetW, targetH), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        REQUIRE(img.width() == targetW);
+    }
+    const double pngMs = t.nsecsElapsed() / 1e6 / iterations;
+
+    std::cout << "cache hit to " << targetW << "x" << targetH << " pixels (" << seconds << " s mono): peaks "
+              << peakMs << " ms, png " << pngMs << " ms" << std::endl;
+    std::cout << "bytes on disk: peaks int16 " << peakBytes << ", peaks int8 " << peak8Bytes
+              << " (all widths/DPRs), png+json " << pngBytes << " (one width/DPR)" << std::endl;
+
+    QFile::remove(WaveformCache::peakFilePath(peakKey));
+    QFile::remove(d.filePath(pngKey + ".png"));
+    QFile::remove(d.filePath(pngKey + ".json"));
+}
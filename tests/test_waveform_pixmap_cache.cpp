@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/SoundContainer.h"
+#include "../src/WaveformCache.h"
+#include "../src/WaveformCacheProbe.h"
+#include "../src/WaveformPixmapCache.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLabel>
+#include <QThread>
+#include <cmath>
+#include <iostream>
+
+/**
+ * Tests for the process-wide waveform pixmap cache.
+ */
+
+namespace {
+
+QPixmap makePixmap(int w, int h)
+{
+    QPixmap pm(w, h);
+    pm.fill(Qt::red);
+    return pm;
+}
+
+} // namespace
+
+TEST_CASE("Pixmaps are evicted least recently used first", "[waveform][pixmapcache]") {
+    app();
+    WaveformPixmapCache& cache = WaveformPixmapCache::instance();
+    cache.clear();
+    cache.resetStats();
+    const QPixmap pm = makePixmap(100, 100);
+    const qint64 entryBytes = 100LL * 100 * pm.depth() / 8;
+    cache.setCapacityBytes(entryBytes * 2);
+
+    cache.insert("a", pm);
+    cache.insert("b", pm);
+    REQUIRE(cache.lookup("a", nullptr));     // b is now the oldest
+    cache.insert("c", pm);
+    REQUIRE(cache.lookup("a", nullptr));
+    REQUIRE(!cache.lookup("b", nullptr));
+    REQUIRE(cache.lookup("c", nullptr));
+
+    const WaveformPixmapCache::Stats s = cache.stats();
+    REQUIRE(s.hits == 3);
+    REQUIRE(s.misses == 1);
+    REQUIRE(s.evictions == 1);
+    REQUIRE(s.entries == 2);
+    REQUIRE(s.bytes == entryBytes * 2);
+
+    cache.setCapacityBytes(64LL * 1024 * 1024);
+    cache.clear();
+}
+
+TEST_CASE("Keys separate size, DPR and backdrop", "[waveform][pixmapcache]") {
+    const QString id = WaveformPixmapCache::identityOf("/tmp/x.wav", 100, 1);
+    REQUIRE(id == WaveformPixmapCache::identityOf("/tmp/x.wav", 100, 1));
+    REQUIRE(id != WaveformPixmapCache::identityOf("/tmp/x.wav", 100, 2));
+    const QString base = WaveformPixmapCache::keyFor(id, QSize(200, 60), 1.0, QColor());
+    REQUIRE(base != WaveformPixmapCache::keyFor(id, QSize(201, 60), 1.0, QColor()));
+    REQUIRE(base != WaveformPixmapCache::keyFor(id, QSize(200, 60), 2.0, QColor()));
+    REQUIRE(base != WaveformPixmapCache::keyFor(id, QSize(200, 60), 1.0, QColor(Qt::blue)));
+}
+
+TEST_CASE("The last identity of a path is known without touching the file", "[waveform][pixmapcache]") {
+    WaveformPixmapCache& cache = WaveformPixmapCache::instance();
+    cache.clear();
+    REQUIRE(cache.knownIdentity("/tmp/never-probed.wav").isEmpty());
+    WaveformPixmapCache::identityOf("/tmp/never-probed.wav", 100, 1);
+    const QString latest = WaveformPixmapCache::identityOf("/tmp/never-probed.wav", 100, 2);
+    REQUIRE(cache.knownIdentity("/tmp/never-probed.wav") == latest);
+    cache.clear();
+    REQUIRE(cache.knownIdentity("/tmp/never-probed.wav").isEmpty());
+}
+
+TEST_CASE("Slots showing the same file share one pixmap", "[waveform][pixmapcache][integration]") {
+    app();
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_pixmap_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    qputenv("LIBRE_WAVEFORM_CACHE_DIR", QDir(dir).filePath("cache").toUtf8());
+    WaveformCache::clearAll();
+    WaveformPixmapCache::instance().clear();
+
+    const QString path = QDir(dir).filePath("tone.wav");
+    std::vector<float> samples(48000);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = 0.5f * std::sin(static_cast<float>(i) * 0.05f);
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, 48000));
+
+    SoundContainer first;
+    first.resize(240, 120);
+    first.show();
+    first.setFile(path);
+    QElapsedTimer et;
+    et.start();
+    while (shownPixmap(first).isNull() && et.elapsed() < 10000) {
+        QCoreApplication::processEvents();
+        QThread::msleep(10);
+    }
+    REQUIRE(!shownPixmap(first).isNull());
+
+    // The copy shows the shared pixmap synchronously, without rendering
+    const quint64 hitsBefore = WaveformPixmapCache::instance().stats().hits;
+    SoundContainer copy;
+    copy.resize(240, 120);
+    copy.show();
+    QCoreApplication::processEvents();
+    et.restart();
+    copy.setFile(path);
+    const double copyMs = et.nsecsElapsed() / 1e6;
+    REQUIRE(!shownPixmap(copy).isNull());
+    REQUIRE(shownPixmap(copy).cacheKey() == shownPixmap(first).cacheKey());
+    REQUIRE(WaveformPixmapCache::instance().stats().hits > hitsBefore);
+
+    std::cout << "copied slot showed its waveform in " << copyMs << " ms" << std::endl;
+    WaveformCacheProbe::instance().waitForDone();
+    QCoreApplication::processEvents();
+    WaveformCache::clearAll();
+}
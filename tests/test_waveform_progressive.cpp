@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/SoundContainer.h"
+#include "../src/WaveformCache.h"
+#include "../src/WaveformCacheProbe.h"
+#include "../src/WaveformJobService.h"
+#include "../src/WaveformPixmapCache.h"
+#include "../src/WaveformWorker.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLabel>
+#include <QThread>
+#include <cmath>
+#include <iostream>
+
+/**
+ * Tests for partial waveform results while long files decode.
+ */
+
+namespace {
+
+QString testDir()
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_progressive_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    return dir;
+}
+
+// A file that takes well over kPartialIntervalMs to decode: the reference
+// MP3 repeated when available (MPEG frames concatenate), else a long WAV
+QString makeLongFile()
+{
+    QFile mp3(QStringLiteral(LSB_REFERENCE_SOUNDS "/1.mp3"));
+    if (mp3.open(QIODevice::ReadOnly)) {
+        const QByteArray data = mp3.readAll();
+        const QString path = QDir(testDir()).filePath("long.mp3");
+        QFile dst(path);
+        REQUIRE(dst.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        for (int i = 0; i < 64; ++i) dst.write(data);
+        return path;
+    }
+    const QString path = QDir(testDir()).filePath("long.wav");
+    std::vector<float> samples(static_cast<size_t>(48000) * 300);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = 0.5f * std::sin(static_cast<float>(i) * 0.01f);
+    REQUIRE(InputCapture::writeWavFile(path.toStdString(), samples, 48000));
+    return path;
+}
+
+} // namespace
+
+TEST_CASE("Partial results are throttled and do not change the final result", "[waveform][progressive]") {
+    const QString path = makeLongFile();
+
+    QElapsedTimer t;
+    t.start();
+    qint64 firstPartialMs = -1;
+    std::vector<double> progress;
+    const WaveformResult final = WaveformWorker::decodeFile(path, 500, 1.0, {}, [&](const WaveformResult& partial) {
+        if (firstPartialMs < 0) firstPartialMs = t.elapsed();
+        REQUIRE(partial.peaks.isValid());
+        REQUIRE(partial.min.size() == 500);
+        progress.push_back(partial.progress);
+    });
+    const qint64 fullMs = t.elapsed();
+    REQUIRE(final.sampleRate > 0);
+    REQUIRE(final.progress == 1.0);
+
+    std::cout << "decode " << fullMs << " ms, " << progress.size() << " partials, first after " << firstPartialMs
+              << " ms" << std::endl;
+    if (fullMs > 3 * WaveformWorker::kPartialIntervalMs) {
+        REQUIRE(!progress.empty());
+        REQUIRE(firstPartialMs < WaveformWorker::kPartialIntervalMs + 200);
+    }
+    // At most one partial per interval, each further along than the last
+    REQUIRE(static_cast<qint64>(progress.size()) <= fullMs / WaveformWorker::kPartialIntervalMs + 1);
+    for (size_t i = 0; i < progress.size(); ++i) {
+        REQUIRE(progress[i] < 1.0);
+        if (i > 0) REQUIRE(progress[i] > progress[i - 1]);
+    }
+
+    const WaveformResult plain = WaveformWorker::decodeFile(path, 500, 1.0);
+    REQUIRE(plain.min == final.min);
+    REQUIRE(plain.max == final.max);
+    REQUIRE(plain.peaks.levels[0].max == final.peaks.levels[0].max);
+}
+
+TEST_CASE("Time to first pixel on a long file", "[.][waveform][progressive][benchmark]") {
+    app();
+    qputenv("LIBRE_WAVEFORM_CACHE_DIR", QDir(testDir()).filePath("cache").toUtf8());
+    WaveformCache::clearAll();
+    WaveformPixmapCache::instance().clear();
+    const QString path = makeLongFile();
+
+    SoundContainer sc;
+    sc.resize(240, 120);
+    sc.show();
+    QCoreApplication::processEvents();
+
+    QElapsedTimer t;
+    t.start();
+    sc.setFile(path);
+    qint64 firstPixelMs = -1;
+    while (t.elapsed() < 30000) {
+        QCoreApplication::processEvents();
+        if (firstPixelMs < 0 && !shownPixmap(sc).isNull()) firstPixelMs = t.elapsed();
+        if (firstPixelMs >= 0 && WaveformJobService::instance().activeDecodeCount() == 0) break;
+        QThread::msleep(2);
+    }
+    QCoreApplication::processEvents();
+    const qint64 completeMs = t.elapsed();
+
+    std::cout << "time to first pixel " << firstPixelMs << " ms, complete waveform " << completeMs << " ms"
+              << std::endl;
+    REQUIRE(firstPixelMs >= 0);
+    REQUIRE(!shownPixmap(sc).isNull());
+
+    WaveformCacheProbe::instance().waitForDone();
+    QCoreApplication::processEvents();
+    WaveformCache::clearAll();
+}
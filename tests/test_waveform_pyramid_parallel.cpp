@@ -0,0 +1,127 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/WaveformPyramid.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * Tests for the multi-threaded pyramid build: identical output for any
+ * thread count, and how it scales on a long recording.
+ */
+
+namespace {
+
+// Deterministic noise under a slow envelope
+QVector<float> makeSamples(qint64 frames, int channels)
+{
+    QVector<float> s(frames * channels);
+    quint32 seed = 1;
+    for (qint64 i = 0; i < s.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(static_cast<qint32>(seed)) / 2147483648.0f;
+        const float envelope = 0.1f + 0.9f * static_cast<float>((i / channels) % 480000) / 480000.0f;
+        s[i] = envelope * noise;
+    }
+    return s;
+}
+
+bool sameLevels(const QVector<WaveformLevel>& a, const QVector<WaveformLevel>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (int k = 0; k < a.size(); ++k) {
+        if (a[k].samplesPerBucket != b[k].samplesPerBucket || a[k].min != b[k].min || a[k].max != b[k].max) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Parallel builds match the single-threaded build", "[waveform][pyramid][parallel]") {
+    // Odd lengths and bucket sizes, so chunks, tiles and levels end on
+    // partial buckets
+    struct Shape { qint64 frames; int channels; int baseBucket; };
+    const Shape shapes[] = {
+        {1, 1, 256},
+        {1000, 2, 3},
+        {WaveformPyramid::kTileBuckets * 256 + 77, 2, 256},
+        {3 * WaveformPyramid::kTileBuckets * 7 + 5, 3, 7},
+        {5000001, 1, 100},
+    };
+    for (const Shape& shape : shapes) {
+        const QVector<float> samples = makeSamples(shape.frames, shape.channels);
+        const QVector<WaveformLevel> serial = WaveformPyramid::build(samples, shape.channels, shape.baseBucket, 1);
+        REQUIRE(!serial.isEmpty());
+        REQUIRE(serial.back().min.size() == 1);
+        for (int threads : {2, 3, 8}) {
+            REQUIRE(sameLevels(WaveformPyramid::build(samples, shape.channels, shape.baseBucket, threads), serial));
+        }
+
+        // Every bucket of every level covers its whole frame range
+        for (int k = 0; k < serial.size(); ++k) {
+            const WaveformLevel& level = serial[k];
+            const qint64 spb = level.samplesPerBucket;
+            REQUIRE(level.min.size() == (shape.frames + spb - 1) / spb);
+            const qint64 step = std::max<qint64>(1, level.min.size() / 16);
+            for (qint64 j = 0; j < level.min.size(); j += step) {
+                float lo = samples[j * spb * shape.channels];
+                float hi = lo;
+                const qint64 end = std::min(shape.frames, (j + 1) * spb) * shape.channels;
+                for (qint64 i = j * spb * shape.channels; i < end; ++i) {
+                    lo = std::min(lo, samples[i]);
+                    hi = std::max(hi, samples[i]);
+                }
+                REQUIRE(level.min[j] == lo);
+                REQUIRE(level.max[j] == hi);
+            }
+        }
+    }
+}
+
+TEST_CASE("buildFromBase is deterministic across thread counts", "[waveform][pyramid][parallel]") {
+    const QVector<float> samples = makeSamples(WaveformPyramid::kTileBuckets * 64 + 13, 1);
+    const QVector<WaveformLevel> levels = WaveformPyramid::build(samples, 1, 16, 1);
+    for (int threads : {1, 2, 5}) {
+        REQUIRE(sameLevels(WaveformPyramid::buildFromBase(levels[0], threads), levels));
+    }
+}
+
+TEST_CASE("Pyramid build scaling on a long stereo recording", "[.][waveform][pyramid][parallel][benchmark]") {
+    // Two hours at 48 kHz, or what a quarter of the physical memory holds
+    const qint64 physical = static_cast<qint64>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+    const qint64 maxFrames = physical > 0 ? physical / 4 / (2 * static_cast<qint64>(sizeof(float)))
+                                          : qint64(600) * 48000;
+    const qint64 frames = std::min(qint64(2) * 3600 * 48000, maxFrames);
+    QVector<float> samples;
+    try {
+        samples = makeSamples(frames, 2);
+    } catch (const std::bad_alloc&) {
+        WARN("not enough memory for the benchmark buffer");
+        return;
+    }
+
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    QVector<WaveformLevel> serial;
+    double serialMs = 0.0;
+    std::cout << frames / 48000.0 / 60.0 << " min of 48 kHz stereo ("
+              << samples.size() * sizeof(float) / (1024 * 1024) << " MiB), " << cores << " hardware threads:" << std::endl;
+    for (int threads = 1; threads <= std::max(4, cores); threads *= 2) {
+        QElapsedTimer t;
+        t.start();
+        const QVector<WaveformLevel> levels = WaveformPyramid::build(samples, 2, 256, threads);
+        const double ms = t.nsecsElapsed() / 1e6;
+        if (threads == 1) {
+            serial = levels;
+            serialMs = ms;
+        } else {
+            REQUIRE(sameLevels(levels, serial));
+        }
+        std::cout << "  " << threads << " thread(s): " << ms << " ms (" << serialMs / ms << "x)" << std::endl;
+    }
+}
@@ -2,15 +2,84 @@
 #include <catch2/catch.hpp>
 #include "../src/WaveformRenderer.h"
 #include "../src/WaveformCache.h"
+#include "../src/WaveformKernels.h"
 #include "../src/WaveformPyramid.h"
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QIODevice>
+#include <QPainter>
+#include <cmath>
+#include <iostream>
 
 static QVector<float> vec(std::initializer_list<float> l) { return QVector<float>(l); }
 
+namespace {
+
+// The former QPainter renderer: one drawLine per column, one bucket sampled
+// per column. Reference for output and speed.
+QImage renderWithPainter(const WaveformLevel& level, int pixelWidth, float dpr, int heightCss)
+{
+    const int width = static_cast<int>(std::ceil(pixelWidth * dpr));
+    const int height = static_cast<int>(std::ceil(heightCss * dpr));
+    QImage img(width, height, QImage::Format_ARGB32);
+    img.setDevicePixelRatio(dpr);
+    img.fill(Qt::transparent);
+    QPainter p(&img);
+    p.setRenderHint(QPainter::Antialiasing, false);
+    const int buckets = qMax(1, level.min.size());
+    for (int x = 0; x < width; ++x) {
+        const double bucketPos = (static_cast<double>(x) / static_cast<double>(width)) * static_cast<double>(buckets);
+        const int idx = qBound(0, static_cast<int>(std::floor(bucketPos)), buckets - 1);
+        const float vmin = level.min.isEmpty() ? 0.0f : level.min[idx];
+        const float vmax = level.max.isEmpty() ? 0.0f : level.max[idx];
+        const double top = (1.0 - ((vmax + 1.0) / 2.0)) * (height - 1);
+        const double bottom = (1.0 - ((vmin + 1.0) / 2.0)) * (height - 1);
+        p.setPen(QColor(0, 0, 0, 200));
+        p.drawLine(x, qBound(0, static_cast<int>(std::round(top)), height - 1), x,
+                   qBound(0, static_cast<int>(std::round(bottom)), height - 1));
+    }
+    p.setPen(QColor(128, 128, 128, 60));
+    p.drawLine(0, height / 2, width - 1, height / 2);
+    p.end();
+    return img;
+}
+
+// First and last row of column x with any waveform coverage, skipping the centre line
+QPair<int, int> columnExtent(const QImage& img, int x)
+{
+    int first = -1;
+    int last = -1;
+    for (int y = 0; y < img.height(); ++y) {
+        if (y == img.height() / 2) continue;
+        if (qAlpha(img.pixel(x, y)) == 0) continue;
+        if (first < 0) first = y;
+        last = y;
+    }
+    return {first, last};
+}
+
+WaveformLevel noiseLevel(int buckets)
+{
+    WaveformLevel level;
+    level.samplesPerBucket = 256;
+    level.min.resize(buckets);
+    level.max.resize(buckets);
+    quint32 seed = 12345;
+    for (int i = 0; i < buckets; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const float a = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        const float envelope = 0.2f + 0.8f * std::fabs(std::sin(i * 0.003f));
+        level.max[i] = a * envelope;
+        level.min[i] = -a * envelope * 0.9f;
+    }
+    return level;
+}
+
+} // namespace
+
 TEST_CASE("render level to image and cache", "[waveform][renderer][cache]") {
     QVector<float> samples = vec({-1.0f, -0.5f, 0.2f, 0.7f, -0.3f, 0.1f});
     int channels = 1;
@@ -39,6 +108,7 @@ TEST_CASE("render level to image and cache", "[waveform][renderer][cache]") {
     meta["height"] = cssHeight;
     bool ok = WaveformCache::write(key, img, meta);
     REQUIRE(ok == true);
+    WaveformCache::flush();
 
     // For debugging: print metadata file contents written to disk
     QString dir = WaveformCache::cacheDirPath();
@@ -101,3 +171,118 @@ TEST_CASE("render level to image and cache", "[waveform][renderer][cache]") {
     REQUIRE(!QFile::exists(imgPath));
     REQUIRE(!QFile::exists(metaPath));
 }
+
+TEST_CASE("Scanline rasterizer matches the QPainter renderer", "[waveform][renderer]") {
+    // One bucket per column: nothing to decimate, so both sample the same values
+    const WaveformLevel level = noiseLevel(300);
+    const QImage fast = Waveform::renderLevelToImage(level, 300, 1.0f, 40).convertToFormat(QImage::Format_ARGB32);
+    const QImage reference = renderWithPainter(level, 300, 1.0f, 40);
+    REQUIRE(fast.size() == reference.size());
+    REQUIRE(fast.devicePixelRatio() == reference.devicePixelRatio());
+    for (int x = 0; x < fast.width(); ++x) {
+        INFO("column " << x);
+        const auto a = columnExtent(fast, x);
+        const auto b = columnExtent(reference, x);
+        REQUIRE(std::abs(a.first - b.first) <= 1);
+        REQUIRE(std::abs(a.second - b.second) <= 1);
+        if (a.first >= 0) REQUIRE(qAlpha(fast.pixel(x, a.first)) == 200);
+        // Centre line blended over the waveform the same way
+        const QRgb c0 = fast.pixel(x, fast.height() / 2);
+        const QRgb c1 = reference.pixel(x, reference.height() / 2);
+        REQUIRE(std::abs(qAlpha(c0) - qAlpha(c1)) <= 2);
+        REQUIRE(std::abs(qGray(c0) - qGray(c1)) <= 2);
+    }
+}
+
+TEST_CASE("Each column shows every bucket under it", "[waveform][renderer]") {
+    // A single full-scale peak between the buckets a per-column lookup samples
+    WaveformLevel level;
+    level.min = QVector<float>(1000, 0.0f);
+    level.max = QVector<float>(1000, 0.0f);
+    level.max[7] = 1.0f;
+    level.min[993] = -1.0f;
+    const QImage img = Waveform::renderLevelToImage(level, 100, 1.0f, 40);
+    REQUIRE(columnExtent(img, 0).first == 0);
+    REQUIRE(columnExtent(img, 99).second == img.height() - 1);
+    // Untouched columns stay flat around the centre
+    const auto flat = columnExtent(img, 50);
+    REQUIRE((flat.first < 0 || flat.first >= img.height() / 2 - 1));
+    REQUIRE(flat.second <= img.height() / 2 + 1);
+
+    // Narrower than the data at HiDPI, and wider than it
+    const QImage hidpi = Waveform::renderLevelToImage(level, 50, 2.0f, 20);
+    REQUIRE(hidpi.width() == 100);
+    REQUIRE(columnExtent(hidpi, 0).first == 0);
+    const QImage wide = Waveform::renderLevelToImage(level, 4000, 1.0f, 20);
+    REQUIRE(columnExtent(wide, 28).first == 0);
+}
+
+TEST_CASE("Antialiasing shades only the column edges", "[waveform][renderer]") {
+    const WaveformLevel level = noiseLevel(400);
+    const QImage aliased = Waveform::renderLevelToImage(level, 400, 1.0f, 37);
+    const QImage smooth = Waveform::renderLevelToImage(level, 400, 1.0f, 37, true);
+    const int centre = aliased.height() / 2;
+    int partial = 0;
+    for (int x = 0; x < aliased.width(); ++x) {
+        const auto extent = columnExtent(smooth, x);
+        for (int y = 0; y < aliased.height(); ++y) {
+            if (y == centre) continue;
+            const int a = qAlpha(aliased.pixel(x, y));
+            const int s = qAlpha(smooth.pixel(x, y));
+            REQUIRE((a == 0 || a == 200));
+            if (y > extent.first && y < extent.second) REQUIRE(s == 200);
+            if (s != 0 && s != 200) {
+                REQUIRE((y == extent.first || y == extent.second));
+                ++partial;
+            }
+        }
+        // The aliased column is the antialiased one rounded to whole rows
+        const auto hard = columnExtent(aliased, x);
+        if (hard.first >= 0) {
+            REQUIRE(hard.first >= extent.first);
+            REQUIRE(hard.second <= extent.second);
+        }
+    }
+    REQUIRE(partial > 0);
+}
+
+TEST_CASE("Rasterizer output does not depend on the SIMD path", "[waveform][renderer]") {
+    const WaveformLevel level = noiseLevel(5000);
+    const WaveformKernels::Isa best = WaveformKernels::activeIsa();
+    REQUIRE(WaveformKernels::setActiveIsa(WaveformKernels::Isa::Scalar));
+    const QImage scalar = Waveform::renderLevelToImage(level, 1203, 1.5f, 41, true);
+    REQUIRE(WaveformKernels::setActiveIsa(best));
+    const QImage simd = Waveform::renderLevelToImage(level, 1203, 1.5f, 41, true);
+    REQUIRE(scalar == simd);
+}
+
+TEST_CASE("Scanline rasterizer and QPainter cost on wide HiDPI images", "[.][waveform][renderer][benchmark]") {
+    // A 2000 px wide, 80 px high widget at DPR 2 over a finer pyramid level
+    const WaveformLevel level = noiseLevel(16000);
+    const int cssWidth = 2000;
+    const float dpr = 2.0f;
+    const int cssHeight = 80;
+    const int iterations = 20;
+
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < iterations; ++i) {
+        const QImage img = renderWithPainter(level, cssWidth, dpr, cssHeight);
+        REQUIRE(img.width() == 4000);
+    }
+    const double painterMs = t.nsecsElapsed() / 1e6 / iterations;
+
+    double fastMs[2] = {0.0, 0.0};
+    for (int aa = 0; aa < 2; ++aa) {
+        t.restart();
+        for (int i = 0; i < iterations; ++i) {
+            const QImage img = Waveform::renderLevelToImage(level, cssWidth, dpr, cssHeight, aa == 1);
+            REQUIRE(img.width() == 4000);
+        }
+        fastMs[aa] = t.nsecsElapsed() / 1e6 / iterations;
+    }
+
+    std::cout << "render 4000x160 from 16000 buckets: QPainter " << painterMs << " ms, scanline ("
+              << WaveformKernels::isaName(WaveformKernels::activeIsa()) << ") " << fastMs[0] << " ms, antialiased "
+              << fastMs[1] << " ms (" << painterMs / fastMs[0] << "x)" << std::endl;
+}
@@ -0,0 +1,160 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/InputCapture.h"
+#include "../src/SoundContainer.h"
+#include "../src/WaveformPackedPeaks.h"
+#include "../src/WaveformPixmapCache.h"
+#include "../src/WaveformRenderer.h"
+#include "../src/WaveformWorker.h"
+#include "TestHelpers.h"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QThread>
+#include <cmath>
+#include <iostream>
+
+/**
+ * Tests for re-rendering a container's waveform from its peaks on resize.
+ */
+
+namespace {
+
+// Ten seconds of a sine under a fast envelope: plenty of detail to blur
+WaveformResult makeWaveform(QString* path)
+{
+    const QString dir = QDir::tempPath() + QString("/libresoundboard_resize_%1").arg(QCoreApplication::applicationPid());
+    QDir().mkpath(dir);
+    *path = dir + "/detail.wav";
+    std::vector<float> samples(static_cast<size_t>(48000) * 10);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const float envelope = std::fabs(std::sin(static_cast<float>(i) * 0.0007f));
+        samples[i] = envelope * std::sin(static_cast<float>(i) * 0.05f);
+    }
+    REQUIRE(InputCapture::writeWavFile(path->toStdString(), samples, 48000));
+    WaveformResult waveform = WaveformWorker::decodeSamples(samples.data(), samples.size(), 48000, 1, 500, 1.0);
+    WaveformWorker::stampSource(*path, &waveform);
+    return waveform;
+}
+
+// Whether the container shows the peaks rendered at exactly its display size
+// (from its packed int16 copy of them)
+bool showsExactRender(SoundContainer& sc, const WaveformPeaks& peaks)
+{
+    const QPixmap pm = shownPixmap(sc);
+    if (pm.isNull()) return false;
+    const WaveformLevel level = WaveformPackedPeaks::pack(peaks).levelForWidth(pm.width());
+    const QImage expected = Waveform::renderLevelToImage(level, pm.width(), 1.0f, pm.height());
+    return pm.toImage().convertToFormat(expected.format()) == expected;
+}
+
+bool waitForExactRender(SoundContainer& sc, const WaveformPeaks& peaks, int timeoutMs)
+{
+    QElapsedTimer t;
+    t.start();
+    while (t.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents();
+        if (showsExactRender(sc, peaks)) return true;
+        QThread::msleep(5);
+    }
+    return false;
+}
+
+// A window edge dragged in 20 px steps, one event loop pass per step.
+// Returns the time the whole drag took in ms.
+double dragWidth(SoundContainer& sc, int from, int to)
+{
+    QElapsedTimer t;
+    t.start();
+    for (int w = from + 20; w <= to; w += 20) {
+        sc.resize(w, 120);
+        QCoreApplication::processEvents();
+    }
+    return t.nsecsElapsed() / 1e6;
+}
+
+} // namespace
+
+TEST_CASE("Resizing re-renders the waveform at the exact size", "[waveform][resize]") {
+    app();
+    WaveformPixmapCache::instance().clear();
+    QString path;
+    const WaveformResult waveform = makeWaveform(&path);
+    REQUIRE(waveform.peaks.isValid());
+
+    SoundContainer sc;
+    sc.resize(240, 120);
+    sc.show();
+    QCoreApplication::processEvents();
+    sc.setFileWithWaveform(path, waveform);
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 1000));
+    const int narrow = shownPixmap(sc).width();
+
+    // A small change renders in place once the resize settles
+    sc.resize(252, 120);
+    QCoreApplication::processEvents();
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 2000));
+    REQUIRE(shownPixmap(sc).width() > narrow);
+
+    // A large one stretches the old pixmap first, then renders off-thread
+    sc.resize(1600, 120);
+    QCoreApplication::processEvents();
+    const QPixmap stretched = shownPixmap(sc);
+    REQUIRE(stretched.width() > 4 * narrow);
+    REQUIRE(!showsExactRender(sc, waveform.peaks));
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 2000));
+    REQUIRE(shownPixmap(sc).size() == stretched.size());
+
+    // Back to a size rendered before: served by the pixmap cache right away
+    sc.resize(252, 120);
+    QCoreApplication::processEvents();
+    REQUIRE(showsExactRender(sc, waveform.peaks));
+}
+
+TEST_CASE("A resize burst is rendered once it settles", "[waveform][resize]") {
+    app();
+    WaveformPixmapCache::instance().clear();
+    QString path;
+    const WaveformResult waveform = makeWaveform(&path);
+
+    SoundContainer sc;
+    sc.resize(300, 120);
+    sc.show();
+    QCoreApplication::processEvents();
+    sc.setFileWithWaveform(path, waveform);
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 1000));
+
+    // While the edge keeps moving, only the old pixmap is stretched
+    dragWidth(sc, 300, 2300);
+    REQUIRE(!showsExactRender(sc, waveform.peaks));
+
+    // The exact render follows once the debounce delay has passed
+    QThread::msleep(SoundContainer::kResizeRenderDelayMs);
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 2000));
+}
+
+TEST_CASE("Resize burst timing", "[.][waveform][resize][benchmark]") {
+    app();
+    WaveformPixmapCache::instance().clear();
+    QString path;
+    const WaveformResult waveform = makeWaveform(&path);
+
+    SoundContainer sc;
+    sc.resize(300, 120);
+    sc.show();
+    QCoreApplication::processEvents();
+    sc.setFileWithWaveform(path, waveform);
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 1000));
+
+    const double burstMs = dragWidth(sc, 300, 2300);
+    QElapsedTimer t;
+    t.start();
+    REQUIRE(waitForExactRender(sc, waveform.peaks, 2000));
+    const double settleMs = t.nsecsElapsed() / 1e6;
+
+    std::cout << "100 resize steps: " << burstMs / 100.0 << " ms per step, exact render "
+              << settleMs << " ms after the last one (" << SoundContainer::kResizeRenderDelayMs
+              << " ms debounce)" << std::endl;
+}
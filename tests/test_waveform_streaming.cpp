@@ -0,0 +1,166 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "../src/AudioFile.h"
+#include "../src/WaveformWorker.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+/**
+ * Tests for streaming waveform generation from MP3 (mpg123) input.
+ */
+
+namespace {
+
+QString referenceMp3()
+{
+    return QStringLiteral(LSB_REFERENCE_SOUNDS "/1.mp3");
+}
+
+// Concatenated MPEG frames form a valid, longer MP3 stream
+QString makeLongMp3(int copies)
+{
+    QFile src(referenceMp3());
+    REQUIRE(src.open(QIODevice::ReadOnly));
+    const QByteArray data = src.readAll();
+    const QString path = QDir::tempPath() + QString("/libresoundboard_stream_%1_%2.mp3")
+                                                .arg(QCoreApplication::applicationPid())
+                                                .arg(copies);
+    QFile dst(path);
+    REQUIRE(dst.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    for (int i = 0; i < copies; ++i) dst.write(data);
+    return path;
+}
+
+// Peak resident set size in KB (VmHWM), -1 when unavailable
+qint64 peakRssKb()
+{
+    QFile f("/proc/self/status");
+    if (!f.open(QIODevice::ReadOnly)) return -1;
+    for (const QByteArray& line : f.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:")) return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+    return -1;
+}
+
+// Restart peak RSS tracking from the current RSS (Linux >= 4.0)
+void resetPeakRss()
+{
+    QFile f("/proc/self/clear_refs");
+    if (f.open(QIODevice::WriteOnly)) f.write("5");
+}
+
+} // namespace
+
+TEST_CASE("MP3 streams to the same peaks as a full decode", "[waveform][streaming]") {
+    if (!QFile::exists(referenceMp3())) {
+        WARN("reference MP3 not found, skipping");
+        return;
+    }
+    AudioFileReader reader;
+    REQUIRE(reader.open(referenceMp3()));
+    REQUIRE(reader.sampleRate() > 0);
+    REQUIRE(reader.channels() > 0);
+    REQUIRE(reader.frames() > 0);
+    reader.close();
+
+    const WaveformResult streamed = WaveformWorker::decodeFile(referenceMp3(), 500, 1.0);
+    REQUIRE(streamed.sampleRate > 0);
+    REQUIRE(streamed.min.size() == 500);
+
+    AudioFile af;
+    REQUIRE(af.load(referenceMp3()));
+    std::vector<float> samples;
+    int sampleRate = 0;
+    int channels = 0;
+    REQUIRE(af.readAllSamples(samples, sampleRate, channels));
+    const WaveformResult full = WaveformWorker::decodeSamples(samples.data(), samples.size() / channels, sampleRate,
+                                                              channels, 500, 1.0);
+
+    REQUIRE(streamed.sampleRate == full.sampleRate);
+    REQUIRE(streamed.channels == full.channels);
+    REQUIRE(std::llabs(streamed.peaks.totalFrames - full.peaks.totalFrames) <= 1152);
+    const auto& a = streamed.peaks.levels[0];
+    const auto& b = full.peaks.levels[0];
+    const int common = std::min(a.min.size(), b.min.size());
+    REQUIRE(common > 0);
+    for (int i = 0; i < common; ++i) {
+        REQUIRE(a.min[i] == Approx(b.min[i]).margin(1e-3));
+        REQUIRE(a.max[i] == Approx(b.max[i]).margin(1e-3));
+    }
+}
+
+TEST_CASE("MP3 decoding stops promptly when cancelled", "[waveform][streaming]") {
+    if (!QFile::exists(referenceMp3())) {
+        WARN("reference MP3 not found, skipping");
+        return;
+    }
+    const QString path = makeLongMp3(64);
+    auto token = QSharedPointer<QAtomicInteger<int>>::create(0);
+    std::atomic<bool> done{false};
+    WaveformResult result;
+    std::thread decoder([&]() {
+        result = WaveformWorker::decodeFile(path, 500, 1.0, token);
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    QElapsedTimer t;
+    t.start();
+    token->storeRelaxed(1);
+    decoder.join();
+    const qint64 stopMs = t.elapsed();
+
+    std::cout << "cancelled MP3 decode returned " << stopMs << " ms after the request" << std::endl;
+    REQUIRE(done.load());
+    REQUIRE(result.sampleRate == 0);
+    REQUIRE(stopMs < 250);
+    QFile::remove(path);
+}
+
+TEST_CASE("Streaming and full MP3 decode peak memory", "[.][waveform][streaming][benchmark]") {
+    if (!QFile::exists(referenceMp3())) {
+        WARN("reference MP3 not found, skipping");
+        return;
+    }
+    // About five minutes of audio
+    const QString path = makeLongMp3(64);
+    QElapsedTimer t;
+
+    // Streaming first, so a kernel without clear_refs still gives a fair delta
+    resetPeakRss();
+    qint64 before = peakRssKb();
+    t.start();
+    const WaveformResult streamed = WaveformWorker::decodeFile(path, 500, 1.0);
+    const double streamMs = t.nsecsElapsed() / 1e6;
+    const qint64 streamKb = peakRssKb() - before;
+    REQUIRE(streamed.sampleRate > 0);
+
+    resetPeakRss();
+    before = peakRssKb();
+    t.restart();
+    qint64 fullKb = 0;
+    {
+        AudioFile af;
+        REQUIRE(af.load(path));
+        std::vector<float> samples;
+        int sampleRate = 0;
+        int channels = 0;
+        REQUIRE(af.readAllSamples(samples, sampleRate, channels));
+        const WaveformResult full = WaveformWorker::decodeSamples(samples.data(), samples.size() / channels,
+                                                                  sampleRate, channels, 500, 1.0);
+        REQUIRE(full.sampleRate > 0);
+        fullKb = peakRssKb() - before;
+    }
+    const double fullMs = t.nsecsElapsed() / 1e6;
+
+    std::cout << "5 min MP3: streaming " << streamMs << " ms, peak RSS +" << streamKb << " KB; full decode "
+              << fullMs << " ms, peak RSS +" << fullKb << " KB" << std::endl;
+    QFile::remove(path);
+}